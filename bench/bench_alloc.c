@@ -0,0 +1,147 @@
+/*************************************************************************
+	> File Name: bench_alloc.c
+	> 大容量队列在不同分配方式下的吞吐量：ring_buffer_new（posix_memalign）、mmap 4KB页、
+	> 透明大页、MAP_HUGETLB大页，以及是否预先缺页。
+	> 每种方式先测第一圈写入（包含缺页），再测保持队列接近满时的循环读写：
+	> 每次写入和读出长度随机的一块，并在队列中已有数据的范围内随机ring_buffer_peek若干字节，
+	> 模拟按偏移查找记录，这部分访问跨越整个数组，主要开销是TLB缺失。
+	> 用法：bench_alloc [ring_mb]，默认512MB。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_alloc
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_alloc.h"
+
+#define CHUNK_MAX 4096
+#define PEEKS 16
+#define STEADY_OPS (4UL * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* 当前进程的透明大页用量（/proc/self/smaps_rollup中的AnonHugePages），单位MB */
+static unsigned long anon_huge_mb(void)
+{
+    char line[128];
+    unsigned long kb = 0;
+    FILE *fp = fopen("/proc/self/smaps_rollup", "r");
+
+    if (fp != NULL)
+    {
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            if (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1)
+            {
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    return kb / 1024;
+}
+
+static void run(const char *name, ring_buffer_size_t ring_len, const ring_buffer_alloc_opts_t *opts)
+{
+    static char chunk[CHUNK_MAX];
+    ring_buffer_t *rb;
+    ring_buffer_size_t len, items, cap;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL, bytes = 0;
+    unsigned long i, huge;
+    unsigned sum = 0;
+    char c;
+    int k;
+    double t_alloc, t_first, t_steady;
+
+    t_alloc = now_sec();
+    rb = opts == NULL ? ring_buffer_new(ring_len) : ring_buffer_new_opts(ring_len, opts);
+    t_alloc = now_sec() - t_alloc;
+    if (rb == NULL)
+    {
+        printf("%-24s allocation failed\n", name);
+        return;
+    }
+    cap = rb->buffer_cap;
+    memset(chunk, 'a', sizeof(chunk));
+
+    //第一圈：把队列写到只剩一块的空间，没有预先缺页时每个新页都在这里缺页。
+    t_first = now_sec();
+    while (ring_buffer_num_items(rb) + CHUNK_MAX <= cap)
+    {
+        len = 64 + (ring_buffer_size_t)(xorshift(&seed) % (CHUNK_MAX - 64));
+        ring_buffer_queue_arr(rb, chunk, len);
+    }
+    t_first = now_sec() - t_first;
+    huge = anon_huge_mb();
+
+    //稳定阶段：读出一块、写入一块，队列始终接近满，读写位置绕整个数组循环。
+    t_steady = now_sec();
+    for (i = 0; i < STEADY_OPS; i++)
+    {
+        len = 64 + (ring_buffer_size_t)(xorshift(&seed) % (CHUNK_MAX - 64));
+        ring_buffer_dequeue_arr(rb, chunk, len);
+        ring_buffer_queue_arr(rb, chunk, len);
+        bytes += 2 * (uint64_t)len;
+
+        items = ring_buffer_num_items(rb);
+        for (k = 0; k < PEEKS; k++)
+        {
+            ring_buffer_peek(rb, &c, (ring_buffer_size_t)(xorshift(&seed) % items));
+            sum += (unsigned char)c;
+        }
+    }
+    t_steady = now_sec() - t_steady;
+
+    printf("%-24s %10.3f %12.0f %12.0f %12.1f %10lu%s\n", name, t_alloc * 1e3, (cap - CHUNK_MAX) / t_first / 1e6,
+           bytes / t_steady / 1e6, STEADY_OPS * PEEKS / t_steady / 1e6, huge,
+           (rb->flags & RING_BUFFER_FLAG_HUGETLB) ? " (hugetlb)" : "");
+    if (sum == 0)
+    {
+        printf("unexpected checksum\n");
+    }
+    ring_buffer_destroy(&rb);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long ring_mb = argc > 1 ? strtoul(argv[1], NULL, 10) : 512;
+    ring_buffer_size_t ring_len = (ring_buffer_size_t)(ring_mb * 1024 * 1024);
+    ring_buffer_alloc_opts_t opts;
+
+    printf("ring %lu MB, chunks 64..%d bytes, %d random peeks per chunk\n", ring_mb, CHUNK_MAX, PEEKS);
+    printf("%-24s %10s %12s %12s %12s %10s\n", "allocation", "alloc ms", "1st lap MB/s", "wrap MB/s", "peek M/s",
+           "THP MB");
+
+    run("ring_buffer_new", ring_len, NULL);
+
+    memset(&opts, 0, sizeof(opts));
+    run("mmap 4K", ring_len, &opts);
+    opts.flags = RING_BUFFER_ALLOC_PREFAULT;
+    run("mmap 4K prefault", ring_len, &opts);
+    opts.flags = RING_BUFFER_ALLOC_THP;
+    run("THP 2M", ring_len, &opts);
+    opts.flags = RING_BUFFER_ALLOC_THP | RING_BUFFER_ALLOC_PREFAULT;
+    run("THP 2M prefault", ring_len, &opts);
+    opts.flags = RING_BUFFER_ALLOC_HUGETLB | RING_BUFFER_ALLOC_PREFAULT;
+    run("hugetlb 2M prefault", ring_len, &opts);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*************************************************************************
+	> File Name: bench_arr.c
+	> 比较逐字节实现与分段memcpy实现的ring_buffer_queue_arr/dequeue_arr吞吐量。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_arr
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+
+#define RING_LENGTH 32768
+#define TOTAL_BYTES (256UL * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 原实现：逐字节调用ring_buffer_queue。 */
+static void bytewise_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size)
+{
+    ring_buffer_size_t i;
+    for (i = 0; i < size; i++)
+    {
+        ring_buffer_queue(buffer, data[i]);
+    }
+}
+
+/* 原实现：逐字节调用ring_buffer_dequeue。 */
+static ring_buffer_size_t bytewise_dequeue_arr(ring_buffer_t *buffer, char *data, ring_buffer_size_t len)
+{
+    ring_buffer_size_t cnt = 0;
+    while ((cnt < len) && ring_buffer_dequeue(buffer, data + cnt))
+    {
+        cnt++;
+    }
+    return cnt;
+}
+
+static double run(ring_buffer_t *rb, char *in, char *out, ring_buffer_size_t frame, int bulk)
+{
+    size_t rounds = TOTAL_BYTES / frame;
+    size_t i;
+    double t0 = now_sec();
+    for (i = 0; i < rounds; i++)
+    {
+        if (bulk)
+        {
+            ring_buffer_queue_arr(rb, in, frame);
+            ring_buffer_dequeue_arr(rb, out, frame);
+        }
+        else
+        {
+            bytewise_queue_arr(rb, in, frame);
+            bytewise_dequeue_arr(rb, out, frame);
+        }
+    }
+    double t = now_sec() - t0;
+    if (memcmp(in, out, frame) != 0)
+    {
+        fprintf(stderr, "data mismatch at frame %u\n", (unsigned)frame);
+        exit(1);
+    }
+    return (double)rounds * frame / t / 1e9;
+}
+
+int main(void)
+{
+    static const ring_buffer_size_t frames[] = {64, 1024, 4096, 16384};
+    char *in = malloc(RING_LENGTH);
+    char *out = malloc(RING_LENGTH);
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    size_t i;
+
+    if (in == NULL || out == NULL || rb == NULL)
+    {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    for (i = 0; i < RING_LENGTH; i++)
+    {
+        in[i] = (char)(i * 31);
+    }
+
+    printf("%8s %14s %14s %8s\n", "frame", "bytewise GB/s", "memcpy GB/s", "speedup");
+    for (i = 0; i < sizeof(frames) / sizeof(frames[0]); i++)
+    {
+        /* 从一个不对齐的位置开始，让每一帧都经历回绕。 */
+        ring_buffer_init(rb);
+        ring_buffer_queue_arr(rb, in, 100);
+        ring_buffer_dequeue_arr(rb, out, 100);
+        double slow = run(rb, in, out, frames[i], 0);
+        double fast = run(rb, in, out, frames[i], 1);
+        printf("%8u %14.3f %14.3f %7.1fx\n", (unsigned)frames[i], slow, fast, fast / slow);
+    }
+
+    ring_buffer_destroy(&rb);
+    free(in);
+    free(out);
+    return 0;
+}
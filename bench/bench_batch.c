@@ -0,0 +1,131 @@
+/*************************************************************************
+	> File Name: bench_batch.c
+	> 小消息（8/16/32/64字节）的跨线程吞吐量：生产者每批追加B条消息后发布一次，
+	> 消费者每次最多读出B条，只更新一次读位置，B = 1/16/256；
+	> 对照组为逐条ring_buffer_push_msg/ring_buffer_pop_msg。输出每秒百万条消息。
+	> 用法：bench_batch [每组消息数，默认4000000]
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_batch
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ringbuffer_msg.h"
+
+#define CAPACITY (64 * 1024)
+#define MAX_BATCH 256
+
+typedef struct
+{
+    ring_buffer_t *rb;
+    unsigned long count;
+    ring_buffer_size_t size;
+    ring_buffer_size_t batch;
+} bench_arg_t;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *producer(void *arg)
+{
+    bench_arg_t *b = arg;
+    ring_buffer_msg_batch_t batch;
+    char msg[64];
+    unsigned long i;
+
+    memset(msg, 'x', sizeof(msg));
+    ring_buffer_begin_batch(b->rb, &batch);
+    for (i = 0; i < b->count; i++)
+    {
+        if (b->batch == 0)
+        {
+            while (!ring_buffer_push_msg(b->rb, msg, b->size))
+            {
+                sched_yield();
+            }
+            continue;
+        }
+        while (!ring_buffer_batch_append(&batch, msg, b->size))
+        {
+            ring_buffer_publish_batch(&batch);
+            sched_yield();
+        }
+        if (batch.records == b->batch)
+        {
+            ring_buffer_publish_batch(&batch);
+        }
+    }
+    if (b->batch != 0)
+    {
+        ring_buffer_publish_batch(&batch);
+    }
+    return NULL;
+}
+
+/* batch为0时是逐条收发的对照组，返回每秒百万条消息 */
+static double run(unsigned long count, ring_buffer_size_t size, ring_buffer_size_t batch)
+{
+    static char out[MAX_BATCH * 64];
+    ring_buffer_size_t lens[MAX_BATCH], len, n;
+    bench_arg_t arg = {ring_buffer_new(CAPACITY), count, size, batch};
+    unsigned long received = 0;
+    pthread_t tid;
+    double t0 = now_sec();
+
+    pthread_create(&tid, NULL, producer, &arg);
+    while (received < count)
+    {
+        if (batch == 0)
+        {
+            len = sizeof(out);
+            n = ring_buffer_pop_msg(arg.rb, out, &len);
+        }
+        else
+        {
+            n = ring_buffer_dequeue_batch(arg.rb, out, sizeof(out), lens, batch);
+        }
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        received += n;
+    }
+    pthread_join(tid, NULL);
+    t0 = now_sec() - t0;
+    ring_buffer_destroy(&arg.rb);
+    return count / t0 / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    static const ring_buffer_size_t sizes[] = {8, 16, 32, 64};
+    static const ring_buffer_size_t batches[] = {0, 1, 16, 256};
+    unsigned long count = argc > 1 ? strtoul(argv[1], NULL, 10) : 4000000;
+    int i, j;
+
+    printf("%lu messages per run, %d KB ring, Mmsg/s\n", count, CAPACITY / 1024);
+    printf("%-6s %10s %10s %10s %10s\n", "size", "push/pop", "batch 1", "batch 16", "batch 256");
+    for (i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        printf("%-6lu", (unsigned long)sizes[i]);
+        for (j = 0; j < (int)(sizeof(batches) / sizeof(batches[0])); j++)
+        {
+            printf(" %10.2f", run(count, sizes[i], batches[j]));
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    return 0;
+}
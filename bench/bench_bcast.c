@@ -0,0 +1,163 @@
+/*************************************************************************
+	> File Name: bench_bcast.c
+	> 一个生产者向1/2/4/8个读者分发同一数据流（每次写入256字节，共64MB）：
+	> 广播队列只写一份数据，每个读者各自读取；对照组为每个读者一个SPSC队列，生产者逐个写入N份。
+	> 输出生产者的有效吞吐（MB/s，即每个读者收到的数据量 / 总时间）。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_bcast
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+#include "ringbuffer_bcast.h"
+
+#define CAPACITY (64 * 1024)
+#define CHUNK 256
+#define TOTAL (64UL * 1024 * 1024)
+#define MAX_READERS 8
+
+static ring_buffer_bcast_t *bcast;
+static ring_buffer_t *copies[MAX_READERS];
+static int reader_ids[MAX_READERS];
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *bcast_reader(void *arg)
+{
+    int id = reader_ids[(long)arg];
+    char buf[4096];
+    uint64_t got = 0, sum = 0;
+    ring_buffer_size_t n;
+
+    while (got < TOTAL)
+    {
+        n = ring_buffer_bcast_read(bcast, id, buf, sizeof(buf));
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        sum += (unsigned char)buf[n - 1];
+        got += n;
+    }
+    return (void *)(uintptr_t)sum;
+}
+
+static void *copy_reader(void *arg)
+{
+    ring_buffer_t *rb = copies[(long)arg];
+    char buf[4096];
+    uint64_t got = 0, sum = 0;
+    ring_buffer_size_t n;
+
+    while (got < TOTAL)
+    {
+        n = ring_buffer_spsc_dequeue_arr(rb, buf, sizeof(buf));
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        sum += (unsigned char)buf[n - 1];
+        got += n;
+    }
+    return (void *)(uintptr_t)sum;
+}
+
+static double run(int readers, int broadcast)
+{
+    pthread_t tid[MAX_READERS];
+    char chunk[CHUNK];
+    uint64_t sent;
+    double t0;
+    long t;
+    int k;
+
+    memset(chunk, 'b', sizeof(chunk));
+    if (broadcast)
+    {
+        bcast = ring_buffer_bcast_new(CAPACITY, RING_BUFFER_REJECT);
+    }
+    for (t = 0; t < readers; t++)
+    {
+        if (broadcast)
+        {
+            reader_ids[t] = ring_buffer_bcast_join(bcast);
+        }
+        else
+        {
+            copies[t] = ring_buffer_new(CAPACITY);
+        }
+    }
+
+    t0 = now_sec();
+    for (t = 0; t < readers; t++)
+    {
+        pthread_create(&tid[t], NULL, broadcast ? bcast_reader : copy_reader, (void *)t);
+    }
+    for (sent = 0; sent < TOTAL; sent += CHUNK)
+    {
+        if (broadcast)
+        {
+            while (ring_buffer_bcast_write(bcast, chunk, CHUNK) == 0)
+            {
+                sched_yield();
+            }
+        }
+        else
+        {
+            //每个读者一份拷贝，任一队列满时生产者都要等待。
+            for (k = 0; k < readers; k++)
+            {
+                while (ring_buffer_spsc_queue_arr(copies[k], chunk, CHUNK) == 0)
+                {
+                    sched_yield();
+                }
+            }
+        }
+    }
+    for (t = 0; t < readers; t++)
+    {
+        pthread_join(tid[t], NULL);
+    }
+    t0 = now_sec() - t0;
+
+    if (broadcast)
+    {
+        ring_buffer_bcast_destroy(&bcast);
+    }
+    for (t = 0; !broadcast && t < readers; t++)
+    {
+        ring_buffer_destroy(&copies[t]);
+    }
+    return TOTAL / t0 / (1024 * 1024);
+}
+
+int main(void)
+{
+    int readers;
+
+    printf("1 writer, %lu MB stream, %d-byte writes, %d KB rings\n", TOTAL >> 20, CHUNK, CAPACITY >> 10);
+    printf("%-8s %16s %16s %8s\n", "readers", "broadcast MB/s", "N copies MB/s", "ratio");
+    for (readers = 1; readers <= MAX_READERS; readers *= 2)
+    {
+        double b = run(readers, 1);
+        double c = run(readers, 0);
+        printf("%-8d %16.1f %16.1f %8.2f\n", readers, b, c, b / c);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*************************************************************************
+	> File Name: bench_exact.c
+	> 比较2的整数次幂容量（只取与）和任意容量（ring_buffer_new_exact，跨过数组末尾时条件加法）
+	> 在热路径上的开销：单字节读写、spsc单字节读写、64B/1500B批量读写和零拷贝借出/提交。
+	> 用法：bench_exact [pow2_capacity exact_capacity]，默认4096和4104（多一个cache line的8字节）。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_exact
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+
+#define OPS (32UL * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 依次测试各种读写，结果为每次写入+读出的纳秒数 */
+static void run(const char *name, ring_buffer_t *rb)
+{
+    static char in[1500], out[1500];
+    ring_buffer_span_t spans[2];
+    unsigned long i, sum = 0;
+    double t0, t_byte, t_spsc, t_64, t_1500, t_zc;
+    char c;
+
+    /* 保持队列中有少量数据，读写位置不断绕过数组末尾 */
+    ring_buffer_queue_arr(rb, in, 64);
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        ring_buffer_queue(rb, (char)i);
+        ring_buffer_dequeue(rb, &c);
+        sum += c;
+    }
+    t_byte = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        ring_buffer_spsc_queue(rb, (char)i);
+        ring_buffer_spsc_dequeue(rb, &c);
+        sum += c;
+    }
+    t_spsc = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 8; i++)
+    {
+        ring_buffer_queue_arr(rb, in, 64);
+        sum += ring_buffer_dequeue_arr(rb, out, 64);
+    }
+    t_64 = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 64; i++)
+    {
+        ring_buffer_spsc_queue_arr(rb, in, 1500);
+        sum += ring_buffer_spsc_dequeue_arr(rb, out, 1500);
+    }
+    t_1500 = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 8; i++)
+    {
+        ring_buffer_reserve(rb, 64, spans);
+        spans[0].data[0] = (char)i;
+        ring_buffer_commit(rb, 64);
+        sum += ring_buffer_peek_spans(rb, spans);
+        ring_buffer_consume(rb, 64);
+    }
+    t_zc = now_sec() - t0;
+
+    printf("%-22s %8lu %10.2f %10.2f %10.2f %10.2f %10.2f (%lu)\n", name, (unsigned long)rb->buffer_cap,
+           t_byte / OPS * 1e9, t_spsc / OPS * 1e9, t_64 / (OPS / 8) * 1e9, t_1500 / (OPS / 64) * 1e9,
+           t_zc / (OPS / 8) * 1e9, sum & 1);
+}
+
+int main(int argc, char *argv[])
+{
+    ring_buffer_size_t pow2 = argc > 2 ? strtoul(argv[1], NULL, 10) : 4096;
+    ring_buffer_size_t exact = argc > 2 ? strtoul(argv[2], NULL, 10) : 4104;
+    ring_buffer_t *a = ring_buffer_new(pow2), *b = ring_buffer_new_exact(exact, RING_BUFFER_OVERWRITE);
+
+    if (a == NULL || b == NULL)
+    {
+        return 1;
+    }
+
+    printf("ns per queue+dequeue\n");
+    printf("%-22s %8s %10s %10s %10s %10s %10s\n", "ring", "capacity", "byte", "spsc byte", "64B arr", "1500B spsc",
+           "64B zc");
+    run("ring_buffer_new", a);
+    run("ring_buffer_new_exact", b);
+
+    ring_buffer_destroy(&a);
+    ring_buffer_destroy(&b);
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*************************************************************************
+	> File Name: bench_index.c
+	> 比较32位与64位索引计数器在热路径上的开销。
+	> 同一份代码分别以-DRING_BUFFER_INDEX_BITS=32和64编译为bench_index32/bench_index64。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_index32 bench_index64
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+
+#define RING_LENGTH 4096
+#define OPS (64UL * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    char in[64] = {0}, out[64];
+    unsigned long i, sum = 0;
+    double t0, t_byte, t_spsc, t_arr;
+
+    if (rb == NULL)
+    {
+        return 1;
+    }
+
+    /* 保持队列中有一半数据，让每次操作都经过回绕 */
+    ring_buffer_queue_arr(rb, in, 64);
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        char c;
+        ring_buffer_queue(rb, (char)i);
+        ring_buffer_dequeue(rb, &c);
+        sum += c;
+    }
+    t_byte = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        char c;
+        ring_buffer_spsc_queue(rb, (char)i);
+        ring_buffer_spsc_dequeue(rb, &c);
+        sum += c;
+    }
+    t_spsc = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 16; i++)
+    {
+        ring_buffer_queue_arr(rb, in, 64);
+        sum += ring_buffer_dequeue_arr(rb, out, 64);
+    }
+    t_arr = now_sec() - t0;
+
+    printf("index bits %d: queue+dequeue %.2f ns, spsc queue+dequeue %.2f ns, 64B arr queue+dequeue %.2f ns (%lu)\n",
+           RING_BUFFER_INDEX_BITS, t_byte / OPS * 1e9, t_spsc / OPS * 1e9, t_arr / (OPS / 16) * 1e9, sum & 1);
+
+    ring_buffer_destroy(&rb);
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*************************************************************************
+	> File Name: bench_io.c
+	> 队列与fd之间搬运数据的吞吐量：经临时缓冲区拷贝再read/write、readv/writev直接读写、
+	> 以及io_uring变体。目标分别为管道（另一线程读空）和文件（到末尾后从头覆盖）。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_io
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ringbuffer_io.h"
+
+#define RING_LENGTH (1024 * 1024)
+#define CHUNK (64 * 1024)
+#define FILE_BYTES (64UL * 1024 * 1024)
+#define TOTAL_BYTES (2UL * 1024 * 1024 * 1024)
+
+enum
+{
+    MODE_COPY,
+    MODE_VECTOR,
+    MODE_URING,
+};
+
+static ring_buffer_uring_t *uring;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *drain_pipe(void *arg)
+{
+    static char sink[CHUNK];
+    int fd = *(int *)arg;
+
+    while (read(fd, sink, sizeof(sink)) > 0)
+    {
+    }
+    return NULL;
+}
+
+/* 队列中保持数据（只移动head，不拷贝内容），每次最多CHUNK字节写到fd */
+static ssize_t drain_once(ring_buffer_t *rb, int fd, int mode)
+{
+    static char tmp[CHUNK];
+    ring_buffer_span_t spans[2];
+    ring_buffer_size_t n;
+
+    n = ring_buffer_reserve(rb, RING_LENGTH, spans);
+    ring_buffer_commit(rb, n);
+
+    switch (mode)
+    {
+    case MODE_COPY:
+    {
+        ssize_t w;
+
+        n = ring_buffer_dequeue_arr(rb, tmp, CHUNK);
+        w = write(fd, tmp, n);
+        return w;
+    }
+    case MODE_VECTOR:
+        return ring_buffer_write_to_fd(rb, fd, CHUNK);
+    default:
+        return ring_buffer_uring_write_to_fd(uring, rb, fd, CHUNK);
+    }
+}
+
+/* 从fd读入队列，再读出丢弃（只移动tail），返回读入的字节数 */
+static ssize_t fill_once(ring_buffer_t *rb, int fd, int mode)
+{
+    static char tmp[CHUNK];
+    ring_buffer_span_t spans[2];
+    ssize_t r;
+
+    switch (mode)
+    {
+    case MODE_COPY:
+        r = read(fd, tmp, CHUNK);
+        if (r > 0)
+        {
+            ring_buffer_queue_arr(rb, tmp, (ring_buffer_size_t)r);
+        }
+        break;
+    case MODE_VECTOR:
+        r = ring_buffer_read_from_fd(rb, fd, CHUNK);
+        break;
+    default:
+        r = ring_buffer_uring_read_from_fd(uring, rb, fd, CHUNK);
+        break;
+    }
+    ring_buffer_consume(rb, ring_buffer_peek_spans(rb, spans));
+    return r;
+}
+
+/* 写入管道的带宽，单位GB/s */
+static double run_pipe(int mode)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    unsigned long total = 0;
+    pthread_t reader;
+    int p[2];
+    double t0;
+
+    if (pipe(p) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    fcntl(p[1], F_SETPIPE_SZ, RING_LENGTH);
+    pthread_create(&reader, NULL, drain_pipe, &p[0]);
+
+    t0 = now_sec();
+    while (total < TOTAL_BYTES)
+    {
+        ssize_t w = drain_once(rb, p[1], mode);
+
+        if (w <= 0)
+        {
+            perror("write");
+            exit(1);
+        }
+        total += w;
+    }
+    t0 = now_sec() - t0;
+
+    close(p[1]);
+    pthread_join(reader, NULL);
+    close(p[0]);
+    ring_buffer_destroy(&rb);
+    return total / t0 / 1e9;
+}
+
+/* 写入（write非0）或读取文件的带宽，单位GB/s；文件放在/tmp，通常在页缓存中 */
+static double run_file(int mode, int write_dir)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    char path[] = "/tmp/bench_io_XXXXXX";
+    unsigned long total = 0, pos = 0;
+    int fd = mkstemp(path);
+    double t0;
+
+    if (fd < 0 || ftruncate(fd, FILE_BYTES) != 0)
+    {
+        perror("mkstemp");
+        exit(1);
+    }
+    unlink(path);
+
+    t0 = now_sec();
+    while (total < TOTAL_BYTES)
+    {
+        ssize_t n = write_dir ? drain_once(rb, fd, mode) : fill_once(rb, fd, mode);
+
+        if (n < 0)
+        {
+            perror(write_dir ? "write" : "read");
+            exit(1);
+        }
+        total += n;
+        pos += n;
+        if (n == 0 || pos >= FILE_BYTES)
+        {
+            lseek(fd, 0, SEEK_SET);
+            pos = 0;
+        }
+    }
+    t0 = now_sec() - t0;
+
+    close(fd);
+    ring_buffer_destroy(&rb);
+    return total / t0 / 1e9;
+}
+
+int main(void)
+{
+    static const char *names[] = {"copy", "readv/writev", "io_uring"};
+    int mode;
+
+    uring = ring_buffer_uring_new(8);
+    printf("%14s %14s %14s %14s\n", "path", "pipe GB/s", "file wr GB/s", "file rd GB/s");
+    for (mode = MODE_COPY; mode <= MODE_URING; mode++)
+    {
+        double pipe_bw, wr, rd;
+
+        if (mode == MODE_URING && uring == NULL)
+        {
+            break;
+        }
+        pipe_bw = run_pipe(mode);
+        wr = run_file(mode, 1);
+        rd = run_file(mode, 0);
+        printf("%14s %14.2f %14.2f %14.2f\n", names[mode], pipe_bw, wr, rd);
+    }
+
+    ring_buffer_uring_destroy(&uring);
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*************************************************************************
+	> File Name: bench_journal.c
+	> 持久化日志队列：256字节记录的持续写入吞吐量（不同步、按不同间隔调用ring_buffer_sync），
+	> 以及写满的大容量日志重新打开（逐条校验恢复）所需的时间。
+	> 用法：bench_journal [dir] [reopen_ring_mb]，默认在/tmp下测试2048MB的日志。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_journal
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "ringbuffer_journal.h"
+
+#define RECORD 256
+#define WRITE_RING (256UL * 1024 * 1024)
+#define WRITE_TOTAL (2UL * 1024 * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 写入WRITE_TOTAL字节的记录，每写入sync_every字节同步一次（0为不同步），消费者每批读空。返回MB/s */
+static double run_write(const char *path, unsigned long sync_every)
+{
+    static char rec[RECORD], out[RECORD];
+    ring_buffer_t *rb = ring_buffer_journal_create(path, WRITE_RING);
+    unsigned long total = 0, since_sync = 0;
+    ring_buffer_size_t len;
+    double t0;
+    int i;
+
+    if (rb == NULL)
+    {
+        exit(1);
+    }
+    memset(rec, 'j', sizeof(rec));
+
+    t0 = now_sec();
+    while (total < WRITE_TOTAL)
+    {
+        for (i = 0; i < 1024; i++)
+        {
+            ring_buffer_journal_append(rb, rec, RECORD);
+        }
+        total += 1024 * RECORD;
+        since_sync += 1024 * RECORD;
+        if (sync_every != 0 && since_sync >= sync_every)
+        {
+            ring_buffer_sync(rb);
+            since_sync = 0;
+        }
+        for (i = 0; i < 1024; i++)
+        {
+            len = sizeof(out);
+            ring_buffer_journal_read(rb, out, &len);
+        }
+    }
+    if (sync_every != 0)
+    {
+        ring_buffer_sync(rb);
+    }
+    t0 = now_sec() - t0;
+
+    ring_buffer_journal_close(&rb);
+    unlink(path);
+    return total / t0 / 1e6;
+}
+
+/* 写满ring_mb大小的日志并关闭，测量重新打开的时间 */
+static void run_reopen(const char *path, unsigned long ring_mb)
+{
+    static char rec[RECORD];
+    ring_buffer_t *rb = ring_buffer_journal_create(path, ring_mb * 1024 * 1024);
+    ring_buffer_size_t discarded, items;
+    double t0, t_open;
+    int fd;
+
+    if (rb == NULL)
+    {
+        exit(1);
+    }
+    memset(rec, 'r', sizeof(rec));
+    while (ring_buffer_journal_append(rb, rec, RECORD))
+    {
+    }
+    items = ring_buffer_num_items(rb);
+    t0 = now_sec();
+    ring_buffer_journal_close(&rb);
+    printf("reopen: %lu MB journal, %.0f MB of records, close (msync) %.3f s\n", ring_mb, items / 1e6,
+           now_sec() - t0);
+
+    t0 = now_sec();
+    rb = ring_buffer_journal_open(path, &discarded);
+    t_open = now_sec() - t0;
+    if (rb == NULL || discarded != 0 || ring_buffer_num_items(rb) != items)
+    {
+        fprintf(stderr, "recovery lost records\n");
+        exit(1);
+    }
+    printf("  warm page cache: open %.3f s (%.2f GB/s verified)\n", t_open, items / t_open / 1e9);
+    ring_buffer_journal_close(&rb);
+
+    //丢弃页缓存，模拟重启后从磁盘读取。
+    fd = open(path, O_RDONLY);
+    if (fd >= 0)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+    t0 = now_sec();
+    rb = ring_buffer_journal_open(path, &discarded);
+    t_open = now_sec() - t0;
+    if (rb == NULL || discarded != 0)
+    {
+        fprintf(stderr, "recovery lost records\n");
+        exit(1);
+    }
+    printf("  cold page cache: open %.3f s (%.2f GB/s verified)\n", t_open, items / t_open / 1e9);
+    ring_buffer_journal_close(&rb);
+    unlink(path);
+}
+
+int main(int argc, char *argv[])
+{
+    static const unsigned long intervals[] = {0, 64UL << 20, 4UL << 20, 256UL << 10};
+    const char *dir = argc > 1 ? argv[1] : "/tmp";
+    unsigned long ring_mb = argc > 2 ? strtoul(argv[2], NULL, 10) : 2048;
+    char path[256];
+    size_t i;
+
+    snprintf(path, sizeof(path), "%s/bench_journal_%d", dir, (int)getpid());
+    printf("%16s %12s\n", "sync every", "write MB/s");
+    for (i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++)
+    {
+        char label[32];
+
+        if (intervals[i] == 0)
+        {
+            snprintf(label, sizeof(label), "never");
+        }
+        else
+        {
+            snprintf(label, sizeof(label), "%lu KB", intervals[i] >> 10);
+        }
+        printf("%16s %12.1f\n", label, run_write(path, intervals[i]));
+    }
+
+    run_reopen(path, ring_mb);
+    return 0;
+}
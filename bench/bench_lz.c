@@ -0,0 +1,168 @@
+/*************************************************************************
+	> File Name: bench_lz.c
+	> 压缩记录和普通消息的比较：类似日志的文本记录（可压缩）和随机数据（不可压缩），
+	> 每条记录约700字节。输出写入并读出的有效吞吐量（按原始字节计）、
+	> 1MB的队列写满时能容纳的原始字节数、压缩率和每条记录的压缩/解压耗时。
+	> 用法：bench_lz [记录数，默认200000]
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_lz
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_lz.h"
+
+#define RING_CAP (1024 * 1024)
+#define PATTERNS 64
+#define RECORD_MAX 1024
+
+static char records[PATTERNS][RECORD_MAX];
+static ring_buffer_size_t lengths[PATTERNS];
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* 准备PATTERNS条记录，文本记录是8行日志，随机记录长度相同 */
+static void make_records(int text)
+{
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    int i, j, len;
+
+    for (i = 0; i < PATTERNS; i++)
+    {
+        len = 0;
+        for (j = 0; j < 8; j++)
+        {
+            int n = i * 8 + j;
+            len += sprintf(records[i] + len,
+                           "ts=%d level=%s service=gateway path=/api/v1/items/%d status=%d latency_us=%d\n",
+                           1700000000 + n, n % 11 == 0 ? "warn" : "info", n % 97, n % 13 == 0 ? 503 : 200,
+                           (int)(xorshift(&seed) % 5000));
+        }
+        if (!text)
+        {
+            for (j = 0; j < len; j++)
+            {
+                records[i][j] = (char)xorshift(&seed);
+            }
+        }
+        lengths[i] = len;
+    }
+}
+
+/* 写入一条读出一条，批量进行以保持队列中有数据，返回原始字节的MB/s */
+static double throughput(long count, int compressed, ring_buffer_lz_t *writer, ring_buffer_lz_t *reader)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_CAP);
+    static char out[RING_BUFFER_LZ_MAX_RECORD];
+    ring_buffer_size_t len;
+    double bytes = 0, t0;
+    long i, j;
+
+    t0 = now_sec();
+    for (i = 0; i < count; i += 64)
+    {
+        for (j = i; j < i + 64; j++)
+        {
+            if (compressed)
+            {
+                ring_buffer_push_lz(rb, writer, records[j % PATTERNS], lengths[j % PATTERNS]);
+            }
+            else
+            {
+                ring_buffer_push_msg(rb, records[j % PATTERNS], lengths[j % PATTERNS]);
+            }
+        }
+        for (j = i; j < i + 64; j++)
+        {
+            len = sizeof(out);
+            if (compressed ? ring_buffer_pop_lz(rb, reader, out, &len) : ring_buffer_pop_msg(rb, out, &len))
+            {
+                bytes += len;
+            }
+        }
+    }
+    t0 = now_sec() - t0;
+    ring_buffer_destroy(&rb);
+    return bytes / t0 / (1024 * 1024);
+}
+
+/* 写满一个1MB的队列，返回容纳的原始字节数 */
+static double capacity(int compressed, ring_buffer_lz_t *writer)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_CAP);
+    double bytes = 0;
+    long i;
+
+    for (i = 0;; i++)
+    {
+        const char *rec = records[i % PATTERNS];
+        ring_buffer_size_t len = lengths[i % PATTERNS];
+
+        if (!(compressed ? ring_buffer_push_lz(rb, writer, rec, len) : ring_buffer_push_msg(rb, rec, len)))
+        {
+            break;
+        }
+        bytes += len;
+    }
+    ring_buffer_destroy(&rb);
+    return bytes;
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = {"random", "text"};
+    long count = argc > 1 ? atol(argv[1]) : 200000;
+    ring_buffer_lz_stats_t wstats, rstats;
+    ring_buffer_lz_t *writer, *reader;
+    double raw_mbs, lz_mbs, raw_cap, lz_cap;
+    int text;
+
+    count = (count + 63) / 64 * 64;
+    printf("%ld records of ~700 bytes, 1 MB ring\n", count);
+    printf("%-8s %12s %12s %10s %10s %8s %10s %10s\n", "data", "msg MB/s", "lz MB/s", "msg cap MB", "lz cap MB",
+           "ratio", "pack ns", "unpack ns");
+    for (text = 0; text < 2; text++)
+    {
+        make_records(text);
+        writer = ring_buffer_lz_new();
+        reader = ring_buffer_lz_new();
+        if (writer == NULL || reader == NULL)
+        {
+            return 1;
+        }
+
+        raw_mbs = throughput(count, 0, NULL, NULL);
+        lz_mbs = throughput(count, 1, writer, reader);
+        ring_buffer_lz_get_stats(writer, &wstats);
+        ring_buffer_lz_get_stats(reader, &rstats);
+        raw_cap = capacity(0, NULL);
+        lz_cap = capacity(1, writer);
+
+        printf("%-8s %12.0f %12.0f %10.2f %10.2f %8.2f %10.0f %10.0f\n", names[text], raw_mbs, lz_mbs,
+               raw_cap / (1024 * 1024), lz_cap / (1024 * 1024), (double)wstats.raw_bytes / wstats.packed_bytes,
+               (double)wstats.compress_ns / wstats.records, (double)rstats.decompress_ns / rstats.read_records);
+
+        ring_buffer_lz_destroy(&writer);
+        ring_buffer_lz_destroy(&reader);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*************************************************************************
+	> File Name: bench_mpmc.c
+	> MPMC队列扩展性测试：线程数从1对生产者/消费者增加到占满所有核心。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_mpmc
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer_mpmc.h"
+
+#define ITEMS (8UL * 1024 * 1024)
+#define ELEM_SIZE 16
+
+struct job
+{
+    ring_buffer_mpmc_t *queue;
+    unsigned long items;
+    ring_buffer_size_t batch;
+};
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *producer(void *arg)
+{
+    struct job *job = arg;
+    char elems[64 * ELEM_SIZE] = {0};
+    unsigned long done = 0;
+    while (done < job->items)
+    {
+        ring_buffer_size_t n = job->batch;
+        if (n > job->items - done)
+        {
+            n = job->items - done;
+        }
+        n = ring_buffer_mpmc_enqueue_batch(job->queue, elems, n);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    struct job *job = arg;
+    char elems[64 * ELEM_SIZE];
+    unsigned long done = 0;
+    while (done < job->items)
+    {
+        ring_buffer_size_t n = job->batch;
+        if (n > job->items - done)
+        {
+            n = job->items - done;
+        }
+        n = ring_buffer_mpmc_dequeue_batch(job->queue, elems, n);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+    return NULL;
+}
+
+/* pairs对生产者/消费者，每个生产者写入ITEMS / pairs个元素 */
+static double run(int pairs, ring_buffer_size_t batch)
+{
+    ring_buffer_mpmc_t *queue = ring_buffer_mpmc_new(ELEM_SIZE, 4096);
+    pthread_t tids[2 * 64];
+    struct job job = {queue, ITEMS / pairs, batch};
+    int i;
+
+    double t0 = now_sec();
+    for (i = 0; i < pairs; i++)
+    {
+        pthread_create(&tids[2 * i], NULL, producer, &job);
+        pthread_create(&tids[2 * i + 1], NULL, consumer, &job);
+    }
+    for (i = 0; i < 2 * pairs; i++)
+    {
+        pthread_join(tids[i], NULL);
+    }
+    double t = now_sec() - t0;
+
+    ring_buffer_mpmc_destroy(&queue);
+    return (double)job.items * pairs / t / 1e6;
+}
+
+int main(void)
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int pairs, max_pairs = cpus / 2 > 1 ? cpus / 2 : 1;
+
+    if (max_pairs > 64)
+    {
+        max_pairs = 64;
+    }
+
+    printf("%6s %8s %16s %16s\n", "cpus", "threads", "single Mops/s", "batch16 Mops/s");
+    /* 1, 2, 4, ...对线程，最后一档正好占满所有核心 */
+    for (pairs = 1;; pairs = (pairs * 2 > max_pairs) ? max_pairs : pairs * 2)
+    {
+        printf("%6ld %8d %16.2f %16.2f\n", cpus, 2 * pairs, run(pairs, 1), run(pairs, 16));
+        if (pairs >= max_pairs)
+        {
+            break;
+        }
+    }
+    return 0;
+}
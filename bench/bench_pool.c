@@ -0,0 +1,146 @@
+/*************************************************************************
+	> File Name: bench_pool.c
+	> 连接队列的创建/使用/销毁：同时保持LIVE个连接，每次随机关闭一个连接并新建一个
+	> （容量按4KB/16KB/64KB混合），写入并读出一条消息，共1M次。
+	> 比较ring_buffer_new/ring_buffer_destroy（posix_memalign/free）和队列池，
+	> 每种方式在单独的子进程中运行，输出每秒次数、结束时的RSS和峰值RSS。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_pool
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_pool.h"
+
+#define LIVE 10000
+#define CHURN (1000 * 1000)
+#define MESSAGE 200
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* 按70%/25%/5%的比例选择4KB/16KB/64KB的容量 */
+static ring_buffer_size_t pick_size(uint64_t *seed)
+{
+    unsigned r = (unsigned)(xorshift(seed) % 100);
+    return r < 70 ? 4096 : (r < 95 ? 16384 : 65536);
+}
+
+/* 当前RSS，单位MB */
+static double rss_mb(void)
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp != NULL)
+    {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+static void run(const char *name, int use_pool)
+{
+    static ring_buffer_t *conns[LIVE];
+    ring_buffer_pool_class_t classes[] = {{4096, LIVE}, {16384, LIVE}, {65536, LIVE}};
+    ring_buffer_pool_t *pool = NULL;
+    char msg[MESSAGE], out[MESSAGE];
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    struct rusage ru;
+    double t0, rss;
+    int i, k;
+
+    memset(msg, 'm', sizeof(msg));
+    if (use_pool)
+    {
+        pool = ring_buffer_pool_new(classes, 3, RING_BUFFER_OVERWRITE);
+        if (pool == NULL)
+        {
+            exit(1);
+        }
+    }
+    for (k = 0; k < LIVE; k++)
+    {
+        ring_buffer_size_t size = pick_size(&seed);
+        conns[k] = use_pool ? ring_buffer_pool_acquire(pool, size) : ring_buffer_new(size);
+    }
+
+    t0 = now_sec();
+    for (i = 0; i < CHURN; i++)
+    {
+        ring_buffer_size_t size = pick_size(&seed);
+
+        k = (int)(xorshift(&seed) % LIVE);
+        if (use_pool)
+        {
+            ring_buffer_pool_release(pool, conns[k]);
+            conns[k] = ring_buffer_pool_acquire(pool, size);
+        }
+        else
+        {
+            ring_buffer_destroy(&conns[k]);
+            conns[k] = ring_buffer_new(size);
+        }
+        if (conns[k] == NULL)
+        {
+            fprintf(stderr, "%s: allocation failed\n", name);
+            exit(1);
+        }
+        ring_buffer_queue_arr(conns[k], msg, sizeof(msg));
+        ring_buffer_dequeue_arr(conns[k], out, sizeof(out));
+    }
+    t0 = now_sec() - t0;
+    rss = rss_mb();
+    getrusage(RUSAGE_SELF, &ru);
+
+    printf("%-22s %10.2f %12.1f %12.1f\n", name, CHURN / t0 / 1e6, rss, ru.ru_maxrss / 1024.0);
+}
+
+int main(void)
+{
+    static const char *names[] = {"ring_buffer_new", "ring_buffer_pool"};
+    pid_t pid;
+    int i;
+
+    printf("%d live rings (4K/16K/64K), %d create/use/destroy\n", LIVE, CHURN);
+    printf("%-22s %10s %12s %12s\n", "allocation", "Mops/s", "RSS MB", "peak RSS MB");
+    fflush(stdout);
+    for (i = 0; i < 2; i++)
+    {
+        //每种方式在单独的子进程中运行，RSS互不影响。
+        pid = fork();
+        if (pid == 0)
+        {
+            run(names[i], i);
+            fflush(stdout);
+            _exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/*************************************************************************
+	> File Name: bench_resize.c
+	> 大量基本空闲的连接：每个连接一个队列，每轮每个连接收发一条256字节的消息，
+	> 其中1%的连接收到一次24KB的突发数据（写入后读完），共64轮。
+	> 比较固定32KB的队列和自动调整容量的队列（1KB起步，最大32KB，连续4次检查空闲后缩小一半），
+	> 每种方式在单独的子进程中运行，输出耗时、结束时的RSS和峰值RSS。
+	> 用法：bench_resize [连接数，默认100000]
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_resize
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_resize.h"
+
+#define ROUNDS 64
+#define MESSAGE 256
+#define BURST (24 * 1024)
+#define FIXED_CAP (32 * 1024)
+#define MIN_CAP 1024
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* 当前RSS，单位MB */
+static double rss_mb(void)
+{
+    long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp != NULL)
+    {
+        if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(fp);
+    }
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+static void run(const char *name, long conns, int adaptive)
+{
+    ring_buffer_t **rings = calloc(conns, sizeof(*rings));
+    ring_buffer_autosize_t *sizes = calloc(conns, sizeof(*sizes));
+    static char msg[BURST], out[BURST];
+    uint64_t seed = 0x2545F4914F6CDD1DULL, resizes = 0;
+    ring_buffer_size_t cap;
+    struct rusage ru;
+    double t0, rss;
+    long k;
+    int round, off;
+
+    memset(msg, 'm', sizeof(msg));
+    for (k = 0; k < conns; k++)
+    {
+        sizes[k] = (ring_buffer_autosize_t){MIN_CAP, FIXED_CAP, 4, 0};
+        rings[k] = ring_buffer_new(adaptive ? MIN_CAP : FIXED_CAP);
+        if (rings[k] == NULL)
+        {
+            exit(1);
+        }
+    }
+
+    t0 = now_sec();
+    for (round = 0; round < ROUNDS; round++)
+    {
+        for (k = 0; k < conns; k++)
+        {
+            int burst = xorshift(&seed) % 100 == 0;
+            ring_buffer_size_t len = burst ? BURST : MESSAGE;
+
+            cap = rings[k]->buffer_cap;
+            //突发数据按消息大小分多次写入，与实际连接收包的方式相同。
+            for (off = 0; off < (int)len; off += MESSAGE)
+            {
+                if (adaptive)
+                {
+                    ring_buffer_queue_arr_auto(&rings[k], msg + off, MESSAGE, &sizes[k]);
+                }
+                else
+                {
+                    ring_buffer_queue_arr(rings[k], msg + off, MESSAGE);
+                }
+            }
+            ring_buffer_dequeue_arr(rings[k], out, len);
+            if (adaptive)
+            {
+                ring_buffer_autosize_check(&rings[k], &sizes[k]);
+            }
+            resizes += rings[k]->buffer_cap != cap;
+        }
+    }
+    t0 = now_sec() - t0;
+    rss = rss_mb();
+    getrusage(RUSAGE_SELF, &ru);
+
+    printf("%-10s %10.2f %12.1f %12.1f %10llu\n", name, t0, rss, ru.ru_maxrss / 1024.0,
+           (unsigned long long)resizes);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *names[] = {"fixed", "adaptive"};
+    long conns = argc > 1 ? atol(argv[1]) : 100000;
+    pid_t pid;
+    int i;
+
+    printf("%ld connections, %d rounds of %d-byte messages, 1%% get a %d KB burst per round\n", conns, ROUNDS,
+           MESSAGE, BURST / 1024);
+    printf("%-10s %10s %12s %12s %10s\n", "rings", "seconds", "RSS MB", "peak RSS MB", "resizes");
+    fflush(stdout);
+    for (i = 0; i < 2; i++)
+    {
+        //每种方式在单独的子进程中运行，RSS互不影响。
+        pid = fork();
+        if (pid == 0)
+        {
+            run(names[i], conns, i);
+            fflush(stdout);
+            _exit(0);
+        }
+        waitpid(pid, NULL, 0);
+    }
+    return 0;
+}
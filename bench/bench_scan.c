@@ -0,0 +1,167 @@
+/*************************************************************************
+	> File Name: bench_scan.c
+	> 按行读出的吞吐量：模拟的日志行（平均约120字节）写入队列后逐行读出，
+	> 对比逐字节ring_buffer_peek查找换行和各扫描实现的ring_buffer_dequeue_line，
+	> 另外测试ring_buffer_count统计行数的带宽。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_scan
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_scan.h"
+
+#define RING_LENGTH (1024 * 1024)
+#define LOG_BYTES (RING_LENGTH / 2)
+#define TOTAL_BYTES (1024UL * 1024 * 1024)
+
+static char log_data[LOG_BYTES];
+static ring_buffer_size_t log_len;
+static unsigned long log_lines;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 生成类似服务日志的文本：时间戳、级别、模块名和长度不等的消息 */
+static void make_log(void)
+{
+    static const char *levels[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+    static const char *modules[] = {"http", "db.pool", "scheduler", "auth", "cache"};
+    static const char *words[] = {"request", "completed", "user", "id=42", "latency", "ms", "retry",
+                                  "connection", "reset", "by", "peer", "GET", "/api/v1/items", "200"};
+    char line[512];
+    unsigned long i = 0;
+
+    srand(1);
+    for (;;)
+    {
+        int len = snprintf(line, sizeof(line), "2024-05-17T12:%02lu:%02lu.%03lu %-5s [%s]", (i / 60) % 60, i % 60,
+                           i % 1000, levels[rand() % 6], modules[rand() % 5]);
+        int k, words_n = 3 + rand() % 20;
+
+        for (k = 0; k < words_n; k++)
+        {
+            len += snprintf(line + len, sizeof(line) - len, " %s", words[rand() % 14]);
+        }
+        line[len++] = '\n';
+        if (log_len + len > LOG_BYTES)
+        {
+            break;
+        }
+        memcpy(log_data + log_len, line, len);
+        log_len += len;
+        i++;
+    }
+    log_lines = i;
+}
+
+/* 不使用扫描函数时的写法：逐字节peek查找换行，再整行读出 */
+static ring_buffer_size_t peek_line(ring_buffer_t *rb, char *out, ring_buffer_size_t len)
+{
+    ring_buffer_size_t i, n = ring_buffer_num_items(rb);
+    char c;
+
+    for (i = 0; i < n && i < len; i++)
+    {
+        ring_buffer_peek(rb, &c, i);
+        if (c == '\n')
+        {
+            return ring_buffer_dequeue_arr(rb, out, i + 1);
+        }
+    }
+    return 0;
+}
+
+/* 返回每秒读出的行数 */
+static double run_lines(ring_buffer_t *rb, int naive)
+{
+    static char out[4096];
+    unsigned long total = 0, lines = 0;
+    double t0 = now_sec();
+
+    while (total < TOTAL_BYTES)
+    {
+        ring_buffer_size_t n;
+
+        ring_buffer_queue_arr(rb, log_data, log_len);
+        while ((n = naive ? peek_line(rb, out, sizeof(out)) : ring_buffer_dequeue_line(rb, out, sizeof(out))) != 0)
+        {
+            lines++;
+        }
+        total += log_len;
+    }
+    if (lines != log_lines * (total / log_len))
+    {
+        fprintf(stderr, "line count mismatch: %lu\n", lines);
+        exit(1);
+    }
+    return lines / (now_sec() - t0);
+}
+
+/* 返回ring_buffer_count的扫描带宽，单位GB/s */
+static double run_count(ring_buffer_t *rb)
+{
+    unsigned long total = 0, lines = 0;
+    double t0;
+
+    ring_buffer_init(rb);
+    ring_buffer_queue_arr(rb, log_data, log_len);
+    t0 = now_sec();
+    while (total < TOTAL_BYTES)
+    {
+        lines += ring_buffer_count(rb, '\n');
+        total += log_len;
+    }
+    if (lines != log_lines * (total / log_len))
+    {
+        fprintf(stderr, "count mismatch: %lu\n", lines);
+        exit(1);
+    }
+    t0 = now_sec() - t0;
+    ring_buffer_init(rb);
+    return total / t0 / 1e9;
+}
+
+int main(void)
+{
+    static const struct
+    {
+        ring_buffer_scan_impl_t impl;
+        const char *name;
+    } impls[] = {
+        {RING_BUFFER_SCAN_SCALAR, "scalar"},
+        {RING_BUFFER_SCAN_SSE2, "sse2"},
+        {RING_BUFFER_SCAN_AVX2, "avx2"},
+    };
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    double lines, count;
+    size_t i;
+
+    make_log();
+    printf("log: %lu lines, %.1f bytes/line\n", log_lines, (double)log_len / log_lines);
+    printf("%10s %16s %16s\n", "impl", "Mlines/s", "count GB/s");
+    printf("%10s %16.3f %16s\n", "peek", run_lines(rb, 1) / 1e6, "-");
+    for (i = 0; i < sizeof(impls) / sizeof(impls[0]); i++)
+    {
+        if (!ring_buffer_scan_select(impls[i].impl))
+        {
+            continue;
+        }
+        lines = run_lines(rb, 0);
+        count = run_count(rb);
+        printf("%10s %16.3f %16.2f\n", impls[i].name, lines / 1e6, count);
+    }
+
+    ring_buffer_destroy(&rb);
+    return 0;
+}
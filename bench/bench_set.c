@@ -0,0 +1,124 @@
+/*************************************************************************
+	> File Name: bench_set.c
+	> 一个消费者服务一万个队列，每轮随机1%的队列各收到一条32字节的消息。
+	> 比较逐个检查ring_buffer_is_empty的轮询和队列集合的就绪位图调度，
+	> 输出消费者每轮的耗时和每条消息的分发开销，以及生产者标记就绪的开销。
+	> 用法：bench_set [队列数，默认10000] [活跃比例%，默认1]
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_set
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_set.h"
+
+#define ROUNDS 2000
+#define MESSAGE 32
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    int percent = argc > 2 ? atoi(argv[2]) : 1;
+    int active = count * percent / 100 > 0 ? count * percent / 100 : 1;
+    ring_buffer_t **rings = calloc(count, sizeof(*rings));
+    ring_buffer_set_t *set = ring_buffer_set_new((uint32_t)count, NULL);
+    uint64_t seed = 0x2545F4914F6CDD1DULL, messages = 0;
+    double produce[2] = {0, 0}, consume[2] = {0, 0}, t0;
+    ring_buffer_size_t quantum;
+    char msg[MESSAGE], out[256];
+    int mode, round, i, id;
+
+    if (rings == NULL || set == NULL)
+    {
+        return 1;
+    }
+    memset(msg, 'm', sizeof(msg));
+    for (i = 0; i < count; i++)
+    {
+        rings[i] = ring_buffer_new_policy(256, RING_BUFFER_REJECT);
+        if (rings[i] == NULL)
+        {
+            return 1;
+        }
+        ring_buffer_set_add(set, rings[i], (uint32_t)(i % RING_BUFFER_SET_LEVELS), 256);
+    }
+
+    //mode 0为轮询，1为队列集合；两种方式使用相同的随机序列。
+    for (mode = 0; mode < 2; mode++)
+    {
+        seed = 0x2545F4914F6CDD1DULL;
+        messages = 0;
+        for (round = 0; round < ROUNDS; round++)
+        {
+            t0 = now_sec();
+            for (i = 0; i < active; i++)
+            {
+                id = (int)(xorshift(&seed) % (uint64_t)count);
+                ring_buffer_queue_arr(rings[id], msg, MESSAGE);
+                if (mode == 1)
+                {
+                    ring_buffer_set_notify(set, id);
+                }
+            }
+            produce[mode] += now_sec() - t0;
+
+            t0 = now_sec();
+            if (mode == 0)
+            {
+                for (i = 0; i < count; i++)
+                {
+                    if (!ring_buffer_is_empty(rings[i]))
+                    {
+                        messages += ring_buffer_dequeue_arr(rings[i], out, sizeof(out)) / MESSAGE;
+                    }
+                }
+            }
+            else
+            {
+                while ((id = ring_buffer_set_next(set, &quantum)) >= 0)
+                {
+                    messages += ring_buffer_dequeue_arr(rings[id], out, quantum) / MESSAGE;
+                    ring_buffer_set_done(set, id);
+                }
+            }
+            consume[mode] += now_sec() - t0;
+        }
+        if (mode == 0)
+        {
+            printf("%d rings, %d active per round (%d%%), %d rounds, %llu messages\n", count, active, percent, ROUNDS,
+                   (unsigned long long)messages);
+            printf("%-10s %16s %16s %18s\n", "consumer", "us/round", "ns/message", "producer ns/msg");
+        }
+        printf("%-10s %16.2f %16.1f %18.1f\n", mode == 0 ? "polling" : "ring set", consume[mode] * 1e6 / ROUNDS,
+               consume[mode] * 1e9 / messages, produce[mode] * 1e9 / ((double)ROUNDS * active));
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        ring_buffer_destroy(&rings[i]);
+    }
+    free(rings);
+    ring_buffer_set_destroy(&set);
+    return 0;
+}
@@ -0,0 +1,180 @@
+/*************************************************************************
+	> File Name: bench_spsc.c
+	> 比较无锁SPSC接口与互斥锁保护的ring_buffer_t在两个线程间的吞吐量和往返延迟。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_spsc
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer.h"
+
+#define RING_LENGTH 16384
+#define TOTAL_BYTES (64UL * 1024 * 1024)
+#define PINGPONG_ROUNDS 100000
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 互斥锁版本：先检查剩余空间，避免普通接口覆盖未读数据。 */
+static ring_buffer_size_t locked_queue_arr(ring_buffer_t *rb, const char *data, ring_buffer_size_t size)
+{
+    pthread_mutex_lock(&lock);
+    ring_buffer_size_t space = rb->buffer_cap - ring_buffer_num_items(rb);
+    if (size > space)
+    {
+        size = space;
+    }
+    ring_buffer_queue_arr(rb, data, size);
+    pthread_mutex_unlock(&lock);
+    return size;
+}
+
+static ring_buffer_size_t locked_dequeue_arr(ring_buffer_t *rb, char *data, ring_buffer_size_t len)
+{
+    pthread_mutex_lock(&lock);
+    len = ring_buffer_dequeue_arr(rb, data, len);
+    pthread_mutex_unlock(&lock);
+    return len;
+}
+
+static ring_buffer_size_t send_all(ring_buffer_t *rb, const char *data, ring_buffer_size_t size, int locked)
+{
+    ring_buffer_size_t done = 0;
+    while (done < size)
+    {
+        ring_buffer_size_t n = locked ? locked_queue_arr(rb, data + done, size - done)
+                                      : ring_buffer_spsc_queue_arr(rb, data + done, size - done);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+    return done;
+}
+
+static void recv_all(ring_buffer_t *rb, char *data, ring_buffer_size_t size, int locked)
+{
+    ring_buffer_size_t done = 0;
+    while (done < size)
+    {
+        ring_buffer_size_t n = locked ? locked_dequeue_arr(rb, data + done, size - done)
+                                      : ring_buffer_spsc_dequeue_arr(rb, data + done, size - done);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+}
+
+struct job
+{
+    ring_buffer_t *to_peer;
+    ring_buffer_t *from_peer;
+    ring_buffer_size_t chunk;
+    int locked;
+};
+
+static void *stream_producer(void *arg)
+{
+    struct job *job = arg;
+    char data[1024] = {0};
+    unsigned long sent;
+    for (sent = 0; sent < TOTAL_BYTES; sent += job->chunk)
+    {
+        send_all(job->to_peer, data, job->chunk, job->locked);
+    }
+    return NULL;
+}
+
+static double throughput(ring_buffer_size_t chunk, int locked)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    struct job job = {rb, NULL, chunk, locked};
+    char data[1024];
+    unsigned long received;
+    pthread_t tid;
+
+    double t0 = now_sec();
+    pthread_create(&tid, NULL, stream_producer, &job);
+    for (received = 0; received < TOTAL_BYTES; received += chunk)
+    {
+        recv_all(rb, data, chunk, locked);
+    }
+    pthread_join(tid, NULL);
+    double t = now_sec() - t0;
+
+    ring_buffer_destroy(&rb);
+    return TOTAL_BYTES / t / 1e9;
+}
+
+/* 回显线程：收到一个字节就原样发回。 */
+static void *echo(void *arg)
+{
+    struct job *job = arg;
+    char c;
+    int i;
+    for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        recv_all(job->from_peer, &c, 1, job->locked);
+        send_all(job->to_peer, &c, 1, job->locked);
+    }
+    return NULL;
+}
+
+static double round_trip_ns(int locked)
+{
+    ring_buffer_t *ping = ring_buffer_new(RING_LENGTH);
+    ring_buffer_t *pong = ring_buffer_new(RING_LENGTH);
+    struct job job = {pong, ping, 1, locked};
+    pthread_t tid;
+    char c = 'x';
+    int i;
+
+    pthread_create(&tid, NULL, echo, &job);
+    double t0 = now_sec();
+    for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        send_all(ping, &c, 1, locked);
+        recv_all(pong, &c, 1, locked);
+    }
+    double t = now_sec() - t0;
+    pthread_join(tid, NULL);
+
+    ring_buffer_destroy(&ping);
+    ring_buffer_destroy(&pong);
+    return t / PINGPONG_ROUNDS * 1e9;
+}
+
+int main(void)
+{
+    static const ring_buffer_size_t chunks[] = {1, 64, 1024};
+    size_t i;
+
+    printf("%8s %14s %14s\n", "chunk", "mutex GB/s", "spsc GB/s");
+    for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+    {
+        double locked = throughput(chunks[i], 1);
+        double lockfree = throughput(chunks[i], 0);
+        printf("%8u %14.3f %14.3f\n", (unsigned)chunks[i], locked, lockfree);
+    }
+
+    printf("round trip: mutex %.0f ns, spsc %.0f ns\n", round_trip_ns(1), round_trip_ns(0));
+    return 0;
+}
@@ -0,0 +1,91 @@
+/*************************************************************************
+	> File Name: bench_stats.c
+	> 测量统计计数在热路径上的开销。
+	> 同一份代码分别以-DRING_BUFFER_STATS=0和1编译为bench_stats_off/bench_stats_on。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_stats_off bench_stats_on
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+
+#define RING_LENGTH 4096
+#define OPS (64UL * 1024 * 1024)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    ring_buffer_stats_t st;
+    ring_buffer_span_t spans[2];
+    char in[64] = {0}, out[64];
+    unsigned long i, sum = 0;
+    double t0, t_byte, t_spsc, t_arr, t_zc;
+
+    if (rb == NULL)
+    {
+        return 1;
+    }
+
+    /* 保持队列中有一半数据，让每次操作都经过回绕 */
+    ring_buffer_queue_arr(rb, in, 64);
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        char c;
+        ring_buffer_queue(rb, (char)i);
+        ring_buffer_dequeue(rb, &c);
+        sum += c;
+    }
+    t_byte = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS; i++)
+    {
+        char c;
+        ring_buffer_spsc_queue(rb, (char)i);
+        ring_buffer_spsc_dequeue(rb, &c);
+        sum += c;
+    }
+    t_spsc = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 16; i++)
+    {
+        ring_buffer_spsc_queue_arr(rb, in, 64);
+        sum += ring_buffer_spsc_dequeue_arr(rb, out, 64);
+    }
+    t_arr = now_sec() - t0;
+
+    t0 = now_sec();
+    for (i = 0; i < OPS / 16; i++)
+    {
+        ring_buffer_reserve(rb, 64, spans);
+        ring_buffer_commit(rb, 64);
+        sum += ring_buffer_peek_spans(rb, spans);
+        ring_buffer_consume(rb, 64);
+    }
+    t_zc = now_sec() - t0;
+
+    ring_buffer_get_stats(rb, &st);
+    printf("stats %s: queue+dequeue %.2f ns, spsc %.2f ns, 64B spsc arr %.2f ns, 64B reserve/commit+peek/consume %.2f ns"
+           " (%lu, %llu records)\n",
+           RING_BUFFER_STATS ? "on " : "off", t_byte / OPS * 1e9, t_spsc / OPS * 1e9, t_arr / (OPS / 16) * 1e9,
+           t_zc / (OPS / 16) * 1e9, sum & 1, (unsigned long long)st.enqueued_records);
+
+    ring_buffer_destroy(&rb);
+    return 0;
+}
@@ -0,0 +1,390 @@
+/*************************************************************************
+	> File Name: bench_suite.c
+	> 回归基准：单字节读写、多种长度的数组读写、大量跨越数组末尾的读写、
+	> 跨线程SPSC吞吐量与往返延迟（绑定CPU）、跨进程共享内存吞吐量。
+	> 结果以JSON输出到stdout，便于在不同提交之间比较。
+	> 用法：bench_suite [producer_cpu consumer_cpu]，默认绑定到CPU 0和1。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_suite
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/wait.h>
+
+#include "ringbuffer.h"
+#include "ringbuffer_shm.h"
+
+#ifndef BENCH_REV
+#define BENCH_REV "unknown"
+#endif
+
+#define RING_LENGTH 65536
+// 单线程测试重复次数，取中位数
+#define REPEAT 5
+#define BYTE_OPS (16UL * 1024 * 1024)
+#define BULK_BYTES (256UL * 1024 * 1024)
+#define STREAM_BYTES (256UL * 1024 * 1024)
+#define PINGPONG_ROUNDS 100000
+
+static int producer_cpu = 0, consumer_cpu = 1;
+// 绑定CPU是否全部成功，CPU不存在时为0，结果中如实记录
+static int pinned = 1;
+static int first_result = 1;
+// 防止编译器优化掉读出的数据
+static volatile unsigned long sink;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 绑定当前线程到cpu，cpu不存在时绑定失败，继续运行但记录下来。 */
+static void pin(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        pinned = 0;
+    }
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n)
+{
+    qsort(v, n, sizeof(v[0]), cmp_double);
+    return v[n / 2];
+}
+
+/* 输出一条结果，fields为已经格式化好的JSON字段。 */
+static void emit(const char *name, const char *fields)
+{
+    printf("%s    {\"name\": \"%s\", %s}", first_result ? "" : ",\n", name, fields);
+    first_result = 0;
+    fflush(stdout);
+}
+
+/*
+ * 单线程部分
+ */
+
+static double byte_ops(int spsc)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    unsigned long i, sum = 0;
+    double t0;
+    char c;
+
+    ring_buffer_queue_arr(rb, "half", 4);
+    t0 = now_sec();
+    for (i = 0; i < BYTE_OPS; i++)
+    {
+        if (spsc)
+        {
+            ring_buffer_spsc_queue(rb, (char)i);
+            ring_buffer_spsc_dequeue(rb, &c);
+        }
+        else
+        {
+            ring_buffer_queue(rb, (char)i);
+            ring_buffer_dequeue(rb, &c);
+        }
+        sum += c;
+    }
+    t0 = now_sec() - t0;
+    sink += sum;
+    ring_buffer_destroy(&rb);
+    return t0 / BYTE_OPS * 1e9;
+}
+
+/*
+ * 一次写入size字节再读出size字节，返回每对操作的纳秒数。
+ * offset为开始前队列中已有的数据量，用于控制读写位置相对数组末尾的分布。
+ */
+static double bulk_ops(ring_buffer_size_t size, ring_buffer_size_t offset)
+{
+    static char in[65536], out[65536];
+    ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+    unsigned long i, rounds = BULK_BYTES / size;
+    double t0;
+
+    ring_buffer_spsc_queue_arr(rb, in, offset);
+    t0 = now_sec();
+    for (i = 0; i < rounds; i++)
+    {
+        ring_buffer_spsc_queue_arr(rb, in, size);
+        ring_buffer_spsc_dequeue_arr(rb, out, size);
+    }
+    t0 = now_sec() - t0;
+    sink += out[0];
+    ring_buffer_destroy(&rb);
+    return t0 / rounds * 1e9;
+}
+
+static void single_thread(void)
+{
+    static const ring_buffer_size_t sizes[] = {16, 64, 256, 1024, 4096, 16384};
+    /* 与容量互质的长度，几乎每隔几次就有一次读写跨越数组末尾 */
+    static const ring_buffer_size_t wrap_sizes[] = {61, 1021, 16411};
+    double v[REPEAT];
+    char fields[256];
+    size_t k;
+    int r;
+
+    for (r = 0; r < REPEAT; r++)
+    {
+        v[r] = byte_ops(0);
+    }
+    snprintf(fields, sizeof(fields), "\"ns_per_op\": %.3f", median(v, REPEAT));
+    emit("byte_queue_dequeue", fields);
+
+    for (r = 0; r < REPEAT; r++)
+    {
+        v[r] = byte_ops(1);
+    }
+    snprintf(fields, sizeof(fields), "\"ns_per_op\": %.3f", median(v, REPEAT));
+    emit("byte_spsc_queue_dequeue", fields);
+
+    for (k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+    {
+        double ns;
+        /* 队列中保留一半数据，读写位置对齐size，不跨越数组末尾 */
+        for (r = 0; r < REPEAT; r++)
+        {
+            v[r] = bulk_ops(sizes[k], RING_LENGTH / 2);
+        }
+        ns = median(v, REPEAT);
+        snprintf(fields, sizeof(fields), "\"size\": %u, \"ns_per_op\": %.3f, \"gb_per_s\": %.3f",
+                 (unsigned)sizes[k], ns, sizes[k] / ns);
+        emit("bulk_queue_dequeue", fields);
+    }
+
+    for (k = 0; k < sizeof(wrap_sizes) / sizeof(wrap_sizes[0]); k++)
+    {
+        double ns;
+        for (r = 0; r < REPEAT; r++)
+        {
+            v[r] = bulk_ops(wrap_sizes[k], 7);
+        }
+        ns = median(v, REPEAT);
+        snprintf(fields, sizeof(fields), "\"size\": %u, \"ns_per_op\": %.3f, \"gb_per_s\": %.3f",
+                 (unsigned)wrap_sizes[k], ns, wrap_sizes[k] / ns);
+        emit("wraparound_queue_dequeue", fields);
+    }
+}
+
+/*
+ * 跨线程部分
+ */
+
+struct job
+{
+    ring_buffer_t *to_peer;
+    ring_buffer_t *from_peer;
+    ring_buffer_size_t chunk;
+};
+
+static void send_all(ring_buffer_t *rb, const char *data, ring_buffer_size_t size)
+{
+    ring_buffer_size_t done = 0;
+    while (done < size)
+    {
+        ring_buffer_size_t n = ring_buffer_spsc_queue_arr(rb, data + done, size - done);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+}
+
+static void recv_all(ring_buffer_t *rb, char *data, ring_buffer_size_t size)
+{
+    ring_buffer_size_t done = 0;
+    while (done < size)
+    {
+        ring_buffer_size_t n = ring_buffer_spsc_dequeue_arr(rb, data + done, size - done);
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        done += n;
+    }
+}
+
+static void *stream_producer(void *arg)
+{
+    struct job *job = arg;
+    static char data[16384];
+    unsigned long sent;
+
+    pin(producer_cpu);
+    for (sent = 0; sent < STREAM_BYTES; sent += job->chunk)
+    {
+        send_all(job->to_peer, data, job->chunk);
+    }
+    return NULL;
+}
+
+static void *echo(void *arg)
+{
+    struct job *job = arg;
+    char c;
+    int i;
+
+    pin(producer_cpu);
+    for (i = 0; i < PINGPONG_ROUNDS; i++)
+    {
+        recv_all(job->from_peer, &c, 1);
+        send_all(job->to_peer, &c, 1);
+    }
+    return NULL;
+}
+
+static void cross_thread(void)
+{
+    static const ring_buffer_size_t chunks[] = {64, 1024, 16384};
+    static double rtt[PINGPONG_ROUNDS];
+    static char data[16384];
+    char fields[256];
+    size_t k;
+    int i;
+
+    pin(consumer_cpu);
+    for (k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++)
+    {
+        ring_buffer_t *rb = ring_buffer_new(RING_LENGTH);
+        struct job job = {rb, NULL, chunks[k]};
+        unsigned long received;
+        pthread_t tid;
+        double t;
+
+        t = now_sec();
+        pthread_create(&tid, NULL, stream_producer, &job);
+        for (received = 0; received < STREAM_BYTES; received += chunks[k])
+        {
+            recv_all(rb, data, chunks[k]);
+        }
+        pthread_join(tid, NULL);
+        t = now_sec() - t;
+        ring_buffer_destroy(&rb);
+
+        snprintf(fields, sizeof(fields), "\"chunk\": %u, \"gb_per_s\": %.3f, \"producer_cpu\": %d, \"consumer_cpu\": %d, \"pinned\": %s",
+                 (unsigned)chunks[k], STREAM_BYTES / t / 1e9, producer_cpu, consumer_cpu, pinned ? "true" : "false");
+        emit("spsc_thread_throughput", fields);
+    }
+
+    {
+        ring_buffer_t *ping = ring_buffer_new(RING_LENGTH);
+        ring_buffer_t *pong = ring_buffer_new(RING_LENGTH);
+        struct job job = {pong, ping, 1};
+        pthread_t tid;
+        char c = 'x';
+
+        pthread_create(&tid, NULL, echo, &job);
+        for (i = 0; i < PINGPONG_ROUNDS; i++)
+        {
+            double t = now_sec();
+            send_all(ping, &c, 1);
+            recv_all(pong, &c, 1);
+            rtt[i] = (now_sec() - t) * 1e9;
+        }
+        pthread_join(tid, NULL);
+        ring_buffer_destroy(&ping);
+        ring_buffer_destroy(&pong);
+
+        qsort(rtt, PINGPONG_ROUNDS, sizeof(rtt[0]), cmp_double);
+        snprintf(fields, sizeof(fields),
+                 "\"rounds\": %d, \"ns_p50\": %.0f, \"ns_p99\": %.0f, \"ns_p999\": %.0f, \"producer_cpu\": %d, \"consumer_cpu\": %d, \"pinned\": %s",
+                 PINGPONG_ROUNDS, rtt[PINGPONG_ROUNDS / 2], rtt[PINGPONG_ROUNDS * 99 / 100],
+                 rtt[PINGPONG_ROUNDS * 999 / 1000], producer_cpu, consumer_cpu, pinned ? "true" : "false");
+        emit("spsc_thread_round_trip", fields);
+    }
+}
+
+/*
+ * 跨进程部分：memfd共享内存队列，子进程为消费者。
+ */
+static void cross_process(void)
+{
+    static const ring_buffer_size_t chunks[] = {64, 1024, 16384};
+    static char data[16384];
+    char fields[256];
+    size_t k;
+
+    for (k = 0; k < sizeof(chunks) / sizeof(chunks[0]); k++)
+    {
+        int fd;
+        ring_buffer_t *rb = ring_buffer_memfd_create("bench_suite", RING_LENGTH, &fd);
+        unsigned long sent;
+        pid_t pid;
+        double t;
+
+        if (rb == NULL)
+        {
+            return;
+        }
+        t = now_sec();
+        pid = fork();
+        if (pid == 0)
+        {
+            ring_buffer_t *peer = ring_buffer_fd_open(fd);
+            unsigned long received;
+
+            pin(consumer_cpu);
+            for (received = 0; received < STREAM_BYTES; received += chunks[k])
+            {
+                recv_all(peer, data, chunks[k]);
+            }
+            _exit(0);
+        }
+        pin(producer_cpu);
+        for (sent = 0; sent < STREAM_BYTES; sent += chunks[k])
+        {
+            send_all(rb, data, chunks[k]);
+        }
+        waitpid(pid, NULL, 0);
+        t = now_sec() - t;
+        ring_buffer_shm_close(&rb);
+        close(fd);
+
+        snprintf(fields, sizeof(fields), "\"chunk\": %u, \"gb_per_s\": %.3f, \"producer_cpu\": %d, \"consumer_cpu\": %d, \"pinned\": %s",
+                 (unsigned)chunks[k], STREAM_BYTES / t / 1e9, producer_cpu, consumer_cpu, pinned ? "true" : "false");
+        emit("shm_process_throughput", fields);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2)
+    {
+        producer_cpu = atoi(argv[1]);
+        consumer_cpu = atoi(argv[2]);
+    }
+
+    printf("{\n  \"rev\": \"%s\",\n  \"index_bits\": %d,\n  \"ring_length\": %d,\n  \"online_cpus\": %ld,\n"
+           "  \"results\": [\n",
+           BENCH_REV, RING_BUFFER_INDEX_BITS, RING_LENGTH, sysconf(_SC_NPROCESSORS_ONLN));
+    single_thread();
+    cross_thread();
+    cross_process();
+    printf("\n  ]\n}\n");
+    return 0;
+}
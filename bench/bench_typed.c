@@ -0,0 +1,103 @@
+/*************************************************************************
+	> File Name: bench_typed.c
+	> 比较RING_BUFFER_DEFINE生成的定长元素队列与字节队列接口搬运8/64/256字节元素的速度。
+ ************************************************************************/
+
+// compile command:
+//  make -C bench bench_typed
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_typed.h"
+
+#define TOTAL_BYTES (256UL * 1024 * 1024)
+#define RING_ELEMS 256
+
+typedef struct { char b[8]; } elem8_t;
+typedef struct { char b[64]; } elem64_t;
+typedef struct { char b[256]; } elem256_t;
+
+RING_BUFFER_DEFINE(ring8, elem8_t, RING_ELEMS)
+RING_BUFFER_DEFINE(ring64, elem64_t, RING_ELEMS)
+RING_BUFFER_DEFINE(ring256, elem256_t, RING_ELEMS)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 字节接口：每个元素逐字节入队/出队 */
+static double run_bytewise(ring_buffer_t *rb, size_t size)
+{
+    char in[256] = {1}, out[256];
+    unsigned long i, n = TOTAL_BYTES / size / 16;
+    size_t k;
+    double t0 = now_sec();
+    for (i = 0; i < n; i++)
+    {
+        for (k = 0; k < size; k++)
+        {
+            ring_buffer_queue(rb, in[k]);
+        }
+        for (k = 0; k < size; k++)
+        {
+            ring_buffer_dequeue(rb, &out[k]);
+        }
+    }
+    return n / (now_sec() - t0) / 1e6;
+}
+
+/* 字节接口：每个元素一次queue_arr/dequeue_arr */
+static double run_arr(ring_buffer_t *rb, size_t size)
+{
+    char in[256] = {1}, out[256];
+    unsigned long i, n = TOTAL_BYTES / size;
+    double t0 = now_sec();
+    for (i = 0; i < n; i++)
+    {
+        ring_buffer_queue_arr(rb, in, size);
+        ring_buffer_dequeue_arr(rb, out, size);
+    }
+    return n / (now_sec() - t0) / 1e6;
+}
+
+#define RUN_TYPED(name, type)                               \
+    static double run_##name(void)                          \
+    {                                                       \
+        static name##_t ring;                               \
+        type in = {{1}}, out;                               \
+        unsigned long i, n = TOTAL_BYTES / sizeof(type);    \
+        name##_init(&ring);                                 \
+        double t0 = now_sec();                              \
+        for (i = 0; i < n; i++)                             \
+        {                                                   \
+            name##_push(&ring, &in);                        \
+            name##_pop(&ring, &out);                        \
+            __asm__ volatile("" : : "g"(&out) : "memory");  \
+        }                                                   \
+        return n / (now_sec() - t0) / 1e6;                  \
+    }
+
+RUN_TYPED(ring8, elem8_t)
+RUN_TYPED(ring64, elem64_t)
+RUN_TYPED(ring256, elem256_t)
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(RING_ELEMS * 256);
+
+    printf("%6s %18s %18s %18s\n", "elem", "bytewise Melem/s", "arr Melem/s", "typed Melem/s");
+    printf("%6d %18.2f %18.2f %18.2f\n", 8, run_bytewise(rb, 8), run_arr(rb, 8), run_ring8());
+    printf("%6d %18.2f %18.2f %18.2f\n", 64, run_bytewise(rb, 64), run_arr(rb, 64), run_ring64());
+    printf("%6d %18.2f %18.2f %18.2f\n", 256, run_bytewise(rb, 256), run_arr(rb, 256), run_ring256());
+
+    ring_buffer_destroy(&rb);
+    return 0;
+}
@@ -1,8 +1,11 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #include "ringbuffer.h"
 
@@ -14,67 +17,256 @@
  * 王景鑫 2022/10/10
  */
 
+/*
+ * head_index和tail_index是自由增长的计数器，只在访问数组时与index_mask取与，
+ * 队列元素个数恒为head - tail（无符号减法在计数器回绕时依然正确），
+ * 满的条件是head - tail == buffer_cap，不再浪费一个位置。
+ *
+ * 容量不是2的整数次幂时（RING_BUFFER_FLAG_EXACT），index_mask + 1是不小于容量的最小2的整数次幂，
+ * 计数器的低位只取[0, buffer_cap)，跨过数组末尾时跳过剩下的index_gap个值，高位即圈数。
+ * 因此数组下标仍然是一次取与，移动计数器（ring_buffer_advance）和求两个计数器的距离
+ * （ring_buffer_distance）各多一次比较和条件加减，不需要除法。2的整数次幂容量时index_gap为0，
+ * 两个函数退化为普通的加减。
+ *
+ * 索引的读写约定：
+ * 本端的索引只有自己修改，使用relaxed读取；对端的索引使用acquire读取，
+ * 保证看到对端在发布索引之前写入（或读出）的数据；本端索引用release发布。
+ * 在x86上这些操作都是普通的mov指令，单线程使用时没有额外开销。
+ */
+#define RB_LOAD(obj, order) atomic_load_explicit(&(obj), memory_order_##order)
+#define RB_STORE(obj, val, order) atomic_store_explicit(&(obj), (val), memory_order_##order)
+
+/*
+ * 统计计数。每组计数只有一个写者（生产者或消费者），用relaxed的读-加-写代替原子加法，
+ * 在x86上是普通的mov/add，不需要lock前缀。RING_BUFFER_STATS为0时这些宏全部展开为空。
+ */
+#if RING_BUFFER_STATS
+#define RB_STAT_ADD(obj, n) RB_STORE(obj, RB_LOAD(obj, relaxed) + (n), relaxed)
+
+static inline unsigned ring_buffer_stat_bucket(ring_buffer_size_t n)
+{
+    unsigned bucket = 63 - __builtin_clzll((unsigned long long)n);
+    return bucket < RING_BUFFER_STATS_BUCKETS ? bucket : RING_BUFFER_STATS_BUCKETS - 1;
+}
+
+/**
+ * 记录一次写入：size为写入的字节数，items为写入后生产者看到的数据量。
+ */
+static inline void ring_buffer_stat_enqueue(ring_buffer_t *buffer, ring_buffer_size_t size, ring_buffer_size_t items)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    RB_STAT_ADD(buffer->stat_enqueued_bytes, size);
+    RB_STAT_ADD(buffer->stat_enqueued_records, 1);
+    RB_STAT_ADD(buffer->stat_enqueue_hist[ring_buffer_stat_bucket(size)], 1);
+    if (items > RB_LOAD(buffer->stat_high_water, relaxed))
+    {
+        RB_STORE(buffer->stat_high_water, items, relaxed);
+    }
+}
+
+static inline void ring_buffer_stat_dequeue(ring_buffer_t *buffer, ring_buffer_size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+    RB_STAT_ADD(buffer->stat_dequeued_bytes, size);
+    RB_STAT_ADD(buffer->stat_dequeued_records, 1);
+    RB_STAT_ADD(buffer->stat_dequeue_hist[ring_buffer_stat_bucket(size)], 1);
+}
+
+#define RB_STAT_ENQUEUE(buffer, size, items) ring_buffer_stat_enqueue(buffer, size, items)
+#define RB_STAT_DEQUEUE(buffer, size) ring_buffer_stat_dequeue(buffer, size)
+#define RB_STAT_FULL(buffer) RB_STAT_ADD((buffer)->stat_full_hits, 1)
+#define RB_STAT_EMPTY(buffer) RB_STAT_ADD((buffer)->stat_empty_hits, 1)
+#define RB_STAT_OVERWRITE(buffer) RB_STAT_ADD((buffer)->stat_overwrites, 1)
+#else
+#define RB_STAT_ENQUEUE(buffer, size, items) ((void)0)
+#define RB_STAT_DEQUEUE(buffer, size) ((void)0)
+#define RB_STAT_FULL(buffer) ((void)0)
+#define RB_STAT_EMPTY(buffer) ((void)0)
+#define RB_STAT_OVERWRITE(buffer) ((void)0)
+#endif
+
 void ring_buffer_init(ring_buffer_t *buffer)
 {
-    buffer->tail_index = 0;
-    buffer->head_index = 0;
+    RB_STORE(buffer->tail_index, 0, relaxed);
+    RB_STORE(buffer->head_index, 0, relaxed);
+    buffer->cached_tail = 0;
+    buffer->cached_head = 0;
+    buffer->synced_head = 0;
+    buffer->producer_spin = 0;
+    buffer->consumer_spin = 0;
+    RB_STORE(buffer->data_futex, 0, relaxed);
+    RB_STORE(buffer->data_waiters, 0, relaxed);
+    RB_STORE(buffer->space_futex, 0, relaxed);
+    RB_STORE(buffer->space_waiters, 0, relaxed);
+    RB_STORE(buffer->dropped_bytes, 0, relaxed);
+    RB_STORE(buffer->dropped_msgs, 0, relaxed);
+#if RING_BUFFER_STATS
+    {
+        int i;
+        RB_STORE(buffer->stat_enqueued_bytes, 0, relaxed);
+        RB_STORE(buffer->stat_enqueued_records, 0, relaxed);
+        RB_STORE(buffer->stat_high_water, 0, relaxed);
+        RB_STORE(buffer->stat_full_hits, 0, relaxed);
+        RB_STORE(buffer->stat_overwrites, 0, relaxed);
+        RB_STORE(buffer->stat_dequeued_bytes, 0, relaxed);
+        RB_STORE(buffer->stat_dequeued_records, 0, relaxed);
+        RB_STORE(buffer->stat_empty_hits, 0, relaxed);
+        for (i = 0; i < RING_BUFFER_STATS_BUCKETS; i++)
+        {
+            RB_STORE(buffer->stat_enqueue_hist[i], 0, relaxed);
+            RB_STORE(buffer->stat_dequeue_hist[i], 0, relaxed);
+        }
+    }
+#endif
 }
 
-ring_buffer_size_t ring_buffer_calc_size(size_t buffer_length)
+/**
+ * 检查溢出策略的取值。
+ */
+static int ring_buffer_policy_valid(ring_buffer_overflow_t policy)
 {
-    int i;
+    if (policy != RING_BUFFER_OVERWRITE && policy != RING_BUFFER_REJECT && policy != RING_BUFFER_DROP_NEWEST)
+    {
+        fprintf(stderr, "%s -- unknown overflow policy 0x%x.\n", __func__, (unsigned)policy);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * 填写头部信息并清空队列。
+ */
+static void ring_buffer_setup(ring_buffer_t *buffer, int64_t data_offset, ring_buffer_size_t buffer_cap, uint16_t flags)
+{
+    buffer->version = RING_BUFFER_VERSION;
+    buffer->elem_size = sizeof(char);
+    buffer->index_size = sizeof(ring_buffer_size_t);
+#if RING_BUFFER_STATS
+    flags |= RING_BUFFER_FLAG_STATS;
+#endif
+    buffer->buffer_cap = buffer_cap;
+    buffer->index_mask = 1;
+    while (buffer->index_mask < buffer_cap)
+    {
+        buffer->index_mask <<= 1;
+    }
+    buffer->index_gap = buffer->index_mask - buffer_cap;
+    buffer->index_mask -= 1;
+    flags &= ~RING_BUFFER_FLAG_EXACT;
+    if (buffer->index_gap != 0)
+    {
+        flags |= RING_BUFFER_FLAG_EXACT;
+    }
+    buffer->flags = flags;
+    buffer->data_offset = data_offset;
+
+    //设置成员变量的值
+    ring_buffer_init(buffer);
+
+    atomic_store_explicit(&buffer->magic, RING_BUFFER_MAGIC, memory_order_release);
+}
+
+size_t ring_buffer_calc_size(size_t buffer_length)
+{
+    size_t cap = 1;
     //长度检查
     if (buffer_length > RING_BUFFER_SIZE)
     {
-        fprintf(stderr, "%s -- ring_buffer_size exceed max range of RING_BUFFER_SIZE(%d).\n", __func__, RING_BUFFER_SIZE);
+        fprintf(stderr, "%s -- ring_buffer_size exceed max range of RING_BUFFER_SIZE(%llu).\n", __func__,
+                (unsigned long long)RING_BUFFER_SIZE);
         return 0;
     }
 
-    for (i = 1; i <= RING_BUFFER_SIZE; i *= 2)
+    while (cap < buffer_length)
     {
-        if (buffer_length <= i)
-        {
-            buffer_length = i;
-            // printf("buffer_length = %lu\n",buffer_length);
-            //返回地址块大小包含结构体占用的部分。
-            return (buffer_length + (size_t)sizeof(ring_buffer_t));
-        }
+        cap <<= 1;
     }
+
+    //返回地址块大小包含结构体占用的部分。
+    return cap + sizeof(ring_buffer_t);
 }
 
 ring_buffer_t *ring_buffer_new(ring_buffer_size_t buffer_length)
 {
+    return ring_buffer_new_policy(buffer_length, RING_BUFFER_OVERWRITE);
+}
 
-    ring_buffer_t *buffer = NULL;
+size_t ring_buffer_calc_size_exact(size_t length)
+{
+    if (length == 0 || length > RING_BUFFER_SIZE)
+    {
+        fprintf(stderr, "%s -- ring_buffer_size must be 1..RING_BUFFER_SIZE(%llu).\n", __func__,
+                (unsigned long long)RING_BUFFER_SIZE);
+        return 0;
+    }
 
-    buffer_length = ring_buffer_calc_size(buffer_length);
+    //容量按RING_BUFFER_EXACT_ALIGN对齐，消息层的长度头和日志记录不会被数组末尾截断。
+    return (length + RING_BUFFER_EXACT_ALIGN - 1) / RING_BUFFER_EXACT_ALIGN * RING_BUFFER_EXACT_ALIGN +
+           sizeof(ring_buffer_t);
+}
 
-    //使用一次malloc分配内存，大小是sizeof(ring_buffer_t) + sizeof(buffer_cap*sizeof(char))
-    //然后把结构体首地址赋给结构体指针buffer，数组首地址赋给buffer->buffer_array。
-    buffer = (ring_buffer_t *)malloc(buffer_length * sizeof(char));
+/**
+ * 分配alloc_length字节（头部加数组）并初始化队列。
+ */
+static ring_buffer_t *ring_buffer_alloc(size_t alloc_length, uint16_t flags)
+{
+    ring_buffer_t *buffer;
 
-    // printf("sizeof ring_buffer_t:%d, sizeof buffer_array:%d.\n",sizeof(ring_buffer_t),(ring_buffer_size * sizeof(char)));
-    // printf("malloc, buffer addr %p -> %d (ring_buffer_t).\n",&buffer,buffer);
-    // printf("tail addr of malloc:%d.\n",(int)buffer + sizeof(ring_buffer_t) + ring_buffer_size * sizeof(char));
+    //使用一次分配内存，大小是sizeof(ring_buffer_t) + sizeof(buffer_cap*sizeof(char))
+    //结构体中的head/tail各占一个cache line，所以按cache line对齐分配。
+    int err = posix_memalign((void **)&buffer, RING_BUFFER_CACHE_LINE, alloc_length * sizeof(char));
 
-    if (buffer == NULL)
+    if (err != 0)
     {
-        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(errno));
-        free(buffer);
+        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(err));
         return (ring_buffer_t *)NULL;
     }
 
-    // printf("addr of buffer++:%d.\n",buffer+1);
-    // buffer+1得到结构体后面的地址，将其类型转换为(char*)后赋值给buffer->array
-    buffer->buffer_array = (char *)(buffer + 1);
-    buffer->buffer_cap = buffer_length - sizeof(ring_buffer_t);
-
-    //设置成员变量的值
-    ring_buffer_init(buffer);
+    // 数组紧跟在结构体后面，只记录其相对结构体首地址的偏移。
+    ring_buffer_setup(buffer, sizeof(ring_buffer_t), alloc_length - sizeof(ring_buffer_t), flags);
 
     return buffer;
 }
 
+ring_buffer_t *ring_buffer_new_exact(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy)
+{
+    size_t alloc_length;
+
+    if (!ring_buffer_policy_valid(policy))
+    {
+        return (ring_buffer_t *)NULL;
+    }
+
+    alloc_length = ring_buffer_calc_size_exact(buffer_length);
+    if (alloc_length == 0)
+    {
+        return (ring_buffer_t *)NULL;
+    }
+    return ring_buffer_alloc(alloc_length, (uint16_t)policy | RING_BUFFER_FLAG_EXACT_SIZE);
+}
+
+ring_buffer_t *ring_buffer_new_policy(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy)
+{
+    if (!ring_buffer_policy_valid(policy))
+    {
+        return (ring_buffer_t *)NULL;
+    }
+
+    size_t alloc_length = ring_buffer_calc_size(buffer_length);
+    if (alloc_length == 0)
+    {
+        return (ring_buffer_t *)NULL;
+    }
+
+    return ring_buffer_alloc(alloc_length, (uint16_t)policy);
+}
+
 void ring_buffer_destroy(ring_buffer_t **buffer)
 {
 
@@ -85,13 +277,39 @@ void ring_buffer_destroy(ring_buffer_t **buffer)
         return;
     }
 
-    free(*buffer);
+    if ((*buffer)->flags & RING_BUFFER_FLAG_POOLED)
+    {
+        fprintf(stderr, "%s -- ring buffer belongs to a pool, use ring_buffer_pool_release.\n", __func__);
+        return;
+    }
+
+    if ((*buffer)->flags & RING_BUFFER_FLAG_MIRRORED)
+    {
+        //镜像映射：头部、数组和数组的第二份映射是一段连续的虚拟地址。
+        munmap(*buffer, (*buffer)->data_offset + 2 * (*buffer)->buffer_cap);
+    }
+    else if ((*buffer)->flags & RING_BUFFER_FLAG_MAPPED)
+    {
+        //ring_buffer_new_opts：头部独占一页，data_offset即页大小，映射长度按页向上取整。
+        size_t page = (size_t)(*buffer)->data_offset;
+        munmap(*buffer, page + ((*buffer)->buffer_cap + page - 1) / page * page);
+    }
+    else
+    {
+        free(*buffer);
+    }
     *buffer = NULL;
 }
 
-ring_buffer_t *ring_buffer_attach(void *addr, ring_buffer_size_t length)
+ring_buffer_t *ring_buffer_attach(void *addr, size_t length)
+{
+    return ring_buffer_attach_policy(addr, length, RING_BUFFER_OVERWRITE);
+}
+
+ring_buffer_t *ring_buffer_attach_policy(void *addr, size_t length, ring_buffer_overflow_t policy)
 {
     ring_buffer_t *buffer;
+    size_t cap;
     //判断传入参数是否为空值。
     if (addr == NULL)
     {
@@ -99,77 +317,277 @@ ring_buffer_t *ring_buffer_attach(void *addr, ring_buffer_size_t length)
         return NULL;
     }
 
+    if (!ring_buffer_policy_valid(policy))
+    {
+        return NULL;
+    }
+
+    if (length <= sizeof(ring_buffer_t))
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_t.\n", __func__);
+        return NULL;
+    }
+
     buffer = addr;
-    buffer->buffer_array = (char *)(buffer + 1);
-    buffer->buffer_cap = length - sizeof(ring_buffer_t);
+    cap = length - sizeof(ring_buffer_t);
+    if ((cap & (cap - 1)) != 0)
+    {
+        //不是ring_buffer_calc_size得到的长度，按任意容量使用。
+        cap -= cap % RING_BUFFER_EXACT_ALIGN;
+    }
+    if (cap == 0 || cap > RING_BUFFER_SIZE)
+    {
+        fprintf(stderr, "%s -- buffer_cap must be 1..RING_BUFFER_SIZE.\n", __func__);
+        return NULL;
+    }
+    ring_buffer_setup(buffer, sizeof(ring_buffer_t), (ring_buffer_size_t)cap, (uint16_t)policy);
 
-    //设置成员变量的值
-    ring_buffer_init(buffer);
+    return buffer;
+}
+
+ring_buffer_t *ring_buffer_attach_array(void *addr, char *array, ring_buffer_size_t buffer_cap, uint16_t flags)
+{
+    if (addr == NULL || array == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr or *array is NULL.\n", __func__);
+        return NULL;
+    }
+
+    if (buffer_cap == 0 || buffer_cap > RING_BUFFER_SIZE ||
+        ((flags & RING_BUFFER_FLAG_EXACT) ? buffer_cap % RING_BUFFER_EXACT_ALIGN != 0
+                                           : (buffer_cap & (buffer_cap - 1)) != 0))
+    {
+        fprintf(stderr, "%s -- buffer_cap must be a power of 2 (or a multiple of %d with RING_BUFFER_FLAG_EXACT) "
+                        "not exceeding RING_BUFFER_SIZE.\n",
+                __func__, RING_BUFFER_EXACT_ALIGN);
+        return NULL;
+    }
+
+    if (!ring_buffer_policy_valid((ring_buffer_overflow_t)(flags & RING_BUFFER_FLAG_OVERFLOW_MASK)))
+    {
+        return NULL;
+    }
+
+    ring_buffer_setup(addr, array - (char *)addr, buffer_cap, flags);
+
+    return addr;
+}
+
+ring_buffer_t *ring_buffer_open(void *addr, size_t length)
+{
+    ring_buffer_t *buffer = addr;
+
+    if (addr == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr is NULL.\n", __func__);
+        return NULL;
+    }
+
+    if (length < sizeof(ring_buffer_t))
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_t.\n", __func__);
+        return NULL;
+    }
+
+    //magic最后写入，读到正确的magic说明其余头部字段已经初始化完成。
+    if (atomic_load_explicit(&buffer->magic, memory_order_acquire) != RING_BUFFER_MAGIC)
+    {
+        fprintf(stderr, "%s -- bad magic, memory block is not a ring buffer.\n", __func__);
+        return NULL;
+    }
+
+    if (buffer->version != RING_BUFFER_VERSION || buffer->elem_size != sizeof(char) ||
+        buffer->index_size != sizeof(ring_buffer_size_t))
+    {
+        fprintf(stderr, "%s -- incompatible ring buffer version %u, element size %u, index size %u.\n",
+                __func__, (unsigned)buffer->version, (unsigned)buffer->elem_size, (unsigned)buffer->index_size);
+        return NULL;
+    }
+
+#if RING_BUFFER_STATS
+    //以统计方式编译时头部更大，不能打开不含统计字段的队列。
+    if (!(buffer->flags & RING_BUFFER_FLAG_STATS))
+    {
+        fprintf(stderr, "%s -- ring buffer was created without RING_BUFFER_STATS.\n", __func__);
+        return NULL;
+    }
+#endif
+
+    if (buffer->buffer_cap == 0 || (buffer->index_mask & (buffer->index_mask + 1)) != 0 ||
+        buffer->index_mask < buffer->buffer_cap - 1 ||
+        buffer->index_gap != buffer->index_mask + 1 - buffer->buffer_cap ||
+        buffer->data_offset < (int64_t)sizeof(ring_buffer_t) ||
+        (uint64_t)buffer->data_offset + buffer->buffer_cap > length)
+    {
+        fprintf(stderr, "%s -- corrupted ring buffer header.\n", __func__);
+        return NULL;
+    }
 
     return buffer;
 }
 
-void ring_buffer_queue(ring_buffer_t *buffer, char data)
+/**
+ * 累加丢弃计数。计数只由生产者修改，relaxed的读写足以让其他线程或进程读到完整的值。
+ */
+static void ring_buffer_count_drop(ring_buffer_t *buffer, ring_buffer_size_t bytes)
+{
+    RB_STORE(buffer->dropped_bytes, RB_LOAD(buffer->dropped_bytes, relaxed) + bytes, relaxed);
+    RB_STORE(buffer->dropped_msgs, RB_LOAD(buffer->dropped_msgs, relaxed) + 1, relaxed);
+}
+
+uint8_t ring_buffer_queue(ring_buffer_t *buffer, char data)
 {
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, acquire);
+
     /* Is buffer full? */
-    if (ring_buffer_is_full(buffer))
+    if (ring_buffer_distance(buffer, head, tail) == buffer->buffer_cap)
     {
-        /* Is going to overwrite the oldest byte */
-        /* Increase tail index */
-        buffer->tail_index = ((buffer->tail_index + 1) & (buffer->buffer_cap - 1));
+        RB_STAT_FULL(buffer);
+        switch (buffer->flags & RING_BUFFER_FLAG_OVERFLOW_MASK)
+        {
+        case RING_BUFFER_REJECT:
+            return 0;
+        case RING_BUFFER_DROP_NEWEST:
+            ring_buffer_count_drop(buffer, 1);
+            return 0;
+        default:
+            /* Is going to overwrite the oldest byte */
+            /* Increase tail index */
+            ring_buffer_count_drop(buffer, 1);
+            RB_STAT_OVERWRITE(buffer);
+            tail = ring_buffer_advance(buffer, tail, 1);
+            RB_STORE(buffer->tail_index, tail, release);
+            /* tail被生产者移动过，消费者缓存的head可能落在tail之前，需要一并更新。 */
+            buffer->cached_head = tail;
+            break;
+        }
     }
+    buffer->cached_tail = tail;
 
     /* Place data in buffer */
-    buffer->buffer_array[buffer->head_index] = data;
-    buffer->head_index = ((buffer->head_index + 1) & (buffer->buffer_cap - 1));
+    ring_buffer_data(buffer)[head & buffer->index_mask] = data;
+    head = ring_buffer_advance(buffer, head, 1);
+    RB_STORE(buffer->head_index, head, release);
+    RB_STAT_ENQUEUE(buffer, 1, ring_buffer_distance(buffer, head, tail));
+    return 1;
 }
 
-uint8_t ring_buffer_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size)
+/**
+ * 剩余空间space不足以写入size个字节时按溢出策略处理，返回本次应写入的字节数。
+ * 只在空间不足时调用，不影响正常写入的路径。
+ */
+static ring_buffer_size_t ring_buffer_overflow(ring_buffer_t *buffer, ring_buffer_size_t size, ring_buffer_size_t space)
 {
-    /* Add bytes; one by one */
-    /* 增加入队列数据大小的判断，超过队列容量则失败返回。 */
-    if (size > buffer->buffer_cap)
+    RB_STAT_FULL(buffer);
+    switch (buffer->flags & RING_BUFFER_FLAG_OVERFLOW_MASK)
     {
-        fprintf(stderr, "%s -- queue array size exceed buffer size.\n", __func__);
+    case RING_BUFFER_REJECT:
         return 0;
+    case RING_BUFFER_DROP_NEWEST:
+        ring_buffer_count_drop(buffer, size - space);
+        return space;
+    default:
+        /* 增加入队列数据大小的判断，超过队列容量则失败返回。 */
+        if (size > buffer->buffer_cap)
+        {
+            fprintf(stderr, "%s -- queue array size exceed buffer size.\n", __func__);
+            return 0;
+        }
+        /* 写入之后最旧的size - space个字节会被覆盖。 */
+        ring_buffer_count_drop(buffer, size - space);
+        RB_STAT_OVERWRITE(buffer);
+        return size;
     }
+}
+
+ring_buffer_size_t ring_buffer_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size)
+{
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, acquire);
+    ring_buffer_size_t space = buffer->buffer_cap - ring_buffer_distance(buffer, head, tail);
 
-    ring_buffer_size_t i;
-    for (i = 0; i < size; i++)
+    if (size > space)
     {
-        ring_buffer_queue(buffer, data[i]);
+        size = ring_buffer_overflow(buffer, size, space);
+        if (size == 0)
+        {
+            return 0;
+        }
     }
-    return 1;
+
+    ring_buffer_size_t pos = head & buffer->index_mask;
+
+    /* 最多分两段拷贝：head到数组末尾，然后从数组起始位置继续。 */
+    size_t first = buffer->buffer_cap - pos;
+    if (first > size)
+    {
+        first = size;
+    }
+    memcpy(ring_buffer_data(buffer) + pos, data, first);
+    memcpy(ring_buffer_data(buffer), data + first, size - first);
+
+    head = ring_buffer_advance(buffer, head, size);
+    RB_STORE(buffer->head_index, head, release);
+
+    /* 覆盖策略：空间不足时覆盖最旧的数据，队列保持满状态（tail与head下标相同、相差一圈）。 */
+    if (size > space)
+    {
+        tail = head - (buffer->index_mask + 1);
+        RB_STORE(buffer->tail_index, tail, release);
+        buffer->cached_head = tail;
+    }
+    buffer->cached_tail = tail;
+    RB_STAT_ENQUEUE(buffer, size, ring_buffer_distance(buffer, head, tail));
+    return size;
 }
 
 uint8_t ring_buffer_dequeue(ring_buffer_t *buffer, char *data)
 {
-    if (ring_buffer_is_empty(buffer))
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, acquire);
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+
+    if (head == tail)
     {
         /* No items */
+        RB_STAT_EMPTY(buffer);
         return 0;
     }
 
-    *data = buffer->buffer_array[buffer->tail_index];
-    buffer->tail_index = ((buffer->tail_index + 1) & (buffer->buffer_cap - 1));
+    buffer->cached_head = head;
+    *data = ring_buffer_data(buffer)[tail & buffer->index_mask];
+    RB_STORE(buffer->tail_index, ring_buffer_advance(buffer, tail, 1), release);
+    RB_STAT_DEQUEUE(buffer, 1);
     return 1;
 }
 
 ring_buffer_size_t ring_buffer_dequeue_arr(ring_buffer_t *buffer, char *data, ring_buffer_size_t len)
 {
-    if (ring_buffer_is_empty(buffer))
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, acquire);
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+    ring_buffer_size_t items = ring_buffer_distance(buffer, head, tail);
+    if (items == 0)
     {
         /* No items */
+        RB_STAT_EMPTY(buffer);
         return 0;
     }
 
-    char *data_ptr = data;
-    ring_buffer_size_t cnt = 0;
-    while ((cnt < len) && ring_buffer_dequeue(buffer, data_ptr))
+    buffer->cached_head = head;
+    ring_buffer_size_t cnt = (len < items) ? len : items;
+    ring_buffer_size_t pos = tail & buffer->index_mask;
+
+    /* 最多分两段拷贝：tail到数组末尾，然后从数组起始位置继续。 */
+    size_t first = buffer->buffer_cap - pos;
+    if (first > cnt)
     {
-        cnt++;
-        data_ptr++;
+        first = cnt;
     }
+    memcpy(data, ring_buffer_data(buffer) + pos, first);
+    memcpy(data + first, ring_buffer_data(buffer), cnt - first);
+
+    RB_STORE(buffer->tail_index, ring_buffer_advance(buffer, tail, cnt), release);
+    RB_STAT_DEQUEUE(buffer, cnt);
     return cnt;
 }
 
@@ -182,14 +600,255 @@ uint8_t ring_buffer_peek(ring_buffer_t *buffer, char *data, ring_buffer_size_t i
     }
 
     /* Add index to pointer */
-    ring_buffer_size_t data_index = ((buffer->tail_index + index) & (buffer->buffer_cap - 1));
-    *data = buffer->buffer_array[data_index];
+    ring_buffer_size_t data_index =
+        ring_buffer_advance(buffer, RB_LOAD(buffer->tail_index, relaxed), index) & buffer->index_mask;
+    *data = ring_buffer_data(buffer)[data_index];
+    return 1;
+}
+
+uint64_t ring_buffer_dropped_bytes(ring_buffer_t *buffer)
+{
+    return RB_LOAD(buffer->dropped_bytes, relaxed);
+}
+
+uint64_t ring_buffer_dropped_msgs(ring_buffer_t *buffer)
+{
+    return RB_LOAD(buffer->dropped_msgs, relaxed);
+}
+
+void ring_buffer_get_stats(ring_buffer_t *buffer, ring_buffer_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->capacity = buffer->buffer_cap;
+    stats->num_items = ring_buffer_num_items(buffer);
+    stats->dropped_bytes = RB_LOAD(buffer->dropped_bytes, relaxed);
+    stats->dropped_msgs = RB_LOAD(buffer->dropped_msgs, relaxed);
+#if RING_BUFFER_STATS
+    int i;
+    stats->enqueued_bytes = RB_LOAD(buffer->stat_enqueued_bytes, relaxed);
+    stats->enqueued_records = RB_LOAD(buffer->stat_enqueued_records, relaxed);
+    stats->dequeued_bytes = RB_LOAD(buffer->stat_dequeued_bytes, relaxed);
+    stats->dequeued_records = RB_LOAD(buffer->stat_dequeued_records, relaxed);
+    stats->high_water = RB_LOAD(buffer->stat_high_water, relaxed);
+    stats->full_hits = RB_LOAD(buffer->stat_full_hits, relaxed);
+    stats->empty_hits = RB_LOAD(buffer->stat_empty_hits, relaxed);
+    stats->overwrites = RB_LOAD(buffer->stat_overwrites, relaxed);
+    for (i = 0; i < RING_BUFFER_STATS_BUCKETS; i++)
+    {
+        stats->enqueue_hist[i] = RB_LOAD(buffer->stat_enqueue_hist[i], relaxed);
+        stats->dequeue_hist[i] = RB_LOAD(buffer->stat_dequeue_hist[i], relaxed);
+    }
+#endif
+}
+
+ring_buffer_size_t ring_buffer_spsc_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size)
+{
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+    ring_buffer_size_t space = buffer->buffer_cap - ring_buffer_distance(buffer, head, buffer->cached_tail);
+
+    /* 缓存的tail不足以容纳本次数据时，才去读取消费者所在的cache line。 */
+    if (space < size)
+    {
+        buffer->cached_tail = RB_LOAD(buffer->tail_index, acquire);
+        space = buffer->buffer_cap - ring_buffer_distance(buffer, head, buffer->cached_tail);
+        if (size > space)
+        {
+            RB_STAT_FULL(buffer);
+            size = space;
+        }
+    }
+
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    ring_buffer_size_t pos = head & buffer->index_mask;
+    size_t first = buffer->buffer_cap - pos;
+    if (first > size)
+    {
+        first = size;
+    }
+    memcpy(ring_buffer_data(buffer) + pos, data, first);
+    memcpy(ring_buffer_data(buffer), data + first, size - first);
+
+    /* 数据写完之后再发布head。 */
+    head = ring_buffer_advance(buffer, head, size);
+    RB_STORE(buffer->head_index, head, release);
+    RB_STAT_ENQUEUE(buffer, size, ring_buffer_distance(buffer, head, buffer->cached_tail));
+    return size;
+}
+
+uint8_t ring_buffer_spsc_queue(ring_buffer_t *buffer, char data)
+{
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+
+    if (ring_buffer_distance(buffer, head, buffer->cached_tail) == buffer->buffer_cap)
+    {
+        buffer->cached_tail = RB_LOAD(buffer->tail_index, acquire);
+        if (ring_buffer_distance(buffer, head, buffer->cached_tail) == buffer->buffer_cap)
+        {
+            /* Buffer is full */
+            RB_STAT_FULL(buffer);
+            return 0;
+        }
+    }
+
+    ring_buffer_data(buffer)[head & buffer->index_mask] = data;
+    head = ring_buffer_advance(buffer, head, 1);
+    RB_STORE(buffer->head_index, head, release);
+    RB_STAT_ENQUEUE(buffer, 1, ring_buffer_distance(buffer, head, buffer->cached_tail));
+    return 1;
+}
+
+ring_buffer_size_t ring_buffer_spsc_dequeue_arr(ring_buffer_t *buffer, char *data, ring_buffer_size_t len)
+{
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+    ring_buffer_size_t items = ring_buffer_distance(buffer, buffer->cached_head, tail);
+
+    /* 缓存的head不够本次读取时，才去读取生产者所在的cache line。 */
+    if (items < len)
+    {
+        buffer->cached_head = RB_LOAD(buffer->head_index, acquire);
+        items = ring_buffer_distance(buffer, buffer->cached_head, tail);
+        if (len > items)
+        {
+            len = items;
+        }
+    }
+
+    if (len == 0)
+    {
+        RB_STAT_EMPTY(buffer);
+        return 0;
+    }
+
+    ring_buffer_size_t pos = tail & buffer->index_mask;
+    size_t first = buffer->buffer_cap - pos;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(data, ring_buffer_data(buffer) + pos, first);
+    memcpy(data + first, ring_buffer_data(buffer), len - first);
+
+    /* 数据读完之后再发布tail，生产者才可以复用这段空间。 */
+    RB_STORE(buffer->tail_index, ring_buffer_advance(buffer, tail, len), release);
+    RB_STAT_DEQUEUE(buffer, len);
+    return len;
+}
+
+uint8_t ring_buffer_spsc_dequeue(ring_buffer_t *buffer, char *data)
+{
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+
+    if (tail == buffer->cached_head)
+    {
+        buffer->cached_head = RB_LOAD(buffer->head_index, acquire);
+        if (tail == buffer->cached_head)
+        {
+            /* No items */
+            RB_STAT_EMPTY(buffer);
+            return 0;
+        }
+    }
+
+    *data = ring_buffer_data(buffer)[tail & buffer->index_mask];
+    RB_STORE(buffer->tail_index, ring_buffer_advance(buffer, tail, 1), release);
+    RB_STAT_DEQUEUE(buffer, 1);
+    return 1;
+}
+
+/**
+ * 将从计数pos开始的len个字节拆分为最多两段连续内存。
+ */
+static void ring_buffer_fill_spans(ring_buffer_t *buffer, ring_buffer_size_t pos, ring_buffer_size_t len,
+                                   ring_buffer_span_t spans[2])
+{
+    ring_buffer_size_t offset = pos & buffer->index_mask;
+    ring_buffer_size_t first = buffer->buffer_cap - offset;
+    /* 镜像映射时数组末尾之后就是数组开头，任何不超过容量的范围都是连续的。 */
+    if (first > len || (buffer->flags & RING_BUFFER_FLAG_MIRRORED))
+    {
+        first = len;
+    }
+
+    spans[0].data = ring_buffer_data(buffer) + offset;
+    spans[0].len = first;
+    spans[1].data = ring_buffer_data(buffer);
+    spans[1].len = len - first;
+}
+
+ring_buffer_size_t ring_buffer_reserve(ring_buffer_t *buffer, ring_buffer_size_t size, ring_buffer_span_t spans[2])
+{
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+    ring_buffer_size_t space = buffer->buffer_cap - ring_buffer_distance(buffer, head, buffer->cached_tail);
+
+    if (space < size)
+    {
+        buffer->cached_tail = RB_LOAD(buffer->tail_index, acquire);
+        space = buffer->buffer_cap - ring_buffer_distance(buffer, head, buffer->cached_tail);
+        if (size > space)
+        {
+            RB_STAT_FULL(buffer);
+            size = space;
+        }
+    }
+
+    ring_buffer_fill_spans(buffer, head, size, spans);
+    return size;
+}
+
+uint8_t ring_buffer_commit(ring_buffer_t *buffer, ring_buffer_size_t size)
+{
+    ring_buffer_size_t head = RB_LOAD(buffer->head_index, relaxed);
+
+    /* 借出空间时已经刷新过cached_tail，这里只用缓存值检查。 */
+    if (size > buffer->buffer_cap - ring_buffer_distance(buffer, head, buffer->cached_tail))
+    {
+        fprintf(stderr, "%s -- commit size exceed reserved space.\n", __func__);
+        return 0;
+    }
+
+    head = ring_buffer_advance(buffer, head, size);
+    RB_STORE(buffer->head_index, head, release);
+    RB_STAT_ENQUEUE(buffer, size, ring_buffer_distance(buffer, head, buffer->cached_tail));
+    return 1;
+}
+
+ring_buffer_size_t ring_buffer_peek_spans(ring_buffer_t *buffer, ring_buffer_span_t spans[2])
+{
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+    ring_buffer_size_t items;
+
+    buffer->cached_head = RB_LOAD(buffer->head_index, acquire);
+    if (buffer->cached_head == tail)
+    {
+        RB_STAT_EMPTY(buffer);
+    }
+    items = ring_buffer_distance(buffer, buffer->cached_head, tail);
+    ring_buffer_fill_spans(buffer, tail, items, spans);
+    return items;
+}
+
+uint8_t ring_buffer_consume(ring_buffer_t *buffer, ring_buffer_size_t size)
+{
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, relaxed);
+
+    if (size > ring_buffer_distance(buffer, buffer->cached_head, tail))
+    {
+        fprintf(stderr, "%s -- consume size exceed readable data.\n", __func__);
+        return 0;
+    }
+
+    RB_STORE(buffer->tail_index, ring_buffer_advance(buffer, tail, size), release);
+    RB_STAT_DEQUEUE(buffer, size);
     return 1;
 }
 
 inline uint8_t ring_buffer_is_empty(ring_buffer_t *buffer)
 {
-    return (buffer->head_index == buffer->tail_index);
+    return ring_buffer_num_items(buffer) == 0;
 }
 
 /**
@@ -199,7 +858,7 @@ inline uint8_t ring_buffer_is_empty(ring_buffer_t *buffer)
  */
 inline uint8_t ring_buffer_is_full(ring_buffer_t *buffer)
 {
-    return ((buffer->head_index - buffer->tail_index) & (buffer->buffer_cap - 1)) == (buffer->buffer_cap - 1);
+    return ring_buffer_num_items(buffer) == buffer->buffer_cap;
 }
 
 /**
@@ -209,7 +868,9 @@ inline uint8_t ring_buffer_is_full(ring_buffer_t *buffer)
  */
 inline ring_buffer_size_t ring_buffer_num_items(ring_buffer_t *buffer)
 {
-    return ((buffer->head_index - buffer->tail_index) & (buffer->buffer_cap - 1));
+    /* 先读tail再读head，保证另一线程并发修改时结果不会超过容量。 */
+    ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, acquire);
+    return ring_buffer_distance(buffer, RB_LOAD(buffer->head_index, acquire), tail);
 }
 
 /**
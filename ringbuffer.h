@@ -1,34 +1,110 @@
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdatomic.h>
 
 /**
  * @file
  * 对环形队列进行了改写，使它可以支持可变长度的队列。
- * 由于算法原理限制，队列长度仍然需要保持是2的整数次幂。
+ * 默认的队列长度是2的整数次幂，ring_buffer_new_exact可以按指定长度（8字节对齐）分配。
  * 增加了ring_buffer_new函数，用于环形队列对象的分配。
  * 相对应的，增加了ring_buffer_destroy函数用于队列对象的释放。
  * 为了适用于共享内存工作环境，增加了三个函数，分别是
  * ring_buffer_calc_size
  * ring_buffer_attach
  * ring_buffer_detach
- * 目前队列最大可设置长度为32768个char。超过该长度将发生异常。
- * 队列的实际可利用长度为设置长度-1，需要予以注意。
+ * 共享内存中只保存数组的相对偏移，可使用ring_buffer_open在其他进程中重新打开。
+ * 索引类型在编译时通过RING_BUFFER_INDEX_BITS选择32位或64位（默认64位），
+ * 64位时队列最大可设置长度为2^40个char，32位时为2^31个char。
+ * head/tail为自由增长的计数器，队列可以完全装满，实际可利用长度等于设置长度。
  * 王景鑫   2022/10/10
  */
 
 #ifndef RINGBUFFER_H
 #define RINGBUFFER_H
 
-// 最大允许队列长度
-#define RING_BUFFER_SIZE 32768 // 2^15
+// 索引位宽，可在编译时用-DRING_BUFFER_INDEX_BITS=32修改。
+#ifndef RING_BUFFER_INDEX_BITS
+#define RING_BUFFER_INDEX_BITS 64
+#endif
+
+// 统计开关，可在编译时用-DRING_BUFFER_STATS=1打开；关闭时头部不包含统计字段，读写路径上也没有任何统计代码。
+#ifndef RING_BUFFER_STATS
+#define RING_BUFFER_STATS 0
+#endif
 
 /**
  * The type which is used to hold the size
  * and the indicies of the buffer.
  * Must be able to fit \c RING_BUFFER_SIZE .
- * **将其定义为uint32_t可以兼容更大的长度，需要同时修改RING_BUFFER_SIZE的宏定义为2^31次幂**
+ * head/tail计数器自由增长、自然回绕，RING_BUFFER_SIZE不超过该类型范围的一半即可保证正确。
+ */
+#if RING_BUFFER_INDEX_BITS == 64
+typedef uint64_t ring_buffer_size_t;
+// 与ring_buffer_size_t等宽的有符号类型，用于比较两个计数器的先后。
+typedef int64_t ring_buffer_diff_t;
+// 最大允许队列长度
+#define RING_BUFFER_SIZE ((ring_buffer_size_t)1 << 40)
+#elif RING_BUFFER_INDEX_BITS == 32
+typedef uint32_t ring_buffer_size_t;
+typedef int32_t ring_buffer_diff_t;
+// 最大允许队列长度
+#define RING_BUFFER_SIZE ((ring_buffer_size_t)1 << 31)
+#else
+#error "RING_BUFFER_INDEX_BITS must be 32 or 64"
+#endif
+
+// 共享内存头部的标识和版本号，ring_buffer_open据此校验内存块。
+#define RING_BUFFER_MAGIC 0x52494e47 // "RING"
+#define RING_BUFFER_VERSION 6
+
+// flags：数组之后紧跟着同一物理内存的第二份映射，见ring_buffer_new_mirrored。
+#define RING_BUFFER_FLAG_MIRRORED 0x0001
+// flags：消息层在记录跨越数组末尾时填充跳过标记，使每条记录都连续存放，见ringbuffer_msg.h。
+#define RING_BUFFER_FLAG_MSG_PAD 0x0002
+// flags：溢出策略所占的位，取值见ring_buffer_overflow_t。
+#define RING_BUFFER_FLAG_OVERFLOW_MASK 0x000C
+// flags：头部包含统计字段（创建者以RING_BUFFER_STATS=1编译），见ring_buffer_get_stats。
+#define RING_BUFFER_FLAG_STATS 0x0010
+// flags：队列映射自文件，数组中是带校验和的日志记录，见ringbuffer_journal.h。
+#define RING_BUFFER_FLAG_JOURNAL 0x0020
+// flags：头部和数组由mmap分配，数组从第data_offset字节（映射所用的页大小）开始，见ringbuffer_alloc.h。
+#define RING_BUFFER_FLAG_MAPPED 0x0040
+// flags：RING_BUFFER_FLAG_MAPPED的映射使用了MAP_HUGETLB大页。
+#define RING_BUFFER_FLAG_HUGETLB 0x0080
+// flags：队列是队列池中的一个槽位，用ring_buffer_pool_release放回，见ringbuffer_pool.h。
+#define RING_BUFFER_FLAG_POOLED 0x0100
+// flags：容量不是2的整数次幂，计数器每跨过一次数组末尾跳过index_gap，见ring_buffer_new_exact。
+#define RING_BUFFER_FLAG_EXACT 0x0200
+// flags：队列是广播队列的头部，之后是读者表，见ringbuffer_bcast.h。
+#define RING_BUFFER_FLAG_BCAST 0x0400
+// flags：队列是带时间戳的事件记录器，按固定大小的槽位存放记录，见ringbuffer_trace.h。
+#define RING_BUFFER_FLAG_TRACE 0x0800
+// flags：容量按ring_buffer_new_exact的规则取整（RING_BUFFER_EXACT_ALIGN的倍数），调整容量时沿用；
+// 与RING_BUFFER_FLAG_EXACT不同，容量恰好是2的整数次幂时也保留。
+#define RING_BUFFER_FLAG_EXACT_SIZE 0x1000
+
+// ring_buffer_new_exact等接口把容量向上取整到该值的倍数，消息层和日志记录的对齐依赖这一点。
+#define RING_BUFFER_EXACT_ALIGN 8
+
+// 批大小直方图的桶数，第k个桶统计长度在[2^k, 2^(k+1))之间的读写，最后一个桶包含更大的长度。
+#define RING_BUFFER_STATS_BUCKETS 32
+
+// cache line大小，head与tail分别放在不同的cache line上，避免生产者和消费者互相干扰。
+#define RING_BUFFER_CACHE_LINE 64
+
+/**
+ * 普通写入接口（ring_buffer_queue/ring_buffer_queue_arr）在空间不足时的处理方式，
+ * 创建队列时指定，保存在flags中。SPSC和零拷贝接口不受影响，它们从不覆盖数据。
  */
-typedef uint16_t ring_buffer_size_t;
+typedef enum ring_buffer_overflow_t
+{
+    /** 覆盖最旧的数据（默认），被覆盖的字节计入丢弃计数。 */
+    RING_BUFFER_OVERWRITE = 0x0000,
+    /** 整次写入失败，不写入任何内容，也不计入丢弃计数。 */
+    RING_BUFFER_REJECT = 0x0004,
+    /** 写入能放下的部分，丢弃新数据中放不下的部分并计入丢弃计数。 */
+    RING_BUFFER_DROP_NEWEST = 0x0008,
+} ring_buffer_overflow_t;
 
 /**
  * Simplifies the use of <tt>struct ring_buffer_t</tt>.
@@ -42,22 +118,195 @@ typedef struct ring_buffer_t ring_buffer_t;
  */
 struct ring_buffer_t
 {
+    /** 固定为RING_BUFFER_MAGIC，在头部其余字段写好之后最后写入。 */
+    _Atomic uint32_t magic;
+    /** 内存布局版本，RING_BUFFER_VERSION。 */
+    uint16_t version;
+    /** 元素大小，字节队列为1。 */
+    uint16_t elem_size;
+    /** 索引类型的字节数，打开时校验双方的RING_BUFFER_INDEX_BITS一致。 */
+    uint16_t index_size;
+    /** RING_BUFFER_FLAG_*，记录数组的分配方式。 */
+    uint16_t flags;
     /**
      * Buffer memory.
-     * 用指针方式实现，在ring_buffer_new函数或者ring_buffer_attach中进行地址绑定。
-     * */
-    char *buffer_array;
-    /* 队列缓冲的大小级别，2的整数幂次 */
-    /**
-     * 同时，这个变量也作为mask使用。mask = buffer_cap - 1
+     * 不保存绝对地址，只保存数组相对结构体首地址的偏移，
+     * 这样同一块共享内存被不同进程映射到不同地址时依然有效。
+     * 使用ring_buffer_data获取数组地址。
      */
+    int64_t data_offset;
+    /** 数组长度，通常是2的整数幂次；设置了RING_BUFFER_FLAG_EXACT时为任意8字节对齐的长度。 */
     ring_buffer_size_t buffer_cap;
-    /** Index of tail. */
-    ring_buffer_size_t tail_index;
-    /** Index of head. */
-    ring_buffer_size_t head_index;
+    /**
+     * 计数器到数组下标的mask：不小于buffer_cap的最小2的整数幂次减一，数组下标为index & index_mask。
+     * 2的整数幂次容量时即buffer_cap - 1。
+     */
+    ring_buffer_size_t index_mask;
+    /**
+     * 计数器每跨过一次数组末尾额外加上的值，index_mask + 1 - buffer_cap，2的整数幂次容量时为0。
+     * 计数器的低位因此始终小于buffer_cap，高位是圈数，计数器依然自由增长、自然回绕。
+     */
+    ring_buffer_size_t index_gap;
+
+    /* 以下为生产者所在的cache line */
+    /** Index of head. 自由增长的写入计数，只由生产者修改。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t head_index;
+    /** 生产者缓存的tail，只在空间看起来不足时才重新读取tail_index。 */
+    ring_buffer_size_t cached_tail;
+    /** ring_buffer_queue_wait的自适应自旋次数，见ringbuffer_wait.h。 */
+    uint32_t producer_spin;
+    /** 按溢出策略被丢弃（覆盖或截断）的累计字节数，只由生产者修改，其他进程可以随时读取。 */
+    _Atomic uint64_t dropped_bytes;
+    /** 发生过丢弃的写入次数，每次写入调用（或每条消息）最多计一次。 */
+    _Atomic uint64_t dropped_msgs;
+    /** 文件映射的队列最近一次ring_buffer_sync时的head，之后写入的数据尚未落盘。 */
+    ring_buffer_size_t synced_head;
+
+    /* 以下为消费者所在的cache line */
+    /** Index of tail. 自由增长的读出计数，只由消费者修改（覆盖写入的普通接口除外）。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t tail_index;
+    /** 消费者缓存的head，只在数据看起来不足时才重新读取head_index。 */
+    ring_buffer_size_t cached_head;
+    /** ring_buffer_dequeue_wait的自适应自旋次数，见ringbuffer_wait.h。 */
+    uint32_t consumer_spin;
+
+    /*
+     * 以下为阻塞等待使用的futex字，单独占一个cache line。
+     * 只有等待者睡眠前才会修改，平时双方只读，不会在生产者和消费者之间来回迁移。
+     */
+    /** 消费者等待数据时睡眠的futex字，生产者唤醒时加一。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic uint32_t data_futex;
+    /** 正在等待数据的消费者个数，为0时生产者不发起唤醒。 */
+    _Atomic uint32_t data_waiters;
+    /** 生产者等待空间时睡眠的futex字，消费者唤醒时加一。 */
+    _Atomic uint32_t space_futex;
+    /** 正在等待空间的生产者个数，为0时消费者不发起唤醒。 */
+    _Atomic uint32_t space_waiters;
+
+#if RING_BUFFER_STATS
+    /*
+     * 以下为统计计数，生产者和消费者各自只修改自己的一组，分别放在不同的cache line上。
+     * 计数使用relaxed原子读写，其他进程可以通过ring_buffer_get_stats随时读取。
+     */
+    /** 写入的字节数。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic uint64_t stat_enqueued_bytes;
+    /** 写入的次数（零拷贝接口为提交次数，消息层即消息条数）。 */
+    _Atomic uint64_t stat_enqueued_records;
+    /** 写入之后生产者看到的最大数据量。 */
+    _Atomic uint64_t stat_high_water;
+    /** 因空间不足而没有完整写入的次数。 */
+    _Atomic uint64_t stat_full_hits;
+    /** 覆盖了旧数据的写入次数。 */
+    _Atomic uint64_t stat_overwrites;
+    /** 写入长度的log2直方图。 */
+    _Atomic uint64_t stat_enqueue_hist[RING_BUFFER_STATS_BUCKETS];
+
+    /** 读出的字节数。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic uint64_t stat_dequeued_bytes;
+    /** 读出的次数。 */
+    _Atomic uint64_t stat_dequeued_records;
+    /** 读取时队列为空的次数。 */
+    _Atomic uint64_t stat_empty_hits;
+    /** 读出长度的log2直方图。 */
+    _Atomic uint64_t stat_dequeue_hist[RING_BUFFER_STATS_BUCKETS];
+#endif
 };
 
+/**
+ * ring_buffer_get_stats返回的统计快照。
+ * 各个计数分别读取，彼此之间不保证是同一时刻的值。
+ */
+typedef struct ring_buffer_stats_t
+{
+    /** 队列容量。 */
+    uint64_t capacity;
+    /** 读取快照时队列中的数据量。 */
+    uint64_t num_items;
+    /** 写入的字节数。 */
+    uint64_t enqueued_bytes;
+    /** 写入的次数。 */
+    uint64_t enqueued_records;
+    /** 读出的字节数。 */
+    uint64_t dequeued_bytes;
+    /** 读出的次数。 */
+    uint64_t dequeued_records;
+    /** 最大数据量。 */
+    uint64_t high_water;
+    /** 写入时空间不足的次数。 */
+    uint64_t full_hits;
+    /** 读取时队列为空的次数。 */
+    uint64_t empty_hits;
+    /** 覆盖了旧数据的写入次数。 */
+    uint64_t overwrites;
+    /** 按溢出策略丢弃的字节数，同ring_buffer_dropped_bytes。 */
+    uint64_t dropped_bytes;
+    /** 发生丢弃的写入次数，同ring_buffer_dropped_msgs。 */
+    uint64_t dropped_msgs;
+    /** 写入长度的log2直方图。 */
+    uint64_t enqueue_hist[RING_BUFFER_STATS_BUCKETS];
+    /** 读出长度的log2直方图。 */
+    uint64_t dequeue_hist[RING_BUFFER_STATS_BUCKETS];
+} ring_buffer_stats_t;
+
+/**
+ * 零拷贝接口返回的一段连续内存。
+ */
+typedef struct ring_buffer_span_t
+{
+    /** 内存段首地址 */
+    char *data;
+    /** 内存段长度，0表示该段不存在 */
+    ring_buffer_size_t len;
+} ring_buffer_span_t;
+
+/**
+ * @brief 返回队列数组在当前进程中的地址。
+ * @param buffer The ring buffer.
+ * @return 数组首地址。
+ */
+static inline char *ring_buffer_data(const ring_buffer_t *buffer)
+{
+    return (char *)buffer + buffer->data_offset;
+}
+
+/**
+ * @brief 计数器index向后移动n（n不超过容量）之后的值。
+ * 跨过数组末尾时多加index_gap（条件加法，没有除法），2的整数幂次容量时index_gap为0，即index + n。
+ * @param buffer The ring buffer.
+ * @param index - head/tail计数器或其他由它们推算出的位置。
+ * @param n - 移动的字节数。
+ * @return 新的计数器值。
+ */
+static inline ring_buffer_size_t ring_buffer_advance(const ring_buffer_t *buffer, ring_buffer_size_t index,
+                                                     ring_buffer_size_t n)
+{
+    ring_buffer_size_t next = index + n;
+    if ((index & buffer->index_mask) + n >= buffer->buffer_cap)
+    {
+        next += buffer->index_gap;
+    }
+    return next;
+}
+
+/**
+ * @brief 两个计数器之间的字节数（head在tail之后且相距不超过容量）。
+ * 两者圈数不同时减去一次index_gap。
+ * @param buffer The ring buffer.
+ * @param head - 较新的计数器。
+ * @param tail - 较旧的计数器。
+ * @return head - tail对应的字节数。
+ */
+static inline ring_buffer_size_t ring_buffer_distance(const ring_buffer_t *buffer, ring_buffer_size_t head,
+                                                      ring_buffer_size_t tail)
+{
+    ring_buffer_size_t d = head - tail;
+    if ((head ^ tail) > buffer->index_mask)
+    {
+        d -= buffer->index_gap;
+    }
+    return d;
+}
+
 /**
  * Initializes the ring buffer pointed to by <em>buffer</em>.
  * This function can also be used to empty/reset the buffer.
@@ -69,10 +318,10 @@ void ring_buffer_init(ring_buffer_t *buffer);
  * @brief 计算需要分配给ring_buffer_t结构体的内存大小，以sizeof(char)为单位。
  * 返回值是可以容纳length个char的最小2的整数次幂 + ring_buffer_t结构体大小。
  * @param length - 需要ring_buffer环形队列容纳的容量大小,以sizeof(char)为单位。。
- * @return 需要分配的内存大小，以sizeof(char)为单位。
+ * @return 需要分配的内存大小，以sizeof(char)为单位；length超过RING_BUFFER_SIZE时返回0。
  *
  */
-ring_buffer_size_t ring_buffer_calc_size(size_t length);
+size_t ring_buffer_calc_size(size_t length);
 
 /**
  * 初始化ring_buffer结构体，并返回该结构体对象的地址。
@@ -84,6 +333,32 @@ ring_buffer_size_t ring_buffer_calc_size(size_t length);
  */
 ring_buffer_t *ring_buffer_new(ring_buffer_size_t buffer_length);
 
+/**
+ * @brief 与ring_buffer_new相同，同时指定普通写入接口的溢出策略。
+ * @param buffer_length 申请分配队列的大小，规则与ring_buffer_new相同。
+ * @param policy 溢出策略，ring_buffer_new使用RING_BUFFER_OVERWRITE。
+ * @return 初始化完成的ring_buffer_t结构体对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_new_policy(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy);
+
+/**
+ * @brief 与ring_buffer_calc_size相同，但容量只向上取整到RING_BUFFER_EXACT_ALIGN的倍数，不取2的整数次幂。
+ * @param length - 需要ring_buffer环形队列容纳的容量大小。
+ * @return 需要分配的内存大小；length为0或超过RING_BUFFER_SIZE时返回0。
+ */
+size_t ring_buffer_calc_size_exact(size_t length);
+
+/**
+ * @brief 分配容量不取2的整数次幂的队列，容量为buffer_length向上取整到RING_BUFFER_EXACT_ALIGN的倍数。
+ * 计数器依然自由增长，数组下标依然是index & index_mask，只在跨过数组末尾时多做一次条件加法，
+ * 读写路径上没有除法和取模。容量恰好是2的整数次幂时与ring_buffer_new_policy完全相同。
+ * 所有读写接口、零拷贝接口、消息层和阻塞等待都可以使用，使用ring_buffer_destroy释放。
+ * @param buffer_length 队列容量，不超过RING_BUFFER_SIZE。
+ * @param policy 溢出策略。
+ * @return 初始化完成的ring_buffer_t结构体对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_new_exact(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy);
+
 /**
  * @brief 销毁不再使用的队列对象。
  * @param buffer 将要销毁的ring_buffer_t对象指针的地址，请注意这是一个二级指针，需要传递结构体指针的地址。
@@ -96,29 +371,68 @@ void ring_buffer_destroy(ring_buffer_t **buffer);
 
 /**
  * @brief 使用传入的内存块初始化ring_buffer_t并返回该结构体实例地址。
- * 此函数需传入已经分配好的内存块。 * 该内存块大小应使用ring_buffer_alloc_calculate函数计算获得。
+ * 此函数需传入已经分配好的内存块。 * 该内存块大小应使用ring_buffer_calc_size函数计算获得。
  * 此函数的典型使用场景是进程间使用共享内存方式通信，并在分配好的共享内存中放置环形队列。
+ * 注意此函数会写入头部并清空队列，只应由创建者调用一次；其他进程请使用ring_buffer_open。
  * @param addr - 已经分配好的地址空间首地址，无类型指针。
- * @param length - 环形队列的长度。
+ * @param length - 内存块的长度，即ring_buffer_calc_size或ring_buffer_calc_size_exact的返回值，
+ * 数组长度不是2的整数次幂时按RING_BUFFER_EXACT_ALIGN向下取整并设置RING_BUFFER_FLAG_EXACT。
  * @return 返回初始化好的ring_buffer对象地址。
  */
-ring_buffer_t *ring_buffer_attach(void *addr, ring_buffer_size_t length);
+ring_buffer_t *ring_buffer_attach(void *addr, size_t length);
+
+/**
+ * @brief 与ring_buffer_attach相同，同时指定普通写入接口的溢出策略。
+ * @param addr - 已经分配好的地址空间首地址。
+ * @param length - 内存块的长度，即ring_buffer_calc_size的返回值。
+ * @param policy - 溢出策略，ring_buffer_attach使用RING_BUFFER_OVERWRITE。
+ * @return 返回初始化好的ring_buffer对象地址，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_attach_policy(void *addr, size_t length, ring_buffer_overflow_t policy);
+
+/**
+ * @brief 使用单独分配的数组初始化队列头部，供自定义的内存分配方式使用。
+ * 数组地址同样只以相对addr的偏移保存，因此跨进程使用时两者需要位于同一块映射内。
+ * @param addr - 存放ring_buffer_t头部的内存，至少sizeof(ring_buffer_t)字节，按cache line对齐。
+ * @param array - 队列数组首地址。
+ * @param buffer_cap - 数组长度，必须是2的整数次幂且不超过RING_BUFFER_SIZE；
+ * flags中带RING_BUFFER_FLAG_EXACT时可以是任意RING_BUFFER_EXACT_ALIGN的倍数。
+ * @param flags - RING_BUFFER_FLAG_*，溢出策略（ring_buffer_overflow_t）也放在这里。
+ * @return 返回初始化好的ring_buffer对象地址，参数错误返回NULL。
+ */
+ring_buffer_t *ring_buffer_attach_array(void *addr, char *array, ring_buffer_size_t buffer_cap, uint16_t flags);
+
+/**
+ * @brief 打开一块已经由ring_buffer_attach初始化过的内存，校验头部但不重置队列。
+ * 校验内容包括magic、版本、元素大小、容量以及数组是否落在内存块内。
+ * 由于只保存偏移，内存块在不同进程中映射到不同地址都可以正常使用。
+ * @param addr - 已映射的内存块首地址。
+ * @param length - 映射的内存块长度。
+ * @return 成功返回队列对象地址，校验失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_open(void *addr, size_t length);
 
 /**
  * Adds a byte to a ring buffer.
+ * 队列满时按溢出策略处理：默认覆盖最旧的数据（会修改tail），因此不能与另一线程中的消费者并发使用，
+ * 跨线程请使用ring_buffer_spsc_queue。
  * @param buffer The buffer in which the data should be placed.
  * @param data The byte to place.
+ * @return 1 - 已写入, 0 - 队列满，按策略拒绝或丢弃了这个字节。
  */
-void ring_buffer_queue(ring_buffer_t *buffer, char data);
+uint8_t ring_buffer_queue(ring_buffer_t *buffer, char data);
 
 /**
  * Adds an array of bytes to a ring buffer.
+ * 数据最多分两段memcpy写入（head到数组末尾、数组起始位置），只更新一次索引。
+ * 空间不足时按溢出策略处理：RING_BUFFER_OVERWRITE覆盖最旧的数据，size超过队列容量时失败；
+ * RING_BUFFER_REJECT整次失败；RING_BUFFER_DROP_NEWEST只写入能放下的前一部分。
  * @param buffer The buffer in which the data should be placed.
  * @param data A pointer to the array of bytes to place in the queue.
  * @param size The size of the array.
- * @return 1 - success, 0 - fail, exceed buffer size.
+ * @return 实际写入的字节数，失败返回0。
  */
-uint8_t ring_buffer_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size);
+ring_buffer_size_t ring_buffer_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size);
 
 /**
  * Returns the oldest byte in a ring buffer.
@@ -145,15 +459,140 @@ ring_buffer_size_t ring_buffer_dequeue_arr(ring_buffer_t *buffer, char *data, ri
  */
 uint8_t ring_buffer_peek(ring_buffer_t *buffer, char *data, ring_buffer_size_t index);
 
+/**
+ * @brief 返回按溢出策略被丢弃的累计字节数。
+ * @param buffer The buffer.
+ * @return 被覆盖的旧数据和被截断的新数据的字节数之和。
+ */
+uint64_t ring_buffer_dropped_bytes(ring_buffer_t *buffer);
+
+/**
+ * @brief 返回发生过丢弃的写入次数。
+ * @param buffer The buffer.
+ * @return 丢弃过数据的ring_buffer_queue/queue_arr调用次数（消息层为丢弃的消息条数）。
+ */
+uint64_t ring_buffer_dropped_msgs(ring_buffer_t *buffer);
+
+/**
+ * @brief 读取统计快照，可以在另一个线程或进程中调用。
+ * 以RING_BUFFER_STATS=0编译或队列头部不含统计字段时，只填写容量、数据量和丢弃计数，其余为0。
+ * @param buffer The buffer.
+ * @param stats 输出参数，统计快照。
+ */
+void ring_buffer_get_stats(ring_buffer_t *buffer, ring_buffer_stats_t *stats);
+
+/**
+ * @brief 单生产者/单消费者（SPSC）无锁接口。
+ * 一个线程（或进程）调用ring_buffer_spsc_queue*作为生产者，另一个线程调用
+ * ring_buffer_spsc_dequeue*作为消费者，二者之间无需加锁。
+ * head/tail使用acquire/release顺序发布，生产者和消费者各自缓存对端的索引，
+ * 只有在缓存值不够用时才读取对端的cache line。
+ * 与ring_buffer_queue不同，SPSC接口在队列满时不会覆盖旧数据。
+ * 普通接口也会维护缓存的索引，所以同一端可以先用普通接口再切换到SPSC接口。
+ */
+
+/**
+ * @brief 生产者写入一个字节。
+ * @param buffer The buffer in which the data should be placed.
+ * @param data The byte to place.
+ * @return 1 - success, 0 - buffer is full.
+ */
+uint8_t ring_buffer_spsc_queue(ring_buffer_t *buffer, char data);
+
+/**
+ * @brief 生产者写入一段数据，空间不足时只写入能容纳的部分。
+ * @param buffer The buffer in which the data should be placed.
+ * @param data A pointer to the array of bytes to place in the queue.
+ * @param size The size of the array.
+ * @return 实际写入的字节数。
+ */
+ring_buffer_size_t ring_buffer_spsc_queue_arr(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size);
+
+/**
+ * @brief 消费者读出一个字节。
+ * @param buffer The buffer from which the data should be returned.
+ * @param data A pointer to the location at which the data should be placed.
+ * @return 1 if data was returned; 0 otherwise.
+ */
+uint8_t ring_buffer_spsc_dequeue(ring_buffer_t *buffer, char *data);
+
+/**
+ * @brief 消费者读出最多len个字节。
+ * @param buffer The buffer from which the data should be returned.
+ * @param data A pointer to the array at which the data should be placed.
+ * @param len The maximum number of bytes to return.
+ * @return The number of bytes returned.
+ */
+ring_buffer_size_t ring_buffer_spsc_dequeue_arr(ring_buffer_t *buffer, char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 零拷贝接口。
+ * 生产者用ring_buffer_reserve借出可写的空间，直接在其中写入数据（例如read()/recv()），
+ * 然后调用ring_buffer_commit使其对消费者可见；消费者用ring_buffer_peek_spans借出可读的数据，
+ * 原地解析后调用ring_buffer_consume释放空间。
+ * 由于数组是环形的，借出的空间最多分为两段：spans[0]从当前位置到数组末尾，spans[1]从数组起始位置开始。
+ * 镜像映射的队列（ring_buffer_new_mirrored）总是只返回一段，spans[1].len为0。
+ * 与SPSC接口一样，生产者和消费者可以在不同线程（或进程）中并发使用，队列满时不会覆盖旧数据。
+ */
+
+/**
+ * @brief 生产者借出最多size字节的可写空间。
+ * @param buffer The buffer in which the data should be placed.
+ * @param size 希望借出的字节数。
+ * @param spans 输出参数，两段可写空间，未使用的段长度为0。
+ * @return 实际借出的字节数，等于spans[0].len + spans[1].len。
+ */
+ring_buffer_size_t ring_buffer_reserve(ring_buffer_t *buffer, ring_buffer_size_t size, ring_buffer_span_t spans[2]);
+
+/**
+ * @brief 提交前size个已写入的字节，使其对消费者可见。
+ * @param buffer The buffer in which the data has been placed.
+ * @param size 提交的字节数，不能超过最近一次ring_buffer_reserve借出的字节数。
+ * @return 1 - success, 0 - fail, size超过了可用空间。
+ */
+uint8_t ring_buffer_commit(ring_buffer_t *buffer, ring_buffer_size_t size);
+
+/**
+ * @brief 消费者借出当前所有可读的数据，不移动tail。
+ * @param buffer The buffer from which the data should be returned.
+ * @param spans 输出参数，两段可读数据，未使用的段长度为0。
+ * @return 可读的字节数，等于spans[0].len + spans[1].len。
+ */
+ring_buffer_size_t ring_buffer_peek_spans(ring_buffer_t *buffer, ring_buffer_span_t spans[2]);
+
+/**
+ * @brief 释放前size个已读的字节，生产者可以复用这段空间。
+ * @param buffer The buffer from which the data has been read.
+ * @param size 释放的字节数，不能超过最近一次ring_buffer_peek_spans返回的字节数。
+ * @return 1 - success, 0 - fail, size超过了可读数据。
+ */
+uint8_t ring_buffer_consume(ring_buffer_t *buffer, ring_buffer_size_t size);
+
 /**
  * Returns whether a ring buffer is empty.
  * @param buffer The buffer for which it should be returned whether it is empty.
  * @return 1 if empty; 0 otherwise.
  */
+uint8_t ring_buffer_is_empty(ring_buffer_t *buffer);
 
-inline uint8_t ring_buffer_is_empty(ring_buffer_t *buffer);
-inline uint8_t ring_buffer_is_full(ring_buffer_t *buffer);
-inline ring_buffer_size_t ring_buffer_num_items(ring_buffer_t *buffer);
-inline void ring_buffer_detach(ring_buffer_t **buffer);
+/**
+ * Returns whether a ring buffer is full.
+ * @param buffer The buffer for which it should be returned whether it is full.
+ * @return 1 if full; 0 otherwise.
+ */
+uint8_t ring_buffer_is_full(ring_buffer_t *buffer);
+
+/**
+ * Returns the number of items in a ring buffer.
+ * @param buffer The buffer for which the number of items should be returned.
+ * @return The number of items in the ring buffer.
+ */
+ring_buffer_size_t ring_buffer_num_items(ring_buffer_t *buffer);
+
+/**
+ * @brief 将共享内存结构体指针设置为NULL，与ring_buffer_attach配对使用。
+ * @param buffer - 需要解除引用的指针。请注意这是二级指针，需要传递结构体指针的地址。
+ */
+void ring_buffer_detach(ring_buffer_t **buffer);
 
 #endif /* RINGBUFFER_H */
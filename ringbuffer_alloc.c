@@ -0,0 +1,182 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "ringbuffer_alloc.h"
+
+/**
+ * @file
+ * 队列内存分配选项的实现。
+ *
+ * 映射布局：第一页只放头部，数组从第二页开始，映射长度为页大小 + 按页取整的容量。
+ * ring_buffer_destroy根据RING_BUFFER_FLAG_MAPPED和data_offset（即页大小）算出映射长度并munmap。
+ */
+
+// mbind支持的最大节点编号。
+#define RING_BUFFER_MAX_NODES 1024
+
+/**
+ * 系统默认的大页大小（/proc/meminfo中的Hugepagesize），读取失败时按2MB。
+ */
+static size_t ring_buffer_huge_page_size(void)
+{
+    char line[128];
+    unsigned long kb = 0;
+    FILE *fp = fopen("/proc/meminfo", "r");
+
+    if (fp != NULL)
+    {
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            if (sscanf(line, "Hugepagesize: %lu kB", &kb) == 1)
+            {
+                break;
+            }
+        }
+        fclose(fp);
+    }
+    return kb != 0 ? kb * 1024 : 2UL * 1024 * 1024;
+}
+
+/**
+ * 分配起始地址按align对齐的匿名映射：多映射一个align再裁掉首尾。
+ */
+static void *ring_buffer_map_aligned(size_t length, size_t align)
+{
+    char *base = mmap(NULL, length + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    char *addr;
+
+    if (base == MAP_FAILED)
+    {
+        return MAP_FAILED;
+    }
+
+    addr = (char *)(((uintptr_t)base + align - 1) & ~(uintptr_t)(align - 1));
+    if (addr != base)
+    {
+        munmap(base, addr - base);
+    }
+    munmap(addr + length, base + align - addr);
+    return addr;
+}
+
+/**
+ * 把[addr, addr + length)绑定到节点node，之后的缺页只从该节点分配。
+ */
+static int ring_buffer_bind_node(void *addr, size_t length, int node)
+{
+    unsigned long mask[RING_BUFFER_MAX_NODES / (8 * sizeof(unsigned long))];
+
+    if (node < 0 || node >= RING_BUFFER_MAX_NODES)
+    {
+        fprintf(stderr, "%s -- numa node %d out of range.\n", __func__, node);
+        return 0;
+    }
+
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_mbind, addr, length, MPOL_BIND, mask, RING_BUFFER_MAX_NODES + 1, 0) != 0)
+    {
+        fprintf(stderr, "%s -- mbind node %d failed:%s\n", __func__, node, strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+ring_buffer_t *ring_buffer_new_opts(ring_buffer_size_t buffer_length, const ring_buffer_alloc_opts_t *opts)
+{
+    ring_buffer_alloc_opts_t defaults = {0, 0, RING_BUFFER_OVERWRITE};
+    size_t alloc_length;
+    size_t base_page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t page = base_page, cap, length, touch, off;
+    ring_buffer_t *buffer;
+    uint16_t flags = RING_BUFFER_FLAG_MAPPED;
+    char *addr = MAP_FAILED;
+
+    if (opts == NULL)
+    {
+        opts = &defaults;
+    }
+    if (opts->flags & RING_BUFFER_ALLOC_EXACT)
+    {
+        alloc_length = ring_buffer_calc_size_exact(buffer_length);
+        flags |= RING_BUFFER_FLAG_EXACT | RING_BUFFER_FLAG_EXACT_SIZE;
+    }
+    else
+    {
+        alloc_length = ring_buffer_calc_size(buffer_length);
+    }
+    if (alloc_length == 0)
+    {
+        return NULL;
+    }
+    if (((uint32_t)opts->policy & ~(uint32_t)RING_BUFFER_FLAG_OVERFLOW_MASK) != 0)
+    {
+        fprintf(stderr, "%s -- invalid overflow policy %d.\n", __func__, (int)opts->policy);
+        return NULL;
+    }
+
+    cap = alloc_length - sizeof(ring_buffer_t);
+    if (opts->flags & (RING_BUFFER_ALLOC_HUGETLB | RING_BUFFER_ALLOC_THP))
+    {
+        page = ring_buffer_huge_page_size();
+    }
+    length = page + (cap + page - 1) / page * page;
+
+    if (opts->flags & RING_BUFFER_ALLOC_HUGETLB)
+    {
+        addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (addr == MAP_FAILED)
+        {
+            fprintf(stderr, "%s -- MAP_HUGETLB failed:%s, fall back to transparent huge pages.\n", __func__,
+                    strerror(errno));
+        }
+        else
+        {
+            flags |= RING_BUFFER_FLAG_HUGETLB;
+        }
+    }
+    if (addr == MAP_FAILED)
+    {
+        addr = ring_buffer_map_aligned(length, page);
+        if (addr == MAP_FAILED)
+        {
+            fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+            return NULL;
+        }
+        //透明大页只是建议，内核不支持或被禁用时依然使用普通页。
+        if (page != base_page && madvise(addr + page, length - page, MADV_HUGEPAGE) != 0)
+        {
+            fprintf(stderr, "%s -- madvise(MADV_HUGEPAGE) failed:%s\n", __func__, strerror(errno));
+        }
+    }
+
+    if ((opts->flags & RING_BUFFER_ALLOC_BIND_NODE) && !ring_buffer_bind_node(addr, length, opts->numa_node))
+    {
+        munmap(addr, length);
+        return NULL;
+    }
+
+    if (opts->flags & RING_BUFFER_ALLOC_PREFAULT)
+    {
+        //透明大页可能分配失败而退回普通页，按普通页的步长写入才能保证每一页都已分配。
+        touch = (flags & RING_BUFFER_FLAG_HUGETLB) ? page : base_page;
+        for (off = 0; off < length; off += touch)
+        {
+            ((volatile char *)addr)[off] = 0;
+        }
+    }
+
+    buffer = ring_buffer_attach_array(addr, addr + page, (ring_buffer_size_t)cap, flags | (uint16_t)opts->policy);
+    if (buffer == NULL)
+    {
+        munmap(addr, length);
+    }
+    return buffer;
+}
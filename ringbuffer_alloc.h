@@ -0,0 +1,52 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 大容量队列的内存分配选项（Linux）：页对齐、大页、NUMA节点绑定和预先缺页。
+ *
+ * ring_buffer_new使用posix_memalign，大队列的每个4KB页都要占用一个TLB项，
+ * 并且物理内存落在哪个节点取决于谁先访问。ring_buffer_new_opts改用mmap分配：
+ * 头部单独占一页，数组从页边界开始；可以请求大页，把内存绑定到指定的NUMA节点，
+ * 并在返回前访问每一页，热路径上不再发生缺页。
+ *
+ * 得到的队列与普通队列完全相同，使用ring_buffer_destroy释放。
+ * 头部的flags中RING_BUFFER_FLAG_MAPPED表示由本函数分配，RING_BUFFER_FLAG_HUGETLB表示实际使用了
+ * MAP_HUGETLB大页（请求的大页不可用时会退回到透明大页，这个标志不会设置）。
+ */
+
+#ifndef RINGBUFFER_ALLOC_H
+#define RINGBUFFER_ALLOC_H
+
+// ring_buffer_alloc_opts_t.flags：使用MAP_HUGETLB大页（需要预留大页），不可用时退回到RING_BUFFER_ALLOC_THP。
+#define RING_BUFFER_ALLOC_HUGETLB 0x0001
+// ring_buffer_alloc_opts_t.flags：按大页大小对齐，并用madvise(MADV_HUGEPAGE)请求透明大页。
+#define RING_BUFFER_ALLOC_THP 0x0002
+// ring_buffer_alloc_opts_t.flags：返回前写入每一页，使物理内存提前分配（绑定节点时分配在该节点上）。
+#define RING_BUFFER_ALLOC_PREFAULT 0x0004
+// ring_buffer_alloc_opts_t.flags：容量按ring_buffer_new_exact的规则取整，不取2的整数次幂。
+#define RING_BUFFER_ALLOC_EXACT 0x0008
+// ring_buffer_alloc_opts_t.flags：把内存绑定到numa_node指定的节点，未设置时不绑定。
+#define RING_BUFFER_ALLOC_BIND_NODE 0x0010
+
+/**
+ * ring_buffer_new_opts的分配选项，全部清零即为4KB页、不绑定节点、不预先缺页、RING_BUFFER_OVERWRITE。
+ */
+typedef struct ring_buffer_alloc_opts_t
+{
+    /** RING_BUFFER_ALLOC_*的组合。 */
+    uint32_t flags;
+    /** 设置RING_BUFFER_ALLOC_BIND_NODE时绑定的NUMA节点；未设置时忽略，按首次访问的线程所在节点分配。 */
+    int numa_node;
+    /** 普通写入接口的溢出策略。 */
+    ring_buffer_overflow_t policy;
+} ring_buffer_alloc_opts_t;
+
+/**
+ * @brief 按分配选项创建队列。
+ * @param buffer_length 申请分配队列的大小，规则与ring_buffer_new相同。
+ * @param opts 分配选项，NULL等同于全部清零。
+ * @return 初始化完成的ring_buffer_t结构体对象，失败（包括绑定的NUMA节点无效）返回NULL。
+ */
+ring_buffer_t *ring_buffer_new_opts(ring_buffer_size_t buffer_length, const ring_buffer_alloc_opts_t *opts);
+
+#endif /* RINGBUFFER_ALLOC_H */
@@ -0,0 +1,514 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ringbuffer_bcast.h"
+
+/**
+ * @file
+ * 广播队列的实现。
+ *
+ * 受限策略（REJECT/DROP_NEWEST）下生产者把最慢读者的位置缓存在ring.cached_tail中，
+ * 只在空间看起来不足时才重新扫描读者表。读者加入时先发布state再读取head，
+ * 生产者扫描读者表之前执行一次seq_cst fence：两者至少有一方看到对方，
+ * 生产者要么看到这个读者，要么读者读到的head不早于生产者缓存的位置，数据不会在读者读到之前被覆盖。
+ */
+
+// 读者表项的状态。
+#define RING_BUFFER_BCAST_FREE 0
+#define RING_BUFFER_BCAST_JOINING 1
+#define RING_BUFFER_BCAST_ACTIVE 2
+
+/**
+ * 计数器newer是否已经比cursor超前一圈以上（cursor处的数据已经或正在被覆盖）。
+ * 相距不超过一圈时两者之差不超过index_mask + 1，见ring_buffer_distance。
+ */
+static inline int ring_buffer_bcast_behind(const ring_buffer_t *ring, ring_buffer_size_t newer,
+                                           ring_buffer_size_t cursor)
+{
+    return (ring_buffer_size_t)(newer - cursor) > ring->index_mask + 1;
+}
+
+/**
+ * 两个计数器之间的字节数，相距可以超过一圈：减去期间跨过数组末尾的次数乘以index_gap。
+ */
+static uint64_t ring_buffer_bcast_span(const ring_buffer_t *ring, ring_buffer_size_t from, ring_buffer_size_t to)
+{
+    ring_buffer_size_t raw = to - from;
+    uint64_t laps;
+
+    if (ring->index_gap == 0)
+    {
+        return raw;
+    }
+    //from的低位加上差值后右移即跨过的圈数，计数器回绕时同样成立；只在读者丢失数据时调用。
+    laps = (ring_buffer_size_t)(raw + (from & ring->index_mask)) / ((uint64_t)ring->index_mask + 1);
+    return raw - laps * ring->index_gap;
+}
+
+/**
+ * 校验读者编号，返回已加入的读者表项。
+ */
+static ring_buffer_bcast_reader_t *ring_buffer_bcast_reader(ring_buffer_bcast_t *bcast, int reader,
+                                                           const char *caller)
+{
+    if (reader < 0 || reader >= RING_BUFFER_BCAST_MAX_READERS ||
+        atomic_load_explicit(&bcast->readers[reader].state, memory_order_relaxed) != RING_BUFFER_BCAST_ACTIVE)
+    {
+        fprintf(stderr, "%s -- reader %d has not joined.\n", caller, reader);
+        return NULL;
+    }
+    return &bcast->readers[reader];
+}
+
+/**
+ * 读者被覆盖：跳到to，累加丢失的字节数。
+ */
+static void ring_buffer_bcast_skip(ring_buffer_bcast_t *bcast, ring_buffer_bcast_reader_t *r,
+                                   ring_buffer_size_t cursor, ring_buffer_size_t to)
+{
+    uint64_t lost = ring_buffer_bcast_span(&bcast->ring, cursor, to);
+
+    atomic_store_explicit(&r->lost_bytes, atomic_load_explicit(&r->lost_bytes, memory_order_relaxed) + lost,
+                          memory_order_relaxed);
+    atomic_store_explicit(&r->lapped, atomic_load_explicit(&r->lapped, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    r->cached_head = to;
+    atomic_store_explicit(&r->cursor, to, memory_order_release);
+}
+
+/**
+ * 覆盖策略下检查拷贝期间cursor处的数据是否被覆盖，被覆盖时跳到当前的head。
+ * @return 1 - 数据有效，0 - 已被覆盖。
+ */
+static int ring_buffer_bcast_validate(ring_buffer_bcast_t *bcast, ring_buffer_bcast_reader_t *r,
+                                      ring_buffer_size_t cursor)
+{
+    ring_buffer_size_t claim;
+
+    if ((bcast->ring.flags & RING_BUFFER_FLAG_OVERFLOW_MASK) != RING_BUFFER_OVERWRITE)
+    {
+        return 1;
+    }
+
+    //与生产者写入数据之前的release fence配对：读到了被覆盖的字节，就一定能读到相应的claim。
+    atomic_thread_fence(memory_order_acquire);
+    claim = atomic_load_explicit(&bcast->claim, memory_order_relaxed);
+    if (!ring_buffer_bcast_behind(&bcast->ring, claim, cursor))
+    {
+        return 1;
+    }
+    ring_buffer_bcast_skip(bcast, r, cursor, atomic_load_explicit(&bcast->ring.head_index, memory_order_acquire));
+    return 0;
+}
+
+/**
+ * 扫描读者表，返回最慢读者的位置，没有读者时返回head。
+ * 读者的位置落后超过一圈说明它正在加入，写入的是加入前的旧值，此时不留出任何空间。
+ */
+static ring_buffer_size_t ring_buffer_bcast_slowest(ring_buffer_bcast_t *bcast, ring_buffer_size_t head)
+{
+    ring_buffer_t *ring = &bcast->ring;
+    ring_buffer_size_t slowest = head, cursor, max_items = 0, items;
+    int i;
+
+    //与ring_buffer_bcast_join中的seq_cst读写配对，见文件说明。
+    atomic_thread_fence(memory_order_seq_cst);
+    for (i = 0; i < RING_BUFFER_BCAST_MAX_READERS; i++)
+    {
+        if (atomic_load_explicit(&bcast->readers[i].state, memory_order_acquire) != RING_BUFFER_BCAST_ACTIVE)
+        {
+            continue;
+        }
+        cursor = atomic_load_explicit(&bcast->readers[i].cursor, memory_order_acquire);
+        if (ring_buffer_bcast_behind(ring, head, cursor))
+        {
+            //返回距离head正好一圈的位置，剩余空间为0。
+            return head - (ring->index_mask + 1);
+        }
+        items = ring_buffer_distance(ring, head, cursor);
+        if (items > max_items)
+        {
+            max_items = items;
+            slowest = cursor;
+        }
+    }
+    return slowest;
+}
+
+size_t ring_buffer_bcast_calc_size(size_t length)
+{
+    size_t alloc_length = ring_buffer_calc_size(length);
+
+    if (alloc_length == 0)
+    {
+        return 0;
+    }
+    return alloc_length - sizeof(ring_buffer_t) + sizeof(ring_buffer_bcast_t);
+}
+
+ring_buffer_bcast_t *ring_buffer_bcast_attach(void *addr, size_t length, ring_buffer_overflow_t policy)
+{
+    ring_buffer_bcast_t *bcast = addr;
+    uint16_t flags = RING_BUFFER_FLAG_BCAST | (uint16_t)policy;
+    size_t cap;
+    int i;
+
+    if (addr == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr is NULL.\n", __func__);
+        return NULL;
+    }
+    if (((uint32_t)policy & ~(uint32_t)RING_BUFFER_FLAG_OVERFLOW_MASK) != 0)
+    {
+        fprintf(stderr, "%s -- invalid overflow policy %d.\n", __func__, (int)policy);
+        return NULL;
+    }
+    if (length <= sizeof(ring_buffer_bcast_t))
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_bcast_t.\n", __func__);
+        return NULL;
+    }
+
+    cap = length - sizeof(ring_buffer_bcast_t);
+    if ((cap & (cap - 1)) != 0)
+    {
+        //不是ring_buffer_bcast_calc_size得到的长度，按任意容量使用。
+        cap -= cap % RING_BUFFER_EXACT_ALIGN;
+        flags |= RING_BUFFER_FLAG_EXACT;
+    }
+    if (cap == 0 || cap > RING_BUFFER_SIZE)
+    {
+        fprintf(stderr, "%s -- buffer_cap must be 1..RING_BUFFER_SIZE.\n", __func__);
+        return NULL;
+    }
+
+    atomic_store_explicit(&bcast->claim, 0, memory_order_relaxed);
+    for (i = 0; i < RING_BUFFER_BCAST_MAX_READERS; i++)
+    {
+        atomic_store_explicit(&bcast->readers[i].cursor, 0, memory_order_relaxed);
+        atomic_store_explicit(&bcast->readers[i].state, RING_BUFFER_BCAST_FREE, memory_order_relaxed);
+        atomic_store_explicit(&bcast->readers[i].lost_bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&bcast->readers[i].lapped, 0, memory_order_relaxed);
+        bcast->readers[i].cached_head = 0;
+    }
+
+    //magic在ring_buffer_attach_array中最后写入，读者表此时已经初始化完成。
+    if (ring_buffer_attach_array(addr, (char *)addr + sizeof(ring_buffer_bcast_t), (ring_buffer_size_t)cap, flags) ==
+        NULL)
+    {
+        return NULL;
+    }
+    return bcast;
+}
+
+ring_buffer_bcast_t *ring_buffer_bcast_new(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy)
+{
+    size_t alloc_length = ring_buffer_bcast_calc_size(buffer_length);
+    ring_buffer_bcast_t *bcast;
+    int err;
+
+    if (alloc_length == 0)
+    {
+        return NULL;
+    }
+
+    err = posix_memalign((void **)&bcast, RING_BUFFER_CACHE_LINE, alloc_length);
+    if (err != 0)
+    {
+        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(err));
+        return NULL;
+    }
+
+    if (ring_buffer_bcast_attach(bcast, alloc_length, policy) == NULL)
+    {
+        free(bcast);
+        return NULL;
+    }
+    return bcast;
+}
+
+void ring_buffer_bcast_destroy(ring_buffer_bcast_t **bcast)
+{
+    if (*bcast == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_bcast_t ptr is NULL.\n", __func__);
+        return;
+    }
+    free(*bcast);
+    *bcast = NULL;
+}
+
+ring_buffer_bcast_t *ring_buffer_bcast_open(void *addr, size_t length)
+{
+    ring_buffer_t *ring = ring_buffer_open(addr, length);
+
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+    if (!(ring->flags & RING_BUFFER_FLAG_BCAST) || ring->data_offset < (int64_t)sizeof(ring_buffer_bcast_t))
+    {
+        fprintf(stderr, "%s -- memory block is not a broadcast ring buffer.\n", __func__);
+        return NULL;
+    }
+    return (ring_buffer_bcast_t *)ring;
+}
+
+ring_buffer_size_t ring_buffer_bcast_write(ring_buffer_bcast_t *bcast, const char *data, ring_buffer_size_t size)
+{
+    ring_buffer_t *ring = &bcast->ring;
+    ring_buffer_size_t head = atomic_load_explicit(&ring->head_index, memory_order_relaxed);
+    uint16_t policy = ring->flags & RING_BUFFER_FLAG_OVERFLOW_MASK;
+    ring_buffer_size_t space, index, first;
+    char *array = ring_buffer_data(ring);
+
+    if (policy == RING_BUFFER_OVERWRITE)
+    {
+        if (size > ring->buffer_cap)
+        {
+            fprintf(stderr, "%s -- size exceed buffer capacity.\n", __func__);
+            return 0;
+        }
+        //先发布claim，再写入数据，读者拷贝之后据此判断数据是否被覆盖。
+        atomic_store_explicit(&bcast->claim, ring_buffer_advance(ring, head, size), memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    else
+    {
+        space = ring->buffer_cap - ring_buffer_distance(ring, head, ring->cached_tail);
+        if (space < size)
+        {
+            ring->cached_tail = ring_buffer_bcast_slowest(bcast, head);
+            space = ring->buffer_cap - ring_buffer_distance(ring, head, ring->cached_tail);
+        }
+        if (space < size)
+        {
+            if (policy == RING_BUFFER_REJECT)
+            {
+                return 0;
+            }
+            atomic_store_explicit(&ring->dropped_bytes,
+                                  atomic_load_explicit(&ring->dropped_bytes, memory_order_relaxed) + (size - space),
+                                  memory_order_relaxed);
+            atomic_store_explicit(&ring->dropped_msgs,
+                                  atomic_load_explicit(&ring->dropped_msgs, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            size = space;
+        }
+    }
+
+    index = head & ring->index_mask;
+    first = ring->buffer_cap - index;
+    if (first >= size)
+    {
+        memcpy(array + index, data, size);
+    }
+    else
+    {
+        memcpy(array + index, data, first);
+        memcpy(array, data + first, size - first);
+    }
+
+    atomic_store_explicit(&ring->head_index, ring_buffer_advance(ring, head, size), memory_order_release);
+    return size;
+}
+
+int ring_buffer_bcast_join(ring_buffer_bcast_t *bcast)
+{
+    ring_buffer_bcast_reader_t *r;
+    ring_buffer_size_t head;
+    uint32_t expected;
+    int i;
+
+    for (i = 0; i < RING_BUFFER_BCAST_MAX_READERS; i++)
+    {
+        r = &bcast->readers[i];
+        expected = RING_BUFFER_BCAST_FREE;
+        if (!atomic_compare_exchange_strong_explicit(&r->state, &expected, RING_BUFFER_BCAST_JOINING,
+                                                     memory_order_acquire, memory_order_relaxed))
+        {
+            continue;
+        }
+
+        atomic_store_explicit(&r->lost_bytes, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->lapped, 0, memory_order_relaxed);
+        atomic_store_explicit(&r->cursor, atomic_load_explicit(&bcast->ring.head_index, memory_order_acquire),
+                              memory_order_relaxed);
+        //先发布state再读取head，与ring_buffer_bcast_slowest中的fence配对。
+        atomic_store_explicit(&r->state, RING_BUFFER_BCAST_ACTIVE, memory_order_seq_cst);
+        head = atomic_load_explicit(&bcast->ring.head_index, memory_order_seq_cst);
+        r->cached_head = head;
+        atomic_store_explicit(&r->cursor, head, memory_order_release);
+        return i;
+    }
+
+    fprintf(stderr, "%s -- no free reader slot (max %d).\n", __func__, RING_BUFFER_BCAST_MAX_READERS);
+    return -1;
+}
+
+void ring_buffer_bcast_leave(ring_buffer_bcast_t *bcast, int reader)
+{
+    if (ring_buffer_bcast_reader(bcast, reader, __func__) == NULL)
+    {
+        return;
+    }
+    atomic_store_explicit(&bcast->readers[reader].state, RING_BUFFER_BCAST_FREE, memory_order_release);
+}
+
+/**
+ * 读者可读的字节数：先看缓存的head，不足need时重新读取head_index；被超过一圈时跳到head。
+ */
+static ring_buffer_size_t ring_buffer_bcast_items(ring_buffer_bcast_t *bcast, ring_buffer_bcast_reader_t *r,
+                                                 ring_buffer_size_t cursor, ring_buffer_size_t need)
+{
+    ring_buffer_t *ring = &bcast->ring;
+    ring_buffer_size_t items = ring_buffer_distance(ring, r->cached_head, cursor);
+
+    if (items < need)
+    {
+        r->cached_head = atomic_load_explicit(&ring->head_index, memory_order_acquire);
+        if (ring_buffer_bcast_behind(ring, r->cached_head, cursor))
+        {
+            ring_buffer_bcast_skip(bcast, r, cursor, r->cached_head);
+            return 0;
+        }
+        items = ring_buffer_distance(ring, r->cached_head, cursor);
+    }
+    return items;
+}
+
+ring_buffer_size_t ring_buffer_bcast_read(ring_buffer_bcast_t *bcast, int reader, char *data, ring_buffer_size_t len)
+{
+    ring_buffer_bcast_reader_t *r = ring_buffer_bcast_reader(bcast, reader, __func__);
+    ring_buffer_t *ring = &bcast->ring;
+    ring_buffer_size_t cursor, items, index, first;
+    const char *array = ring_buffer_data(ring);
+
+    if (r == NULL)
+    {
+        return 0;
+    }
+
+    do
+    {
+        cursor = atomic_load_explicit(&r->cursor, memory_order_relaxed);
+        items = ring_buffer_bcast_items(bcast, r, cursor, len);
+        if (items > len)
+        {
+            items = len;
+        }
+        if (items == 0)
+        {
+            return 0;
+        }
+
+        index = cursor & ring->index_mask;
+        first = ring->buffer_cap - index;
+        if (first >= items)
+        {
+            memcpy(data, array + index, items);
+        }
+        else
+        {
+            memcpy(data, array + index, first);
+            memcpy(data + first, array, items - first);
+        }
+    } while (!ring_buffer_bcast_validate(bcast, r, cursor));
+
+    atomic_store_explicit(&r->cursor, ring_buffer_advance(ring, cursor, items), memory_order_release);
+    return items;
+}
+
+ring_buffer_size_t ring_buffer_bcast_peek_spans(ring_buffer_bcast_t *bcast, int reader, ring_buffer_span_t spans[2])
+{
+    ring_buffer_bcast_reader_t *r = ring_buffer_bcast_reader(bcast, reader, __func__);
+    ring_buffer_t *ring = &bcast->ring;
+    ring_buffer_size_t cursor, items, index, first;
+    char *array = ring_buffer_data(ring);
+
+    spans[0].data = spans[1].data = NULL;
+    spans[0].len = spans[1].len = 0;
+    if (r == NULL)
+    {
+        return 0;
+    }
+
+    cursor = atomic_load_explicit(&r->cursor, memory_order_relaxed);
+    items = ring_buffer_bcast_items(bcast, r, cursor, ring->buffer_cap);
+    if (items == 0)
+    {
+        return 0;
+    }
+
+    index = cursor & ring->index_mask;
+    first = ring->buffer_cap - index;
+    spans[0].data = array + index;
+    if (first >= items)
+    {
+        spans[0].len = items;
+    }
+    else
+    {
+        spans[0].len = first;
+        spans[1].data = array;
+        spans[1].len = items - first;
+    }
+    return items;
+}
+
+uint8_t ring_buffer_bcast_consume(ring_buffer_bcast_t *bcast, int reader, ring_buffer_size_t size)
+{
+    ring_buffer_bcast_reader_t *r = ring_buffer_bcast_reader(bcast, reader, __func__);
+    ring_buffer_size_t cursor;
+
+    if (r == NULL)
+    {
+        return 0;
+    }
+
+    cursor = atomic_load_explicit(&r->cursor, memory_order_relaxed);
+    if (size > ring_buffer_distance(&bcast->ring, r->cached_head, cursor))
+    {
+        fprintf(stderr, "%s -- consume size exceed readable data.\n", __func__);
+        return 0;
+    }
+    if (!ring_buffer_bcast_validate(bcast, r, cursor))
+    {
+        return 0;
+    }
+
+    atomic_store_explicit(&r->cursor, ring_buffer_advance(&bcast->ring, cursor, size), memory_order_release);
+    return 1;
+}
+
+ring_buffer_size_t ring_buffer_bcast_available(ring_buffer_bcast_t *bcast, int reader)
+{
+    ring_buffer_bcast_reader_t *r = ring_buffer_bcast_reader(bcast, reader, __func__);
+    ring_buffer_size_t head, cursor;
+
+    if (r == NULL)
+    {
+        return 0;
+    }
+
+    cursor = atomic_load_explicit(&r->cursor, memory_order_relaxed);
+    head = atomic_load_explicit(&bcast->ring.head_index, memory_order_acquire);
+    if (ring_buffer_bcast_behind(&bcast->ring, head, cursor))
+    {
+        return bcast->ring.buffer_cap;
+    }
+    return ring_buffer_distance(&bcast->ring, head, cursor);
+}
+
+uint64_t ring_buffer_bcast_lost(ring_buffer_bcast_t *bcast, int reader)
+{
+    if (reader < 0 || reader >= RING_BUFFER_BCAST_MAX_READERS)
+    {
+        fprintf(stderr, "%s -- reader %d out of range.\n", __func__, reader);
+        return 0;
+    }
+    return atomic_load_explicit(&bcast->readers[reader].lost_bytes, memory_order_relaxed);
+}
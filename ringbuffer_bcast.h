@@ -0,0 +1,172 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 广播队列：一个生产者，多个读者各自维护读取位置，每个读者都读到完整的数据流。
+ *
+ * 队列头部（ring_buffer_t）之后是读者表，每个读者的读取位置单独占一个cache line；
+ * 生产者只写一份数据，不需要为每个读者拷贝一个队列。溢出策略决定慢读者的处理方式：
+ * - RING_BUFFER_REJECT / RING_BUFFER_DROP_NEWEST：生产者受最慢的读者限制，空间不足时
+ *   拒绝整次写入或只写入放得下的部分（计入ring_buffer_dropped_bytes）；
+ * - RING_BUFFER_OVERWRITE：生产者从不等待，落后超过一圈的读者被跳过，
+ *   跳过的字节数记在该读者的lost_bytes中（ring_buffer_bcast_lost）。
+ *
+ * 覆盖策略下生产者写入数据之前先发布claim（即将写到的位置），读者拷贝之后再检查claim，
+ * 确认读到的数据在拷贝期间没有被覆盖，原理与seqlock相同；其他策略下数据不会被覆盖，不需要这一步。
+ *
+ * 头部只保存相对偏移，可以放在共享内存中：创建者调用ring_buffer_bcast_attach，
+ * 其他进程调用ring_buffer_bcast_open后再用ring_buffer_bcast_join加入。
+ * 读者加入时从当前的head开始读，加入之前写入的数据不可见。
+ */
+
+#ifndef RINGBUFFER_BCAST_H
+#define RINGBUFFER_BCAST_H
+
+// 读者个数上限。
+#define RING_BUFFER_BCAST_MAX_READERS 16
+
+/**
+ * 读者表中的一项，单独占一个cache line，只由该读者修改（state在加入和退出时修改）。
+ */
+typedef struct ring_buffer_bcast_reader_t
+{
+    /** 下一个要读的位置，与head_index使用相同的计数方式。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t cursor;
+    /** 0 - 空闲，1 - 正在加入，2 - 已加入。 */
+    _Atomic uint32_t state;
+    /** 被生产者覆盖而没有读到的累计字节数。 */
+    _Atomic uint64_t lost_bytes;
+    /** 被生产者超过一圈的次数。 */
+    _Atomic uint64_t lapped;
+    /** 读者缓存的head，只在数据看起来不足时才重新读取head_index。 */
+    ring_buffer_size_t cached_head;
+} ring_buffer_bcast_reader_t;
+
+/**
+ * Simplifies the use of <tt>struct ring_buffer_bcast_t</tt>.
+ */
+typedef struct ring_buffer_bcast_t ring_buffer_bcast_t;
+
+/**
+ * 广播队列头部，数组紧跟在结构体之后。
+ * ring中的head_index是生产者发布的位置，cached_tail是生产者缓存的最慢读者位置，tail_index不使用。
+ */
+struct ring_buffer_bcast_t
+{
+    /** 队列头部：容量、数组偏移、溢出策略、head和丢弃计数。 */
+    ring_buffer_t ring;
+    /** 覆盖策略下生产者即将写到的位置，在写入数据之前发布，读者据此判断数据是否被覆盖。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t claim;
+    /** 读者表。 */
+    ring_buffer_bcast_reader_t readers[RING_BUFFER_BCAST_MAX_READERS];
+};
+
+/**
+ * @brief 计算广播队列需要的内存大小。
+ * @param length - 队列容量，规则与ring_buffer_calc_size相同。
+ * @return 需要分配的内存大小，length超过RING_BUFFER_SIZE时返回0。
+ */
+size_t ring_buffer_bcast_calc_size(size_t length);
+
+/**
+ * @brief 分配并初始化广播队列。
+ * @param buffer_length - 队列容量，规则与ring_buffer_new相同。
+ * @param policy - 溢出策略，见文件说明。
+ * @return 初始化完成的队列，失败返回NULL。
+ */
+ring_buffer_bcast_t *ring_buffer_bcast_new(ring_buffer_size_t buffer_length, ring_buffer_overflow_t policy);
+
+/**
+ * @brief 销毁ring_buffer_bcast_new分配的队列，并将指针置为NULL。
+ * @param bcast - 队列对象指针的地址。
+ */
+void ring_buffer_bcast_destroy(ring_buffer_bcast_t **bcast);
+
+/**
+ * @brief 在已分配的内存块（例如共享内存）中初始化广播队列，没有任何读者。
+ * @param addr - 内存块首地址，按cache line对齐。
+ * @param length - 内存块长度，即ring_buffer_bcast_calc_size的返回值；
+ * 数组长度不是2的整数次幂时与ring_buffer_attach一样按任意容量使用。
+ * @param policy - 溢出策略。
+ * @return 初始化完成的队列，失败返回NULL。
+ */
+ring_buffer_bcast_t *ring_buffer_bcast_attach(void *addr, size_t length, ring_buffer_overflow_t policy);
+
+/**
+ * @brief 打开其他进程已初始化的广播队列，校验头部，不改变队列状态。
+ * @param addr - 映射到当前进程的内存块首地址。
+ * @param length - 映射长度。
+ * @return 队列对象，校验失败返回NULL。
+ */
+ring_buffer_bcast_t *ring_buffer_bcast_open(void *addr, size_t length);
+
+/**
+ * @brief 写入数据，只能由一个生产者调用。
+ * @param bcast - 队列对象。
+ * @param data - 数据。
+ * @param size - 字节数，覆盖策略下不能超过容量。
+ * @return 写入的字节数：RING_BUFFER_REJECT空间不足时为0，RING_BUFFER_DROP_NEWEST为放得下的部分。
+ */
+ring_buffer_size_t ring_buffer_bcast_write(ring_buffer_bcast_t *bcast, const char *data, ring_buffer_size_t size);
+
+/**
+ * @brief 加入为读者，从当前的head开始读取。
+ * @param bcast - 队列对象。
+ * @return 读者编号，读者表已满返回-1。
+ */
+int ring_buffer_bcast_join(ring_buffer_bcast_t *bcast);
+
+/**
+ * @brief 退出，读者编号可以被重新使用；RING_BUFFER_REJECT等策略下不再限制生产者。
+ * @param bcast - 队列对象。
+ * @param reader - ring_buffer_bcast_join返回的编号。
+ */
+void ring_buffer_bcast_leave(ring_buffer_bcast_t *bcast, int reader);
+
+/**
+ * @brief 读出最多len个字节，每个读者只能在一个线程中读取。
+ * 覆盖策略下读者落后超过一圈时跳到当前的head，跳过的字节计入ring_buffer_bcast_lost。
+ * @param bcast - 队列对象。
+ * @param reader - 读者编号。
+ * @param data - 输出缓冲区。
+ * @param len - 缓冲区长度。
+ * @return 读出的字节数，没有数据时返回0。
+ */
+ring_buffer_size_t ring_buffer_bcast_read(ring_buffer_bcast_t *bcast, int reader, char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 零拷贝读取：返回该读者可读的数据（最多两段），不移动读取位置。
+ * 覆盖策略下数据可能在处理期间被覆盖，以ring_buffer_bcast_consume的返回值为准。
+ * @param bcast - 队列对象。
+ * @param reader - 读者编号。
+ * @param spans - 输出的两段内存。
+ * @return 可读的字节数。
+ */
+ring_buffer_size_t ring_buffer_bcast_peek_spans(ring_buffer_bcast_t *bcast, int reader, ring_buffer_span_t spans[2]);
+
+/**
+ * @brief 释放ring_buffer_bcast_peek_spans返回的前size个字节。
+ * @param bcast - 队列对象。
+ * @param reader - 读者编号。
+ * @param size - 释放的字节数，不超过peek得到的长度。
+ * @return 1 - 处理期间数据没有被覆盖，0 - 数据已被覆盖（需要丢弃处理结果），读者已跳到当前的head。
+ */
+uint8_t ring_buffer_bcast_consume(ring_buffer_bcast_t *bcast, int reader, ring_buffer_size_t size);
+
+/**
+ * @brief 读者可读的字节数。
+ * @param bcast - 队列对象。
+ * @param reader - 读者编号。
+ * @return 字节数，被超过一圈时返回容量。
+ */
+ring_buffer_size_t ring_buffer_bcast_available(ring_buffer_bcast_t *bcast, int reader);
+
+/**
+ * @brief 读者因被覆盖而丢失的累计字节数。
+ * @param bcast - 队列对象。
+ * @param reader - 读者编号。
+ * @return 字节数。
+ */
+uint64_t ring_buffer_bcast_lost(ring_buffer_bcast_t *bcast, int reader);
+
+#endif /* RINGBUFFER_BCAST_H */
@@ -0,0 +1,337 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "ringbuffer_io.h"
+
+#if RING_BUFFER_IO_URING
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/**
+ * @file
+ * 队列与文件描述符之间直接读写的实现。
+ */
+
+/**
+ * 把两段内存截取到最多max字节并填入iov，返回iovec个数，*total为总字节数。
+ */
+static int ring_buffer_fill_iov(const ring_buffer_span_t spans[2], ring_buffer_size_t max, struct iovec iov[2],
+                                size_t *total)
+{
+    ring_buffer_size_t first = spans[0].len < max ? spans[0].len : max;
+    ring_buffer_size_t second = spans[1].len < max - first ? spans[1].len : max - first;
+
+    iov[0].iov_base = spans[0].data;
+    iov[0].iov_len = first;
+    iov[1].iov_base = spans[1].data;
+    iov[1].iov_len = second;
+    *total = (size_t)first + second;
+    return second != 0 ? 2 : 1;
+}
+
+ssize_t ring_buffer_write_to_fd(ring_buffer_t *buffer, int fd, ring_buffer_size_t max)
+{
+    ring_buffer_span_t spans[2];
+    struct iovec iov[2];
+    size_t total;
+    int cnt;
+    ssize_t n;
+
+    ring_buffer_peek_spans(buffer, spans);
+    cnt = ring_buffer_fill_iov(spans, max, iov, &total);
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    n = writev(fd, iov, cnt);
+    if (n > 0)
+    {
+        ring_buffer_consume(buffer, (ring_buffer_size_t)n);
+    }
+    return n;
+}
+
+ssize_t ring_buffer_read_from_fd(ring_buffer_t *buffer, int fd, ring_buffer_size_t max)
+{
+    ring_buffer_span_t spans[2];
+    struct iovec iov[2];
+    size_t total;
+    int cnt;
+    ssize_t n;
+
+    ring_buffer_reserve(buffer, max, spans);
+    cnt = ring_buffer_fill_iov(spans, max, iov, &total);
+    if (total == 0)
+    {
+        errno = max == 0 ? EINVAL : ENOBUFS;
+        return -1;
+    }
+
+    n = readv(fd, iov, cnt);
+    if (n > 0)
+    {
+        ring_buffer_commit(buffer, (ring_buffer_size_t)n);
+    }
+    return n;
+}
+
+#if RING_BUFFER_IO_URING
+
+/**
+ * 同步使用：每次调用只提交一个请求并等待它完成，提交队列中不会积压请求。
+ * 提交队列和完成队列的头尾索引与内核共享，按io_uring的约定用acquire/release访问。
+ * 内核没有取走请求时撤回sq_tail；请求已经提交后一直等到它完成，iov在此之前不会被改写，
+ * 完成队列中也不会留下属于上一次调用的结果。等待时出现无法恢复的错误，上下文标记为不可用。
+ */
+struct ring_buffer_uring_t
+{
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    _Atomic unsigned *sq_head;
+    _Atomic unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    _Atomic unsigned *cq_head;
+    _Atomic unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    struct iovec iov[2];
+    /* 不为0时上下文已不可用，值为导致失败的errno */
+    int failed;
+};
+
+ring_buffer_uring_t *ring_buffer_uring_new(unsigned entries)
+{
+    struct io_uring_params params;
+    ring_buffer_uring_t *uring;
+    char *sq, *cq;
+
+    uring = calloc(1, sizeof(ring_buffer_uring_t));
+    if (uring == NULL)
+    {
+        fprintf(stderr, "%s -- calloc failed\n", __func__);
+        return NULL;
+    }
+
+    memset(&params, 0, sizeof(params));
+    uring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (uring->fd < 0)
+    {
+        fprintf(stderr, "%s -- io_uring_setup: %s\n", __func__, strerror(errno));
+        free(uring);
+        return NULL;
+    }
+
+    uring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    uring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    uring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    uring->sq_ring = mmap(NULL, uring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd,
+                          IORING_OFF_SQ_RING);
+    uring->cq_ring = mmap(NULL, uring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd,
+                          IORING_OFF_CQ_RING);
+    uring->sqes = mmap(NULL, uring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, uring->fd,
+                       IORING_OFF_SQES);
+    if (uring->sq_ring == MAP_FAILED || uring->cq_ring == MAP_FAILED || uring->sqes == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap: %s\n", __func__, strerror(errno));
+        if (uring->sq_ring != MAP_FAILED)
+        {
+            munmap(uring->sq_ring, uring->sq_ring_size);
+        }
+        if (uring->cq_ring != MAP_FAILED)
+        {
+            munmap(uring->cq_ring, uring->cq_ring_size);
+        }
+        if (uring->sqes != MAP_FAILED)
+        {
+            munmap(uring->sqes, uring->sqes_size);
+        }
+        close(uring->fd);
+        free(uring);
+        return NULL;
+    }
+
+    sq = uring->sq_ring;
+    cq = uring->cq_ring;
+    uring->sq_head = (_Atomic unsigned *)(sq + params.sq_off.head);
+    uring->sq_tail = (_Atomic unsigned *)(sq + params.sq_off.tail);
+    uring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    uring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    uring->cq_head = (_Atomic unsigned *)(cq + params.cq_off.head);
+    uring->cq_tail = (_Atomic unsigned *)(cq + params.cq_off.tail);
+    uring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    uring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return uring;
+}
+
+void ring_buffer_uring_destroy(ring_buffer_uring_t **uring)
+{
+    if (uring == NULL || *uring == NULL)
+    {
+        return;
+    }
+
+    munmap((*uring)->sqes, (*uring)->sqes_size);
+    munmap((*uring)->cq_ring, (*uring)->cq_ring_size);
+    munmap((*uring)->sq_ring, (*uring)->sq_ring_size);
+    close((*uring)->fd);
+    free(*uring);
+    *uring = NULL;
+}
+
+/**
+ * 提交一个readv/writev请求并等待完成，返回内核的结果（负数为-errno）。
+ * offset为-1，与readv/writev一样使用并推进fd的当前位置。
+ */
+static int ring_buffer_uring_submit(ring_buffer_uring_t *uring, uint8_t opcode, int fd, int iovcnt)
+{
+    unsigned tail = atomic_load_explicit(uring->sq_tail, memory_order_relaxed);
+    unsigned index = tail & *uring->sq_mask;
+    struct io_uring_sqe *sqe = &uring->sqes[index];
+    unsigned head;
+    int res, err;
+
+    if (uring->failed != 0)
+    {
+        return -uring->failed;
+    }
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)-1;
+    sqe->addr = (uint64_t)(uintptr_t)uring->iov;
+    sqe->len = (unsigned)iovcnt;
+    uring->sq_array[index] = index;
+    atomic_store_explicit(uring->sq_tail, tail + 1, memory_order_release);
+
+    //内核取走请求时推进sq_head；出错而请求没有被取走时撤回，下一次调用不会重复提交它。
+    while (atomic_load_explicit(uring->sq_head, memory_order_acquire) == tail)
+    {
+        if (syscall(__NR_io_uring_enter, uring->fd, 1, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            atomic_load_explicit(uring->sq_head, memory_order_acquire) == tail && errno != EINTR)
+        {
+            err = errno;
+            atomic_store_explicit(uring->sq_tail, tail, memory_order_release);
+            return -err;
+        }
+    }
+
+    //请求已经提交：必须等到它的完成事件，否则内核之后还会访问iov，结果也会被下一次调用误认。
+    head = atomic_load_explicit(uring->cq_head, memory_order_relaxed);
+    while (head == atomic_load_explicit(uring->cq_tail, memory_order_acquire))
+    {
+        if (syscall(__NR_io_uring_enter, uring->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR &&
+            errno != EAGAIN && errno != EBUSY)
+        {
+            uring->failed = errno;
+            fprintf(stderr, "%s -- io_uring_enter: %s, context is no longer usable.\n", __func__, strerror(errno));
+            return -uring->failed;
+        }
+    }
+    res = uring->cqes[head & *uring->cq_mask].res;
+    atomic_store_explicit(uring->cq_head, head + 1, memory_order_release);
+    return res;
+}
+
+ssize_t ring_buffer_uring_write_to_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                      ring_buffer_size_t max)
+{
+    ring_buffer_span_t spans[2];
+    size_t total;
+    int cnt, res;
+
+    ring_buffer_peek_spans(buffer, spans);
+    cnt = ring_buffer_fill_iov(spans, max, uring->iov, &total);
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    res = ring_buffer_uring_submit(uring, IORING_OP_WRITEV, fd, cnt);
+    if (res < 0)
+    {
+        errno = -res;
+        return -1;
+    }
+    if (res > 0)
+    {
+        ring_buffer_consume(buffer, (ring_buffer_size_t)res);
+    }
+    return res;
+}
+
+ssize_t ring_buffer_uring_read_from_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                       ring_buffer_size_t max)
+{
+    ring_buffer_span_t spans[2];
+    size_t total;
+    int cnt, res;
+
+    ring_buffer_reserve(buffer, max, spans);
+    cnt = ring_buffer_fill_iov(spans, max, uring->iov, &total);
+    if (total == 0)
+    {
+        errno = max == 0 ? EINVAL : ENOBUFS;
+        return -1;
+    }
+
+    res = ring_buffer_uring_submit(uring, IORING_OP_READV, fd, cnt);
+    if (res < 0)
+    {
+        errno = -res;
+        return -1;
+    }
+    if (res > 0)
+    {
+        ring_buffer_commit(buffer, (ring_buffer_size_t)res);
+    }
+    return res;
+}
+
+#else /* !RING_BUFFER_IO_URING */
+
+ring_buffer_uring_t *ring_buffer_uring_new(unsigned entries)
+{
+    (void)entries;
+    fprintf(stderr, "%s -- built without io_uring support\n", __func__);
+    return NULL;
+}
+
+void ring_buffer_uring_destroy(ring_buffer_uring_t **uring)
+{
+    (void)uring;
+}
+
+ssize_t ring_buffer_uring_write_to_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                      ring_buffer_size_t max)
+{
+    (void)uring;
+    return ring_buffer_write_to_fd(buffer, fd, max);
+}
+
+ssize_t ring_buffer_uring_read_from_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                       ring_buffer_size_t max)
+{
+    (void)uring;
+    return ring_buffer_read_from_fd(buffer, fd, max);
+}
+
+#endif /* RING_BUFFER_IO_URING */
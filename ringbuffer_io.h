@@ -0,0 +1,90 @@
+#include <sys/types.h>
+
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 队列与文件描述符之间的直接读写（Linux/POSIX）。
+ * 可读数据（或可写空间）最多分为两段，直接作为两个iovec交给一次readv/writev，
+ * 不需要先拷贝到临时缓冲区；内核实际接受了多少字节就读出（或写入）多少字节。
+ *
+ * ring_buffer_write_to_fd属于消费者一端，ring_buffer_read_from_fd属于生产者一端，
+ * 与ring_buffer_spsc_*接口一样可以和另一端并发使用。read_from_fd只写入空闲空间，
+ * 不受溢出策略影响，不会覆盖未读的数据。对端使用ringbuffer_wait.h的阻塞接口时，
+ * 调用者需要自己调用对应的唤醒函数。
+ *
+ * 出错时返回-1并保留errno，与readv/writev相同，非阻塞fd上的EAGAIN不打印错误。
+ *
+ * 另外提供基于io_uring的同名变体（ring_buffer_uring_*），内核或编译环境不支持时
+ * ring_buffer_uring_new返回NULL，调用者可以回退到readv/writev版本。
+ */
+
+#ifndef RINGBUFFER_IO_H
+#define RINGBUFFER_IO_H
+
+// 是否编译io_uring变体，默认在有<linux/io_uring.h>时开启；直接使用系统调用，不依赖liburing。
+#ifndef RING_BUFFER_IO_URING
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define RING_BUFFER_IO_URING 1
+#endif
+#endif
+#endif
+#ifndef RING_BUFFER_IO_URING
+#define RING_BUFFER_IO_URING 0
+#endif
+
+/**
+ * @brief 把队列中的数据写入fd，一次writev，只读出fd实际接受的字节数。
+ * @param buffer The buffer from which the data should be written.
+ * @param fd 文件、管道或套接字。
+ * @param max 最多写入的字节数。
+ * @return 写入的字节数，队列为空时返回0（不调用writev），出错返回-1。
+ */
+ssize_t ring_buffer_write_to_fd(ring_buffer_t *buffer, int fd, ring_buffer_size_t max);
+
+/**
+ * @brief 从fd读入数据到队列的空闲空间，一次readv，只写入实际读到的字节数。
+ * @param buffer The buffer in which the data should be placed.
+ * @param fd 文件、管道或套接字。
+ * @param max 最多读入的字节数。
+ * @return 读入的字节数，0表示文件结束；队列已满时返回-1并设置errno为ENOBUFS，其他错误返回-1。
+ */
+ssize_t ring_buffer_read_from_fd(ring_buffer_t *buffer, int fd, ring_buffer_size_t max);
+
+/**
+ * io_uring上下文，一个上下文同一时间只能被一个线程使用。
+ * 请求提交后等待完成时io_uring_enter出现无法恢复的错误，上下文不再可用，
+ * 之后的调用都返回-1并设置同样的errno，只能销毁后重新创建。
+ */
+typedef struct ring_buffer_uring_t ring_buffer_uring_t;
+
+/**
+ * @brief 创建io_uring上下文。
+ * @param entries 提交队列长度，会被内核向上取整到2的幂。
+ * @return 上下文指针，不支持io_uring时返回NULL。
+ */
+ring_buffer_uring_t *ring_buffer_uring_new(unsigned entries);
+
+/**
+ * @brief 关闭io_uring上下文，并将指针置为NULL。
+ * @param uring 上下文指针的地址。
+ */
+void ring_buffer_uring_destroy(ring_buffer_uring_t **uring);
+
+/**
+ * @brief ring_buffer_write_to_fd的io_uring版本：提交一个IORING_OP_WRITEV并等待完成。
+ * @return 与ring_buffer_write_to_fd相同。
+ */
+ssize_t ring_buffer_uring_write_to_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                      ring_buffer_size_t max);
+
+/**
+ * @brief ring_buffer_read_from_fd的io_uring版本：提交一个IORING_OP_READV并等待完成。
+ * 内核会等到fd可读再完成请求，非阻塞fd上也不会返回EAGAIN。
+ * @return 与ring_buffer_read_from_fd相同。
+ */
+ssize_t ring_buffer_uring_read_from_fd(ring_buffer_uring_t *uring, ring_buffer_t *buffer, int fd,
+                                       ring_buffer_size_t max);
+
+#endif /* RINGBUFFER_IO_H */
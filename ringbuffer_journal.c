@@ -0,0 +1,420 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ringbuffer_journal.h"
+
+/**
+ * @file
+ * 持久化日志队列的实现。
+ *
+ * 记录格式：uint32长度 + uint32校验和 + 内容，按RING_BUFFER_JOURNAL_HEADER对齐，
+ * 因为容量是2的幂且不小于8，记录头总是完整地落在数组末尾之前。
+ * 校验和为CRC32C(记录起始位置的64位自由增长计数 + 长度 + 内容)，
+ * 同一位置上一轮的旧记录起始计数不同，不能通过校验。
+ */
+
+typedef uint32_t (*crc_fn)(uint32_t crc, const void *data, size_t len);
+
+static uint32_t crc32c_table[256];
+
+static uint32_t crc32c_soft(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+
+    while (len--)
+    {
+        crc = crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+/**
+ * SSE4.2的crc32指令每次处理8字节。
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    uint64_t c = crc, v;
+
+    for (; len >= 8; len -= 8, p += 8)
+    {
+        memcpy(&v, p, sizeof(v));
+        c = __builtin_ia32_crc32di(c, v);
+    }
+    crc = (uint32_t)c;
+    for (; len > 0; len--)
+    {
+        crc = __builtin_ia32_crc32qi(crc, *p++);
+    }
+    return crc;
+}
+#endif
+
+// 按CPU支持情况选择的实现，第一次使用时初始化，各线程初始化的结果相同。
+static _Atomic(crc_fn) crc32c_impl;
+
+static uint32_t crc32c(uint32_t crc, const void *data, size_t len)
+{
+    crc_fn fn = atomic_load_explicit(&crc32c_impl, memory_order_acquire);
+
+    if (fn == NULL)
+    {
+        uint32_t i, k, c;
+
+        for (i = 0; i < 256; i++)
+        {
+            for (c = i, k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            }
+            crc32c_table[i] = c;
+        }
+        fn = crc32c_soft;
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            fn = crc32c_sse42;
+        }
+#endif
+        atomic_store_explicit(&crc32c_impl, fn, memory_order_release);
+    }
+    return fn(crc, data, len);
+}
+
+static inline ring_buffer_size_t journal_record_size(ring_buffer_size_t len)
+{
+    return (RING_BUFFER_JOURNAL_HEADER + len + RING_BUFFER_JOURNAL_HEADER - 1) &
+           ~(ring_buffer_size_t)(RING_BUFFER_JOURNAL_HEADER - 1);
+}
+
+/**
+ * 位置pos处长度为len的记录的校验和，内容从数组中读取（可能跨越数组末尾），data不为NULL时从data读取。
+ */
+static uint32_t journal_checksum(ring_buffer_t *buffer, ring_buffer_size_t pos, uint32_t len, const char *data)
+{
+    uint64_t pos64 = (uint64_t)pos;
+    uint32_t crc = crc32c(~0u, &pos64, sizeof(pos64));
+
+    crc = crc32c(crc, &len, sizeof(len));
+    if (data != NULL)
+    {
+        crc = crc32c(crc, data, len);
+    }
+    else
+    {
+        ring_buffer_size_t offset = (pos + RING_BUFFER_JOURNAL_HEADER) & (buffer->buffer_cap - 1);
+        ring_buffer_size_t first = buffer->buffer_cap - offset;
+
+        if (first > len)
+        {
+            first = len;
+        }
+        crc = crc32c(crc, ring_buffer_data(buffer) + offset, first);
+        crc = crc32c(crc, ring_buffer_data(buffer), len - first);
+    }
+    return ~crc;
+}
+
+/**
+ * 把两段内存中从offset开始的len个字节与data之间拷贝，to_ring为1时写入队列。
+ */
+static void journal_copy(const ring_buffer_span_t spans[2], ring_buffer_size_t offset, char *data,
+                         ring_buffer_size_t len, int to_ring)
+{
+    ring_buffer_size_t k, n;
+
+    for (k = 0; k < 2 && len > 0; k++)
+    {
+        if (offset >= spans[k].len)
+        {
+            offset -= spans[k].len;
+            continue;
+        }
+        n = spans[k].len - offset < len ? spans[k].len - offset : len;
+        if (to_ring)
+        {
+            memcpy(spans[k].data + offset, data, n);
+        }
+        else
+        {
+            memcpy(data, spans[k].data + offset, n);
+        }
+        data += n;
+        len -= n;
+        offset = 0;
+    }
+}
+
+/**
+ * 对包含[p, p + len)的整页执行msync。
+ */
+static int journal_msync(const void *p, size_t len)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)p & ~(page - 1);
+
+    if (msync((void *)start, (uintptr_t)p + len - start, MS_SYNC) != 0)
+    {
+        fprintf(stderr, "%s -- msync failed:%s\n", __func__, strerror(errno));
+        return 0;
+    }
+    return 1;
+}
+
+ring_buffer_t *ring_buffer_journal_create(const char *path, ring_buffer_size_t buffer_length)
+{
+    size_t length;
+    ring_buffer_t *buffer;
+    void *addr;
+    int fd, err;
+
+    if (buffer_length < RING_BUFFER_JOURNAL_HEADER)
+    {
+        buffer_length = RING_BUFFER_JOURNAL_HEADER;
+    }
+    length = ring_buffer_calc_size(buffer_length);
+    if (length == 0)
+    {
+        return NULL;
+    }
+
+    fd = open(path, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s -- open %s failed:%s\n", __func__, path, strerror(errno));
+        return NULL;
+    }
+
+    err = posix_fallocate(fd, 0, length);
+    if (err == EOPNOTSUPP || err == EINVAL)
+    {
+        //文件系统不支持预分配时退回到稀疏文件。
+        err = ftruncate(fd, length) != 0 ? errno : 0;
+    }
+    if (err != 0)
+    {
+        fprintf(stderr, "%s -- allocate %s failed:%s\n", __func__, path, strerror(err));
+        goto fail;
+    }
+
+    addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+        goto fail;
+    }
+    close(fd);
+
+    buffer = ring_buffer_attach_array(addr, (char *)addr + sizeof(ring_buffer_t), length - sizeof(ring_buffer_t),
+                                      RING_BUFFER_FLAG_JOURNAL | RING_BUFFER_REJECT);
+    if (buffer == NULL || !journal_msync(buffer, sizeof(ring_buffer_t)))
+    {
+        munmap(addr, length);
+        unlink(path);
+        return NULL;
+    }
+    return buffer;
+
+fail:
+    close(fd);
+    unlink(path);
+    return NULL;
+}
+
+/**
+ * 从tail开始逐条校验记录，返回第一条无效记录的位置（全部有效时为head）。
+ */
+static ring_buffer_size_t journal_recover(ring_buffer_t *buffer, ring_buffer_size_t tail, ring_buffer_size_t head)
+{
+    ring_buffer_size_t pos = tail;
+    uint32_t header[2];
+
+    while (head - pos >= RING_BUFFER_JOURNAL_HEADER)
+    {
+        memcpy(header, ring_buffer_data(buffer) + (pos & (buffer->buffer_cap - 1)), sizeof(header));
+        if (header[0] > head - pos - RING_BUFFER_JOURNAL_HEADER || journal_record_size(header[0]) > head - pos ||
+            journal_checksum(buffer, pos, header[0], NULL) != header[1])
+        {
+            break;
+        }
+        pos += journal_record_size(header[0]);
+    }
+    return pos;
+}
+
+ring_buffer_t *ring_buffer_journal_open(const char *path, ring_buffer_size_t *discarded)
+{
+    struct stat st;
+    ring_buffer_t *buffer;
+    ring_buffer_size_t tail, head, valid;
+    void *addr;
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s -- open %s failed:%s\n", __func__, path, strerror(errno));
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "%s -- fstat failed:%s\n", __func__, strerror(errno));
+        close(fd);
+        return NULL;
+    }
+    addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    buffer = ring_buffer_open(addr, st.st_size);
+    if (buffer == NULL)
+    {
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+
+    tail = atomic_load_explicit(&buffer->tail_index, memory_order_relaxed);
+    head = atomic_load_explicit(&buffer->head_index, memory_order_relaxed);
+    if (!(buffer->flags & RING_BUFFER_FLAG_JOURNAL) || tail % RING_BUFFER_JOURNAL_HEADER != 0)
+    {
+        fprintf(stderr, "%s -- %s is not a journal.\n", __func__, path);
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+    //tail和head所在的头部页可能来自不同时刻，head落后于tail或超出容量时视为没有有效数据。
+    if (head - tail > buffer->buffer_cap)
+    {
+        head = tail;
+    }
+
+    valid = journal_recover(buffer, tail, head);
+    if (discarded != NULL)
+    {
+        *discarded = head - valid;
+    }
+
+    //上一个进程留下的缓存值和等待者计数都不再有效。
+    atomic_store_explicit(&buffer->head_index, valid, memory_order_relaxed);
+    buffer->cached_tail = tail;
+    buffer->cached_head = valid;
+    buffer->synced_head = tail;
+    atomic_store_explicit(&buffer->data_waiters, 0, memory_order_relaxed);
+    atomic_store_explicit(&buffer->space_waiters, 0, memory_order_relaxed);
+    if (!journal_msync(buffer, sizeof(ring_buffer_t)))
+    {
+        munmap(addr, st.st_size);
+        return NULL;
+    }
+    return buffer;
+}
+
+uint8_t ring_buffer_journal_append(ring_buffer_t *buffer, const char *data, ring_buffer_size_t len)
+{
+    ring_buffer_size_t head = atomic_load_explicit(&buffer->head_index, memory_order_relaxed);
+    ring_buffer_size_t record = journal_record_size(len);
+    ring_buffer_span_t spans[2];
+    uint32_t header[2];
+
+    if (len > UINT32_MAX - RING_BUFFER_JOURNAL_HEADER || record > buffer->buffer_cap)
+    {
+        fprintf(stderr, "%s -- record size exceed buffer size.\n", __func__);
+        return 0;
+    }
+    if (ring_buffer_reserve(buffer, record, spans) != record)
+    {
+        return 0;
+    }
+
+    header[0] = (uint32_t)len;
+    header[1] = journal_checksum(buffer, head, header[0], data);
+    memcpy(spans[0].data, header, sizeof(header));
+    journal_copy(spans, RING_BUFFER_JOURNAL_HEADER, (char *)data, len, 1);
+    return ring_buffer_commit(buffer, record);
+}
+
+uint8_t ring_buffer_journal_read(ring_buffer_t *buffer, char *data, ring_buffer_size_t *len)
+{
+    ring_buffer_span_t spans[2];
+    uint32_t header[2];
+
+    if (ring_buffer_peek_spans(buffer, spans) < RING_BUFFER_JOURNAL_HEADER)
+    {
+        *len = 0;
+        return 0;
+    }
+
+    memcpy(header, spans[0].data, sizeof(header));
+    if (header[0] > *len)
+    {
+        *len = header[0];
+        return 0;
+    }
+
+    journal_copy(spans, RING_BUFFER_JOURNAL_HEADER, data, header[0], 0);
+    *len = header[0];
+    return ring_buffer_consume(buffer, journal_record_size(header[0]));
+}
+
+uint8_t ring_buffer_sync(ring_buffer_t *buffer)
+{
+    ring_buffer_size_t head = atomic_load_explicit(&buffer->head_index, memory_order_relaxed);
+    ring_buffer_size_t start = buffer->synced_head;
+    ring_buffer_size_t dirty = head - start;
+
+    if (!(buffer->flags & RING_BUFFER_FLAG_JOURNAL))
+    {
+        fprintf(stderr, "%s -- ring buffer is not file backed.\n", __func__);
+        return 0;
+    }
+
+    if (dirty > buffer->buffer_cap)
+    {
+        start = head - buffer->buffer_cap;
+        dirty = buffer->buffer_cap;
+    }
+    if (dirty != 0)
+    {
+        ring_buffer_size_t offset = start & (buffer->buffer_cap - 1);
+        ring_buffer_size_t first = buffer->buffer_cap - offset;
+
+        if (first > dirty)
+        {
+            first = dirty;
+        }
+        if (!journal_msync(ring_buffer_data(buffer) + offset, first) ||
+            (dirty > first && !journal_msync(ring_buffer_data(buffer), dirty - first)))
+        {
+            return 0;
+        }
+    }
+
+    //数据落盘之后再同步头部，头部中的head不会指向尚未落盘的数据（除非内核自行提前回写）。
+    buffer->synced_head = head;
+    return (uint8_t)journal_msync(buffer, sizeof(ring_buffer_t));
+}
+
+void ring_buffer_journal_close(ring_buffer_t **buffer)
+{
+    if (*buffer == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_t ptr is NULL.\n", __func__);
+        return;
+    }
+
+    ring_buffer_sync(*buffer);
+    munmap(*buffer, (*buffer)->data_offset + (*buffer)->buffer_cap);
+    *buffer = NULL;
+}
@@ -0,0 +1,75 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 映射自文件的持久化日志队列，进程崩溃或重启后队列中未读的记录不会丢失。
+ *
+ * 队列头部（包括head/tail）和数组都在mmap的文件中。每条记录由8字节记录头
+ * （4字节长度 + 4字节CRC32C）和内容组成，整体按8字节对齐；校验和覆盖记录的位置、长度和内容，
+ * 所以写了一半的记录和数组中上一轮残留的旧记录都不能通过校验。
+ *
+ * ring_buffer_sync只把上次同步之后写入的数据范围和头部msync到磁盘：先同步数据，再同步头部。
+ * 没有同步的数据在进程崩溃后依然在页缓存中，只有系统崩溃或断电才可能丢失；
+ * 内核可能在数据之前先回写头部，因此ring_buffer_journal_open打开时会从tail开始逐条校验记录，
+ * 在第一条校验失败的记录处截断head，之后的记录全部丢弃。
+ *
+ * 写入是全有或全无的，空间不足时不写入也不覆盖未读的记录（创建时的溢出策略为RING_BUFFER_REJECT）。
+ * 生产者和消费者可以在不同线程中并发使用，同一个队列不要再混用字节接口或消息层接口。
+ * 同一个文件同一时间只能由一个进程打开。
+ */
+
+#ifndef RINGBUFFER_JOURNAL_H
+#define RINGBUFFER_JOURNAL_H
+
+// 记录头的大小，记录按此对齐。
+#define RING_BUFFER_JOURNAL_HEADER 8
+
+/**
+ * @brief 创建日志文件并初始化队列，文件已存在时失败。
+ * 文件空间在创建时预先分配（文件系统支持时），避免写入时因磁盘满触发SIGBUS。
+ * @param path - 文件路径。
+ * @param buffer_length - 队列容量，规则与ring_buffer_new相同，至少为RING_BUFFER_JOURNAL_HEADER。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_journal_create(const char *path, ring_buffer_size_t buffer_length);
+
+/**
+ * @brief 打开已有的日志文件，校验头部和[tail, head)范围内的每条记录，丢弃校验失败的记录及其后的全部数据。
+ * @param path - 文件路径。
+ * @param discarded - 输出参数，恢复时丢弃的字节数，可以为NULL。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_journal_open(const char *path, ring_buffer_size_t *discarded);
+
+/**
+ * @brief 写入一条记录。
+ * @param buffer The journal in which the record should be placed.
+ * @param data 记录内容。
+ * @param len 记录长度，可以为0。
+ * @return 1 - success, 0 - 剩余空间不足（未写入任何内容）。
+ */
+uint8_t ring_buffer_journal_append(ring_buffer_t *buffer, const char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 读出最早的一条记录，语义与ring_buffer_pop_msg相同。
+ * @param buffer The journal from which the record should be returned.
+ * @param data A pointer to the array at which the record should be placed.
+ * @param len 输入为data的长度，输出为记录的长度；data不够大时不读出记录，只返回需要的长度。
+ * @return 1 if a record was returned; 0 otherwise.
+ */
+uint8_t ring_buffer_journal_read(ring_buffer_t *buffer, char *data, ring_buffer_size_t *len);
+
+/**
+ * @brief 把上次同步之后写入的数据以及队列头部同步到磁盘（msync MS_SYNC），由生产者调用。
+ * @param buffer The journal to flush.
+ * @return 1 - success, 0 - fail.
+ */
+uint8_t ring_buffer_sync(ring_buffer_t *buffer);
+
+/**
+ * @brief 同步并解除映射，将指针置为NULL。
+ * @param buffer - 队列对象指针的地址。
+ */
+void ring_buffer_journal_close(ring_buffer_t **buffer);
+
+#endif /* RINGBUFFER_JOURNAL_H */
@@ -0,0 +1,483 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_lz.h"
+
+/**
+ * @file
+ * 压缩记录和编解码器的实现。
+ *
+ * 压缩格式是LZ4风格（不与LZ4互通）：若干个序列，每个序列是一个token字节
+ * （高4位字面量长度，低4位匹配长度减4，取值15时后面跟着扩展字节，每个255继续），
+ * 字面量，2字节小端的匹配偏移和匹配长度的扩展字节；最后一个序列只有字面量。
+ * 不遵守LZ4的块结尾规则：匹配可以延伸到最后一个字节，结尾也不保留5个字面量，不能交给liblz4解码。
+ * 压缩器是单哈希表的贪心匹配，连续找不到匹配时逐渐加大步长，不可压缩的数据很快就能扫完。
+ */
+
+// 记录头的最高位：数据是压缩过的。
+#define RING_BUFFER_LZ_PACKED 0x80000000u
+// 短于此长度的记录不尝试压缩。
+#define RING_BUFFER_LZ_MIN_INPUT 16
+// 最短匹配长度。
+#define RING_BUFFER_LZ_MIN_MATCH 4
+// base超过此值时清空哈希表重新开始，保证base加上块长度不会溢出。
+#define RING_BUFFER_LZ_BASE_LIMIT 0x80000000u
+
+static uint64_t lz_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint32_t lz_hash(uint32_t seq)
+{
+    return (seq * 2654435761u) >> (32 - RING_BUFFER_LZ_HASH_BITS);
+}
+
+/**
+ * 写入长度的扩展字节（已减去15的部分）。
+ */
+static unsigned char *lz_put_length(unsigned char *op, size_t n)
+{
+    while (n >= 255)
+    {
+        *op++ = 255;
+        n -= 255;
+    }
+    *op++ = (unsigned char)n;
+    return op;
+}
+
+/**
+ * 读取长度的扩展字节，累加到n上。
+ */
+static int lz_get_length(const unsigned char *in, size_t len, size_t *ip, size_t *n)
+{
+    unsigned char b;
+
+    do
+    {
+        if (*ip >= len)
+        {
+            return 0;
+        }
+        b = in[(*ip)++];
+        *n += b;
+    } while (b == 255);
+    return 1;
+}
+
+/**
+ * 输出一个序列：字面量，以及mlen不为0时的匹配。输出放不下时返回0。
+ */
+static int lz_emit(unsigned char **pop, const unsigned char *end, const unsigned char *lit, size_t lit_len,
+                   size_t offset, size_t mlen)
+{
+    unsigned char *op = *pop, *token;
+    size_t need = 1 + lit_len + lit_len / 255 + 1 + (mlen != 0 ? 2 + mlen / 255 + 1 : 0);
+
+    if ((size_t)(end - op) < need)
+    {
+        return 0;
+    }
+
+    token = op++;
+    *token = (unsigned char)((lit_len >= 15 ? 15 : lit_len) << 4);
+    if (lit_len >= 15)
+    {
+        op = lz_put_length(op, lit_len - 15);
+    }
+    memcpy(op, lit, lit_len);
+    op += lit_len;
+
+    if (mlen != 0)
+    {
+        *op++ = (unsigned char)(offset & 0xFF);
+        *op++ = (unsigned char)(offset >> 8);
+        mlen -= RING_BUFFER_LZ_MIN_MATCH;
+        *token |= (unsigned char)(mlen >= 15 ? 15 : mlen);
+        if (mlen >= 15)
+        {
+            op = lz_put_length(op, mlen - 15);
+        }
+    }
+    *pop = op;
+    return 1;
+}
+
+ring_buffer_lz_t *ring_buffer_lz_new(void)
+{
+    //calloc得到的大块内存直接来自mmap，清零的哈希表不需要额外的初始化。
+    ring_buffer_lz_t *lz = calloc(1, sizeof(ring_buffer_lz_t));
+
+    if (lz == NULL)
+    {
+        fprintf(stderr, "%s -- malloc failed.\n", __func__);
+        return NULL;
+    }
+    lz->base = 1;
+    return lz;
+}
+
+void ring_buffer_lz_destroy(ring_buffer_lz_t **lz)
+{
+    if (*lz == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_lz_t ptr is NULL.\n", __func__);
+        return;
+    }
+    free(*lz);
+    *lz = NULL;
+}
+
+size_t ring_buffer_lz_compress(ring_buffer_lz_t *lz, const char *src, size_t len, char *dst, size_t cap)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    unsigned char *op = (unsigned char *)dst;
+    const unsigned char *end = op + cap;
+    size_t ip = 0, anchor = 0, ref, mlen;
+    uint32_t seq, h, base;
+
+    if (len > RING_BUFFER_LZ_MAX_RECORD)
+    {
+        fprintf(stderr, "%s -- block exceed RING_BUFFER_LZ_MAX_RECORD.\n", __func__);
+        return 0;
+    }
+
+    //哈希表中小于base的位置属于之前的数据块，视为无效。
+    if (lz->base >= RING_BUFFER_LZ_BASE_LIMIT)
+    {
+        memset(lz->table, 0, sizeof(lz->table));
+        lz->base = 1;
+    }
+    base = lz->base;
+    lz->base += (uint32_t)len + 1;
+
+    while (ip + RING_BUFFER_LZ_MIN_MATCH <= len)
+    {
+        memcpy(&seq, in + ip, sizeof(seq));
+        h = lz_hash(seq);
+        ref = lz->table[h];
+        lz->table[h] = base + (uint32_t)ip;
+        if (ref < base || memcmp(in + (ref - base), in + ip, RING_BUFFER_LZ_MIN_MATCH) != 0)
+        {
+            //连续找不到匹配时加大步长。
+            ip += 1 + ((ip - anchor) >> 6);
+            continue;
+        }
+
+        ref -= base;
+        mlen = RING_BUFFER_LZ_MIN_MATCH;
+        while (ip + mlen < len && in[ref + mlen] == in[ip + mlen])
+        {
+            mlen++;
+        }
+        if (!lz_emit(&op, end, in + anchor, ip - anchor, ip - ref, mlen))
+        {
+            return 0;
+        }
+        ip += mlen;
+        anchor = ip;
+    }
+
+    if (!lz_emit(&op, end, in + anchor, len - anchor, 0, 0))
+    {
+        return 0;
+    }
+    return (size_t)(op - (unsigned char *)dst);
+}
+
+size_t ring_buffer_lz_decompress(const char *src, size_t len, char *dst, size_t cap)
+{
+    const unsigned char *in = (const unsigned char *)src;
+    unsigned char *out = (unsigned char *)dst;
+    size_t ip = 0, op = 0, lit, offset, mlen, i;
+    unsigned char token;
+
+    while (ip < len)
+    {
+        token = in[ip++];
+        lit = token >> 4;
+        if (lit == 15 && !lz_get_length(in, len, &ip, &lit))
+        {
+            return 0;
+        }
+        if (lit > len - ip || lit > cap - op)
+        {
+            return 0;
+        }
+        memcpy(out + op, in + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == len)
+        {
+            break;
+        }
+
+        if (len - ip < 2)
+        {
+            return 0;
+        }
+        offset = (size_t)in[ip] | ((size_t)in[ip + 1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op)
+        {
+            return 0;
+        }
+        mlen = token & 15;
+        if (mlen == 15 && !lz_get_length(in, len, &ip, &mlen))
+        {
+            return 0;
+        }
+        mlen += RING_BUFFER_LZ_MIN_MATCH;
+        if (mlen > cap - op)
+        {
+            return 0;
+        }
+
+        if (offset >= mlen)
+        {
+            memcpy(out + op, out + op - offset, mlen);
+        }
+        else
+        {
+            //重叠的匹配（例如连续重复的字节）只能逐字节复制。
+            for (i = 0; i < mlen; i++)
+            {
+                out[op + i] = out[op + i - offset];
+            }
+        }
+        op += mlen;
+    }
+    return op;
+}
+
+/**
+ * 把n个字节写到两段内存spans中从offset开始的位置。
+ */
+static void lz_spans_write(ring_buffer_span_t spans[2], size_t offset, const void *src, size_t n)
+{
+    size_t first = 0;
+
+    if (offset < spans[0].len)
+    {
+        first = spans[0].len - offset;
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(spans[0].data + offset, src, first);
+        offset = spans[0].len;
+    }
+    memcpy(spans[1].data + (offset - spans[0].len), (const char *)src + first, n - first);
+}
+
+/**
+ * 从两段内存spans中从offset开始的位置读出n个字节。
+ */
+static void lz_spans_read(const ring_buffer_span_t spans[2], size_t offset, void *dst, size_t n)
+{
+    size_t first = 0;
+
+    if (offset < spans[0].len)
+    {
+        first = spans[0].len - offset;
+        if (first > n)
+        {
+            first = n;
+        }
+        memcpy(dst, spans[0].data + offset, first);
+        offset = spans[0].len;
+    }
+    memcpy((char *)dst + first, spans[1].data + (offset - spans[0].len), n - first);
+}
+
+uint8_t ring_buffer_push_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, const char *data, ring_buffer_size_t len)
+{
+    ring_buffer_span_t spans[2];
+    const char *payload = data;
+    size_t size = len, packed = 0;
+    uint32_t info = (uint32_t)len;
+    uint64_t t0;
+
+    if (len > RING_BUFFER_LZ_MAX_RECORD)
+    {
+        fprintf(stderr, "%s -- record exceed RING_BUFFER_LZ_MAX_RECORD.\n", __func__);
+        return 0;
+    }
+
+    //输出上限为len - 1，压缩后没有变小时返回0，按原样存放。
+    t0 = lz_now_ns();
+    if (len >= RING_BUFFER_LZ_MIN_INPUT)
+    {
+        packed = ring_buffer_lz_compress(lz, data, len, lz->scratch, len - 1);
+    }
+    lz->stats.compress_ns += lz_now_ns() - t0;
+    if (packed != 0)
+    {
+        payload = lz->scratch;
+        size = packed;
+        info |= RING_BUFFER_LZ_PACKED;
+    }
+
+    if (!ring_buffer_reserve_msg(buffer, sizeof(info) + size, spans))
+    {
+        return 0;
+    }
+    lz_spans_write(spans, 0, &info, sizeof(info));
+    lz_spans_write(spans, sizeof(info), payload, size);
+    if (!ring_buffer_commit_msg(buffer, sizeof(info) + size))
+    {
+        return 0;
+    }
+
+    lz->stats.records++;
+    lz->stats.raw_bytes += len;
+    lz->stats.packed_bytes += sizeof(info) + size;
+    lz->stats.stored_records += packed == 0;
+    return 1;
+}
+
+/**
+ * 查看最早的一条记录并校验记录头。
+ * @return 1 - success, 0 - 队列为空, -1 - 记录损坏（已丢弃）。
+ */
+static int lz_front(ring_buffer_t *buffer, ring_buffer_span_t spans[2], uint32_t *info, size_t *size,
+                    const char *caller)
+{
+    size_t total, raw;
+
+    if (!ring_buffer_peek_msg(buffer, spans))
+    {
+        return 0;
+    }
+
+    total = spans[0].len + spans[1].len;
+    if (total >= sizeof(*info))
+    {
+        lz_spans_read(spans, 0, info, sizeof(*info));
+        *size = total - sizeof(*info);
+        raw = *info & ~RING_BUFFER_LZ_PACKED;
+        if (raw <= RING_BUFFER_LZ_MAX_RECORD &&
+            ((*info & RING_BUFFER_LZ_PACKED) ? *size <= RING_BUFFER_LZ_BOUND(raw) : *size == raw))
+        {
+            return 1;
+        }
+    }
+
+    fprintf(stderr, "%s -- corrupted record dropped.\n", caller);
+    ring_buffer_release_msg(buffer);
+    return -1;
+}
+
+/**
+ * 解压spans中从记录头之后开始的size个字节；记录跨越数组末尾时先拼接到scratch中。
+ */
+static int lz_unpack(ring_buffer_lz_t *lz, const ring_buffer_span_t spans[2], size_t size, char *dst, size_t raw)
+{
+    const char *payload = spans[0].data + sizeof(uint32_t);
+
+    if (spans[1].len != 0)
+    {
+        lz_spans_read(spans, sizeof(uint32_t), lz->scratch, size);
+        payload = lz->scratch;
+    }
+    return ring_buffer_lz_decompress(payload, size, dst, raw) == raw;
+}
+
+uint8_t ring_buffer_pop_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, char *data, ring_buffer_size_t *len)
+{
+    ring_buffer_span_t spans[2];
+    uint32_t info;
+    size_t size, raw;
+    uint64_t t0;
+    int ret = lz_front(buffer, spans, &info, &size, __func__);
+
+    if (ret <= 0)
+    {
+        *len = 0;
+        return 0;
+    }
+
+    raw = info & ~RING_BUFFER_LZ_PACKED;
+    if (raw > *len)
+    {
+        *len = raw;
+        return 0;
+    }
+
+    t0 = lz_now_ns();
+    if (!(info & RING_BUFFER_LZ_PACKED))
+    {
+        lz_spans_read(spans, sizeof(info), data, raw);
+    }
+    else if (!lz_unpack(lz, spans, size, data, raw))
+    {
+        fprintf(stderr, "%s -- corrupted record dropped.\n", __func__);
+        ring_buffer_release_msg(buffer);
+        *len = 0;
+        return 0;
+    }
+    lz->stats.decompress_ns += lz_now_ns() - t0;
+    lz->stats.read_records++;
+
+    *len = raw;
+    return ring_buffer_release_msg(buffer);
+}
+
+uint8_t ring_buffer_peek_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, const char **data, ring_buffer_size_t *len)
+{
+    ring_buffer_span_t spans[2];
+    uint32_t info;
+    size_t size, raw;
+    uint64_t t0;
+    int ret = lz_front(buffer, spans, &info, &size, __func__);
+
+    *data = NULL;
+    *len = 0;
+    if (ret <= 0)
+    {
+        return 0;
+    }
+
+    raw = info & ~RING_BUFFER_LZ_PACKED;
+    t0 = lz_now_ns();
+    if (!(info & RING_BUFFER_LZ_PACKED))
+    {
+        //未压缩且连续的记录直接指向队列中的内存。
+        if (spans[0].len >= sizeof(info) + raw)
+        {
+            *data = spans[0].data + sizeof(info);
+        }
+        else
+        {
+            lz_spans_read(spans, sizeof(info), lz->arena, raw);
+            *data = lz->arena;
+        }
+    }
+    else if (lz_unpack(lz, spans, size, lz->arena, raw))
+    {
+        *data = lz->arena;
+    }
+    else
+    {
+        fprintf(stderr, "%s -- corrupted record dropped.\n", __func__);
+        ring_buffer_release_msg(buffer);
+        return 0;
+    }
+    lz->stats.decompress_ns += lz_now_ns() - t0;
+    lz->stats.read_records++;
+
+    *len = raw;
+    return 1;
+}
+
+void ring_buffer_lz_get_stats(const ring_buffer_lz_t *lz, ring_buffer_lz_stats_t *stats)
+{
+    *stats = lz->stats;
+}
@@ -0,0 +1,135 @@
+#include "ringbuffer_msg.h"
+
+/**
+ * @file
+ * 压缩记录：在消息层之上对每条记录做块压缩，内置一个LZ77族（LZ4风格）的编解码器，不依赖外部库。
+ *
+ * 每条记录是一条消息，内容为4字节的记录头（原始长度，最高位表示是否压缩）加上数据。
+ * 压缩后没有变小的记录按原样存放，不可压缩的数据最多多占4字节。
+ * 消费者读出时透明地解压到调用者的缓冲区（ring_buffer_pop_lz），
+ * 或解压到上下文中的缓冲区直接使用（ring_buffer_peek_lz）。
+ *
+ * 编解码需要一个上下文（哈希表和临时缓冲区，约200KB），生产者和消费者各用各的，
+ * 上下文中同时记录压缩率和编解码耗时。队列本身与普通消息队列相同，可以放在共享内存中。
+ */
+
+#ifndef RINGBUFFER_LZ_H
+#define RINGBUFFER_LZ_H
+
+// 单条记录的最大原始长度，匹配偏移用16位表示。
+#define RING_BUFFER_LZ_MAX_RECORD 65536
+// 压缩器哈希表的位数。
+#define RING_BUFFER_LZ_HASH_BITS 12
+// 长度为n的数据压缩后的最大长度（全部是字面量时）。
+#define RING_BUFFER_LZ_BOUND(n) ((n) + (n) / 255 + 16)
+
+/**
+ * 压缩统计，生产者的上下文记录压缩，消费者的上下文记录解压。
+ */
+typedef struct ring_buffer_lz_stats_t
+{
+    /** 写入的记录数。 */
+    uint64_t records;
+    /** 写入的原始字节数。 */
+    uint64_t raw_bytes;
+    /** 实际写入队列的字节数（含记录头），raw_bytes / packed_bytes即压缩率。 */
+    uint64_t packed_bytes;
+    /** 因压缩后没有变小而原样存放的记录数。 */
+    uint64_t stored_records;
+    /** 压缩耗时，纳秒。 */
+    uint64_t compress_ns;
+    /** 读出的记录数。 */
+    uint64_t read_records;
+    /** 解压耗时，纳秒。 */
+    uint64_t decompress_ns;
+} ring_buffer_lz_stats_t;
+
+/**
+ * 编解码上下文，用ring_buffer_lz_new创建，只能在一个线程中使用。
+ */
+typedef struct ring_buffer_lz_t
+{
+    /** 4字节序列的哈希到位置（加上base）的映射，小于base的项已失效。 */
+    uint32_t table[1 << RING_BUFFER_LZ_HASH_BITS];
+    /** 当前数据块的位置基数，每压缩一块增加块长度，避免每次清空哈希表。 */
+    uint32_t base;
+    /** 统计。 */
+    ring_buffer_lz_stats_t stats;
+    /** 压缩输出，或跨越数组末尾的压缩记录拼接后的内容。 */
+    char scratch[RING_BUFFER_LZ_BOUND(RING_BUFFER_LZ_MAX_RECORD)];
+    /** ring_buffer_peek_lz的解压输出。 */
+    char arena[RING_BUFFER_LZ_MAX_RECORD];
+} ring_buffer_lz_t;
+
+/**
+ * @brief 创建编解码上下文。
+ * @return 上下文，失败返回NULL。
+ */
+ring_buffer_lz_t *ring_buffer_lz_new(void);
+
+/**
+ * @brief 销毁上下文，并将指针置为NULL。
+ * @param lz - 上下文指针的地址。
+ */
+void ring_buffer_lz_destroy(ring_buffer_lz_t **lz);
+
+/**
+ * @brief 压缩一块数据。
+ * @param lz - 上下文（只使用哈希表）。
+ * @param src - 原始数据。
+ * @param len - 原始长度，不超过RING_BUFFER_LZ_MAX_RECORD。
+ * @param dst - 输出缓冲区。
+ * @param cap - 输出缓冲区大小，不小于RING_BUFFER_LZ_BOUND(len)时一定成功。
+ * @return 压缩后的长度，输出放不下时返回0。
+ */
+size_t ring_buffer_lz_compress(ring_buffer_lz_t *lz, const char *src, size_t len, char *dst, size_t cap);
+
+/**
+ * @brief 解压一块数据，对损坏的输入做边界检查，不会越界读写。
+ * @param src - 压缩数据。
+ * @param len - 压缩数据长度。
+ * @param dst - 输出缓冲区。
+ * @param cap - 输出缓冲区大小。
+ * @return 解压后的长度，输入损坏或输出放不下时返回0。
+ */
+size_t ring_buffer_lz_decompress(const char *src, size_t len, char *dst, size_t cap);
+
+/**
+ * @brief 压缩并写入一条记录，全有或全无。
+ * @param buffer - 队列。
+ * @param lz - 生产者的上下文。
+ * @param data - 记录内容。
+ * @param len - 记录长度，不超过RING_BUFFER_LZ_MAX_RECORD。
+ * @return 1 - success, 0 - 剩余空间不足或长度超出范围。
+ */
+uint8_t ring_buffer_push_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, const char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 读出最早的一条记录，解压到data中并移除。
+ * @param buffer - 队列。
+ * @param lz - 消费者的上下文。
+ * @param data - 输出缓冲区。
+ * @param len - 输入为data的大小；输出为记录的原始长度，队列为空时为0。
+ * @return 1 - success, 0 - 队列为空、data放不下（记录保留在队列中）或记录损坏（记录被丢弃）。
+ */
+uint8_t ring_buffer_pop_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, char *data, ring_buffer_size_t *len);
+
+/**
+ * @brief 查看最早的一条记录，解压到上下文的缓冲区中，不移除。
+ * 处理完之后调用ring_buffer_release_msg移除；返回的内存在下一次调用之前有效。
+ * @param buffer - 队列。
+ * @param lz - 消费者的上下文。
+ * @param data - 输出参数，记录内容（未压缩的记录可能直接指向队列中的内存）。
+ * @param len - 输出参数，记录的原始长度。
+ * @return 1 - success, 0 - 队列为空或记录损坏（记录被丢弃）。
+ */
+uint8_t ring_buffer_peek_lz(ring_buffer_t *buffer, ring_buffer_lz_t *lz, const char **data, ring_buffer_size_t *len);
+
+/**
+ * @brief 读取上下文中的统计。
+ * @param lz - 上下文。
+ * @param stats - 输出参数。
+ */
+void ring_buffer_lz_get_stats(const ring_buffer_lz_t *lz, ring_buffer_lz_stats_t *stats);
+
+#endif /* RINGBUFFER_LZ_H */
@@ -0,0 +1,236 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ringbuffer_mpmc.h"
+
+/**
+ * @file
+ * Vyukov有界MPMC队列的实现。
+ *
+ * 槽位i的序号初始为i。对第pos个写入位置：序号等于pos表示槽位空闲，
+ * 生产者写完元素后把序号设为pos + 1；消费者读完后把序号设为pos + buffer_cap，
+ * 即下一圈写入时期望的值。
+ */
+
+/** 单个槽位：序号 + 元素 */
+typedef struct
+{
+    _Atomic ring_buffer_size_t seq;
+    char data[];
+} mpmc_slot_t;
+
+static inline mpmc_slot_t *mpmc_slot(ring_buffer_mpmc_t *queue, ring_buffer_size_t pos)
+{
+    return (mpmc_slot_t *)((char *)queue + queue->data_offset +
+                           (size_t)(pos & (queue->buffer_cap - 1)) * queue->slot_size);
+}
+
+static uint32_t mpmc_slot_size(uint32_t elem_size)
+{
+    return (sizeof(mpmc_slot_t) + elem_size + 7) & ~(uint32_t)7;
+}
+
+size_t ring_buffer_mpmc_calc_size(uint32_t elem_size, size_t length)
+{
+    size_t cap = 1;
+
+    if (length > RING_BUFFER_SIZE || elem_size == 0)
+    {
+        fprintf(stderr, "%s -- length exceed RING_BUFFER_SIZE or elem_size is 0.\n", __func__);
+        return 0;
+    }
+
+    while (cap < length)
+    {
+        cap <<= 1;
+    }
+
+    return sizeof(ring_buffer_mpmc_t) + cap * mpmc_slot_size(elem_size);
+}
+
+ring_buffer_mpmc_t *ring_buffer_mpmc_attach(void *addr, uint32_t elem_size, size_t length)
+{
+    ring_buffer_mpmc_t *queue = addr;
+    ring_buffer_size_t i, cap;
+
+    if (addr == NULL || elem_size == 0 || length <= sizeof(ring_buffer_mpmc_t))
+    {
+        fprintf(stderr, "%s -- invalid parameter.\n", __func__);
+        return NULL;
+    }
+
+    //取内存块能容纳的最大2的整数次幂个槽位
+    cap = (length - sizeof(ring_buffer_mpmc_t)) / mpmc_slot_size(elem_size);
+    while (cap & (cap - 1))
+    {
+        cap &= cap - 1;
+    }
+    if (cap == 0)
+    {
+        fprintf(stderr, "%s -- memory block too small for one element.\n", __func__);
+        return NULL;
+    }
+
+    queue->elem_size = elem_size;
+    queue->slot_size = mpmc_slot_size(elem_size);
+    queue->buffer_cap = cap;
+    queue->data_offset = sizeof(ring_buffer_mpmc_t);
+    for (i = 0; i < cap; i++)
+    {
+        atomic_store_explicit(&mpmc_slot(queue, i)->seq, i, memory_order_relaxed);
+    }
+    atomic_store_explicit(&queue->enqueue_pos, 0, memory_order_relaxed);
+    atomic_store_explicit(&queue->dequeue_pos, 0, memory_order_release);
+
+    return queue;
+}
+
+ring_buffer_mpmc_t *ring_buffer_mpmc_new(uint32_t elem_size, ring_buffer_size_t length)
+{
+    void *addr = NULL;
+    size_t alloc_length = ring_buffer_mpmc_calc_size(elem_size, length);
+
+    if (alloc_length == 0)
+    {
+        return NULL;
+    }
+
+    int err = posix_memalign(&addr, RING_BUFFER_CACHE_LINE, alloc_length);
+    if (err != 0)
+    {
+        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(err));
+        return NULL;
+    }
+
+    return ring_buffer_mpmc_attach(addr, elem_size, alloc_length);
+}
+
+void ring_buffer_mpmc_destroy(ring_buffer_mpmc_t **queue)
+{
+    if (*queue == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_mpmc_t ptr is NULL.\n", __func__);
+        return;
+    }
+
+    free(*queue);
+    *queue = NULL;
+}
+
+uint8_t ring_buffer_mpmc_try_enqueue(ring_buffer_mpmc_t *queue, const void *elem)
+{
+    return ring_buffer_mpmc_enqueue_batch(queue, elem, 1) == 1;
+}
+
+uint8_t ring_buffer_mpmc_try_dequeue(ring_buffer_mpmc_t *queue, void *elem)
+{
+    return ring_buffer_mpmc_dequeue_batch(queue, elem, 1) == 1;
+}
+
+/**
+ * 从pos开始，统计最多count个序号等于pos + i + ready的连续槽位。
+ * 生产者ready为0（槽位空闲），消费者ready为1（元素已发布）。
+ * 第一个槽位的序号落后时返回-1，表示队列满（或空）。
+ */
+static ring_buffer_diff_t mpmc_scan(ring_buffer_mpmc_t *queue, ring_buffer_size_t pos,
+                                    ring_buffer_size_t count, ring_buffer_size_t ready)
+{
+    ring_buffer_size_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        ring_buffer_size_t seq = atomic_load_explicit(&mpmc_slot(queue, pos + i)->seq, memory_order_acquire);
+        ring_buffer_diff_t dif = (ring_buffer_diff_t)(seq - (pos + i + ready));
+        if (dif != 0)
+        {
+            /* 第一个槽位还停留在上一圈，说明队列满（或空）。 */
+            if (i == 0 && dif < 0)
+            {
+                return -1;
+            }
+            break;
+        }
+    }
+    return i;
+}
+
+ring_buffer_size_t ring_buffer_mpmc_enqueue_batch(ring_buffer_mpmc_t *queue, const void *elems, ring_buffer_size_t count)
+{
+    ring_buffer_size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    ring_buffer_diff_t n;
+    ring_buffer_size_t i;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        n = mpmc_scan(queue, pos, count, 0);
+        if (n < 0)
+        {
+            return 0;
+        }
+        /* n为0说明其他生产者已经占用了pos，重新读取位置 */
+        if (n > 0 && atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + n,
+                                                           memory_order_relaxed, memory_order_relaxed))
+        {
+            break;
+        }
+        if (n == 0)
+        {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    for (i = 0; i < (ring_buffer_size_t)n; i++)
+    {
+        mpmc_slot_t *slot = mpmc_slot(queue, pos + i);
+        memcpy(slot->data, (const char *)elems + (size_t)i * queue->elem_size, queue->elem_size);
+        atomic_store_explicit(&slot->seq, pos + i + 1, memory_order_release);
+    }
+    return n;
+}
+
+ring_buffer_size_t ring_buffer_mpmc_dequeue_batch(ring_buffer_mpmc_t *queue, void *elems, ring_buffer_size_t count)
+{
+    ring_buffer_size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    ring_buffer_diff_t n;
+    ring_buffer_size_t i;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    for (;;)
+    {
+        n = mpmc_scan(queue, pos, count, 1);
+        if (n < 0)
+        {
+            return 0;
+        }
+        if (n > 0 && atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + n,
+                                                           memory_order_relaxed, memory_order_relaxed))
+        {
+            break;
+        }
+        if (n == 0)
+        {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    for (i = 0; i < (ring_buffer_size_t)n; i++)
+    {
+        mpmc_slot_t *slot = mpmc_slot(queue, pos + i);
+        memcpy((char *)elems + (size_t)i * queue->elem_size, slot->data, queue->elem_size);
+        /* 槽位留给下一圈的生产者 */
+        atomic_store_explicit(&slot->seq, pos + i + queue->buffer_cap, memory_order_release);
+    }
+    return n;
+}
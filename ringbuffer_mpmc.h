@@ -0,0 +1,106 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 多生产者/多消费者（MPMC）有界队列，存放固定大小的元素。
+ * 算法为Dmitry Vyukov的有界MPMC队列：每个槽位带一个序号，
+ * 生产者和消费者分别用CAS竞争enqueue_pos/dequeue_pos，然后通过槽位序号发布和回收，
+ * 所有操作都不阻塞，队列满或空时立即返回。
+ * 与ring_buffer_t一样，数组只以相对偏移保存，可以放在共享内存中使用。
+ */
+
+#ifndef RINGBUFFER_MPMC_H
+#define RINGBUFFER_MPMC_H
+
+/**
+ * Simplifies the use of <tt>struct ring_buffer_mpmc_t</tt>.
+ */
+typedef struct ring_buffer_mpmc_t ring_buffer_mpmc_t;
+
+/**
+ * MPMC队列头部，槽位数组紧跟在结构体之后。
+ * 每个槽位是一个ring_buffer_size_t序号加上元素本身，按8字节对齐。
+ */
+struct ring_buffer_mpmc_t
+{
+    /** 元素大小，以字节为单位。 */
+    uint32_t elem_size;
+    /** 槽位大小，序号+元素，按8字节对齐。 */
+    uint32_t slot_size;
+    /** 槽位个数，2的整数幂次。 */
+    ring_buffer_size_t buffer_cap;
+    /** 槽位数组相对结构体首地址的偏移。 */
+    int64_t data_offset;
+
+    /** 下一个写入位置，生产者之间竞争。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t enqueue_pos;
+    /** 下一个读出位置，消费者之间竞争。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic ring_buffer_size_t dequeue_pos;
+};
+
+/**
+ * @brief 计算需要分配给MPMC队列的内存大小。
+ * @param elem_size - 元素大小，以字节为单位。
+ * @param length - 需要容纳的元素个数，实际容量为不小于length的最小2的整数次幂。
+ * @return 需要分配的内存大小，length超过RING_BUFFER_SIZE时返回0。
+ */
+size_t ring_buffer_mpmc_calc_size(uint32_t elem_size, size_t length);
+
+/**
+ * @brief 分配并初始化MPMC队列。
+ * @param elem_size - 元素大小，以字节为单位。
+ * @param length - 需要容纳的元素个数。
+ * @return 初始化完成的队列对象，失败返回NULL。
+ */
+ring_buffer_mpmc_t *ring_buffer_mpmc_new(uint32_t elem_size, ring_buffer_size_t length);
+
+/**
+ * @brief 销毁ring_buffer_mpmc_new分配的队列，并将指针置为NULL。
+ * @param queue - 队列对象指针的地址。
+ */
+void ring_buffer_mpmc_destroy(ring_buffer_mpmc_t **queue);
+
+/**
+ * @brief 在已分配的内存块（例如共享内存）中初始化MPMC队列。
+ * @param addr - 内存块首地址，按cache line对齐。
+ * @param elem_size - 元素大小，以字节为单位。
+ * @param length - 内存块长度，即ring_buffer_mpmc_calc_size的返回值。
+ * @return 初始化完成的队列对象，失败返回NULL。
+ */
+ring_buffer_mpmc_t *ring_buffer_mpmc_attach(void *addr, uint32_t elem_size, size_t length);
+
+/**
+ * @brief 尝试写入一个元素。
+ * @param queue - 队列对象。
+ * @param elem - 指向elem_size字节的元素。
+ * @return 1 - success, 0 - queue is full.
+ */
+uint8_t ring_buffer_mpmc_try_enqueue(ring_buffer_mpmc_t *queue, const void *elem);
+
+/**
+ * @brief 尝试读出一个元素。
+ * @param queue - 队列对象。
+ * @param elem - 用于存放elem_size字节元素的缓冲区。
+ * @return 1 if an element was returned; 0 - queue is empty.
+ */
+uint8_t ring_buffer_mpmc_try_dequeue(ring_buffer_mpmc_t *queue, void *elem);
+
+/**
+ * @brief 批量写入，一次CAS占用连续的多个槽位。
+ * @param queue - 队列对象。
+ * @param elems - 连续存放的count个元素。
+ * @param count - 希望写入的元素个数。
+ * @return 实际写入的元素个数，可能小于count。
+ */
+ring_buffer_size_t ring_buffer_mpmc_enqueue_batch(ring_buffer_mpmc_t *queue, const void *elems, ring_buffer_size_t count);
+
+/**
+ * @brief 批量读出，一次CAS占用连续的多个槽位。
+ * @param queue - 队列对象。
+ * @param elems - 可存放count个元素的缓冲区。
+ * @param count - 希望读出的最大元素个数。
+ * @return 实际读出的元素个数。
+ */
+ring_buffer_size_t ring_buffer_mpmc_dequeue_batch(ring_buffer_mpmc_t *queue, void *elems, ring_buffer_size_t count);
+
+#endif /* RINGBUFFER_MPMC_H */
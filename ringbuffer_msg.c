@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "ringbuffer_msg.h"
+
+/**
+ * @file
+ * 变长消息层的实现。
+ *
+ * 记录格式：uint32长度头 + 消息内容，整体按RING_BUFFER_MSG_HEADER对齐，
+ * 因此长度头总是完整地落在数组末尾之前。长度头为RING_BUFFER_MSG_SKIP时表示
+ * 从这里到数组末尾都是填充，下一条记录从数组开头开始。
+ */
+
+#define RING_BUFFER_MSG_SKIP 0xFFFFFFFFu
+
+static inline ring_buffer_size_t msg_record_size(ring_buffer_size_t len)
+{
+    return (RING_BUFFER_MSG_HEADER + len + RING_BUFFER_MSG_HEADER - 1) & ~(ring_buffer_size_t)(RING_BUFFER_MSG_HEADER - 1);
+}
+
+/**
+ * 写入位置head处的记录需要的填充字节数：设置了RING_BUFFER_FLAG_MSG_PAD且记录会跨越数组末尾时，
+ * 填充到数组末尾。
+ */
+static ring_buffer_size_t msg_padding(ring_buffer_t *buffer, ring_buffer_size_t head, ring_buffer_size_t record)
+{
+    ring_buffer_size_t to_end = buffer->buffer_cap - (head & buffer->index_mask);
+
+    if ((buffer->flags & (RING_BUFFER_FLAG_MSG_PAD | RING_BUFFER_FLAG_MIRRORED)) != RING_BUFFER_FLAG_MSG_PAD ||
+        record <= to_end)
+    {
+        return 0;
+    }
+    return to_end;
+}
+
+/**
+ * 一条记录的最大长度。需要填充时，跨越数组末尾的记录要占用到数组末尾的剩余空间再加上记录本身，
+ * 剩余空间最多比记录少一个字节，因此记录不超过数组长度的一半时在任何写位置都能放下；
+ * 更长的记录在某些写位置即使队列为空也永远无法写入，直接按超长拒绝。
+ */
+static inline ring_buffer_size_t msg_max_record(ring_buffer_t *buffer)
+{
+    if ((buffer->flags & (RING_BUFFER_FLAG_MSG_PAD | RING_BUFFER_FLAG_MIRRORED)) == RING_BUFFER_FLAG_MSG_PAD)
+    {
+        return buffer->buffer_cap / 2;
+    }
+    return buffer->buffer_cap;
+}
+
+/**
+ * 从两段内存in中截取从offset开始的len个字节。
+ */
+static void msg_sub_spans(const ring_buffer_span_t in[2], ring_buffer_size_t offset, ring_buffer_size_t len,
+                          ring_buffer_span_t out[2])
+{
+    if (offset >= in[0].len)
+    {
+        out[0].data = in[1].data + (offset - in[0].len);
+        out[0].len = len;
+        out[1].data = in[1].data;
+        out[1].len = 0;
+        return;
+    }
+
+    out[0].data = in[0].data + offset;
+    out[0].len = in[0].len - offset;
+    if (out[0].len > len)
+    {
+        out[0].len = len;
+    }
+    out[1].data = in[1].data;
+    out[1].len = len - out[0].len;
+}
+
+/**
+ * 空间不足，整条消息都不写入；RING_BUFFER_DROP_NEWEST策略下计为丢弃的消息。
+ */
+static void msg_count_drop(ring_buffer_t *buffer, ring_buffer_size_t len)
+{
+    if ((buffer->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) == RING_BUFFER_DROP_NEWEST)
+    {
+        atomic_store_explicit(&buffer->dropped_bytes,
+                              atomic_load_explicit(&buffer->dropped_bytes, memory_order_relaxed) + len,
+                              memory_order_relaxed);
+        atomic_store_explicit(&buffer->dropped_msgs,
+                              atomic_load_explicit(&buffer->dropped_msgs, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
+    }
+}
+
+uint8_t ring_buffer_set_msg_pad(ring_buffer_t *buffer, uint8_t enable)
+{
+    if (buffer->flags & (RING_BUFFER_FLAG_JOURNAL | RING_BUFFER_FLAG_BCAST | RING_BUFFER_FLAG_TRACE))
+    {
+        fprintf(stderr, "%s -- ring has its own record format.\n", __func__);
+        return 0;
+    }
+    //队列中已有的记录是按原来的规则写入的，只在队列为空时切换。
+    if (!ring_buffer_is_empty(buffer))
+    {
+        fprintf(stderr, "%s -- ring is not empty.\n", __func__);
+        return 0;
+    }
+
+    if (enable)
+    {
+        buffer->flags |= RING_BUFFER_FLAG_MSG_PAD;
+    }
+    else
+    {
+        buffer->flags &= ~RING_BUFFER_FLAG_MSG_PAD;
+    }
+    return 1;
+}
+
+uint8_t ring_buffer_reserve_msg(ring_buffer_t *buffer, ring_buffer_size_t len, ring_buffer_span_t spans[2])
+{
+    ring_buffer_size_t head = atomic_load_explicit(&buffer->head_index, memory_order_relaxed);
+    ring_buffer_size_t record = msg_record_size(len);
+    ring_buffer_size_t pad;
+    ring_buffer_span_t space[2];
+
+    if (len > UINT32_MAX - RING_BUFFER_MSG_HEADER || record > msg_max_record(buffer))
+    {
+        fprintf(stderr, "%s -- message size exceed buffer size.\n", __func__);
+        return 0;
+    }
+
+    pad = msg_padding(buffer, head, record);
+    if (ring_buffer_reserve(buffer, pad + record, space) != pad + record)
+    {
+        msg_count_drop(buffer, len);
+        return 0;
+    }
+
+    if (pad != 0)
+    {
+        uint32_t skip = RING_BUFFER_MSG_SKIP;
+        memcpy(space[0].data, &skip, sizeof(skip));
+    }
+
+    msg_sub_spans(space, pad + RING_BUFFER_MSG_HEADER, len, spans);
+    return 1;
+}
+
+uint8_t ring_buffer_commit_msg(ring_buffer_t *buffer, ring_buffer_size_t len)
+{
+    ring_buffer_size_t head = atomic_load_explicit(&buffer->head_index, memory_order_relaxed);
+    ring_buffer_size_t record = msg_record_size(len);
+    ring_buffer_size_t pad = msg_padding(buffer, head, record);
+    uint32_t header = (uint32_t)len;
+
+    /* 长度头最后写入，随commit一起发布 */
+    memcpy(ring_buffer_data(buffer) + (ring_buffer_advance(buffer, head, pad) & buffer->index_mask), &header,
+           sizeof(header));
+    return ring_buffer_commit(buffer, pad + record);
+}
+
+uint8_t ring_buffer_push_msg(ring_buffer_t *buffer, const char *data, ring_buffer_size_t len)
+{
+    ring_buffer_span_t spans[2];
+
+    if (!ring_buffer_reserve_msg(buffer, len, spans))
+    {
+        return 0;
+    }
+
+    memcpy(spans[0].data, data, spans[0].len);
+    memcpy(spans[1].data, data + spans[0].len, spans[1].len);
+    return ring_buffer_commit_msg(buffer, len);
+}
+
+/**
+ * 跳过填充，返回最早一条记录的长度头；没有记录时返回0。
+ */
+static uint8_t msg_front(ring_buffer_t *buffer, ring_buffer_span_t space[2], uint32_t *header)
+{
+    for (;;)
+    {
+        if (ring_buffer_peek_spans(buffer, space) == 0)
+        {
+            return 0;
+        }
+
+        /* 记录按长度头对齐，长度头总在第一段中 */
+        memcpy(header, space[0].data, sizeof(*header));
+        if (*header != RING_BUFFER_MSG_SKIP)
+        {
+            return 1;
+        }
+        ring_buffer_consume(buffer, space[0].len);
+    }
+}
+
+uint8_t ring_buffer_peek_msg(ring_buffer_t *buffer, ring_buffer_span_t spans[2])
+{
+    ring_buffer_span_t space[2];
+    uint32_t header;
+
+    if (!msg_front(buffer, space, &header))
+    {
+        return 0;
+    }
+
+    msg_sub_spans(space, RING_BUFFER_MSG_HEADER, header, spans);
+    return 1;
+}
+
+uint8_t ring_buffer_release_msg(ring_buffer_t *buffer)
+{
+    ring_buffer_span_t space[2];
+    uint32_t header;
+
+    if (!msg_front(buffer, space, &header))
+    {
+        return 0;
+    }
+
+    return ring_buffer_consume(buffer, msg_record_size(header));
+}
+
+uint8_t ring_buffer_pop_msg(ring_buffer_t *buffer, char *data, ring_buffer_size_t *len)
+{
+    ring_buffer_span_t spans[2];
+    ring_buffer_size_t msg_len;
+
+    if (!ring_buffer_peek_msg(buffer, spans))
+    {
+        *len = 0;
+        return 0;
+    }
+
+    msg_len = spans[0].len + spans[1].len;
+    if (msg_len > *len)
+    {
+        *len = msg_len;
+        return 0;
+    }
+
+    memcpy(data, spans[0].data, spans[0].len);
+    memcpy(data + spans[0].len, spans[1].data, spans[1].len);
+    *len = msg_len;
+    return ring_buffer_consume(buffer, msg_record_size(msg_len));
+}
+
+void ring_buffer_begin_batch(ring_buffer_t *buffer, ring_buffer_msg_batch_t *batch)
+{
+    batch->buffer = buffer;
+    batch->pending = 0;
+    batch->records = 0;
+}
+
+uint8_t ring_buffer_batch_append(ring_buffer_msg_batch_t *batch, const char *data, ring_buffer_size_t len)
+{
+    ring_buffer_t *buffer = batch->buffer;
+    ring_buffer_size_t head = ring_buffer_advance(buffer, atomic_load_explicit(&buffer->head_index, memory_order_relaxed),
+                                                  batch->pending);
+    ring_buffer_size_t record = msg_record_size(len);
+    ring_buffer_size_t pad, need;
+    ring_buffer_span_t space[2], spans[2];
+    uint32_t header = (uint32_t)len;
+
+    if (len > UINT32_MAX - RING_BUFFER_MSG_HEADER || record > msg_max_record(buffer))
+    {
+        fprintf(stderr, "%s -- message size exceed buffer size.\n", __func__);
+        return 0;
+    }
+
+    /* 从已发布的位置借出整批的空间；空间充足时只用cached_tail计算，不读消费者的缓存行。 */
+    pad = msg_padding(buffer, head, record);
+    need = batch->pending + pad + record;
+    if (ring_buffer_reserve(buffer, need, space) != need)
+    {
+        msg_count_drop(buffer, len);
+        return 0;
+    }
+
+    if (pad != 0)
+    {
+        uint32_t skip = RING_BUFFER_MSG_SKIP;
+        msg_sub_spans(space, batch->pending, sizeof(skip), spans);
+        memcpy(spans[0].data, &skip, sizeof(skip));
+    }
+    /* 长度头按对齐不会跨越数组末尾 */
+    msg_sub_spans(space, need - record, RING_BUFFER_MSG_HEADER, spans);
+    memcpy(spans[0].data, &header, sizeof(header));
+    msg_sub_spans(space, need - record + RING_BUFFER_MSG_HEADER, len, spans);
+    memcpy(spans[0].data, data, spans[0].len);
+    memcpy(spans[1].data, data + spans[0].len, spans[1].len);
+
+    batch->pending = need;
+    batch->records++;
+    return 1;
+}
+
+ring_buffer_size_t ring_buffer_publish_batch(ring_buffer_msg_batch_t *batch)
+{
+    ring_buffer_size_t records = batch->records;
+
+    if (records != 0 && !ring_buffer_commit(batch->buffer, batch->pending))
+    {
+        records = 0;
+    }
+    batch->pending = 0;
+    batch->records = 0;
+    return records;
+}
+
+ring_buffer_size_t ring_buffer_dequeue_batch(ring_buffer_t *buffer, char *data, ring_buffer_size_t cap,
+                                             ring_buffer_size_t lens[], ring_buffer_size_t max)
+{
+    ring_buffer_span_t space[2], spans[2];
+    ring_buffer_size_t items, offset = 0, used = 0, count = 0;
+    uint32_t header;
+
+    if (max == 0)
+    {
+        return 0;
+    }
+
+    lens[0] = 0;
+    items = ring_buffer_peek_spans(buffer, space);
+    while (count < max && offset < items)
+    {
+        msg_sub_spans(space, offset, RING_BUFFER_MSG_HEADER, spans);
+        memcpy(&header, spans[0].data, sizeof(header));
+        if (header == RING_BUFFER_MSG_SKIP)
+        {
+            /* 填充只出现在数组末尾，即第一段的末尾 */
+            offset = space[0].len;
+            continue;
+        }
+        if (header > cap - used)
+        {
+            if (count == 0)
+            {
+                lens[0] = header;
+            }
+            break;
+        }
+
+        msg_sub_spans(space, offset + RING_BUFFER_MSG_HEADER, header, spans);
+        memcpy(data + used, spans[0].data, spans[0].len);
+        memcpy(data + used + spans[0].len, spans[1].data, spans[1].len);
+        used += header;
+        lens[count++] = header;
+        offset += msg_record_size(header);
+    }
+
+    if (offset != 0)
+    {
+        ring_buffer_consume(buffer, offset);
+    }
+    return count;
+}
@@ -0,0 +1,141 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 基于字节队列的变长消息层。
+ * 每条记录由4字节长度头和消息内容组成，整体按4字节对齐。
+ * 写入是全有或全无的：空间不足时不写入任何内容，也不会覆盖未读的记录，
+ * 消费者永远不会看到写了一半的记录。
+ * 队列的溢出策略为RING_BUFFER_DROP_NEWEST时，因空间不足而未写入的消息计入丢弃计数
+ * （ring_buffer_dropped_msgs），其他策略下只返回失败。
+ *
+ * 如果队列设置了RING_BUFFER_FLAG_MSG_PAD（创建后调用ring_buffer_set_msg_pad，或在ring_buffer_attach_array的flags中给出），
+ * 跨越数组末尾的记录会被整体移到数组开头，原位置写入跳过标记，
+ * 这样ring_buffer_peek_msg返回的消息总是一段连续内存；镜像映射的队列本身就是连续的，不需要填充。
+ * 填充后的记录在最坏情况下需要接近两倍的空间，因此设置填充时一条记录（长度头 + 内容，按4字节对齐）
+ * 最多为buffer_cap / 2，即消息最长约为buffer_cap / 2 - RING_BUFFER_MSG_HEADER，更长的消息按超长拒绝，
+ * 不计入丢弃。
+ *
+ * 消息层建立在ring_buffer_reserve/commit和ring_buffer_peek_spans/consume之上，
+ * 生产者和消费者可以在不同线程或进程（共享内存）中并发使用，同一个队列不要再混用字节接口。
+ *
+ * 大量小消息可以批量收发：生产者用ring_buffer_begin_batch开始一批，ring_buffer_batch_append
+ * 只写数据并推进批次中的私有写位置，ring_buffer_publish_batch一次性发布整批；
+ * 消费者用ring_buffer_dequeue_batch一次读出多条消息，只更新一次读位置。
+ * 这样每批只写一次共享的head_index/tail_index，而不是每条消息一次。
+ */
+
+#ifndef RINGBUFFER_MSG_H
+#define RINGBUFFER_MSG_H
+
+// 记录头的大小，记录按此对齐。
+#define RING_BUFFER_MSG_HEADER 4
+
+/**
+ * @brief 打开或关闭RING_BUFFER_FLAG_MSG_PAD。只能在队列为空、没有生产者和消费者在使用时调用，
+ * 打开后最长的消息变为约buffer_cap / 2，ring_buffer_resize会保留这个标志。
+ * @param buffer The buffer to configure.
+ * @param enable 1 - 打开，0 - 关闭。
+ * @return 1 - success, 0 - 队列不为空，或者是日志、广播、事件记录器等有自己记录格式的队列。
+ */
+uint8_t ring_buffer_set_msg_pad(ring_buffer_t *buffer, uint8_t enable);
+
+/**
+ * @brief 写入一条消息。
+ * @param buffer The buffer in which the message should be placed.
+ * @param data 消息内容。
+ * @param len 消息长度，可以为0。
+ * @return 1 - success, 0 - 剩余空间不足（未写入任何内容）。
+ */
+uint8_t ring_buffer_push_msg(ring_buffer_t *buffer, const char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 零拷贝写入：为长度为len的消息借出空间，内容直接写入spans，再调用ring_buffer_commit_msg提交。
+ * @param buffer The buffer in which the message should be placed.
+ * @param len 消息长度。
+ * @param spans 输出参数，消息内容所在的最多两段内存，设置RING_BUFFER_FLAG_MSG_PAD时只有一段。
+ * @return 1 - success, 0 - 剩余空间不足。
+ */
+uint8_t ring_buffer_reserve_msg(ring_buffer_t *buffer, ring_buffer_size_t len, ring_buffer_span_t spans[2]);
+
+/**
+ * @brief 提交ring_buffer_reserve_msg借出的消息，写入长度头并使其对消费者可见。
+ * @param buffer The buffer in which the message has been placed.
+ * @param len 消息长度，必须与ring_buffer_reserve_msg的len相同。
+ * @return 1 - success, 0 - fail.
+ */
+uint8_t ring_buffer_commit_msg(ring_buffer_t *buffer, ring_buffer_size_t len);
+
+/**
+ * @brief 查看最早的一条消息但不移除，消息内容留在队列中。
+ * @param buffer The buffer from which the message should be returned.
+ * @param spans 输出参数，消息内容所在的最多两段内存，消息长度为spans[0].len + spans[1].len。
+ * @return 1 if a message was returned; 0 otherwise.
+ */
+uint8_t ring_buffer_peek_msg(ring_buffer_t *buffer, ring_buffer_span_t spans[2]);
+
+/**
+ * @brief 移除最早的一条消息，通常在ring_buffer_peek_msg处理完之后调用。
+ * @param buffer The buffer from which the message should be removed.
+ * @return 1 if a message was removed; 0 otherwise.
+ */
+uint8_t ring_buffer_release_msg(ring_buffer_t *buffer);
+
+/**
+ * @brief 读出最早的一条消息，拷贝到data中并移除。
+ * @param buffer The buffer from which the message should be returned.
+ * @param data 存放消息内容的缓冲区。
+ * @param len 输入为data的大小；输出为消息长度，队列为空时为0。
+ * @return 1 if a message was returned; 0 - 队列为空，或data放不下（此时消息保留在队列中）。
+ */
+uint8_t ring_buffer_pop_msg(ring_buffer_t *buffer, char *data, ring_buffer_size_t *len);
+
+/**
+ * 生产者的批量写入会话，用ring_buffer_begin_batch初始化。
+ */
+typedef struct ring_buffer_msg_batch_t
+{
+    /** 写入的队列。 */
+    ring_buffer_t *buffer;
+    /** 已写入但尚未发布的字节数（含长度头和填充），私有写位置为head_index + pending。 */
+    ring_buffer_size_t pending;
+    /** 已写入但尚未发布的消息数。 */
+    ring_buffer_size_t records;
+} ring_buffer_msg_batch_t;
+
+/**
+ * @brief 开始一批写入。
+ * @param buffer The buffer in which the messages should be placed.
+ * @param batch 输出参数，批量写入会话。
+ */
+void ring_buffer_begin_batch(ring_buffer_t *buffer, ring_buffer_msg_batch_t *batch);
+
+/**
+ * @brief 在批次中追加一条消息，写入数据但不发布，消费者在ring_buffer_publish_batch之前看不到。
+ * @param batch 批量写入会话。
+ * @param data 消息内容。
+ * @param len 消息长度，可以为0。
+ * @return 1 - success, 0 - 剩余空间不足（未写入任何内容，之前追加的消息不受影响）。
+ */
+uint8_t ring_buffer_batch_append(ring_buffer_msg_batch_t *batch, const char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 发布批次中追加的全部消息，只写一次head_index；之后可以继续在同一个会话中追加。
+ * @param batch 批量写入会话。
+ * @return 发布的消息数。
+ */
+ring_buffer_size_t ring_buffer_publish_batch(ring_buffer_msg_batch_t *batch);
+
+/**
+ * @brief 批量读出最多max条消息，依次拷贝到data中并移除，只写一次tail_index。
+ * @param buffer The buffer from which the messages should be returned.
+ * @param data 存放消息内容的缓冲区，消息首尾相接。
+ * @param cap data的大小，放不下的消息留在队列中。
+ * @param lens 输出参数，每条消息的长度；返回0且队列不为空时，lens[0]为第一条消息的长度（data放不下）。
+ * @param max 最多读出的消息数，lens至少有max项。
+ * @return 读出的消息数。
+ */
+ring_buffer_size_t ring_buffer_dequeue_batch(ring_buffer_t *buffer, char *data, ring_buffer_size_t cap,
+                                             ring_buffer_size_t lens[], ring_buffer_size_t max);
+
+#endif /* RINGBUFFER_MSG_H */
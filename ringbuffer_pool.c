@@ -0,0 +1,354 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "ringbuffer_pool.h"
+
+/**
+ * @file
+ * 队列池的实现。
+ *
+ * arena布局：池头部，各级的next数组（按cache line对齐），各级的槽位（按cache line对齐）。
+ * 空闲链表是Treiber栈，链表头带版本号，next数组单独存放，不会覆盖槽位中的队列头部。
+ */
+
+#define RING_BUFFER_POOL_ALIGN(x) (((x) + RING_BUFFER_CACHE_LINE - 1) & ~(uint64_t)(RING_BUFFER_CACHE_LINE - 1))
+
+/**
+ * 校验各级配置，并把容量向上取整到2的整数幂次。
+ */
+static int ring_buffer_pool_check(const ring_buffer_pool_class_t *classes, size_t num_classes,
+                                  ring_buffer_size_t caps[RING_BUFFER_POOL_MAX_CLASSES])
+{
+    size_t i, alloc_length;
+
+    if (classes == NULL || num_classes == 0 || num_classes > RING_BUFFER_POOL_MAX_CLASSES)
+    {
+        fprintf(stderr, "%s -- num_classes must be 1..%d.\n", __func__, RING_BUFFER_POOL_MAX_CLASSES);
+        return 0;
+    }
+
+    for (i = 0; i < num_classes; i++)
+    {
+        alloc_length = ring_buffer_calc_size(classes[i].capacity);
+        if (alloc_length == 0)
+        {
+            return 0;
+        }
+        caps[i] = (ring_buffer_size_t)(alloc_length - sizeof(ring_buffer_t));
+        if (classes[i].count == 0 || classes[i].count == UINT32_MAX)
+        {
+            fprintf(stderr, "%s -- class %zu has an invalid count.\n", __func__, i);
+            return 0;
+        }
+        if (i > 0 && caps[i] <= caps[i - 1])
+        {
+            fprintf(stderr, "%s -- class capacities must be strictly increasing.\n", __func__);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+size_t ring_buffer_pool_calc_size(const ring_buffer_pool_class_t *classes, size_t num_classes)
+{
+    ring_buffer_size_t caps[RING_BUFFER_POOL_MAX_CLASSES];
+    uint64_t length;
+    size_t i;
+
+    if (!ring_buffer_pool_check(classes, num_classes, caps))
+    {
+        return 0;
+    }
+
+    length = RING_BUFFER_POOL_ALIGN(sizeof(ring_buffer_pool_t));
+    for (i = 0; i < num_classes; i++)
+    {
+        length += RING_BUFFER_POOL_ALIGN((uint64_t)classes[i].count * sizeof(uint32_t));
+    }
+    for (i = 0; i < num_classes; i++)
+    {
+        length += (uint64_t)classes[i].count * RING_BUFFER_POOL_ALIGN(sizeof(ring_buffer_t) + (uint64_t)caps[i]);
+    }
+    return (size_t)length;
+}
+
+ring_buffer_pool_t *ring_buffer_pool_attach(void *addr, size_t length, const ring_buffer_pool_class_t *classes,
+                                            size_t num_classes, ring_buffer_overflow_t policy)
+{
+    ring_buffer_size_t caps[RING_BUFFER_POOL_MAX_CLASSES];
+    ring_buffer_pool_t *pool = addr;
+    ring_buffer_pool_slab_t *slab;
+    size_t need = ring_buffer_pool_calc_size(classes, num_classes);
+    uint64_t offset;
+    size_t i;
+
+    if (addr == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr is NULL.\n", __func__);
+        return NULL;
+    }
+    if (need == 0 || length < need)
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_pool_calc_size().\n", __func__);
+        return NULL;
+    }
+    if (((uint32_t)policy & ~(uint32_t)RING_BUFFER_FLAG_OVERFLOW_MASK) != 0 ||
+        (policy & RING_BUFFER_FLAG_OVERFLOW_MASK) == RING_BUFFER_FLAG_OVERFLOW_MASK)
+    {
+        fprintf(stderr, "%s -- invalid overflow policy %d.\n", __func__, (int)policy);
+        return NULL;
+    }
+    ring_buffer_pool_check(classes, num_classes, caps);
+
+    memset(pool, 0, sizeof(*pool));
+    pool->version = RING_BUFFER_VERSION;
+    pool->num_classes = (uint16_t)num_classes;
+    pool->policy = (uint16_t)policy;
+    pool->length = need;
+
+    //槽位的头部在第一次取出时才初始化，这里只写池头部，不访问arena中其余的页。
+    offset = RING_BUFFER_POOL_ALIGN(sizeof(ring_buffer_pool_t));
+    for (i = 0; i < num_classes; i++)
+    {
+        slab = &pool->slabs[i];
+        slab->capacity = caps[i];
+        slab->count = classes[i].count;
+        slab->slot_size = RING_BUFFER_POOL_ALIGN(sizeof(ring_buffer_t) + (uint64_t)caps[i]);
+        slab->next_offset = (int64_t)offset;
+        offset += RING_BUFFER_POOL_ALIGN((uint64_t)classes[i].count * sizeof(uint32_t));
+    }
+    for (i = 0; i < num_classes; i++)
+    {
+        slab = &pool->slabs[i];
+        slab->slots_offset = (int64_t)offset;
+        offset += (uint64_t)slab->count * slab->slot_size;
+        atomic_store_explicit(&slab->free_head, 0, memory_order_relaxed);
+        atomic_store_explicit(&slab->fresh, 0, memory_order_relaxed);
+        atomic_store_explicit(&slab->in_use, 0, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&pool->magic, RING_BUFFER_POOL_MAGIC, memory_order_release);
+    return pool;
+}
+
+ring_buffer_pool_t *ring_buffer_pool_new(const ring_buffer_pool_class_t *classes, size_t num_classes,
+                                         ring_buffer_overflow_t policy)
+{
+    size_t length = ring_buffer_pool_calc_size(classes, num_classes);
+    ring_buffer_pool_t *pool;
+    void *addr;
+
+    if (length == 0)
+    {
+        return NULL;
+    }
+
+    //匿名映射的页在第一次写入时才分配，没有用到的槽位不占用物理内存。
+    addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    pool = ring_buffer_pool_attach(addr, length, classes, num_classes, policy);
+    if (pool == NULL)
+    {
+        munmap(addr, length);
+        return NULL;
+    }
+    pool->mapped = 1;
+    return pool;
+}
+
+ring_buffer_pool_t *ring_buffer_pool_open(void *addr, size_t length)
+{
+    ring_buffer_pool_t *pool = addr;
+
+    if (addr == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr is NULL.\n", __func__);
+        return NULL;
+    }
+    if (length < sizeof(ring_buffer_pool_t))
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_pool_t.\n", __func__);
+        return NULL;
+    }
+    if (atomic_load_explicit(&pool->magic, memory_order_acquire) != RING_BUFFER_POOL_MAGIC)
+    {
+        fprintf(stderr, "%s -- bad magic, pool is not initialized.\n", __func__);
+        return NULL;
+    }
+    if (pool->version != RING_BUFFER_VERSION || pool->num_classes == 0 ||
+        pool->num_classes > RING_BUFFER_POOL_MAX_CLASSES)
+    {
+        fprintf(stderr, "%s -- layout version %u mismatch (expect %u).\n", __func__, (unsigned)pool->version,
+                (unsigned)RING_BUFFER_VERSION);
+        return NULL;
+    }
+    if (pool->length > length)
+    {
+        fprintf(stderr, "%s -- memory block is smaller than the pool.\n", __func__);
+        return NULL;
+    }
+    return pool;
+}
+
+void ring_buffer_pool_destroy(ring_buffer_pool_t **pool)
+{
+    if (*pool == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_pool_t ptr is NULL.\n", __func__);
+        return;
+    }
+    if (!(*pool)->mapped)
+    {
+        fprintf(stderr, "%s -- pool was not allocated by ring_buffer_pool_new.\n", __func__);
+        return;
+    }
+    munmap(*pool, (*pool)->length);
+    *pool = NULL;
+}
+
+static inline _Atomic uint32_t *ring_buffer_pool_next(ring_buffer_pool_t *pool, ring_buffer_pool_slab_t *slab)
+{
+    return (_Atomic uint32_t *)((char *)pool + slab->next_offset);
+}
+
+static inline ring_buffer_t *ring_buffer_pool_slot(ring_buffer_pool_t *pool, ring_buffer_pool_slab_t *slab,
+                                                   uint32_t index)
+{
+    return (ring_buffer_t *)((char *)pool + slab->slots_offset + (uint64_t)index * slab->slot_size);
+}
+
+/**
+ * 从一级中取出一个槽位：先弹出空闲链表，链表为空时取一个从未用过的槽位并初始化头部。
+ */
+static ring_buffer_t *ring_buffer_pool_take(ring_buffer_pool_t *pool, ring_buffer_pool_slab_t *slab)
+{
+    _Atomic uint32_t *next = ring_buffer_pool_next(pool, slab);
+    uint64_t head = atomic_load_explicit(&slab->free_head, memory_order_acquire);
+    uint64_t desired;
+    uint32_t index, fresh;
+    ring_buffer_t *buffer;
+
+    while ((uint32_t)head != 0)
+    {
+        index = (uint32_t)head - 1;
+        //next[index]可能已被其他线程改写，此时链表头的版本号也已变化，CAS会失败并重试。
+        desired = ((head >> 32) + 1) << 32 | atomic_load_explicit(&next[index], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&slab->free_head, &head, desired, memory_order_acquire,
+                                                  memory_order_acquire))
+        {
+            atomic_fetch_add_explicit(&slab->in_use, 1, memory_order_relaxed);
+            return ring_buffer_pool_slot(pool, slab, index);
+        }
+    }
+
+    fresh = atomic_load_explicit(&slab->fresh, memory_order_relaxed);
+    while (fresh < slab->count)
+    {
+        if (atomic_compare_exchange_weak_explicit(&slab->fresh, &fresh, fresh + 1, memory_order_relaxed,
+                                                  memory_order_relaxed))
+        {
+            buffer = ring_buffer_pool_slot(pool, slab, fresh);
+            ring_buffer_attach_array(buffer, (char *)buffer + sizeof(ring_buffer_t), slab->capacity,
+                                     RING_BUFFER_FLAG_POOLED | pool->policy);
+            atomic_fetch_add_explicit(&slab->in_use, 1, memory_order_relaxed);
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+ring_buffer_t *ring_buffer_pool_acquire(ring_buffer_pool_t *pool, ring_buffer_size_t buffer_length)
+{
+    ring_buffer_t *buffer;
+    uint16_t i;
+
+    if (pool == NULL)
+    {
+        fprintf(stderr, "%s paramater *pool is NULL.\n", __func__);
+        return NULL;
+    }
+    if (buffer_length > pool->slabs[pool->num_classes - 1].capacity)
+    {
+        fprintf(stderr, "%s -- buffer_length exceeds the largest class.\n", __func__);
+        return NULL;
+    }
+
+    for (i = 0; i < pool->num_classes; i++)
+    {
+        if (pool->slabs[i].capacity < buffer_length)
+        {
+            continue;
+        }
+        buffer = ring_buffer_pool_take(pool, &pool->slabs[i]);
+        if (buffer != NULL)
+        {
+            return buffer;
+        }
+    }
+    return NULL;
+}
+
+uint8_t ring_buffer_pool_release(ring_buffer_pool_t *pool, ring_buffer_t *buffer)
+{
+    ring_buffer_pool_slab_t *slab;
+    _Atomic uint32_t *next;
+    uint64_t offset, head, desired;
+    uint32_t index;
+    uint16_t i;
+
+    if (pool == NULL || buffer == NULL)
+    {
+        fprintf(stderr, "%s paramater *pool or *buffer is NULL.\n", __func__);
+        return 0;
+    }
+
+    for (i = 0; i < pool->num_classes; i++)
+    {
+        slab = &pool->slabs[i];
+        offset = (uint64_t)((char *)buffer - ((char *)pool + slab->slots_offset));
+        if (offset < (uint64_t)slab->count * slab->slot_size && offset % slab->slot_size == 0)
+        {
+            break;
+        }
+    }
+    if (i == pool->num_classes || !(buffer->flags & RING_BUFFER_FLAG_POOLED))
+    {
+        fprintf(stderr, "%s -- ring buffer does not belong to this pool.\n", __func__);
+        return 0;
+    }
+    index = (uint32_t)(offset / slab->slot_size);
+
+    ring_buffer_init(buffer);
+
+    next = ring_buffer_pool_next(pool, slab);
+    head = atomic_load_explicit(&slab->free_head, memory_order_relaxed);
+    do
+    {
+        atomic_store_explicit(&next[index], (uint32_t)head, memory_order_relaxed);
+        desired = ((head >> 32) + 1) << 32 | (index + 1);
+    } while (!atomic_compare_exchange_weak_explicit(&slab->free_head, &head, desired, memory_order_release,
+                                                    memory_order_relaxed));
+    atomic_fetch_sub_explicit(&slab->in_use, 1, memory_order_relaxed);
+    return 1;
+}
+
+uint32_t ring_buffer_pool_available(const ring_buffer_pool_t *pool, size_t class_index)
+{
+    const ring_buffer_pool_slab_t *slab;
+
+    if (pool == NULL || class_index >= pool->num_classes)
+    {
+        return 0;
+    }
+    slab = &pool->slabs[class_index];
+    return slab->count - atomic_load_explicit(&slab->in_use, memory_order_relaxed);
+}
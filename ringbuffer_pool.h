@@ -0,0 +1,156 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 队列池：从一整块连续内存（arena）中切分出大量固定容量的队列，适合每个连接一个队列的场景。
+ *
+ * 池按容量分为若干级（size class），每一级是一段连续的槽位（slab），
+ * 每个槽位是一个ring_buffer_t头部加上紧跟其后的数组。空闲槽位通过无锁的空闲链表管理，
+ * ring_buffer_pool_acquire和ring_buffer_pool_release都是O(1)，多个线程（或进程）可以并发调用。
+ * 从未使用过的槽位在第一次被取出时才写入头部，因此arena中没有用到的页不会占用物理内存；
+ * 释放的槽位放回链表头部，下一次取出时优先复用，内存访问集中在少量热的页上。
+ *
+ * 池的头部和空闲链表只保存相对偏移，池可以放在共享内存中：创建者调用ring_buffer_pool_attach，
+ * 其他进程调用ring_buffer_pool_open，任一进程取出的队列可以在另一个进程中释放。
+ * 池中的队列带有RING_BUFFER_FLAG_POOLED，不能用ring_buffer_destroy释放。
+ */
+
+#ifndef RINGBUFFER_POOL_H
+#define RINGBUFFER_POOL_H
+
+// 池的最大级数。
+#define RING_BUFFER_POOL_MAX_CLASSES 8
+// 池头部的magic，"RBPL"。
+#define RING_BUFFER_POOL_MAGIC 0x4C504252u
+
+/**
+ * 创建池时的一级配置。
+ */
+typedef struct ring_buffer_pool_class_t
+{
+    /** 该级队列的容量，向上取整到2的整数幂次，各级必须按容量严格递增。 */
+    ring_buffer_size_t capacity;
+    /** 该级的队列个数。 */
+    uint32_t count;
+} ring_buffer_pool_class_t;
+
+/**
+ * 池中的一级（slab）。
+ */
+typedef struct ring_buffer_pool_slab_t
+{
+    /** 该级队列的容量，2的整数幂次。 */
+    ring_buffer_size_t capacity;
+    /** 该级的队列个数。 */
+    uint32_t count;
+    /** 每个槽位的大小：队列头部加数组，按cache line对齐。 */
+    uint64_t slot_size;
+    /** 第一个槽位相对池首地址的偏移。 */
+    int64_t slots_offset;
+    /** 空闲链表的next数组（每个槽位一个uint32_t）相对池首地址的偏移。 */
+    int64_t next_offset;
+
+    /** 空闲链表头：高32位为版本号（防止ABA），低32位为槽位编号加一，0表示链表为空。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic uint64_t free_head;
+    /** 编号不小于fresh的槽位从未被取出过，头部尚未初始化。 */
+    _Atomic uint32_t fresh;
+    /** 当前被取出的队列个数。 */
+    _Atomic uint32_t in_use;
+} ring_buffer_pool_slab_t;
+
+/**
+ * Simplifies the use of <tt>struct ring_buffer_pool_t</tt>.
+ */
+typedef struct ring_buffer_pool_t ring_buffer_pool_t;
+
+/**
+ * 池头部，放在arena的开头，之后依次是各级的next数组和槽位。
+ */
+struct ring_buffer_pool_t
+{
+    /** 固定为RING_BUFFER_POOL_MAGIC，在头部其余字段写好之后最后写入。 */
+    _Atomic uint32_t magic;
+    /** 内存布局版本，与RING_BUFFER_VERSION相同。 */
+    uint16_t version;
+    /** 级数。 */
+    uint16_t num_classes;
+    /** 池中队列使用的溢出策略。 */
+    uint16_t policy;
+    /** 1表示arena由ring_buffer_pool_new分配。 */
+    uint16_t mapped;
+    /** arena的总长度，即ring_buffer_pool_calc_size的返回值。 */
+    uint64_t length;
+    /** 各级，按容量递增。 */
+    ring_buffer_pool_slab_t slabs[RING_BUFFER_POOL_MAX_CLASSES];
+};
+
+/**
+ * @brief 计算容纳给定各级队列的arena大小。
+ * @param classes - 各级配置，按容量严格递增。
+ * @param num_classes - 级数，不超过RING_BUFFER_POOL_MAX_CLASSES。
+ * @return arena大小，参数无效时返回0。
+ */
+size_t ring_buffer_pool_calc_size(const ring_buffer_pool_class_t *classes, size_t num_classes);
+
+/**
+ * @brief 分配arena（匿名mmap，用到的页才占用物理内存）并初始化池。
+ * @param classes - 各级配置。
+ * @param num_classes - 级数。
+ * @param policy - 池中队列的溢出策略。
+ * @return 初始化完成的池，失败返回NULL。
+ */
+ring_buffer_pool_t *ring_buffer_pool_new(const ring_buffer_pool_class_t *classes, size_t num_classes,
+                                         ring_buffer_overflow_t policy);
+
+/**
+ * @brief 在已分配的内存块（例如共享内存）中初始化池，所有队列都是空闲的。
+ * @param addr - 内存块首地址，按cache line对齐。
+ * @param length - 内存块长度，不小于ring_buffer_pool_calc_size的返回值。
+ * @param classes - 各级配置。
+ * @param num_classes - 级数。
+ * @param policy - 池中队列的溢出策略。
+ * @return 初始化完成的池，失败返回NULL。
+ */
+ring_buffer_pool_t *ring_buffer_pool_attach(void *addr, size_t length, const ring_buffer_pool_class_t *classes,
+                                            size_t num_classes, ring_buffer_overflow_t policy);
+
+/**
+ * @brief 打开其他进程已初始化的池，校验头部，不改变池的状态。
+ * @param addr - 映射到当前进程的内存块首地址。
+ * @param length - 映射长度。
+ * @return 池对象，校验失败返回NULL。
+ */
+ring_buffer_pool_t *ring_buffer_pool_open(void *addr, size_t length);
+
+/**
+ * @brief 销毁ring_buffer_pool_new分配的池并将指针置为NULL，池中的队列随之失效。
+ * @param pool - 池对象指针的地址。
+ */
+void ring_buffer_pool_destroy(ring_buffer_pool_t **pool);
+
+/**
+ * @brief 取出一个空的队列。
+ * 从容量不小于buffer_length的最小一级中取出，该级用完时依次尝试更大的级。
+ * @param pool - 池对象。
+ * @param buffer_length - 需要的队列容量。
+ * @return 空队列，池中没有合适的空闲队列时返回NULL。
+ */
+ring_buffer_t *ring_buffer_pool_acquire(ring_buffer_pool_t *pool, ring_buffer_size_t buffer_length);
+
+/**
+ * @brief 把队列放回池中。队列用ring_buffer_init清空，调用后不能再使用该队列。
+ * @param pool - 队列所属的池。
+ * @param buffer - ring_buffer_pool_acquire返回的队列。
+ * @return 1 - success, 0 - 队列不属于这个池。
+ */
+uint8_t ring_buffer_pool_release(ring_buffer_pool_t *pool, ring_buffer_t *buffer);
+
+/**
+ * @brief 查询某一级当前空闲的队列个数（并发修改时只是一个近似值）。
+ * @param pool - 池对象。
+ * @param class_index - 级编号，按容量从0开始。
+ * @return 空闲队列个数，class_index无效时返回0。
+ */
+uint32_t ring_buffer_pool_available(const ring_buffer_pool_t *pool, size_t class_index);
+
+#endif /* RINGBUFFER_POOL_H */
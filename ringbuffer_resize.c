@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "ringbuffer_resize.h"
+
+/**
+ * @file
+ * 在线调整队列容量的实现。
+ *
+ * 新队列中的数据通常从数组开头连续存放（tail = 0）。设置了RING_BUFFER_FLAG_MSG_PAD的队列中，
+ * 数组末尾可能是消息层的填充记录，它的含义是"跳到数组末尾"，不能搬到新数组的中间；
+ * 这类队列的数据如果跨越了数组末尾，就把第一段放在新数组的末尾，保持原来的分界位置。
+ */
+
+// 不是ring_buffer_new*用posix_memalign分配的队列。
+#define RING_BUFFER_RESIZE_UNSUPPORTED                                                                              \
+    (RING_BUFFER_FLAG_MIRRORED | RING_BUFFER_FLAG_JOURNAL | RING_BUFFER_FLAG_MAPPED | RING_BUFFER_FLAG_POOLED |    \
+     RING_BUFFER_FLAG_BCAST | RING_BUFFER_FLAG_TRACE)
+
+/**
+ * 按队列创建时的规则取整后的容量。
+ */
+static size_t ring_buffer_resize_round(const ring_buffer_t *buffer, ring_buffer_size_t cap)
+{
+    size_t alloc_length = (buffer->flags & RING_BUFFER_FLAG_EXACT_SIZE) ? ring_buffer_calc_size_exact(cap)
+                                                                        : ring_buffer_calc_size(cap);
+    return alloc_length == 0 ? 0 : alloc_length - sizeof(ring_buffer_t);
+}
+
+uint8_t ring_buffer_resize(ring_buffer_t **buffer, ring_buffer_size_t new_cap)
+{
+    ring_buffer_t *old, *resized;
+    ring_buffer_overflow_t policy;
+    ring_buffer_size_t tail, items, index, first, start;
+    char *from, *to;
+
+    if (buffer == NULL || *buffer == NULL)
+    {
+        fprintf(stderr, "%s paramater *buffer is NULL.\n", __func__);
+        return 0;
+    }
+
+    old = *buffer;
+    if ((old->flags & RING_BUFFER_RESIZE_UNSUPPORTED) || old->data_offset != (int64_t)sizeof(ring_buffer_t))
+    {
+        fprintf(stderr, "%s -- only rings allocated by ring_buffer_new* can be resized.\n", __func__);
+        return 0;
+    }
+
+    tail = atomic_load_explicit(&old->tail_index, memory_order_relaxed);
+    items = ring_buffer_distance(old, atomic_load_explicit(&old->head_index, memory_order_relaxed), tail);
+    if (new_cap < items)
+    {
+        fprintf(stderr, "%s -- new capacity is smaller than queued data.\n", __func__);
+        return 0;
+    }
+
+    policy = (ring_buffer_overflow_t)(old->flags & RING_BUFFER_FLAG_OVERFLOW_MASK);
+    resized = (old->flags & RING_BUFFER_FLAG_EXACT_SIZE) ? ring_buffer_new_exact(new_cap, policy)
+                                                         : ring_buffer_new_policy(new_cap, policy);
+    if (resized == NULL)
+    {
+        return 0;
+    }
+    resized->flags |= old->flags & RING_BUFFER_FLAG_MSG_PAD;
+
+    //最多两次memcpy：数组末尾之前的一段和从数组开头开始的一段。
+    from = ring_buffer_data(old);
+    to = ring_buffer_data(resized);
+    index = tail & old->index_mask;
+    first = old->buffer_cap - index;
+    if (first > items)
+    {
+        first = items;
+    }
+    start = 0;
+    if (first < items && (old->flags & RING_BUFFER_FLAG_MSG_PAD))
+    {
+        start = resized->buffer_cap - first;
+    }
+    memcpy(to + start, from + index, first);
+    memcpy(to + (start == 0 ? first : 0), from, items - first);
+
+    atomic_store_explicit(&resized->tail_index, start, memory_order_relaxed);
+    atomic_store_explicit(&resized->head_index, ring_buffer_advance(resized, start, items), memory_order_relaxed);
+    resized->cached_tail = start;
+    resized->cached_head = atomic_load_explicit(&resized->head_index, memory_order_relaxed);
+    atomic_store_explicit(&resized->dropped_bytes, atomic_load_explicit(&old->dropped_bytes, memory_order_relaxed),
+                          memory_order_relaxed);
+    atomic_store_explicit(&resized->dropped_msgs, atomic_load_explicit(&old->dropped_msgs, memory_order_relaxed),
+                          memory_order_relaxed);
+#if RING_BUFFER_STATS
+    //统计字段在头部末尾，调整期间没有其他线程访问，整体拷贝。
+    memcpy((char *)resized + offsetof(ring_buffer_t, stat_enqueued_bytes),
+           (char *)old + offsetof(ring_buffer_t, stat_enqueued_bytes),
+           sizeof(ring_buffer_t) - offsetof(ring_buffer_t, stat_enqueued_bytes));
+#endif
+
+    ring_buffer_destroy(&old);
+    *buffer = resized;
+    return 1;
+}
+
+ring_buffer_size_t ring_buffer_queue_arr_auto(ring_buffer_t **buffer, const char *data, ring_buffer_size_t size,
+                                              ring_buffer_autosize_t *autosize)
+{
+    ring_buffer_size_t cap = (*buffer)->buffer_cap;
+    ring_buffer_size_t need = ring_buffer_num_items(*buffer) + size;
+
+    if (need > cap && cap < autosize->max_cap)
+    {
+        while (cap < need && cap < autosize->max_cap)
+        {
+            cap *= 2;
+        }
+        if (cap > autosize->max_cap)
+        {
+            cap = autosize->max_cap;
+        }
+        //增长失败（内存不足）时按原容量写入，由溢出策略处理。
+        ring_buffer_resize(buffer, cap);
+        autosize->low_count = 0;
+    }
+    return ring_buffer_queue_arr(*buffer, data, size);
+}
+
+uint8_t ring_buffer_autosize_check(ring_buffer_t **buffer, ring_buffer_autosize_t *autosize)
+{
+    ring_buffer_size_t cap = (*buffer)->buffer_cap;
+    ring_buffer_size_t target = cap / 2;
+
+    if (ring_buffer_num_items(*buffer) > cap / 4 || cap <= autosize->min_cap)
+    {
+        autosize->low_count = 0;
+        return 0;
+    }
+    if (++autosize->low_count < autosize->shrink_checks)
+    {
+        return 0;
+    }
+
+    autosize->low_count = 0;
+    if (target < autosize->min_cap)
+    {
+        target = autosize->min_cap;
+    }
+    //下限取整之后可能就是当前容量。
+    if (ring_buffer_resize_round(*buffer, target) >= cap)
+    {
+        return 0;
+    }
+    return ring_buffer_resize(buffer, target);
+}
@@ -0,0 +1,65 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 在线调整队列容量：换一块新的内存，把队列中的数据原样搬过去（最多两次memcpy），数据不丢失。
+ *
+ * 只支持ring_buffer_new/ring_buffer_new_policy/ring_buffer_new_exact创建的队列
+ * （镜像映射、ring_buffer_new_opts、文件映射、队列池和广播队列都会被拒绝；
+ * ring_buffer_attach到用户内存上的队列无法区分，调用者不能对它们使用本文件的接口）。
+ * 调整期间不能有其他线程访问队列，调整成功后旧的ring_buffer_t指针失效。
+ *
+ * 另外提供一个可选的自动调整策略：写入空间不足时按2倍增长到上限，
+ * 读者连续多次检查到使用量不超过容量的1/4时缩小一半，直到下限。
+ * 增长和缩小的阈值不同（满 / 1/4），缩小之后使用量不超过一半，不会立即再次增长。
+ */
+
+#ifndef RINGBUFFER_RESIZE_H
+#define RINGBUFFER_RESIZE_H
+
+/**
+ * 自动调整容量的配置和状态，每个队列一个，由调用者保存。
+ */
+typedef struct ring_buffer_autosize_t
+{
+    /** 缩小的下限。 */
+    ring_buffer_size_t min_cap;
+    /** 增长的上限，达到上限之后按队列的溢出策略处理。 */
+    ring_buffer_size_t max_cap;
+    /** 连续多少次ring_buffer_autosize_check的使用量都不超过容量的1/4才缩小，0按1处理。 */
+    uint32_t shrink_checks;
+    /** 状态：已经连续满足缩小条件的检查次数，初始化为0。 */
+    uint32_t low_count;
+} ring_buffer_autosize_t;
+
+/**
+ * @brief 调整队列容量，保留队列中的数据、溢出策略、消息层标志和丢弃计数。
+ * 新容量按创建时的规则取整（2的整数次幂，或ring_buffer_new_exact创建的队列取8的倍数，
+ * 由RING_BUFFER_FLAG_EXACT_SIZE记录，容量中途是2的整数次幂也不会改变）。
+ * @param buffer - 队列对象指针的地址，成功时指向新的队列。
+ * @param new_cap - 新容量，不能小于队列中已有的数据量。
+ * @return 1 - success, 0 - 失败，队列保持不变。
+ */
+uint8_t ring_buffer_resize(ring_buffer_t **buffer, ring_buffer_size_t new_cap);
+
+/**
+ * @brief 写入数据，空间不足时先按2倍增长容量（不超过autosize->max_cap）。
+ * @param buffer - 队列对象指针的地址，增长后指向新的队列。
+ * @param data - 数据。
+ * @param size - 字节数。
+ * @param autosize - 自动调整的配置和状态。
+ * @return 与ring_buffer_queue_arr相同。
+ */
+ring_buffer_size_t ring_buffer_queue_arr_auto(ring_buffer_t **buffer, const char *data, ring_buffer_size_t size,
+                                              ring_buffer_autosize_t *autosize);
+
+/**
+ * @brief 检查是否需要缩小，通常由读者在读出数据之后调用。
+ * 连续autosize->shrink_checks次使用量不超过容量的1/4时把容量缩小一半（不低于autosize->min_cap）。
+ * @param buffer - 队列对象指针的地址，缩小后指向新的队列。
+ * @param autosize - 自动调整的配置和状态。
+ * @return 1 - 本次缩小了容量，0 - 没有调整。
+ */
+uint8_t ring_buffer_autosize_check(ring_buffer_t **buffer, ring_buffer_autosize_t *autosize);
+
+#endif /* RINGBUFFER_RESIZE_H */
@@ -0,0 +1,384 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ringbuffer_scan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RING_BUFFER_SCAN_X86 1
+#else
+#define RING_BUFFER_SCAN_X86 0
+#endif
+
+/**
+ * @file
+ * 分隔符查找的实现。
+ *
+ * 每种实现提供两个函数：scan在长度为n的内存中查找第一个属于集合set（nset个字节）的字节，
+ * 返回其下标，没有找到返回n；count统计等于某个字节的个数。向量实现处理不足一个向量的尾部时
+ * 调用逐字节实现，因此不会读越过两段内存的末尾。
+ */
+
+typedef size_t (*scan_fn)(const char *p, size_t n, const uint8_t *set, int nset);
+typedef size_t (*count_fn)(const char *p, size_t n, uint8_t c);
+
+static size_t scan_scalar(const char *p, size_t n, const uint8_t *set, int nset)
+{
+    uint8_t table[256];
+    size_t i;
+    int k;
+
+    if (nset == 1)
+    {
+        for (i = 0; i < n; i++)
+        {
+            if ((uint8_t)p[i] == set[0])
+            {
+                return i;
+            }
+        }
+        return n;
+    }
+
+    memset(table, 0, sizeof(table));
+    for (k = 0; k < nset; k++)
+    {
+        table[set[k]] = 1;
+    }
+    for (i = 0; i < n; i++)
+    {
+        if (table[(uint8_t)p[i]])
+        {
+            return i;
+        }
+    }
+    return n;
+}
+
+static size_t count_scalar(const char *p, size_t n, uint8_t c)
+{
+    size_t i, cnt = 0;
+
+    for (i = 0; i < n; i++)
+    {
+        cnt += ((uint8_t)p[i] == c);
+    }
+    return cnt;
+}
+
+#if RING_BUFFER_SCAN_X86
+
+__attribute__((target("sse2")))
+static size_t scan_sse2(const char *p, size_t n, const uint8_t *set, int nset)
+{
+    __m128i needles[RING_BUFFER_SCAN_SET_MAX];
+    size_t i = 0;
+    int k;
+
+    needles[0] = _mm_set1_epi8((char)set[0]);
+    for (k = 1; k < nset; k++)
+    {
+        needles[k] = _mm_set1_epi8((char)set[k]);
+    }
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i m = _mm_cmpeq_epi8(v, needles[0]);
+        unsigned mask;
+
+        for (k = 1; k < nset; k++)
+        {
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(v, needles[k]));
+        }
+        mask = (unsigned)_mm_movemask_epi8(m);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + scan_scalar(p + i, n - i, set, nset);
+}
+
+/**
+ * 比较结果（0或-1）逐字节累加到8位计数器中，最多255轮后用psadbw横向求和，避免每轮做popcount。
+ */
+__attribute__((target("sse2")))
+static size_t count_sse2(const char *p, size_t n, uint8_t c)
+{
+    __m128i needle = _mm_set1_epi8((char)c);
+    __m128i total = _mm_setzero_si128();
+    uint64_t sum[2];
+    size_t i = 0;
+
+    while (i + 16 <= n)
+    {
+        __m128i acc = _mm_setzero_si128();
+        int rounds;
+
+        for (rounds = 0; rounds < 255 && i + 16 <= n; rounds++, i += 16)
+        {
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), needle));
+        }
+        total = _mm_add_epi64(total, _mm_sad_epu8(acc, _mm_setzero_si128()));
+    }
+    _mm_storeu_si128((__m128i *)sum, total);
+    return (size_t)(sum[0] + sum[1]) + count_scalar(p + i, n - i, c);
+}
+
+/**
+ * 单字节查找时每次检查64字节，两个比较结果合并后只做一次分支。
+ */
+__attribute__((target("avx2")))
+static size_t scan_avx2(const char *p, size_t n, const uint8_t *set, int nset)
+{
+    __m256i needles[RING_BUFFER_SCAN_SET_MAX];
+    size_t i = 0;
+    int k;
+
+    needles[0] = _mm256_set1_epi8((char)set[0]);
+    for (k = 1; k < nset; k++)
+    {
+        needles[k] = _mm256_set1_epi8((char)set[k]);
+    }
+    if (nset == 1)
+    {
+        for (; i + 64 <= n; i += 64)
+        {
+            __m256i m0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), needles[0]);
+            __m256i m1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 32)), needles[0]);
+
+            if (!_mm256_testz_si256(_mm256_or_si256(m0, m1), _mm256_or_si256(m0, m1)))
+            {
+                unsigned mask0 = (unsigned)_mm256_movemask_epi8(m0);
+
+                if (mask0 != 0)
+                {
+                    return i + __builtin_ctz(mask0);
+                }
+                return i + 32 + __builtin_ctz((unsigned)_mm256_movemask_epi8(m1));
+            }
+        }
+    }
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i m = _mm256_cmpeq_epi8(v, needles[0]);
+        unsigned mask;
+
+        for (k = 1; k < nset; k++)
+        {
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, needles[k]));
+        }
+        mask = (unsigned)_mm256_movemask_epi8(m);
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + scan_scalar(p + i, n - i, set, nset);
+}
+
+__attribute__((target("avx2")))
+static size_t count_avx2(const char *p, size_t n, uint8_t c)
+{
+    __m256i needle = _mm256_set1_epi8((char)c);
+    __m256i total = _mm256_setzero_si256();
+    uint64_t sum[4];
+    size_t i = 0;
+
+    while (i + 32 <= n)
+    {
+        __m256i acc = _mm256_setzero_si256();
+        int rounds;
+
+        for (rounds = 0; rounds < 255 && i + 32 <= n; rounds++, i += 32)
+        {
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), needle));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(acc, _mm256_setzero_si256()));
+    }
+    _mm256_storeu_si256((__m256i *)sum, total);
+    return (size_t)(sum[0] + sum[1] + sum[2] + sum[3]) + count_scalar(p + i, n - i, c);
+}
+
+#endif /* RING_BUFFER_SCAN_X86 */
+
+// 当前选择的实现，第一次使用时按CPU支持情况初始化。各线程初始化的结果相同，不需要加锁。
+static _Atomic(scan_fn) scan_impl;
+static _Atomic(count_fn) count_impl;
+
+static uint8_t scan_supported(ring_buffer_scan_impl_t impl)
+{
+    switch (impl)
+    {
+    case RING_BUFFER_SCAN_SCALAR:
+        return 1;
+#if RING_BUFFER_SCAN_X86
+    case RING_BUFFER_SCAN_SSE2:
+        return __builtin_cpu_supports("sse2") ? 1 : 0;
+    case RING_BUFFER_SCAN_AVX2:
+        return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+    default:
+        return 0;
+    }
+}
+
+uint8_t ring_buffer_scan_select(ring_buffer_scan_impl_t impl)
+{
+    scan_fn scan = scan_scalar;
+    count_fn count = count_scalar;
+
+    if (impl == RING_BUFFER_SCAN_AUTO)
+    {
+        impl = scan_supported(RING_BUFFER_SCAN_AVX2)   ? RING_BUFFER_SCAN_AVX2
+               : scan_supported(RING_BUFFER_SCAN_SSE2) ? RING_BUFFER_SCAN_SSE2
+                                                       : RING_BUFFER_SCAN_SCALAR;
+    }
+    if (!scan_supported(impl))
+    {
+        fprintf(stderr, "%s -- scan implementation %d is not supported on this CPU\n", __func__, (int)impl);
+        return 0;
+    }
+
+#if RING_BUFFER_SCAN_X86
+    if (impl == RING_BUFFER_SCAN_SSE2)
+    {
+        scan = scan_sse2;
+        count = count_sse2;
+    }
+    else if (impl == RING_BUFFER_SCAN_AVX2)
+    {
+        scan = scan_avx2;
+        count = count_avx2;
+    }
+#endif
+
+    atomic_store_explicit(&count_impl, count, memory_order_relaxed);
+    atomic_store_explicit(&scan_impl, scan, memory_order_relaxed);
+    return 1;
+}
+
+static inline scan_fn scan_get(void)
+{
+    scan_fn scan = atomic_load_explicit(&scan_impl, memory_order_relaxed);
+
+    if (scan == NULL)
+    {
+        ring_buffer_scan_select(RING_BUFFER_SCAN_AUTO);
+        scan = atomic_load_explicit(&scan_impl, memory_order_relaxed);
+    }
+    return scan;
+}
+
+static inline count_fn count_get(void)
+{
+    count_fn count = atomic_load_explicit(&count_impl, memory_order_relaxed);
+
+    if (count == NULL)
+    {
+        ring_buffer_scan_select(RING_BUFFER_SCAN_AUTO);
+        count = atomic_load_explicit(&count_impl, memory_order_relaxed);
+    }
+    return count;
+}
+
+/**
+ * 在偏移[start, limit)范围内查找第一个属于集合set的字节，范围超出队列中的数据时截断。
+ * items不为NULL时输出扫描时队列中的字节数。
+ */
+static ring_buffer_diff_t scan_spans(ring_buffer_t *buffer, ring_buffer_size_t start, ring_buffer_size_t limit,
+                                     const uint8_t *set, int nset, ring_buffer_size_t *items)
+{
+    ring_buffer_span_t spans[2];
+    ring_buffer_size_t avail = ring_buffer_peek_spans(buffer, spans);
+    ring_buffer_size_t base = 0;
+    // 向量实现每个字节要与集合中每个字节比较一次，集合较大时查表更快。
+    scan_fn scan = nset > RING_BUFFER_SCAN_SET_MAX ? scan_scalar : scan_get();
+    int k;
+
+    if (items != NULL)
+    {
+        *items = avail;
+    }
+    if (limit > avail)
+    {
+        limit = avail;
+    }
+    for (k = 0; k < 2 && start < limit; k++)
+    {
+        ring_buffer_size_t end = base + spans[k].len;
+
+        if (start < end)
+        {
+            size_t n = (end < limit ? end : limit) - start;
+            size_t hit = scan(spans[k].data + (start - base), n, set, nset);
+
+            if (hit < n)
+            {
+                return (ring_buffer_diff_t)(start + hit);
+            }
+            start = end;
+        }
+        base = end;
+    }
+    return -1;
+}
+
+ring_buffer_diff_t ring_buffer_find(ring_buffer_t *buffer, char byte, ring_buffer_size_t start)
+{
+    uint8_t set = (uint8_t)byte;
+
+    return scan_spans(buffer, start, buffer->buffer_cap, &set, 1, NULL);
+}
+
+ring_buffer_diff_t ring_buffer_find_any(ring_buffer_t *buffer, const char *set, ring_buffer_size_t start)
+{
+    size_t nset = strlen(set);
+
+    if (nset == 0)
+    {
+        fprintf(stderr, "%s -- empty set\n", __func__);
+        return -1;
+    }
+    return scan_spans(buffer, start, buffer->buffer_cap, (const uint8_t *)set, (int)nset, NULL);
+}
+
+ring_buffer_size_t ring_buffer_count(ring_buffer_t *buffer, char byte)
+{
+    ring_buffer_span_t spans[2];
+    count_fn count = count_get();
+
+    ring_buffer_peek_spans(buffer, spans);
+    return (ring_buffer_size_t)(count(spans[0].data, spans[0].len, (uint8_t)byte) +
+                                count(spans[1].data, spans[1].len, (uint8_t)byte));
+}
+
+ring_buffer_size_t ring_buffer_dequeue_line(ring_buffer_t *buffer, char *data, ring_buffer_size_t len)
+{
+    const uint8_t newline = '\n';
+    ring_buffer_diff_t pos;
+    ring_buffer_size_t n, items;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    // 只需要在前len个字节中查找，更长的行本来也只能读出len个字节。
+    pos = scan_spans(buffer, 0, len, &newline, 1, &items);
+    if (pos >= 0)
+    {
+        n = (ring_buffer_size_t)pos + 1;
+    }
+    else if (items >= len)
+    {
+        n = len;
+    }
+    else
+    {
+        return 0;
+    }
+    return ring_buffer_spsc_dequeue_arr(buffer, data, n);
+}
@@ -0,0 +1,78 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 在队列内容中查找分隔符，适用于把字节队列当作文本协议的行缓冲使用。
+ * 查找直接扫描ring_buffer_peek_spans返回的两段内存，x86上按CPU支持情况在运行时选择
+ * AVX2或SSE2实现，其他平台使用逐字节的实现。
+ *
+ * 这些函数都属于消费者一端，可以与另一线程（或进程）中的SPSC生产者并发使用。
+ * 返回的位置都是相对队列中最早一个字节（tail）的偏移。
+ */
+
+#ifndef RINGBUFFER_SCAN_H
+#define RINGBUFFER_SCAN_H
+
+// ring_buffer_find_any使用向量实现时字符集合的最大长度，更大的集合使用查表实现。
+#define RING_BUFFER_SCAN_SET_MAX 8
+
+/**
+ * 扫描实现，ring_buffer_scan_select的参数。
+ */
+typedef enum ring_buffer_scan_impl_t
+{
+    /** 按CPU支持情况自动选择（默认）。 */
+    RING_BUFFER_SCAN_AUTO = 0,
+    /** 逐字节扫描。 */
+    RING_BUFFER_SCAN_SCALAR,
+    /** 每次比较16字节。 */
+    RING_BUFFER_SCAN_SSE2,
+    /** 每次比较32字节。 */
+    RING_BUFFER_SCAN_AVX2,
+} ring_buffer_scan_impl_t;
+
+/**
+ * @brief 查找第一个等于byte的字节。
+ * @param buffer The buffer to scan.
+ * @param byte 要查找的字节。
+ * @param start 从偏移start开始查找，之前的字节跳过。
+ * @return 找到的字节相对tail的偏移，没有找到返回-1。
+ */
+ring_buffer_diff_t ring_buffer_find(ring_buffer_t *buffer, char byte, ring_buffer_size_t start);
+
+/**
+ * @brief 查找第一个属于集合set的字节，类似strpbrk。
+ * @param buffer The buffer to scan.
+ * @param set 以'\0'结尾的字符集合，不能为空串。
+ * @param start 从偏移start开始查找。
+ * @return 找到的字节相对tail的偏移，没有找到返回-1。
+ */
+ring_buffer_diff_t ring_buffer_find_any(ring_buffer_t *buffer, const char *set, ring_buffer_size_t start);
+
+/**
+ * @brief 统计队列中等于byte的字节个数，例如完整的行数。
+ * @param buffer The buffer to scan.
+ * @param byte 要统计的字节。
+ * @return 出现次数。
+ */
+ring_buffer_size_t ring_buffer_count(ring_buffer_t *buffer, char byte);
+
+/**
+ * @brief 读出一行（包括结尾的'\n'），语义与fgets类似但不添加'\0'。
+ * 队列中的第一行比len长时读出前len个字节，剩余部分留给下一次调用；
+ * 队列中还没有完整的行并且数据不足len字节时不读出任何内容。
+ * @param buffer The buffer from which the line should be returned.
+ * @param data A pointer to the array at which the line should be placed.
+ * @param len data的长度。
+ * @return 读出的字节数，没有完整的行时返回0。
+ */
+ring_buffer_size_t ring_buffer_dequeue_line(ring_buffer_t *buffer, char *data, ring_buffer_size_t len);
+
+/**
+ * @brief 指定扫描实现，主要用于测试和基准对比。
+ * @param impl 扫描实现。
+ * @return 1 - success, 0 - 当前CPU不支持该实现（保持原来的选择）。
+ */
+uint8_t ring_buffer_scan_select(ring_buffer_scan_impl_t impl);
+
+#endif /* RINGBUFFER_SCAN_H */
@@ -0,0 +1,266 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ringbuffer_set.h"
+
+/**
+ * @file
+ * 队列集合的实现。
+ *
+ * 生产者：写入数据（release），seq_cst fence，读取就绪位，没有置位时再fetch_or。
+ * 消费者：fetch_and清除就绪位，seq_cst fence，再读取队列。
+ * 两个fence保证两边至少有一方看到另一方的写入：要么生产者看到位已被清除而重新置位，
+ * 要么消费者读队列时看到新数据，不会出现有数据而没有就绪标记的情况。
+ *
+ * 摘要位由生产者在字从0变为非0时置位，由消费者在扫描到全0的字时清除；
+ * 消费者清除之后重新检查一次这个字，不为0就恢复摘要位，避免与并发的置位冲突。
+ */
+
+static const uint32_t ring_buffer_set_default_weights[RING_BUFFER_SET_LEVELS] = {8, 4, 2, 1};
+
+static inline size_t ring_buffer_set_align(size_t n)
+{
+    return (n + RING_BUFFER_CACHE_LINE - 1) & ~(size_t)(RING_BUFFER_CACHE_LINE - 1);
+}
+
+ring_buffer_set_t *ring_buffer_set_new(uint32_t capacity, const uint32_t weights[RING_BUFFER_SET_LEVELS])
+{
+    ring_buffer_set_t *set;
+    uint32_t words = (capacity + 63) / 64;
+    uint32_t summary_words = (words + 63) / 64;
+    size_t words_size = ring_buffer_set_align((size_t)words * sizeof(uint64_t));
+    size_t summary_size = ring_buffer_set_align((size_t)summary_words * sizeof(uint64_t));
+    size_t alloc_length, offset;
+    char *base;
+    int err, l;
+
+    if (capacity == 0 || capacity > INT32_MAX)
+    {
+        fprintf(stderr, "%s -- capacity must be 1..INT32_MAX.\n", __func__);
+        return NULL;
+    }
+    if (weights == NULL)
+    {
+        weights = ring_buffer_set_default_weights;
+    }
+
+    //头部、各优先级的位图和摘要各自按cache line对齐，队列表放在最后。
+    offset = ring_buffer_set_align(sizeof(ring_buffer_set_t));
+    alloc_length = offset + RING_BUFFER_SET_LEVELS * (words_size + summary_size) +
+                   (size_t)capacity * sizeof(ring_buffer_set_entry_t);
+    err = posix_memalign((void **)&base, RING_BUFFER_CACHE_LINE, alloc_length);
+    if (err != 0)
+    {
+        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(err));
+        return NULL;
+    }
+    memset(base, 0, alloc_length);
+
+    set = (ring_buffer_set_t *)base;
+    set->capacity = capacity;
+    set->count = 0;
+    set->words = words;
+    set->summary_words = summary_words;
+    for (l = 0; l < RING_BUFFER_SET_LEVELS; l++)
+    {
+        set->levels[l].words = (_Atomic uint64_t *)(base + offset);
+        offset += words_size;
+        set->levels[l].summary = (_Atomic uint64_t *)(base + offset);
+        offset += summary_size;
+        set->levels[l].weight = weights[l] != 0 ? weights[l] : 1;
+        set->levels[l].credit = set->levels[l].weight;
+        set->levels[l].cursor = 0;
+    }
+    set->entries = (ring_buffer_set_entry_t *)(base + offset);
+    return set;
+}
+
+void ring_buffer_set_destroy(ring_buffer_set_t **set)
+{
+    if (*set == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_set_t ptr is NULL.\n", __func__);
+        return;
+    }
+    free(*set);
+    *set = NULL;
+}
+
+int ring_buffer_set_add(ring_buffer_set_t *set, ring_buffer_t *ring, uint32_t level, ring_buffer_size_t quantum)
+{
+    ring_buffer_set_entry_t *entry;
+
+    if (ring == NULL)
+    {
+        fprintf(stderr, "%s paramater *ring is NULL.\n", __func__);
+        return -1;
+    }
+    if (level >= RING_BUFFER_SET_LEVELS || quantum == 0)
+    {
+        fprintf(stderr, "%s -- invalid level %u or quantum.\n", __func__, level);
+        return -1;
+    }
+    if (set->count == set->capacity)
+    {
+        fprintf(stderr, "%s -- ring set is full.\n", __func__);
+        return -1;
+    }
+
+    entry = &set->entries[set->count];
+    entry->ring = ring;
+    entry->quantum = quantum;
+    entry->level = level;
+    return (int)set->count++;
+}
+
+void ring_buffer_set_notify(ring_buffer_set_t *set, int id)
+{
+    ring_buffer_set_level_t *lv = &set->levels[set->entries[id].level];
+    _Atomic uint64_t *word = &lv->words[id >> 6];
+    _Atomic uint64_t *summary = &lv->summary[id >> 12];
+    uint64_t bit = 1ULL << (id & 63);
+    uint64_t sbit = 1ULL << ((id >> 6) & 63);
+
+    //与消费者清除就绪位之后的fence配对，见文件说明。
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(word, memory_order_seq_cst) & bit)
+    {
+        return;
+    }
+    atomic_fetch_or_explicit(word, bit, memory_order_seq_cst);
+    if (!(atomic_load_explicit(summary, memory_order_seq_cst) & sbit))
+    {
+        atomic_fetch_or_explicit(summary, sbit, memory_order_seq_cst);
+    }
+}
+
+/**
+ * 查找编号不小于start的第一个就绪的队列，不回绕，没有时返回-1。
+ */
+static int ring_buffer_set_find(ring_buffer_set_t *set, ring_buffer_set_level_t *lv, uint32_t start)
+{
+    uint32_t w = start >> 6, s, k;
+    uint64_t bits, sbits, sbit;
+
+    if (start >= set->count)
+    {
+        return -1;
+    }
+
+    //起点所在的字直接检查，之后的字通过摘要跳过全0的部分。
+    bits = atomic_load_explicit(&lv->words[w], memory_order_seq_cst) & (~0ULL << (start & 63));
+    if (bits != 0)
+    {
+        return (int)(w * 64 + __builtin_ctzll(bits));
+    }
+
+    for (s = (w + 1) >> 6; s < set->summary_words; s++)
+    {
+        sbits = atomic_load_explicit(&lv->summary[s], memory_order_seq_cst);
+        if (s == (w + 1) >> 6)
+        {
+            sbits &= ~0ULL << ((w + 1) & 63);
+        }
+        while (sbits != 0)
+        {
+            k = s * 64 + (uint32_t)__builtin_ctzll(sbits);
+            sbit = sbits & -sbits;
+            sbits &= sbits - 1;
+
+            bits = atomic_load_explicit(&lv->words[k], memory_order_seq_cst);
+            if (bits == 0)
+            {
+                //摘要位已过时：清除后重新检查，生产者可能刚刚置位。
+                atomic_fetch_and_explicit(&lv->summary[s], ~sbit, memory_order_seq_cst);
+                bits = atomic_load_explicit(&lv->words[k], memory_order_seq_cst);
+                if (bits == 0)
+                {
+                    continue;
+                }
+                atomic_fetch_or_explicit(&lv->summary[s], sbit, memory_order_seq_cst);
+            }
+            return (int)(k * 64 + __builtin_ctzll(bits));
+        }
+    }
+    return -1;
+}
+
+/**
+ * 从cursor开始轮流查找一个就绪的队列并清除它的就绪位，没有时返回-1。
+ */
+static int ring_buffer_set_claim(ring_buffer_set_t *set, ring_buffer_set_level_t *lv)
+{
+    uint64_t bit, old;
+    int id;
+
+    for (;;)
+    {
+        id = ring_buffer_set_find(set, lv, lv->cursor);
+        if (id < 0 && lv->cursor != 0)
+        {
+            id = ring_buffer_set_find(set, lv, 0);
+        }
+        if (id < 0)
+        {
+            return -1;
+        }
+
+        bit = 1ULL << (id & 63);
+        old = atomic_fetch_and_explicit(&lv->words[id >> 6], ~bit, memory_order_seq_cst);
+        if (old & bit)
+        {
+            atomic_thread_fence(memory_order_seq_cst);
+            lv->cursor = (uint32_t)id + 1 < set->count ? (uint32_t)id + 1 : 0;
+            return id;
+        }
+    }
+}
+
+int ring_buffer_set_next(ring_buffer_set_t *set, ring_buffer_size_t *quantum)
+{
+    ring_buffer_set_level_t *lv;
+    int pass, l, id, exhausted;
+
+    for (pass = 0; pass < 2; pass++)
+    {
+        exhausted = 0;
+        for (l = 0; l < RING_BUFFER_SET_LEVELS; l++)
+        {
+            lv = &set->levels[l];
+            if (lv->credit == 0)
+            {
+                exhausted = 1;
+                continue;
+            }
+            id = ring_buffer_set_claim(set, lv);
+            if (id >= 0)
+            {
+                lv->credit--;
+                *quantum = set->entries[id].quantum;
+                return id;
+            }
+        }
+
+        //有调度次数的优先级都没有就绪的队列；有用完次数的优先级时开始新的一轮。
+        if (!exhausted)
+        {
+            break;
+        }
+        for (l = 0; l < RING_BUFFER_SET_LEVELS; l++)
+        {
+            set->levels[l].credit = set->levels[l].weight;
+        }
+    }
+    return -1;
+}
+
+void ring_buffer_set_done(ring_buffer_set_t *set, int id)
+{
+    if (!ring_buffer_is_empty(set->entries[id].ring))
+    {
+        ring_buffer_set_notify(set, id);
+    }
+}
@@ -0,0 +1,123 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 队列集合：一个消费者线程服务大量队列时，用就绪位图代替逐个检查ring_buffer_is_empty。
+ *
+ * 生产者写入队列之后调用ring_buffer_set_notify，在位图中置位该队列；
+ * 消费者调用ring_buffer_set_next，用find-first-set扫描位图找到下一个就绪的队列并清除它的位，
+ * 空闲的队列不会被访问。位图分两级：每个64位的字对应64个队列，摘要字中的每一位表示一个字不为0，
+ * 一万个队列的摘要只有3个字，扫描只需要读取很少的cache line。
+ *
+ * 每个队列属于一个优先级（0最高），每个优先级有一个权重：一轮调度中优先级l最多被调度weights[l]次，
+ * 高优先级在前，一轮用完后重新开始，因此低优先级的队列不会被饿死。
+ * 每个队列有一个quantum，ring_buffer_set_next返回给消费者，表示这次最多处理多少字节；
+ * 处理完调用ring_buffer_set_done，队列中还有数据时重新置位，排到同优先级的其他就绪队列之后。
+ * 同一优先级内从上次调度的位置开始扫描，轮流调度。
+ *
+ * 任意多个生产者可以并发调用ring_buffer_set_notify；调度状态只属于一个消费者线程。
+ * 队列集合保存的是队列指针，只能在一个进程中使用。
+ */
+
+#ifndef RINGBUFFER_SET_H
+#define RINGBUFFER_SET_H
+
+// 优先级个数。
+#define RING_BUFFER_SET_LEVELS 4
+
+/**
+ * 集合中的一个队列。
+ */
+typedef struct ring_buffer_set_entry_t
+{
+    /** 队列。 */
+    ring_buffer_t *ring;
+    /** 每次调度最多处理的字节数。 */
+    ring_buffer_size_t quantum;
+    /** 优先级，0最高。 */
+    uint32_t level;
+} ring_buffer_set_entry_t;
+
+/**
+ * 一个优先级的就绪位图和调度状态。
+ */
+typedef struct ring_buffer_set_level_t
+{
+    /** 就绪位图，第id位表示编号为id的队列有数据。 */
+    _Atomic uint64_t *words;
+    /** 摘要位图，第k位表示words[k]可能不为0。 */
+    _Atomic uint64_t *summary;
+    /** 每轮调度的次数。 */
+    uint32_t weight;
+    /** 本轮剩余的调度次数。 */
+    uint32_t credit;
+    /** 下一次从这个编号开始扫描。 */
+    uint32_t cursor;
+} ring_buffer_set_level_t;
+
+/**
+ * 队列集合，用ring_buffer_set_new创建。
+ */
+typedef struct ring_buffer_set_t
+{
+    /** 最多容纳的队列数。 */
+    uint32_t capacity;
+    /** 已加入的队列数，编号为0..count - 1。 */
+    uint32_t count;
+    /** 每个优先级的位图字数。 */
+    uint32_t words;
+    /** 每个优先级的摘要字数。 */
+    uint32_t summary_words;
+    /** 队列表。 */
+    ring_buffer_set_entry_t *entries;
+    /** 各优先级。 */
+    ring_buffer_set_level_t levels[RING_BUFFER_SET_LEVELS];
+} ring_buffer_set_t;
+
+/**
+ * @brief 创建队列集合。
+ * @param capacity - 最多容纳的队列数。
+ * @param weights - 各优先级每轮的调度次数，为NULL时使用{8, 4, 2, 1}，0按1处理。
+ * @return 队列集合，失败返回NULL。
+ */
+ring_buffer_set_t *ring_buffer_set_new(uint32_t capacity, const uint32_t weights[RING_BUFFER_SET_LEVELS]);
+
+/**
+ * @brief 销毁队列集合（不销毁其中的队列），并将指针置为NULL。
+ * @param set - 队列集合指针的地址。
+ */
+void ring_buffer_set_destroy(ring_buffer_set_t **set);
+
+/**
+ * @brief 加入一个队列，应在生产者和消费者开始运行之前完成。
+ * @param set - 队列集合。
+ * @param ring - 队列。
+ * @param level - 优先级，0..RING_BUFFER_SET_LEVELS - 1。
+ * @param quantum - 每次调度最多处理的字节数。
+ * @return 队列编号，集合已满或参数错误返回-1。
+ */
+int ring_buffer_set_add(ring_buffer_set_t *set, ring_buffer_t *ring, uint32_t level, ring_buffer_size_t quantum);
+
+/**
+ * @brief 生产者写入数据之后调用，标记队列就绪；已经标记时不写位图所在的cache line。
+ * @param set - 队列集合。
+ * @param id - 队列编号。
+ */
+void ring_buffer_set_notify(ring_buffer_set_t *set, int id);
+
+/**
+ * @brief 取出下一个就绪的队列并清除其就绪标记，只能由消费者线程调用。
+ * @param set - 队列集合。
+ * @param quantum - 输出参数，这次最多处理的字节数。
+ * @return 队列编号，没有就绪的队列返回-1。
+ */
+int ring_buffer_set_next(ring_buffer_set_t *set, ring_buffer_size_t *quantum);
+
+/**
+ * @brief 消费者处理完ring_buffer_set_next返回的队列之后调用，队列中还有数据时重新标记就绪。
+ * @param set - 队列集合。
+ * @param id - 队列编号。
+ */
+void ring_buffer_set_done(ring_buffer_set_t *set, int id);
+
+#endif /* RINGBUFFER_SET_H */
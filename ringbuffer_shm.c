@@ -0,0 +1,223 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ringbuffer_shm.h"
+
+/**
+ * @file
+ * 共享内存队列的创建与打开，以及镜像映射队列的分配。
+ */
+
+/**
+ * 将fd映射为可读写的共享内存。
+ */
+static void *ring_buffer_map(int fd, size_t length)
+{
+    void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+    return addr;
+}
+
+/**
+ * 设置fd大小、映射并初始化队列头部。
+ */
+static ring_buffer_t *ring_buffer_fd_create(int fd, ring_buffer_size_t buffer_length)
+{
+    size_t length = ring_buffer_calc_size(buffer_length);
+    void *addr;
+
+    if (length == 0)
+    {
+        return NULL;
+    }
+
+    if (ftruncate(fd, length) != 0)
+    {
+        fprintf(stderr, "%s -- ftruncate failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    addr = ring_buffer_map(fd, length);
+    if (addr == NULL)
+    {
+        return NULL;
+    }
+
+    return ring_buffer_attach(addr, length);
+}
+
+ring_buffer_t *ring_buffer_shm_create(const char *name, ring_buffer_size_t buffer_length)
+{
+    ring_buffer_t *buffer;
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s -- shm_open %s failed:%s\n", __func__, name, strerror(errno));
+        return NULL;
+    }
+
+    buffer = ring_buffer_fd_create(fd, buffer_length);
+    close(fd);
+    if (buffer == NULL)
+    {
+        shm_unlink(name);
+    }
+    return buffer;
+}
+
+ring_buffer_t *ring_buffer_shm_open(const char *name)
+{
+    ring_buffer_t *buffer;
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s -- shm_open %s failed:%s\n", __func__, name, strerror(errno));
+        return NULL;
+    }
+
+    buffer = ring_buffer_fd_open(fd);
+    close(fd);
+    return buffer;
+}
+
+ring_buffer_t *ring_buffer_memfd_create(const char *name, ring_buffer_size_t buffer_length, int *fd)
+{
+    ring_buffer_t *buffer;
+
+    *fd = memfd_create(name, MFD_CLOEXEC);
+    if (*fd < 0)
+    {
+        fprintf(stderr, "%s -- memfd_create failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    buffer = ring_buffer_fd_create(*fd, buffer_length);
+    if (buffer == NULL)
+    {
+        close(*fd);
+        *fd = -1;
+    }
+    return buffer;
+}
+
+ring_buffer_t *ring_buffer_fd_open(int fd)
+{
+    struct stat st;
+    ring_buffer_t *buffer;
+    void *addr;
+
+    if (fstat(fd, &st) != 0)
+    {
+        fprintf(stderr, "%s -- fstat failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    addr = ring_buffer_map(fd, st.st_size);
+    if (addr == NULL)
+    {
+        return NULL;
+    }
+
+    buffer = ring_buffer_open(addr, st.st_size);
+    if (buffer == NULL)
+    {
+        munmap(addr, st.st_size);
+    }
+    return buffer;
+}
+
+/**
+ * 把memfd映射为：头部页 + 数组 + 数组的第二份映射。失败返回NULL。
+ */
+static ring_buffer_t *ring_buffer_map_mirrored(size_t cap)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t header = (sizeof(ring_buffer_t) + page - 1) / page * page;
+    char *base = MAP_FAILED;
+    int fd = memfd_create("ring_buffer_mirror", MFD_CLOEXEC);
+
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s -- memfd_create failed:%s\n", __func__, strerror(errno));
+        return NULL;
+    }
+
+    if (ftruncate(fd, header + cap) != 0)
+    {
+        fprintf(stderr, "%s -- ftruncate failed:%s\n", __func__, strerror(errno));
+        goto fail;
+    }
+
+    //先占住整段虚拟地址，再用MAP_FIXED把同一个fd映射进去两次。
+    base = mmap(NULL, header + 2 * cap, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED ||
+        mmap(base, header + cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + header + cap, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, header) == MAP_FAILED)
+    {
+        fprintf(stderr, "%s -- mmap failed:%s\n", __func__, strerror(errno));
+        goto fail;
+    }
+
+    close(fd);
+    return ring_buffer_attach_array(base, base + header, cap, RING_BUFFER_FLAG_MIRRORED);
+
+fail:
+    if (base != MAP_FAILED)
+    {
+        munmap(base, header + 2 * cap);
+    }
+    close(fd);
+    return NULL;
+}
+
+ring_buffer_t *ring_buffer_new_mirrored(ring_buffer_size_t buffer_length)
+{
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t length = ring_buffer_calc_size(buffer_length);
+    ring_buffer_t *buffer;
+
+    if (length == 0)
+    {
+        return NULL;
+    }
+
+    //两次映射都以页为单位，容量不足一页时按一页分配。
+    length -= sizeof(ring_buffer_t);
+    if (length < page)
+    {
+        length = page;
+    }
+
+    buffer = ring_buffer_map_mirrored(length);
+    if (buffer == NULL)
+    {
+        fprintf(stderr, "%s -- mirrored mapping unavailable, fall back to ring_buffer_new.\n", __func__);
+        return ring_buffer_new(buffer_length);
+    }
+    return buffer;
+}
+
+void ring_buffer_shm_close(ring_buffer_t **buffer)
+{
+    if (*buffer == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_t ptr is NULL.\n", __func__);
+        return;
+    }
+
+    munmap(*buffer, (*buffer)->data_offset + (*buffer)->buffer_cap);
+    *buffer = NULL;
+}
@@ -0,0 +1,68 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 基于POSIX共享内存或memfd的环形队列创建/打开辅助函数。
+ * 队列头部只保存数组的相对偏移，所以同一块内存在不同进程中映射到不同地址也可以使用。
+ * 创建者调用ring_buffer_shm_create或ring_buffer_memfd_create，
+ * 其他进程调用ring_buffer_shm_open或ring_buffer_fd_open，打开时只校验头部而不会清空队列。
+ * 生产者和消费者跨进程并发使用时，请使用ring_buffer_spsc_*接口。
+ */
+
+#ifndef RINGBUFFER_SHM_H
+#define RINGBUFFER_SHM_H
+
+/**
+ * @brief 创建一个命名的POSIX共享内存队列（shm_open），并初始化队列头部。
+ * 如果同名对象已存在则失败，不再使用时请调用shm_unlink删除名字。
+ * @param name - 共享内存名字，以'/'开头，例如"/capture_ring"。
+ * @param buffer_length - 队列容量，规则与ring_buffer_new相同。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_shm_create(const char *name, ring_buffer_size_t buffer_length);
+
+/**
+ * @brief 打开一个已经存在的命名共享内存队列，校验头部，不清空队列。
+ * @param name - 共享内存名字。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_shm_open(const char *name);
+
+/**
+ * @brief 创建一个memfd匿名共享内存队列。
+ * 返回的文件描述符可以通过fork继承或者通过unix socket传递给其他进程，
+ * 对方使用ring_buffer_fd_open打开。
+ * @param name - memfd名字，仅用于调试（/proc/PID/fd中可见）。
+ * @param buffer_length - 队列容量，规则与ring_buffer_new相同。
+ * @param fd - 输出参数，memfd文件描述符，由调用者负责close。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_memfd_create(const char *name, ring_buffer_size_t buffer_length, int *fd);
+
+/**
+ * @brief 映射一个已经包含队列的文件描述符（memfd或shm_open得到的fd），校验头部，不清空队列。
+ * @param fd - 文件描述符，函数返回后可以关闭。
+ * @return 映射到当前进程的队列对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_fd_open(int fd);
+
+/**
+ * @brief 分配一个镜像映射的队列（magic ring buffer）。
+ * 通过memfd把同一段物理内存连续映射两次，数组末尾之后紧跟着数组开头，
+ * 因此从任意位置开始、长度不超过容量的数据在虚拟地址上总是连续的，读写不需要拆分。
+ * 队列容量至少为一个内存页。映射失败时打印警告并退回到ring_buffer_new的普通分配，
+ * 可以通过flags中的RING_BUFFER_FLAG_MIRRORED判断实际的分配方式。
+ * 使用ring_buffer_destroy释放。
+ * @param buffer_length 申请分配队列的大小，规则与ring_buffer_new相同。
+ * @return 初始化完成的ring_buffer_t结构体对象，失败返回NULL。
+ */
+ring_buffer_t *ring_buffer_new_mirrored(ring_buffer_size_t buffer_length);
+
+/**
+ * @brief 解除当前进程对共享内存队列的映射，并将指针置为NULL。
+ * 只解除映射，不会删除共享内存对象。
+ * @param buffer - 队列对象指针的地址。
+ */
+void ring_buffer_shm_close(ring_buffer_t **buffer);
+
+#endif /* RINGBUFFER_SHM_H */
@@ -0,0 +1,311 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ringbuffer_trace.h"
+
+/**
+ * @file
+ * 事件记录器的实现。
+ *
+ * 第seq条记录写入时覆盖第seq - slots条，因此claim为c时，序号小于c - slots的记录已经（或正在）被覆盖。
+ * 读者先拷贝，再执行acquire fence读取claim，与生产者写入之前的release fence配对：
+ * 只要拷贝读到了新写入的字节，就一定能读到对应的claim，从而丢弃这条记录。
+ */
+
+static inline ring_buffer_trace_record_t *ring_buffer_trace_slot(const ring_buffer_trace_t *trace, uint64_t seq)
+{
+    return (ring_buffer_trace_record_t *)(ring_buffer_data(&trace->ring) +
+                                          ((seq & (trace->slots - 1)) << trace->slot_shift));
+}
+
+/**
+ * claim对应的最早一条完整记录的序号。
+ */
+static inline uint64_t ring_buffer_trace_oldest(const ring_buffer_trace_t *trace, uint64_t claim)
+{
+    return claim > trace->slots ? claim - trace->slots : 0;
+}
+
+/**
+ * 拷贝之后读取claim，返回此时最早一条完整记录的序号。
+ */
+static inline uint64_t ring_buffer_trace_validate(ring_buffer_trace_t *trace)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return ring_buffer_trace_oldest(trace, atomic_load_explicit(&trace->claim, memory_order_relaxed));
+}
+
+uint64_t ring_buffer_trace_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+size_t ring_buffer_trace_calc_size(size_t length)
+{
+    size_t alloc_length = ring_buffer_calc_size(length);
+
+    if (alloc_length == 0)
+    {
+        return 0;
+    }
+    return alloc_length - sizeof(ring_buffer_t) + sizeof(ring_buffer_trace_t);
+}
+
+ring_buffer_trace_t *ring_buffer_trace_attach(void *addr, size_t length, uint32_t slot_size)
+{
+    ring_buffer_trace_t *trace = addr;
+    size_t cap = 1;
+    uint32_t shift = 0;
+
+    if (addr == NULL)
+    {
+        fprintf(stderr, "%s paramater *addr is NULL.\n", __func__);
+        return NULL;
+    }
+    if (slot_size < RING_BUFFER_TRACE_MIN_SLOT || (slot_size & (slot_size - 1)) != 0)
+    {
+        fprintf(stderr, "%s -- slot_size must be a power of two >= %d.\n", __func__, RING_BUFFER_TRACE_MIN_SLOT);
+        return NULL;
+    }
+    if (length <= sizeof(ring_buffer_trace_t))
+    {
+        fprintf(stderr, "%s -- memory block is smaller than ring_buffer_trace_t.\n", __func__);
+        return NULL;
+    }
+
+    //槽位按序号取模定位，数组长度向下取整到2的整数次幂。
+    while (cap <= (length - sizeof(ring_buffer_trace_t)) / 2)
+    {
+        cap <<= 1;
+    }
+    if (cap < slot_size || cap > RING_BUFFER_SIZE)
+    {
+        fprintf(stderr, "%s -- buffer_cap must be slot_size..RING_BUFFER_SIZE.\n", __func__);
+        return NULL;
+    }
+    while (((uint32_t)1 << shift) < slot_size)
+    {
+        shift++;
+    }
+
+    atomic_store_explicit(&trace->claim, 0, memory_order_relaxed);
+    atomic_store_explicit(&trace->head, 0, memory_order_relaxed);
+    trace->last_ts = 0;
+    trace->slot_size = slot_size;
+    trace->slot_shift = shift;
+    trace->slots = cap >> shift;
+
+    //magic在ring_buffer_attach_array中最后写入，槽位参数此时已经初始化完成。
+    if (ring_buffer_attach_array(addr, (char *)addr + sizeof(ring_buffer_trace_t), (ring_buffer_size_t)cap,
+                                 RING_BUFFER_FLAG_TRACE | RING_BUFFER_OVERWRITE) == NULL)
+    {
+        return NULL;
+    }
+    return trace;
+}
+
+ring_buffer_trace_t *ring_buffer_trace_new(ring_buffer_size_t buffer_length, uint32_t slot_size)
+{
+    size_t alloc_length = ring_buffer_trace_calc_size(buffer_length);
+    ring_buffer_trace_t *trace;
+    int err;
+
+    if (alloc_length == 0)
+    {
+        return NULL;
+    }
+
+    err = posix_memalign((void **)&trace, RING_BUFFER_CACHE_LINE, alloc_length);
+    if (err != 0)
+    {
+        fprintf(stderr, "%s -- malloc failed:%s\n", __func__, strerror(err));
+        return NULL;
+    }
+
+    if (ring_buffer_trace_attach(trace, alloc_length, slot_size) == NULL)
+    {
+        free(trace);
+        return NULL;
+    }
+    return trace;
+}
+
+void ring_buffer_trace_destroy(ring_buffer_trace_t **trace)
+{
+    if (*trace == NULL)
+    {
+        fprintf(stderr, "%s -- ring_buffer_trace_t ptr is NULL.\n", __func__);
+        return;
+    }
+    free(*trace);
+    *trace = NULL;
+}
+
+ring_buffer_trace_t *ring_buffer_trace_open(void *addr, size_t length)
+{
+    ring_buffer_t *ring = ring_buffer_open(addr, length);
+    ring_buffer_trace_t *trace = (ring_buffer_trace_t *)ring;
+
+    if (ring == NULL)
+    {
+        return NULL;
+    }
+    if (!(ring->flags & RING_BUFFER_FLAG_TRACE) || ring->data_offset < (int64_t)sizeof(ring_buffer_trace_t) ||
+        trace->slot_size < RING_BUFFER_TRACE_MIN_SLOT || trace->slot_size != (uint32_t)1 << trace->slot_shift ||
+        trace->slots == 0 || (trace->slots & (trace->slots - 1)) != 0 ||
+        trace->slots << trace->slot_shift != (uint64_t)ring->buffer_cap)
+    {
+        fprintf(stderr, "%s -- memory block is not a trace ring buffer.\n", __func__);
+        return NULL;
+    }
+    return trace;
+}
+
+uint8_t ring_buffer_trace_write(ring_buffer_trace_t *trace, const char *data, uint32_t len)
+{
+    return ring_buffer_trace_write_ts(trace, ring_buffer_trace_now(), data, len);
+}
+
+uint8_t ring_buffer_trace_write_ts(ring_buffer_trace_t *trace, uint64_t ts, const char *data, uint32_t len)
+{
+    uint64_t seq = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    ring_buffer_trace_record_t *record;
+
+    if (len > trace->slot_size - sizeof(ring_buffer_trace_record_t))
+    {
+        fprintf(stderr, "%s -- record exceed slot size.\n", __func__);
+        return 0;
+    }
+
+    //二分查找依赖记录按时间排序。
+    if (ts < trace->last_ts)
+    {
+        ts = trace->last_ts;
+    }
+    trace->last_ts = ts;
+
+    //先发布claim，再覆盖第seq - slots条记录。
+    atomic_store_explicit(&trace->claim, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    record = ring_buffer_trace_slot(trace, seq);
+    record->ts = ts;
+    record->seq = seq;
+    record->len = len;
+    record->reserved = 0;
+    memcpy(record->data, data, len);
+
+    atomic_store_explicit(&trace->head, seq + 1, memory_order_release);
+    return 1;
+}
+
+uint64_t ring_buffer_trace_seek(ring_buffer_trace_t *trace, ring_buffer_trace_iter_t *it, uint64_t from, uint64_t to)
+{
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    uint64_t lo = ring_buffer_trace_oldest(trace, atomic_load_explicit(&trace->claim, memory_order_acquire));
+    uint64_t hi = head, mid;
+
+    //读取head之后生产者可能已经转过一圈，claim - slots会超过head，此时窗口为空。
+    if (lo > head)
+    {
+        lo = head;
+    }
+
+    //查找期间最早的记录可能被覆盖，读到的时间戳偏大，结果只会偏早；ring_buffer_trace_next会跳过这些记录。
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (ring_buffer_trace_slot(trace, mid)->ts < from)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    it->next = lo;
+    it->end = head;
+    it->from = from;
+    it->to = to;
+    it->lost = 0;
+    return head - lo;
+}
+
+uint8_t ring_buffer_trace_next(ring_buffer_trace_t *trace, ring_buffer_trace_iter_t *it,
+                               ring_buffer_trace_record_t *record)
+{
+    const ring_buffer_trace_record_t *slot;
+    uint32_t len, max_len = trace->slot_size - sizeof(ring_buffer_trace_record_t);
+    uint64_t oldest;
+
+    while (it->next < it->end)
+    {
+        slot = ring_buffer_trace_slot(trace, it->next);
+        memcpy(record, slot, sizeof(*record));
+        //记录头可能是正在写入的内容，长度先截断到槽位之内，是否有效以claim为准。
+        len = record->len < max_len ? record->len : max_len;
+        memcpy(record->data, slot->data, len);
+
+        oldest = ring_buffer_trace_validate(trace);
+        if (it->next < oldest)
+        {
+            oldest = oldest < it->end ? oldest : it->end;
+            it->lost += oldest - it->next;
+            it->next = oldest;
+            continue;
+        }
+
+        it->next++;
+        if (record->ts < it->from)
+        {
+            continue;
+        }
+        if (record->ts > it->to)
+        {
+            it->next = it->end;
+            return 0;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+uint64_t ring_buffer_trace_snapshot(ring_buffer_trace_t *trace, void *out, uint64_t max)
+{
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+    uint64_t count = head < trace->slots ? head : trace->slots;
+    uint64_t start, first, oldest, drop;
+
+    if (count > max)
+    {
+        count = max;
+    }
+    start = head - count;
+
+    //最多两次memcpy：数组末尾之前的槽位和从数组开头开始的槽位。
+    first = trace->slots - (start & (trace->slots - 1));
+    if (first > count)
+    {
+        first = count;
+    }
+    memcpy(out, ring_buffer_trace_slot(trace, start), first << trace->slot_shift);
+    memcpy((char *)out + (first << trace->slot_shift), ring_buffer_data(&trace->ring),
+           (count - first) << trace->slot_shift);
+
+    oldest = ring_buffer_trace_validate(trace);
+    if (start < oldest)
+    {
+        drop = oldest - start < count ? oldest - start : count;
+        count -= drop;
+        memmove(out, (char *)out + (drop << trace->slot_shift), count << trace->slot_shift);
+    }
+    return count;
+}
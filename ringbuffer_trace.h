@@ -0,0 +1,179 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 事件记录器（flight recorder）：每条记录带一个单调递增的时间戳，写满后覆盖最早的记录。
+ *
+ * 数组按固定大小的槽位划分，第seq条记录放在槽位seq % 槽位数中，记录按时间顺序排列，
+ * 因此可以按时间戳二分查找一个时间窗口，不需要像ring_buffer_dequeue_arr那样读出并解析全部数据。
+ * 查询和快照都是只读的，不移动任何位置，可以有任意多个读者与生产者并发运行。
+ *
+ * 生产者写入一条记录之前先发布claim（即将写入的记录序号加1），读者拷贝之后再检查claim，
+ * 丢弃拷贝期间被覆盖的记录，原理与seqlock相同（见ringbuffer_bcast.h的覆盖策略）。
+ *
+ * 时间戳默认取CLOCK_MONOTONIC的纳秒数（ring_buffer_trace_now）；也可以用ring_buffer_trace_write_ts
+ * 传入其他单调的时钟（例如TSC），查询时使用同一种时钟即可。同一个记录器只能有一个生产者。
+ *
+ * 头部只保存相对偏移，可以放在共享内存中：创建者调用ring_buffer_trace_attach，
+ * 其他进程调用ring_buffer_trace_open后直接查询。ring中的head_index/tail_index不使用。
+ */
+
+#ifndef RINGBUFFER_TRACE_H
+#define RINGBUFFER_TRACE_H
+
+// 槽位大小的下限。
+#define RING_BUFFER_TRACE_MIN_SLOT 32
+
+/**
+ * 槽位中的一条记录，data之后到槽位末尾是记录内容。
+ */
+typedef struct ring_buffer_trace_record_t
+{
+    /** 时间戳。 */
+    uint64_t ts;
+    /** 记录序号，从0开始。 */
+    uint64_t seq;
+    /** 记录长度。 */
+    uint32_t len;
+    /** 保留，写为0。 */
+    uint32_t reserved;
+    /** 记录内容。 */
+    char data[];
+} ring_buffer_trace_record_t;
+
+/**
+ * Simplifies the use of <tt>struct ring_buffer_trace_t</tt>.
+ */
+typedef struct ring_buffer_trace_t ring_buffer_trace_t;
+
+/**
+ * 事件记录器头部，数组紧跟在结构体之后。
+ */
+struct ring_buffer_trace_t
+{
+    /** 队列头部：魔数、容量和数组偏移。 */
+    ring_buffer_t ring;
+    /** 生产者即将写入的记录序号加1，在写入数据之前发布。 */
+    _Alignas(RING_BUFFER_CACHE_LINE) _Atomic uint64_t claim;
+    /** 已写完的记录数，即下一条记录的序号。 */
+    _Atomic uint64_t head;
+    /** 最后一条记录的时间戳，生产者用来保证时间戳不减小。 */
+    uint64_t last_ts;
+    /** 槽位大小，2的整数次幂。 */
+    uint32_t slot_size;
+    /** log2(slot_size)。 */
+    uint32_t slot_shift;
+    /** 槽位数，2的整数次幂。 */
+    uint64_t slots;
+};
+
+/**
+ * 时间窗口查询的迭代器，由ring_buffer_trace_seek初始化。
+ */
+typedef struct ring_buffer_trace_iter_t
+{
+    /** 下一条要读的记录序号。 */
+    uint64_t next;
+    /** 查询时的head，之后写入的记录不在本次查询中。 */
+    uint64_t end;
+    /** 时间窗口的起点（含）。 */
+    uint64_t from;
+    /** 时间窗口的终点（含）。 */
+    uint64_t to;
+    /** 查询期间被生产者覆盖而跳过的记录数。 */
+    uint64_t lost;
+} ring_buffer_trace_iter_t;
+
+/**
+ * @brief 当前时间，CLOCK_MONOTONIC的纳秒数。
+ * @return 时间戳。
+ */
+uint64_t ring_buffer_trace_now(void);
+
+/**
+ * @brief 计算事件记录器需要的内存大小。
+ * @param length - 数组长度，按2的整数次幂向上取整。
+ * @return 需要分配的内存大小，length超过RING_BUFFER_SIZE时返回0。
+ */
+size_t ring_buffer_trace_calc_size(size_t length);
+
+/**
+ * @brief 分配并初始化事件记录器。
+ * @param buffer_length - 数组长度，按2的整数次幂向上取整。
+ * @param slot_size - 槽位大小（含记录头），2的整数次幂，不小于RING_BUFFER_TRACE_MIN_SLOT，不大于数组长度。
+ * @return 初始化完成的记录器，失败返回NULL。
+ */
+ring_buffer_trace_t *ring_buffer_trace_new(ring_buffer_size_t buffer_length, uint32_t slot_size);
+
+/**
+ * @brief 销毁ring_buffer_trace_new分配的记录器，并将指针置为NULL。
+ * @param trace - 记录器指针的地址。
+ */
+void ring_buffer_trace_destroy(ring_buffer_trace_t **trace);
+
+/**
+ * @brief 在已分配的内存块（例如共享内存）中初始化事件记录器。
+ * @param addr - 内存块首地址，按cache line对齐。
+ * @param length - 内存块长度，通常是ring_buffer_trace_calc_size的返回值；数组长度按2的整数次幂向下取整。
+ * @param slot_size - 槽位大小，规则同ring_buffer_trace_new。
+ * @return 初始化完成的记录器，失败返回NULL。
+ */
+ring_buffer_trace_t *ring_buffer_trace_attach(void *addr, size_t length, uint32_t slot_size);
+
+/**
+ * @brief 打开其他进程已初始化的事件记录器，校验头部，不改变记录器状态。
+ * @param addr - 映射到当前进程的内存块首地址。
+ * @param length - 映射长度。
+ * @return 记录器对象，校验失败返回NULL。
+ */
+ring_buffer_trace_t *ring_buffer_trace_open(void *addr, size_t length);
+
+/**
+ * @brief 以当前时间写入一条记录，写满后覆盖最早的记录。
+ * @param trace - 记录器。
+ * @param data - 记录内容。
+ * @param len - 记录长度，不超过slot_size - sizeof(ring_buffer_trace_record_t)。
+ * @return 1 - success, 0 - 记录太长。
+ */
+uint8_t ring_buffer_trace_write(ring_buffer_trace_t *trace, const char *data, uint32_t len);
+
+/**
+ * @brief 以指定的时间戳写入一条记录。
+ * @param trace - 记录器。
+ * @param ts - 时间戳，小于上一条记录时按上一条记录的时间戳保存，保证记录按时间排序。
+ * @param data - 记录内容。
+ * @param len - 记录长度。
+ * @return 1 - success, 0 - 记录太长。
+ */
+uint8_t ring_buffer_trace_write_ts(ring_buffer_trace_t *trace, uint64_t ts, const char *data, uint32_t len);
+
+/**
+ * @brief 二分查找时间窗口[from, to]内的第一条记录，初始化迭代器，不移动任何位置。
+ * @param trace - 记录器。
+ * @param it - 输出参数，迭代器。
+ * @param from - 窗口起点（含）。
+ * @param to - 窗口终点（含）。
+ * @return 查询时记录器中不早于from的记录数（可能包含晚于to的记录）。
+ */
+uint64_t ring_buffer_trace_seek(ring_buffer_trace_t *trace, ring_buffer_trace_iter_t *it, uint64_t from, uint64_t to);
+
+/**
+ * @brief 拷贝时间窗口内的下一条记录，跳过拷贝期间被覆盖的记录（计入it->lost）。
+ * @param trace - 记录器。
+ * @param it - 迭代器。
+ * @param record - 输出缓冲区，至少slot_size字节。
+ * @return 1 - success, 0 - 窗口内没有更多记录。
+ */
+uint8_t ring_buffer_trace_next(ring_buffer_trace_t *trace, ring_buffer_trace_iter_t *it,
+                               ring_buffer_trace_record_t *record);
+
+/**
+ * @brief 拷贝最近的最多max条记录，生产者可以同时写入，拷贝期间被覆盖的记录被丢弃。
+ * @param trace - 记录器。
+ * @param out - 输出缓冲区，至少max * slot_size字节，记录按时间顺序依次存放，每条占一个槽位。
+ * @param max - 最多拷贝的记录数。
+ * @return 拷贝的记录数。
+ */
+uint64_t ring_buffer_trace_snapshot(ring_buffer_trace_t *trace, void *out, uint64_t max);
+
+#endif /* RINGBUFFER_TRACE_H */
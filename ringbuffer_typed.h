@@ -0,0 +1,104 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 按元素类型生成的定长环形队列，全部为头文件中的static inline函数。
+ * 容量在编译时确定，取模的mask是常量，元素按类型整体拷贝，
+ * 不再像ring_buffer_queue那样每个字节一次函数调用。
+ *
+ * 用法：
+ *   RING_BUFFER_DEFINE(msg_ring, struct msg, 256)
+ * 生成类型msg_ring_t和函数msg_ring_init / msg_ring_push / msg_ring_push_overwrite /
+ * msg_ring_pop / msg_ring_peek / msg_ring_num_items / msg_ring_is_empty / msg_ring_is_full。
+ *
+ * 与ring_buffer_t的普通接口一样只适用于单线程（或调用方加锁），
+ * head/tail为自由增长的计数器，队列可以完全装满。
+ */
+
+#ifndef RINGBUFFER_TYPED_H
+#define RINGBUFFER_TYPED_H
+
+/**
+ * @brief 定义名为name的定长队列类型及其操作函数。
+ * @param name - 生成的类型名和函数名前缀。
+ * @param type - 元素类型。
+ * @param cap - 队列容量（元素个数），必须是2的整数次幂的常量。
+ */
+#define RING_BUFFER_DEFINE(name, type, cap)                                                        \
+    _Static_assert((cap) > 0 && ((cap) & ((cap) - 1)) == 0, #name ": capacity must be a power of 2"); \
+                                                                                                   \
+    typedef struct name##_t                                                                        \
+    {                                                                                              \
+        type items[(cap)];                                                                         \
+        ring_buffer_size_t head_index;                                                             \
+        ring_buffer_size_t tail_index;                                                             \
+    } name##_t;                                                                                    \
+                                                                                                   \
+    static inline void name##_init(name##_t *buffer)                                               \
+    {                                                                                              \
+        buffer->head_index = 0;                                                                    \
+        buffer->tail_index = 0;                                                                    \
+    }                                                                                              \
+                                                                                                   \
+    static inline ring_buffer_size_t name##_num_items(const name##_t *buffer)                      \
+    {                                                                                              \
+        return buffer->head_index - buffer->tail_index;                                            \
+    }                                                                                              \
+                                                                                                   \
+    static inline uint8_t name##_is_empty(const name##_t *buffer)                                  \
+    {                                                                                              \
+        return buffer->head_index == buffer->tail_index;                                           \
+    }                                                                                              \
+                                                                                                   \
+    static inline uint8_t name##_is_full(const name##_t *buffer)                                   \
+    {                                                                                              \
+        return buffer->head_index - buffer->tail_index == (cap);                                   \
+    }                                                                                              \
+                                                                                                   \
+    /* 写入一个元素，队列满时返回0，不覆盖旧数据。 */                                  \
+    static inline uint8_t name##_push(name##_t *buffer, const type *item)                          \
+    {                                                                                              \
+        if (name##_is_full(buffer))                                                                \
+        {                                                                                          \
+            return 0;                                                                              \
+        }                                                                                          \
+        buffer->items[buffer->head_index & ((cap) - 1)] = *item;                                   \
+        buffer->head_index++;                                                                      \
+        return 1;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    /* 写入一个元素，队列满时与ring_buffer_queue一样覆盖最旧的元素。 */                \
+    static inline void name##_push_overwrite(name##_t *buffer, const type *item)                   \
+    {                                                                                              \
+        if (name##_is_full(buffer))                                                                \
+        {                                                                                          \
+            buffer->tail_index++;                                                                  \
+        }                                                                                          \
+        buffer->items[buffer->head_index & ((cap) - 1)] = *item;                                   \
+        buffer->head_index++;                                                                      \
+    }                                                                                              \
+                                                                                                   \
+    /* 读出最旧的元素，队列为空时返回0。 */                                                \
+    static inline uint8_t name##_pop(name##_t *buffer, type *item)                                 \
+    {                                                                                              \
+        if (name##_is_empty(buffer))                                                               \
+        {                                                                                          \
+            return 0;                                                                              \
+        }                                                                                          \
+        *item = buffer->items[buffer->tail_index & ((cap) - 1)];                                   \
+        buffer->tail_index++;                                                                      \
+        return 1;                                                                                  \
+    }                                                                                              \
+                                                                                                   \
+    /* 读取第index个元素（0为最旧的元素）但不移除，越界返回0。 */                     \
+    static inline uint8_t name##_peek(const name##_t *buffer, type *item, ring_buffer_size_t index) \
+    {                                                                                              \
+        if (index >= name##_num_items(buffer))                                                     \
+        {                                                                                          \
+            return 0;                                                                              \
+        }                                                                                          \
+        *item = buffer->items[(buffer->tail_index + index) & ((cap) - 1)];                         \
+        return 1;                                                                                  \
+    }
+
+#endif /* RINGBUFFER_TYPED_H */
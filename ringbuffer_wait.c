@@ -0,0 +1,253 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "ringbuffer_wait.h"
+
+/**
+ * @file
+ * 阻塞等待接口的实现。
+ *
+ * 丢失唤醒的避免：等待方先读出futex字，再登记等待者并检查条件，条件不满足才睡眠；
+ * 唤醒方先发布索引，再检查等待者个数，不为0时将futex字加一后唤醒。
+ * 双方在“写自己的变量”和“读对方的变量”之间都有seq_cst屏障，
+ * 所以要么等待方看到新的索引，要么唤醒方看到等待者；
+ * 如果futex字在等待方读出之后被修改，FUTEX_WAIT会立即返回。
+ */
+
+#define RB_LOAD(obj, order) atomic_load_explicit(&(obj), memory_order_##order)
+
+/**
+ * 自旋等待时提示CPU降低功耗，并让出超线程的执行资源。
+ */
+static inline void rb_cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * 在futex字上睡眠，deadline为CLOCK_MONOTONIC的绝对时间，NULL表示一直等待。
+ * 不使用FUTEX_PRIVATE_FLAG，不同进程映射的同一块共享内存也能互相唤醒。
+ */
+static int rb_futex_wait(_Atomic uint32_t *addr, uint32_t expected, const struct timespec *deadline)
+{
+    return (int)syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_BITSET, expected, deadline, NULL,
+                        FUTEX_BITSET_MATCH_ANY);
+}
+
+static void rb_futex_wake(_Atomic uint32_t *addr)
+{
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * 检查数据（for_data非0）或空间是否已有size个字节，就绪时顺便刷新本端缓存的对端索引。
+ */
+static int rb_ready(ring_buffer_t *buffer, int for_data, ring_buffer_size_t size)
+{
+    if (for_data)
+    {
+        ring_buffer_size_t head = RB_LOAD(buffer->head_index, acquire);
+        if (ring_buffer_distance(buffer, head, RB_LOAD(buffer->tail_index, relaxed)) >= size)
+        {
+            buffer->cached_head = head;
+            return 1;
+        }
+    }
+    else
+    {
+        ring_buffer_size_t tail = RB_LOAD(buffer->tail_index, acquire);
+        if (buffer->buffer_cap - ring_buffer_distance(buffer, RB_LOAD(buffer->head_index, relaxed), tail) >= size)
+        {
+            buffer->cached_tail = tail;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 计算timeout_ms对应的绝对截止时间。
+ * 只在真正需要睡眠时才计算，数据已就绪的快速路径上不调用clock_gettime。
+ */
+static void rb_deadline(int timeout_ms, struct timespec *ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout_ms / 1000;
+    ts->tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+/**
+ * 等待数据或空间就绪：先自旋，再在futex上睡眠直到就绪或超过deadline。
+ * 自旋次数按上一次的结果调整，生产者和消费者各自保存在自己的cache line上。
+ * deadline由调用者提供，tv_sec为-1表示尚未计算，多次调用共用同一个截止时间。
+ */
+static uint8_t rb_wait(ring_buffer_t *buffer, int for_data, ring_buffer_size_t size, int timeout_ms,
+                       struct timespec *deadline)
+{
+    _Atomic uint32_t *futex = for_data ? &buffer->data_futex : &buffer->space_futex;
+    _Atomic uint32_t *waiters = for_data ? &buffer->data_waiters : &buffer->space_waiters;
+    uint32_t *spin = for_data ? &buffer->consumer_spin : &buffer->producer_spin;
+    uint32_t i, limit;
+
+    if (size > buffer->buffer_cap)
+    {
+        fprintf(stderr, "%s -- size(%llu) exceed buffer capacity(%llu).\n", __func__,
+                (unsigned long long)size, (unsigned long long)buffer->buffer_cap);
+        return 0;
+    }
+    if (rb_ready(buffer, for_data, size))
+    {
+        return 1;
+    }
+    if (timeout_ms == 0)
+    {
+        return 0;
+    }
+
+    limit = *spin ? *spin : RING_BUFFER_SPIN_MAX / 4;
+    for (i = 0; i < limit; i++)
+    {
+        rb_cpu_relax();
+        if (rb_ready(buffer, for_data, size))
+        {
+            *spin = limit * 2 > RING_BUFFER_SPIN_MAX ? RING_BUFFER_SPIN_MAX : limit * 2;
+            return 1;
+        }
+    }
+    *spin = limit / 2 < RING_BUFFER_SPIN_MIN ? RING_BUFFER_SPIN_MIN : limit / 2;
+
+    if (timeout_ms > 0 && deadline->tv_sec < 0)
+    {
+        rb_deadline(timeout_ms, deadline);
+    }
+
+    for (;;)
+    {
+        uint32_t seq = atomic_load_explicit(futex, memory_order_acquire);
+        int ret, err;
+
+        atomic_fetch_add_explicit(waiters, 1, memory_order_seq_cst);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (rb_ready(buffer, for_data, size))
+        {
+            atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+            return 1;
+        }
+
+        ret = rb_futex_wait(futex, seq, timeout_ms < 0 ? NULL : deadline);
+        err = errno;
+        atomic_fetch_sub_explicit(waiters, 1, memory_order_relaxed);
+        if (ret != 0 && err == ETIMEDOUT)
+        {
+            return (uint8_t)rb_ready(buffer, for_data, size);
+        }
+        /* 被唤醒、EAGAIN（futex字已变化）或EINTR，重新检查条件。 */
+    }
+}
+
+uint8_t ring_buffer_wait_data(ring_buffer_t *buffer, ring_buffer_size_t size, int timeout_ms)
+{
+    struct timespec deadline = {-1, 0};
+    return rb_wait(buffer, 1, size, timeout_ms, &deadline);
+}
+
+uint8_t ring_buffer_wait_space(ring_buffer_t *buffer, ring_buffer_size_t size, int timeout_ms)
+{
+    struct timespec deadline = {-1, 0};
+    return rb_wait(buffer, 0, size, timeout_ms, &deadline);
+}
+
+void ring_buffer_wake_consumer(ring_buffer_t *buffer)
+{
+    /* 与等待方登记等待者之后的屏障配对，保证head的发布先于读取等待者个数。 */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (RB_LOAD(buffer->data_waiters, relaxed) != 0)
+    {
+        atomic_fetch_add_explicit(&buffer->data_futex, 1, memory_order_release);
+        rb_futex_wake(&buffer->data_futex);
+    }
+}
+
+void ring_buffer_wake_producer(ring_buffer_t *buffer)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (RB_LOAD(buffer->space_waiters, relaxed) != 0)
+    {
+        atomic_fetch_add_explicit(&buffer->space_futex, 1, memory_order_release);
+        rb_futex_wake(&buffer->space_futex);
+    }
+}
+
+ring_buffer_size_t ring_buffer_queue_wait(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size, int timeout_ms)
+{
+    struct timespec deadline = {-1, 0};
+    ring_buffer_size_t done = 0;
+
+    for (;;)
+    {
+        ring_buffer_size_t want;
+
+        /* 先写入当前能放下的部分，剩余的再等待空间。 */
+        ring_buffer_size_t written = ring_buffer_spsc_queue_arr(buffer, data + done, size - done);
+        if (written > 0)
+        {
+            done += written;
+            ring_buffer_wake_consumer(buffer);
+        }
+        if (done == size)
+        {
+            break;
+        }
+
+        /* 一次最多等待一整个队列的空间，超出的部分在下一轮写入。 */
+        want = size - done;
+        if (want > buffer->buffer_cap)
+        {
+            want = buffer->buffer_cap;
+        }
+        if (!rb_wait(buffer, 0, want, timeout_ms, &deadline))
+        {
+            break;
+        }
+    }
+    return done;
+}
+
+ring_buffer_size_t ring_buffer_dequeue_wait(ring_buffer_t *buffer, char *data, ring_buffer_size_t len, int timeout_ms)
+{
+    struct timespec deadline = {-1, 0};
+    ring_buffer_size_t n;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+    /* 先直接读取，队列为空时才进入等待。 */
+    n = ring_buffer_spsc_dequeue_arr(buffer, data, len);
+    if (n == 0)
+    {
+        if (!rb_wait(buffer, 1, 1, timeout_ms, &deadline))
+        {
+            return 0;
+        }
+        n = ring_buffer_spsc_dequeue_arr(buffer, data, len);
+    }
+    ring_buffer_wake_producer(buffer);
+    return n;
+}
@@ -0,0 +1,81 @@
+#include "ringbuffer.h"
+
+/**
+ * @file
+ * 字节队列的阻塞等待接口（Linux）。
+ * 等待方先自旋一小段时间，数据（或空间）仍未就绪时在队列头部的futex字上睡眠。
+ * futex字位于队列头部，不使用FUTEX_PRIVATE_FLAG，所以放在共享内存中的队列也可以跨进程唤醒。
+ *
+ * 对端只有在登记了等待者时才会发起futex唤醒，没有等待者时唤醒检查只是一次内存屏障和一次读取，
+ * 不会进入内核。
+ *
+ * 与ring_buffer_spsc_*接口一样只适用于单生产者/单消费者；
+ * 一端使用阻塞接口时，另一端在写入（或读出）之后必须调用对应的唤醒函数，
+ * ring_buffer_queue_wait和ring_buffer_dequeue_wait已经包含了唤醒。
+ *
+ * timeout_ms的约定与poll相同：小于0表示一直等待，0表示不等待，大于0为最长等待的毫秒数。
+ */
+
+#ifndef RINGBUFFER_WAIT_H
+#define RINGBUFFER_WAIT_H
+
+// 自适应自旋次数的上下限：自旋期间等到了就加倍，最终进入睡眠就减半。
+#ifndef RING_BUFFER_SPIN_MIN
+#define RING_BUFFER_SPIN_MIN 16
+#endif
+#ifndef RING_BUFFER_SPIN_MAX
+#define RING_BUFFER_SPIN_MAX 2048
+#endif
+
+/**
+ * @brief 阻塞写入：写入全部size个字节，空间不足时等待消费者读出，每次写入后唤醒等待数据的消费者。
+ * size可以大于队列容量，数据会分多次写入。
+ * @param buffer The buffer in which the data should be placed.
+ * @param data A pointer to the array of data to place in the queue.
+ * @param size The size of the array.
+ * @param timeout_ms 最长等待时间，见文件说明。
+ * @return 实际写入的字节数，超时时小于size。
+ */
+ring_buffer_size_t ring_buffer_queue_wait(ring_buffer_t *buffer, const char *data, ring_buffer_size_t size, int timeout_ms);
+
+/**
+ * @brief 阻塞读出：等到队列中至少有一个字节，读出最多len个字节，然后唤醒等待空间的生产者。
+ * @param buffer The buffer from which the data should be returned.
+ * @param data A pointer to the array at which the data should be placed.
+ * @param len The maximum number of bytes to return.
+ * @param timeout_ms 最长等待时间，见文件说明。
+ * @return The number of bytes returned，超时返回0。
+ */
+ring_buffer_size_t ring_buffer_dequeue_wait(ring_buffer_t *buffer, char *data, ring_buffer_size_t len, int timeout_ms);
+
+/**
+ * @brief 消费者等待队列中至少有size个字节，配合零拷贝接口或消息层使用。
+ * @param buffer The buffer to wait on.
+ * @param size 需要的字节数，不能超过队列容量。
+ * @param timeout_ms 最长等待时间，见文件说明。
+ * @return 1 - 数据已就绪, 0 - 超时或参数错误。
+ */
+uint8_t ring_buffer_wait_data(ring_buffer_t *buffer, ring_buffer_size_t size, int timeout_ms);
+
+/**
+ * @brief 生产者等待队列中至少有size个字节的剩余空间，配合零拷贝接口或消息层使用。
+ * @param buffer The buffer to wait on.
+ * @param size 需要的空间，不能超过队列容量。
+ * @param timeout_ms 最长等待时间，见文件说明。
+ * @return 1 - 空间已就绪, 0 - 超时或参数错误。
+ */
+uint8_t ring_buffer_wait_space(ring_buffer_t *buffer, ring_buffer_size_t size, int timeout_ms);
+
+/**
+ * @brief 生产者发布数据之后调用，如有消费者在等待数据则唤醒它。
+ * @param buffer The buffer.
+ */
+void ring_buffer_wake_consumer(ring_buffer_t *buffer);
+
+/**
+ * @brief 消费者释放空间之后调用，如有生产者在等待空间则唤醒它。
+ * @param buffer The buffer.
+ */
+void ring_buffer_wake_producer(ring_buffer_t *buffer);
+
+#endif /* RINGBUFFER_WAIT_H */
@@ -4,21 +4,28 @@
  ************************************************************************/
 
 // compile command:
-//  gcc -I/include -o test_rb test_ringbuffer.c src/ringbuffer.c
+//  gcc -std=c11 -O2 -o test_rb test_ring_buffer.c ringbuffer.c   (或 make test)
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "ringbuffer.h"
+#include "ringbuffer_typed.h"
 
-void main()
+typedef struct
+{
+	int id;
+	char name[12];
+} point_t;
+
+RING_BUFFER_DEFINE(point_ring, point_t, 8)
+
+int main(void)
 {
 
 	char a[100], b = 0, c[100];
 	int i;
-	int length = 10, calcu_length;
-	void *data = NULL;
 
 	for (i = 0; i < 100; i++)
 	{
@@ -32,11 +39,11 @@ void main()
 	printf("1. ring_buffer_t create test start.\n");
 	printf("1. sizeof ring_buffer_t is %lu.\n", sizeof(ring_buffer_t));
 	printf("1. sizeof ring_buffer_t->buf_cap is %lu.\n", sizeof(rb1->buffer_cap));
-	printf("1. ring_buffer_t->buf_cap is %d.\n", rb1->buffer_cap);
+	printf("1. ring_buffer_t->buf_cap is %lu.\n", (unsigned long)rb1->buffer_cap);
 	printf("1. sizeof ring_buffer_t->head is %lu.\n", sizeof(rb1->head_index));
-	printf("1. sizeof buffer_array is %lu.\n", sizeof(rb1->buffer_array));
-	printf("1. addr of ring_buffer_t is %lu.\n", rb1);
-	printf("1. addr of buffer_array is %lu.\n", rb1->buffer_array);
+	printf("1. buffer_array offset is %ld.\n", (long)rb1->data_offset);
+	printf("1. addr of ring_buffer_t is %p.\n", (void *)rb1);
+	printf("1. addr of buffer_array is %p.\n", (void *)ring_buffer_data(rb1));
 
 	if (rb1 == NULL)
 	{
@@ -81,7 +88,7 @@ void main()
 	ring_buffer_queue(rb1, 'E');
 	ring_buffer_queue(rb1, 'F');
 	ring_buffer_queue(rb1, 'G');
-	printf("3. D~G is queued, the item number is %d.\n", ring_buffer_num_items(rb1));
+	printf("3. D~G is queued, the item number is %lu.\n", (unsigned long)ring_buffer_num_items(rb1));
 	ring_buffer_peek(rb1, &b, 0);
 	printf("3. and peek of %d it is %c.\n", 0, b);
 
@@ -98,8 +105,198 @@ void main()
     if (rb1 == NULL)
 		printf("ring_buffer_destroyed and set to NULL.\n\n");
 
+	printf("5. boundary size test:\n");
+	if (ring_buffer_calc_size(0) != 1 + sizeof(ring_buffer_t) ||
+		ring_buffer_calc_size(4096) != 4096 + sizeof(ring_buffer_t) ||
+		ring_buffer_calc_size(4097) != 8192 + sizeof(ring_buffer_t) ||
+		ring_buffer_calc_size(RING_BUFFER_SIZE) != RING_BUFFER_SIZE + sizeof(ring_buffer_t) ||
+		ring_buffer_calc_size((size_t)RING_BUFFER_SIZE + 1) != 0)
+	{
+		printf("5. failed! ring_buffer_calc_size() boundary.\n");
+		exit(-1);
+	}
+
+	/* 可以完全装满，不浪费位置 */
+	rb1 = ring_buffer_new(16);
+	for (i = 0; i < 16; i++)
+		ring_buffer_queue(rb1, i);
+	if (!ring_buffer_is_full(rb1) || ring_buffer_num_items(rb1) != 16)
+	{
+		printf("5. failed! 16 bytes do not fill a 16 byte buffer.\n");
+		exit(-1);
+	}
+	ring_buffer_queue(rb1, 16);
+	ring_buffer_peek(rb1, &b, 0);
+	if (ring_buffer_num_items(rb1) != 16 || b != 1)
+	{
+		printf("5. failed! overwrite of oldest byte when full.\n");
+		exit(-1);
+	}
+
+	/* 整个容量的数组入队，超过容量的数组被拒绝 */
+	if (!ring_buffer_queue_arr(rb1, a, 16) || ring_buffer_queue_arr(rb1, a, 17) ||
+		ring_buffer_dequeue_arr(rb1, c, 100) != 16 || memcmp(a, c, 16) != 0)
+	{
+		printf("5. failed! full capacity array queue.\n");
+		exit(-1);
+	}
+
+	/* 计数器回绕 */
+	rb1->head_index = rb1->tail_index = rb1->cached_head = rb1->cached_tail = (ring_buffer_size_t)-5;
+	for (i = 0; i < 10; i++)
+	{
+		ring_buffer_queue_arr(rb1, a + i * 10, 10);
+		if (ring_buffer_num_items(rb1) != 10 || ring_buffer_dequeue_arr(rb1, c, 100) != 10 || memcmp(a + i * 10, c, 10) != 0)
+		{
+			printf("5. failed! counter wraparound at round %d.\n", i);
+			exit(-1);
+		}
+	}
+	ring_buffer_destroy(&rb1);
+	printf("5. ...OK\n\n");
+
+	printf("6. zero copy reserve/commit and peek/consume:\n");
+	{
+		ring_buffer_span_t spans[2];
+
+		rb1 = ring_buffer_new(64);
+		/* 把位置移动到数组中间，使借出的空间跨越数组末尾 */
+		ring_buffer_queue_arr(rb1, a, 40);
+		ring_buffer_dequeue_arr(rb1, c, 40);
+
+		if (ring_buffer_reserve(rb1, 100, spans) != 64 || spans[0].len != 24 || spans[1].len != 40)
+		{
+			printf("6. failed! reserve spans %lu + %lu.\n", (unsigned long)spans[0].len, (unsigned long)spans[1].len);
+			exit(-1);
+		}
+		memcpy(spans[0].data, a, 24);
+		memcpy(spans[1].data, a + 24, 26);
+		if (!ring_buffer_is_empty(rb1) || !ring_buffer_commit(rb1, 50) || ring_buffer_commit(rb1, 15))
+		{
+			printf("6. failed! data visible before commit or over commit accepted.\n");
+			exit(-1);
+		}
+
+		if (ring_buffer_peek_spans(rb1, spans) != 50 || spans[0].len != 24 ||
+			memcmp(spans[0].data, a, 24) != 0 || memcmp(spans[1].data, a + 24, 26) != 0)
+		{
+			printf("6. failed! peek spans do not match committed data.\n");
+			exit(-1);
+		}
+		if (!ring_buffer_consume(rb1, 30) || ring_buffer_consume(rb1, 21) || ring_buffer_num_items(rb1) != 20)
+		{
+			printf("6. failed! consume.\n");
+			exit(-1);
+		}
+		ring_buffer_dequeue_arr(rb1, c, 20);
+		if (memcmp(c, a + 30, 20) != 0)
+		{
+			printf("6. failed! data after consume.\n");
+			exit(-1);
+		}
+		ring_buffer_destroy(&rb1);
+	}
+	printf("6. ...OK\n\n");
+
+	printf("7. typed ring generated by RING_BUFFER_DEFINE:\n");
+	{
+		point_ring_t pr;
+		point_t p;
+
+		point_ring_init(&pr);
+		for (i = 0; i < 8; i++)
+		{
+			p.id = i;
+			if (!point_ring_push(&pr, &p))
+			{
+				printf("7. failed! push %d.\n", i);
+				exit(-1);
+			}
+		}
+		if (!point_ring_is_full(&pr) || point_ring_push(&pr, &p))
+		{
+			printf("7. failed! push into full ring.\n");
+			exit(-1);
+		}
+		p.id = 8;
+		point_ring_push_overwrite(&pr, &p);
+		if (!point_ring_peek(&pr, &p, 0) || p.id != 1 || point_ring_peek(&pr, &p, 8))
+		{
+			printf("7. failed! overwrite or peek.\n");
+			exit(-1);
+		}
+		for (i = 1; i <= 8; i++)
+		{
+			if (!point_ring_pop(&pr, &p) || p.id != i)
+			{
+				printf("7. failed! pop order at %d.\n", i);
+				exit(-1);
+			}
+		}
+		if (!point_ring_is_empty(&pr) || point_ring_pop(&pr, &p))
+		{
+			printf("7. failed! pop from empty ring.\n");
+			exit(-1);
+		}
+	}
+	printf("7. ...OK\n\n");
+
+	printf("8. overflow policies and drop counters:\n");
+	{
+		ring_buffer_t *rb;
+
+		/* 默认覆盖：被覆盖的旧字节计入丢弃 */
+		rb = ring_buffer_new(128);
+		if (rb == NULL || ring_buffer_queue_arr(rb, a, 100) != 100 || ring_buffer_queue_arr(rb, a, 40) != 40 ||
+			ring_buffer_dropped_bytes(rb) != 12 || ring_buffer_dropped_msgs(rb) != 1 ||
+			!ring_buffer_queue(rb, 'x') || ring_buffer_dropped_bytes(rb) != 13 ||
+			ring_buffer_dropped_msgs(rb) != 2 || ring_buffer_num_items(rb) != 128)
+		{
+			printf("8. failed! overwrite counters.\n");
+			exit(-1);
+		}
+		ring_buffer_destroy(&rb);
+
+		/* 拒绝：整次写入失败，队列内容不变，不计入丢弃 */
+		rb = ring_buffer_new_policy(16, RING_BUFFER_REJECT);
+		if (rb == NULL || ring_buffer_queue_arr(rb, a, 10) != 10 || ring_buffer_queue_arr(rb, a, 10) != 0 ||
+			ring_buffer_queue_arr(rb, a, 6) != 6 || ring_buffer_queue(rb, 'x') ||
+			ring_buffer_dropped_bytes(rb) != 0 || !ring_buffer_dequeue(rb, &b) || b != 0)
+		{
+			printf("8. failed! reject policy.\n");
+			exit(-1);
+		}
+		ring_buffer_destroy(&rb);
+
+		/* 丢弃新数据：只写入能放下的前一部分 */
+		rb = ring_buffer_new_policy(16, RING_BUFFER_DROP_NEWEST);
+		if (rb == NULL || ring_buffer_queue_arr(rb, a, 10) != 10 || ring_buffer_queue_arr(rb, a + 10, 10) != 6 ||
+			ring_buffer_queue(rb, 'x') || ring_buffer_queue_arr(rb, a, 40) != 0 ||
+			ring_buffer_dropped_bytes(rb) != 4 + 1 + 40 || ring_buffer_dropped_msgs(rb) != 3 ||
+			ring_buffer_dequeue_arr(rb, c, 100) != 16 || memcmp(a, c, 16) != 0)
+		{
+			printf("8. failed! drop newest policy.\n");
+			exit(-1);
+		}
+		if (ring_buffer_queue_arr(rb, a, 40) != 16 || ring_buffer_dropped_bytes(rb) != 69)
+		{
+			printf("8. failed! drop newest larger than capacity.\n");
+			exit(-1);
+		}
+		ring_buffer_destroy(&rb);
+
+		if (ring_buffer_new_policy(16, (ring_buffer_overflow_t)0x0010) != NULL)
+		{
+			printf("8. failed! unknown policy accepted.\n");
+			exit(-1);
+		}
+	}
+	printf("8. ...OK\n\n");
+
 #else   //动态绑定内存方式
-	
+	int length = 10, calcu_length;
+	void *data = NULL;
+
 	printf("===============================================\n");
 	printf("4. test of ring_buffer_attach.\n");
 
@@ -107,7 +304,7 @@ void main()
 	printf("4. buffer size is %d, calculated length is %d.\n", length, calcu_length);
 
 	data = malloc(ring_buffer_calc_size(calcu_length));
-	printf("4. malloc OK, data at %p->%lu.\n\n", &data, data);
+	printf("4. malloc OK, data at %p->%p.\n\n", (void *)&data, data);
 
     //绑定内存块
 	rb1 = ring_buffer_attach(data, calcu_length);
@@ -116,9 +313,9 @@ void main()
 	// printf("4. sizeof ring_buffer_t->buf_cap is %d.\n", sizeof(rb1->buffer_cap));
 	// printf("4. ring_buffer_t->buf_cap is %d.\n", rb1->buffer_cap);
 	// printf("4. sizeof ring_buffer_t->head is %d.\n", sizeof(rb1->head_index));
-	// printf("4. sizeof buffer_array is %d.\n", sizeof(rb1->buffer_array));
+	// printf("4. buffer_array offset is %ld.\n", (long)rb1->data_offset);
 	// printf("4. addr of ring_buffer_t is %lu.\n", rb1);
-	// printf("4. addr of buffer_array is %lu.\n", rb1->buffer_array);
+	// printf("4. addr of buffer_array is %lu.\n", ring_buffer_data(rb1));
 
 	if (rb1 == NULL)
 	{
@@ -132,7 +329,7 @@ void main()
 	for (i = 0; i < 10; i++)
 	{
 		ring_buffer_queue(rb1, i);
-		printf("after  queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, rb1->buffer_array[i % 16], rb1->head_index, rb1->tail_index);
+		printf("after  queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, ring_buffer_data(rb1)[i % 16], rb1->head_index, rb1->tail_index);
 	}
 
 	for (i = 0; i < 10; i++)
@@ -152,18 +349,18 @@ void main()
 	////////////////////////////////////////////////////////////
 	printf("4.1. test for arr queue & arr dequeue:\n");
 	for (i = 0; i < 16; i++)
-		printf("before arr queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, rb1->buffer_array[i % 16], rb1->head_index, rb1->tail_index);
+		printf("before arr queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, ring_buffer_data(rb1)[i % 16], rb1->head_index, rb1->tail_index);
 
 	ring_buffer_queue_arr(rb1, a, 15);
 	for (i = 0; i < 16; i++)
 	{
-		printf("after arr queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, rb1->buffer_array[i % 16], rb1->head_index, rb1->tail_index);
+		printf("after arr queue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, ring_buffer_data(rb1)[i % 16], rb1->head_index, rb1->tail_index);
 	}
 
 	ring_buffer_dequeue_arr(rb1, c, 15);
 	for (i = 0; i < 16; i++)
 	{
-		printf("after arr dequeue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, rb1->buffer_array[i % 16], rb1->head_index, rb1->tail_index);
+		printf("after arr dequeue:buffer_array[%d] \t-- %4d head -> %4d,tail -> %4d\n", i % 16, ring_buffer_data(rb1)[i % 16], rb1->head_index, rb1->tail_index);
 		printf("c[%d]:%d\n", i, c[i]);
 		if (a[i] != c[i])
 		{
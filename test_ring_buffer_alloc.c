@@ -0,0 +1,160 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_alloc.c
+	> 分配选项测试：默认mmap分配的对齐和读写、透明大页与预先缺页、大页不可用时的退回、
+	> NUMA节点绑定和无效参数。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_alloc test_ring_buffer_alloc.c ringbuffer.c ringbuffer_alloc.c
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "ringbuffer_alloc.h"
+
+/* 数组所在内存的NUMA策略，失败返回-1 */
+static int data_policy(ring_buffer_t *rb)
+{
+    int mode;
+
+    if (syscall(SYS_get_mempolicy, &mode, NULL, 0, ring_buffer_data(rb), MPOL_F_ADDR) != 0)
+    {
+        return -1;
+    }
+    return mode;
+}
+
+/* 写读一段跨越数组末尾的数据，检查内容 */
+static void check_queue(ring_buffer_t *rb, const char *step)
+{
+    char in[1000], out[1000];
+    int i, round;
+
+    for (i = 0; i < (int)sizeof(in); i++)
+    {
+        in[i] = (char)(i * 7);
+    }
+    for (round = 0; round < 3 * (int)(rb->buffer_cap / sizeof(in)) + 1; round++)
+    {
+        if (ring_buffer_queue_arr(rb, in, sizeof(in)) != sizeof(in) ||
+            ring_buffer_dequeue_arr(rb, out, sizeof(out)) != sizeof(out) || memcmp(in, out, sizeof(in)) != 0)
+        {
+            printf("%s failed! round %d.\n", step, round);
+            exit(-1);
+        }
+    }
+}
+
+int main(void)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    ring_buffer_alloc_opts_t opts;
+    ring_buffer_t *rb;
+
+    printf("1. default options:\n");
+    rb = ring_buffer_new_opts(1 << 16, NULL);
+    if (rb == NULL || !(rb->flags & RING_BUFFER_FLAG_MAPPED) || (rb->flags & RING_BUFFER_FLAG_HUGETLB) ||
+        ((uintptr_t)rb & (page - 1)) != 0 || (size_t)rb->data_offset != page ||
+        (rb->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) != RING_BUFFER_OVERWRITE)
+    {
+        printf("1. failed! ring_buffer_new_opts().\n");
+        exit(-1);
+    }
+    check_queue(rb, "1.");
+    ring_buffer_destroy(&rb);
+    if (rb != NULL)
+    {
+        printf("1. failed! ring_buffer_destroy().\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n");
+
+    printf("2. transparent huge pages with prefault:\n");
+    memset(&opts, 0, sizeof(opts));
+    opts.flags = RING_BUFFER_ALLOC_THP | RING_BUFFER_ALLOC_PREFAULT;
+    opts.policy = RING_BUFFER_REJECT;
+    rb = ring_buffer_new_opts(4 << 20, &opts);
+    if (rb == NULL || (size_t)rb->data_offset < page || (rb->data_offset & (page - 1)) != 0 ||
+        ((uintptr_t)ring_buffer_data(rb) & (rb->data_offset - 1)) != 0 ||
+        (rb->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) != RING_BUFFER_REJECT)
+    {
+        printf("2. failed! ring_buffer_new_opts().\n");
+        exit(-1);
+    }
+    check_queue(rb, "2.");
+    ring_buffer_destroy(&rb);
+    printf("2. ...OK\n");
+
+    printf("3. hugetlb request (falls back when no huge pages are reserved):\n");
+    opts.flags = RING_BUFFER_ALLOC_HUGETLB | RING_BUFFER_ALLOC_PREFAULT;
+    opts.policy = RING_BUFFER_OVERWRITE;
+    rb = ring_buffer_new_opts(4 << 20, &opts);
+    if (rb == NULL)
+    {
+        printf("3. failed! ring_buffer_new_opts().\n");
+        exit(-1);
+    }
+    printf("   MAP_HUGETLB %s\n", (rb->flags & RING_BUFFER_FLAG_HUGETLB) ? "used" : "not available");
+    check_queue(rb, "3.");
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n");
+
+    printf("4. numa binding and invalid options:\n");
+    // 全部清零的选项不绑定节点
+    memset(&opts, 0, sizeof(opts));
+    opts.flags = RING_BUFFER_ALLOC_PREFAULT;
+    rb = ring_buffer_new_opts(1 << 20, &opts);
+    if (rb == NULL || data_policy(rb) != MPOL_DEFAULT)
+    {
+        printf("4. failed! zeroed options bound the ring.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+
+    opts.flags = RING_BUFFER_ALLOC_PREFAULT | RING_BUFFER_ALLOC_BIND_NODE;
+    opts.numa_node = 0;
+    rb = ring_buffer_new_opts(1 << 20, &opts);
+    if (rb == NULL || data_policy(rb) != MPOL_BIND)
+    {
+        printf("4. failed! bind to node 0.\n");
+        exit(-1);
+    }
+    check_queue(rb, "4.");
+    ring_buffer_destroy(&rb);
+
+    opts.numa_node = 1000;
+    if (ring_buffer_new_opts(1 << 20, &opts) != NULL)
+    {
+        printf("4. failed! node 1000 accepted.\n");
+        exit(-1);
+    }
+    opts.numa_node = 5000;
+    if (ring_buffer_new_opts(1 << 20, &opts) != NULL)
+    {
+        printf("4. failed! node 5000 accepted.\n");
+        exit(-1);
+    }
+    opts.numa_node = -1;
+    if (ring_buffer_new_opts(1 << 20, &opts) != NULL)
+    {
+        printf("4. failed! node -1 accepted.\n");
+        exit(-1);
+    }
+    opts.flags = 0;
+    opts.policy = (ring_buffer_overflow_t)0x5;
+    if (ring_buffer_new_opts(1 << 20, &opts) != NULL)
+    {
+        printf("4. failed! invalid policy accepted.\n");
+        exit(-1);
+    }
+    printf("4. ...OK\n");
+
+    return 0;
+}
@@ -0,0 +1,353 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_bcast.c
+	> 广播队列测试：受最慢读者限制的写入、截断写入、覆盖策略下慢读者的丢失计数、
+	> 零拷贝读取的覆盖检测、多线程读者、任意容量、共享内存中跨进程读取。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_bcast test_ring_buffer_bcast.c ringbuffer.c ringbuffer_bcast.c -pthread
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_bcast.h"
+
+#define READERS 3
+#define WORDS 2000000
+
+static ring_buffer_bcast_t *shared_bcast;
+static int reader_ids[READERS];
+
+/* 读出连续的uint64_t序号，检查顺序；覆盖策略下允许跳过，但跳过的字节必须计入丢失 */
+static void *reader_thread(void *arg)
+{
+    int id = reader_ids[(long)arg];
+    uint64_t buf[64], expect = 0, received = 0;
+    ring_buffer_size_t n, i;
+    int overwrite = (shared_bcast->ring.flags & RING_BUFFER_FLAG_OVERFLOW_MASK) == RING_BUFFER_OVERWRITE;
+
+    while (received + ring_buffer_bcast_lost(shared_bcast, id) / sizeof(uint64_t) < WORDS)
+    {
+        n = ring_buffer_bcast_read(shared_bcast, id, (char *)buf, sizeof(buf));
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        if (n % sizeof(uint64_t) != 0)
+        {
+            printf("4. failed! partial word.\n");
+            exit(-1);
+        }
+        for (i = 0; i < n / sizeof(uint64_t); i++)
+        {
+            if (buf[i] != expect && !(overwrite && buf[i] > expect))
+            {
+                printf("4. failed! reader %d expect %llu got %llu.\n", id, (unsigned long long)expect,
+                       (unsigned long long)buf[i]);
+                exit(-1);
+            }
+            expect = buf[i] + 1;
+            received++;
+        }
+    }
+    if (!overwrite && received != WORDS)
+    {
+        printf("4. failed! reader %d received %llu lost %llu.\n", id, (unsigned long long)received,
+               (unsigned long long)ring_buffer_bcast_lost(shared_bcast, id));
+        exit(-1);
+    }
+    return NULL;
+}
+
+/* 一个生产者写入WORDS个序号，每次1到8个 */
+static void run_threads(ring_buffer_overflow_t policy)
+{
+    pthread_t tid[READERS];
+    uint64_t words[8], next = 0;
+    long t;
+    int k, n;
+
+    shared_bcast = ring_buffer_bcast_new(4096, policy);
+    for (t = 0; t < READERS; t++)
+    {
+        reader_ids[t] = ring_buffer_bcast_join(shared_bcast);
+        pthread_create(&tid[t], NULL, reader_thread, (void *)t);
+    }
+    while (next < WORDS)
+    {
+        n = (int)(next % 8) + 1;
+        if (next + n > WORDS)
+        {
+            n = (int)(WORDS - next);
+        }
+        for (k = 0; k < n; k++)
+        {
+            words[k] = next + k;
+        }
+        if (ring_buffer_bcast_write(shared_bcast, (char *)words, n * sizeof(uint64_t)) == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        next += n;
+    }
+    for (t = 0; t < READERS; t++)
+    {
+        pthread_join(tid[t], NULL);
+    }
+    ring_buffer_bcast_destroy(&shared_bcast);
+}
+
+int main(void)
+{
+    ring_buffer_bcast_t *bcast;
+    ring_buffer_span_t spans[2];
+    char data[256], out[256];
+    int a, b, c, i, ids[RING_BUFFER_BCAST_MAX_READERS];
+
+    for (i = 0; i < (int)sizeof(data); i++)
+    {
+        data[i] = (char)i;
+    }
+
+    printf("1. producer gated by the slowest reader:\n");
+    bcast = ring_buffer_bcast_new(64, RING_BUFFER_REJECT);
+    a = ring_buffer_bcast_join(bcast);
+    b = ring_buffer_bcast_join(bcast);
+    if (bcast == NULL || bcast->ring.buffer_cap != 64 || a < 0 || b < 0 || a == b ||
+        ring_buffer_bcast_write(bcast, data, 64) != 64 || ring_buffer_bcast_write(bcast, data, 1) != 0)
+    {
+        printf("1. failed! write until full.\n");
+        exit(-1);
+    }
+    if (ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 64 || memcmp(data, out, 64) != 0 ||
+        ring_buffer_bcast_write(bcast, data, 1) != 0)
+    {
+        printf("1. failed! fast reader must not free space while another reader lags.\n");
+        exit(-1);
+    }
+    if (ring_buffer_bcast_read(bcast, b, out, 32) != 32 || memcmp(data, out, 32) != 0 ||
+        ring_buffer_bcast_write(bcast, data + 64, 33) != 0 || ring_buffer_bcast_write(bcast, data + 64, 32) != 32)
+    {
+        printf("1. failed! slowest reader frees space.\n");
+        exit(-1);
+    }
+    if (ring_buffer_bcast_available(bcast, a) != 32 || ring_buffer_bcast_available(bcast, b) != 64 ||
+        ring_buffer_bcast_read(bcast, b, out, sizeof(out)) != 64 || memcmp(data + 32, out, 64) != 0)
+    {
+        printf("1. failed! independent cursors.\n");
+        exit(-1);
+    }
+    // 最慢的读者退出后只受剩下的读者限制，新加入的读者从当前的head开始
+    ring_buffer_bcast_leave(bcast, a);
+    if (ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 0)
+    {
+        printf("1. failed! read after leave.\n");
+        exit(-1);
+    }
+    c = ring_buffer_bcast_join(bcast);
+    if (c < 0 || ring_buffer_bcast_available(bcast, c) != 0 || ring_buffer_bcast_write(bcast, data, 64) != 64 ||
+        ring_buffer_bcast_available(bcast, c) != 64)
+    {
+        printf("1. failed! leave and join.\n");
+        exit(-1);
+    }
+    for (i = 0; i < RING_BUFFER_BCAST_MAX_READERS - 2; i++)
+    {
+        ids[i] = ring_buffer_bcast_join(bcast);
+    }
+    if (ids[RING_BUFFER_BCAST_MAX_READERS - 3] < 0 || ring_buffer_bcast_join(bcast) != -1)
+    {
+        printf("1. failed! reader table limit.\n");
+        exit(-1);
+    }
+    ring_buffer_bcast_destroy(&bcast);
+    printf("1. ...OK\n");
+
+    printf("2. drop newest counts truncated bytes:\n");
+    bcast = ring_buffer_bcast_new(64, RING_BUFFER_DROP_NEWEST);
+    a = ring_buffer_bcast_join(bcast);
+    if (ring_buffer_bcast_write(bcast, data, 50) != 50 || ring_buffer_bcast_write(bcast, data + 50, 50) != 14 ||
+        ring_buffer_dropped_bytes(&bcast->ring) != 36 || ring_buffer_dropped_msgs(&bcast->ring) != 1 ||
+        ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 64 || memcmp(data, out, 64) != 0 ||
+        ring_buffer_bcast_lost(bcast, a) != 0)
+    {
+        printf("2. failed! truncated write.\n");
+        exit(-1);
+    }
+    ring_buffer_bcast_destroy(&bcast);
+    printf("2. ...OK\n");
+
+    printf("3. overwrite laps slow readers and reports their loss:\n");
+    bcast = ring_buffer_bcast_new(64, RING_BUFFER_OVERWRITE);
+    a = ring_buffer_bcast_join(bcast);
+    b = ring_buffer_bcast_join(bcast);
+    for (i = 0; i < 3; i++)
+    {
+        if (ring_buffer_bcast_write(bcast, data + i * 50, 50) != 50 ||
+            ring_buffer_bcast_read(bcast, b, out, sizeof(out)) != 50 || memcmp(data + i * 50, out, 50) != 0)
+        {
+            printf("3. failed! producer never waits.\n");
+            exit(-1);
+        }
+    }
+    if (ring_buffer_bcast_write(bcast, data, 65) != 0 || ring_buffer_bcast_available(bcast, a) != 64 ||
+        ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 0 || ring_buffer_bcast_lost(bcast, a) != 150 ||
+        ring_buffer_bcast_lost(bcast, b) != 0)
+    {
+        printf("3. failed! lapped reader loss %llu.\n", (unsigned long long)ring_buffer_bcast_lost(bcast, a));
+        exit(-1);
+    }
+    if (ring_buffer_bcast_write(bcast, data, 10) != 10 || ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 10 ||
+        memcmp(data, out, 10) != 0)
+    {
+        printf("3. failed! lapped reader resumes at head.\n");
+        exit(-1);
+    }
+    // 零拷贝读取期间数据被覆盖，consume报告无效
+    if (ring_buffer_bcast_peek_spans(bcast, b, spans) != 10 || spans[0].len != 10 ||
+        memcmp(spans[0].data, data, 10) != 0 || ring_buffer_bcast_write(bcast, data, 64) != 64 ||
+        ring_buffer_bcast_consume(bcast, b, 10) || ring_buffer_bcast_lost(bcast, b) != 74)
+    {
+        printf("3. failed! consume after overwrite.\n");
+        exit(-1);
+    }
+    if (ring_buffer_bcast_write(bcast, data, 20) != 20 || ring_buffer_bcast_peek_spans(bcast, b, spans) != 20 ||
+        spans[0].len + spans[1].len != 20 || !ring_buffer_bcast_consume(bcast, b, 20))
+    {
+        printf("3. failed! consume intact data.\n");
+        exit(-1);
+    }
+    ring_buffer_bcast_destroy(&bcast);
+    printf("3. ...OK\n");
+
+    printf("4. one writer, %d reader threads:\n", READERS);
+    run_threads(RING_BUFFER_REJECT);
+    run_threads(RING_BUFFER_OVERWRITE);
+    printf("4. ...OK\n");
+
+    printf("5. arbitrary capacity:\n");
+    {
+        size_t length = sizeof(ring_buffer_bcast_t) + 1000;
+        void *addr = aligned_alloc(RING_BUFFER_CACHE_LINE, (length + 63) / 64 * 64);
+        uint64_t written = 0, got = 0, n;
+
+        bcast = ring_buffer_bcast_attach(addr, length, RING_BUFFER_REJECT);
+        a = ring_buffer_bcast_join(bcast);
+        if (bcast == NULL || bcast->ring.buffer_cap != 1000 || !(bcast->ring.flags & RING_BUFFER_FLAG_EXACT))
+        {
+            printf("5. failed! attach with 1000 bytes.\n");
+            exit(-1);
+        }
+        for (i = 0; i < 20000; i++)
+        {
+            n = (uint64_t)(i % 53) + 1;
+            for (c = 0; c < (int)n; c++)
+            {
+                data[c] = (char)((written + c) * 7);
+            }
+            written += ring_buffer_bcast_write(bcast, data, (ring_buffer_size_t)n);
+            n = ring_buffer_bcast_read(bcast, a, out, (ring_buffer_size_t)(i % 47) + 1);
+            for (c = 0; c < (int)n; c++)
+            {
+                if (out[c] != (char)((got + c) * 7))
+                {
+                    printf("5. failed! byte %llu.\n", (unsigned long long)(got + c));
+                    exit(-1);
+                }
+            }
+            got += n;
+        }
+        if (written != got + ring_buffer_bcast_available(bcast, a))
+        {
+            printf("5. failed! written %llu read %llu.\n", (unsigned long long)written, (unsigned long long)got);
+            exit(-1);
+        }
+        // 覆盖策略下跨越多圈的丢失字节数依然准确
+        bcast = ring_buffer_bcast_attach(addr, length, RING_BUFFER_OVERWRITE);
+        a = ring_buffer_bcast_join(bcast);
+        for (i = 0; i < 1000; i++)
+        {
+            ring_buffer_bcast_write(bcast, data, 77);
+        }
+        if (ring_buffer_bcast_read(bcast, a, out, sizeof(out)) != 0 || ring_buffer_bcast_lost(bcast, a) != 77000)
+        {
+            printf("5. failed! loss across laps %llu.\n", (unsigned long long)ring_buffer_bcast_lost(bcast, a));
+            exit(-1);
+        }
+        free(addr);
+    }
+    printf("5. ...OK\n");
+
+    printf("6. broadcast ring in shared memory, read by another process:\n");
+    {
+        size_t length = ring_buffer_bcast_calc_size(128);
+        void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        uint32_t seq, value;
+        pid_t pid;
+        int status;
+
+        bcast = ring_buffer_bcast_attach(addr, length, RING_BUFFER_REJECT);
+        a = ring_buffer_bcast_join(bcast);
+        {
+            ring_buffer_t *plain = ring_buffer_new(128);
+            if (ring_buffer_bcast_open(plain, ring_buffer_calc_size(128)) != NULL)
+            {
+                printf("6. failed! opened a plain ring buffer.\n");
+                exit(-1);
+            }
+            ring_buffer_destroy(&plain);
+        }
+        pid = fork();
+        if (pid == 0)
+        {
+            // 子进程按其他进程的方式打开队列，使用父进程为它加入的读者编号
+            ring_buffer_bcast_t *child = ring_buffer_bcast_open(addr, length);
+            if (child == NULL)
+            {
+                _exit(1);
+            }
+            for (seq = 0; seq < 100000;)
+            {
+                if (ring_buffer_bcast_read(child, a, (char *)&value, sizeof(value)) != sizeof(value))
+                {
+                    sched_yield();
+                    continue;
+                }
+                if (value != seq++)
+                {
+                    _exit(2);
+                }
+            }
+            _exit(0);
+        }
+        for (seq = 0; seq < 100000;)
+        {
+            if (ring_buffer_bcast_write(bcast, (char *)&seq, sizeof(seq)) == 0)
+            {
+                sched_yield();
+                continue;
+            }
+            seq++;
+        }
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || ring_buffer_bcast_available(bcast, a) != 0)
+        {
+            printf("6. failed! cross-process read, child status %d.\n", WEXITSTATUS(status));
+            exit(-1);
+        }
+        munmap(addr, length);
+    }
+    printf("6. ...OK\n");
+
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_exact.c
+	> 任意容量队列测试：容量取整和头部字段、与参考模型对比的随机读写（覆盖/拒绝策略）、
+	> 计数器自然回绕、零拷贝和消息层跨越数组末尾、双线程并发收发、共享内存打开校验。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_exact test_ring_buffer_exact.c ringbuffer.c ringbuffer_msg.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer_msg.h"
+
+#define MODEL_MAX 20000
+#define TRANSFER (64UL * 1024 * 1024)
+
+/* 参考模型：按顺序保存队列中的全部字节 */
+static char model[MODEL_MAX];
+static size_t model_len;
+
+static uint64_t seed = 88172645463325252ULL;
+
+static uint64_t xorshift(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+
+static void model_push(const char *data, size_t len, size_t cap)
+{
+    // 覆盖策略：先丢掉最旧的字节
+    if (model_len + len > cap)
+    {
+        size_t drop = model_len + len - cap;
+        memmove(model, model + drop, model_len - drop);
+        model_len -= drop;
+    }
+    memcpy(model + model_len, data, len);
+    model_len += len;
+}
+
+static void model_pop(size_t len)
+{
+    memmove(model, model + len, model_len - len);
+    model_len -= len;
+}
+
+/* 随机读写ops次，每次操作后与参考模型比较 */
+static void run_model(ring_buffer_t *rb, int ops, const char *step)
+{
+    char in[4096], out[4096], c;
+    ring_buffer_size_t cap = rb->buffer_cap, len, got, i;
+    int reject = (rb->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) == RING_BUFFER_REJECT;
+    int op;
+
+    model_len = 0;
+    for (op = 0; op < ops; op++)
+    {
+        len = (ring_buffer_size_t)(xorshift() % (cap < sizeof(in) ? cap + 1 : sizeof(in)));
+        switch (xorshift() % 5)
+        {
+        case 0:
+        case 1:
+            for (i = 0; i < len; i++)
+            {
+                in[i] = (char)xorshift();
+            }
+            got = ring_buffer_queue_arr(rb, in, len);
+            if (reject && model_len + len > cap ? got != 0 : got != len)
+            {
+                printf("%s failed! queue_arr returned %u for %u.\n", step, (unsigned)got, (unsigned)len);
+                exit(-1);
+            }
+            if (got != 0)
+            {
+                model_push(in, len, cap);
+            }
+            break;
+        case 2:
+            got = ring_buffer_dequeue_arr(rb, out, len);
+            if (got != (len < model_len ? len : model_len) || memcmp(out, model, got) != 0)
+            {
+                printf("%s failed! dequeue_arr.\n", step);
+                exit(-1);
+            }
+            model_pop(got);
+            break;
+        case 3:
+            c = (char)xorshift();
+            if (ring_buffer_queue(rb, c))
+            {
+                model_push(&c, 1, cap);
+            }
+            if (ring_buffer_dequeue(rb, &c) != (model_len != 0) || (model_len != 0 && c != model[0]))
+            {
+                printf("%s failed! queue/dequeue one byte.\n", step);
+                exit(-1);
+            }
+            if (model_len != 0)
+            {
+                model_pop(1);
+            }
+            break;
+        default:
+            if (model_len != 0)
+            {
+                i = (ring_buffer_size_t)(xorshift() % model_len);
+                if (!ring_buffer_peek(rb, &c, i) || c != model[i])
+                {
+                    printf("%s failed! peek %u.\n", step, (unsigned)i);
+                    exit(-1);
+                }
+            }
+            break;
+        }
+        if (ring_buffer_num_items(rb) != model_len || ring_buffer_is_full(rb) != (model_len == cap))
+        {
+            printf("%s failed! num_items %u, expect %u.\n", step, (unsigned)ring_buffer_num_items(rb),
+                   (unsigned)model_len);
+            exit(-1);
+        }
+    }
+}
+
+static void *producer(void *arg)
+{
+    ring_buffer_t *rb = arg;
+    unsigned char block[1500];
+    unsigned long sent = 0;
+    ring_buffer_size_t i, n, len;
+
+    while (sent < TRANSFER)
+    {
+        len = (ring_buffer_size_t)(1 + sent % 1499);
+        for (i = 0; i < len; i++)
+        {
+            block[i] = (unsigned char)((sent + i) * 131);
+        }
+        for (i = 0; i < len; i += n)
+        {
+            n = ring_buffer_spsc_queue_arr(rb, (char *)block + i, len - i);
+            if (n == 0)
+            {
+                sched_yield();
+            }
+        }
+        sent += len;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    static const ring_buffer_size_t caps[] = {8, 24, 1000, 4104, 17000};
+    ring_buffer_t *rb;
+    size_t i;
+
+    printf("1. exact capacities:\n");
+    rb = ring_buffer_new_exact(17000, RING_BUFFER_OVERWRITE);
+    if (rb == NULL || rb->buffer_cap != 17000 || !(rb->flags & RING_BUFFER_FLAG_EXACT) ||
+        rb->index_mask != 32767 || rb->index_gap != 32768 - 17000)
+    {
+        printf("1. failed! ring_buffer_new_exact(17000).\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    rb = ring_buffer_new_exact(4096, RING_BUFFER_OVERWRITE);
+    if (rb == NULL || rb->buffer_cap != 4096 || (rb->flags & RING_BUFFER_FLAG_EXACT) || rb->index_gap != 0)
+    {
+        printf("1. failed! ring_buffer_new_exact(4096).\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    if (ring_buffer_calc_size_exact(1001) != 1008 + sizeof(ring_buffer_t) || ring_buffer_calc_size_exact(0) != 0 ||
+        ring_buffer_new_exact(0, RING_BUFFER_OVERWRITE) != NULL)
+    {
+        printf("1. failed! ring_buffer_calc_size_exact().\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n");
+
+    printf("2. random operations against a reference model:\n");
+    for (i = 0; i < sizeof(caps) / sizeof(caps[0]); i++)
+    {
+        rb = ring_buffer_new_exact(caps[i], RING_BUFFER_OVERWRITE);
+        run_model(rb, 100000, "2. overwrite");
+        ring_buffer_destroy(&rb);
+        rb = ring_buffer_new_exact(caps[i], RING_BUFFER_REJECT);
+        run_model(rb, 100000, "2. reject");
+        ring_buffer_destroy(&rb);
+    }
+    printf("2. ...OK\n");
+
+    printf("3. counters wrap around the index type:\n");
+    rb = ring_buffer_new_exact(1000, RING_BUFFER_OVERWRITE);
+    {
+        // 从最后一圈的开头开始，几次读写之后计数器自然回绕到0附近
+        ring_buffer_size_t start = ~rb->index_mask;
+        atomic_store(&rb->head_index, start);
+        atomic_store(&rb->tail_index, start);
+        rb->cached_head = rb->cached_tail = start;
+        run_model(rb, 20000, "3.");
+        if (atomic_load(&rb->head_index) >= start)
+        {
+            printf("3. failed! head did not wrap.\n");
+            exit(-1);
+        }
+    }
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n");
+
+    printf("4. zero copy and messages across the array end:\n");
+    rb = ring_buffer_new_exact(1000, RING_BUFFER_REJECT);
+    {
+        ring_buffer_span_t spans[2];
+        char msg[300], out[300];
+        ring_buffer_size_t len;
+        int k;
+
+        for (k = 0; k < 10000; k++)
+        {
+            len = (ring_buffer_size_t)(k * 37 % 300);
+            memset(msg, (char)k, len);
+            if (!ring_buffer_push_msg(rb, msg, len) || !ring_buffer_peek_msg(rb, spans) ||
+                spans[0].len + spans[1].len != len)
+            {
+                printf("4. failed! message %d.\n", k);
+                exit(-1);
+            }
+            len = sizeof(out);
+            if (!ring_buffer_pop_msg(rb, out, &len) || len != (ring_buffer_size_t)(k * 37 % 300) ||
+                (len != 0 && (out[0] != (char)k || out[len - 1] != (char)k)))
+            {
+                printf("4. failed! pop message %d.\n", k);
+                exit(-1);
+            }
+            // 零拷贝接口：借出的空间与读出的数据都在数组末尾拆成两段（长度保持消息层要求的4字节对齐）
+            if (ring_buffer_reserve(rb, 332, spans) != 332 || spans[0].len + spans[1].len != 332)
+            {
+                printf("4. failed! reserve.\n");
+                exit(-1);
+            }
+            memset(spans[0].data, 'z', spans[0].len);
+            memset(spans[1].data, 'z', spans[1].len);
+            ring_buffer_commit(rb, 332);
+            if (ring_buffer_peek_spans(rb, spans) != 332 || spans[0].data[0] != 'z' ||
+                (spans[1].len != 0 && spans[1].data[spans[1].len - 1] != 'z') || !ring_buffer_consume(rb, 332))
+            {
+                printf("4. failed! peek_spans.\n");
+                exit(-1);
+            }
+        }
+    }
+    ring_buffer_destroy(&rb);
+    printf("4. ...OK\n");
+
+    printf("5. two threads:\n");
+    rb = ring_buffer_new_exact(10000, RING_BUFFER_REJECT);
+    {
+        pthread_t tid;
+        unsigned char block[2048];
+        unsigned long received = 0, expect_from = 0;
+        ring_buffer_size_t k, n;
+        unsigned long len = 1, done = 0;
+
+        pthread_create(&tid, NULL, producer, rb);
+        while (received < TRANSFER)
+        {
+            n = ring_buffer_spsc_dequeue_arr(rb, (char *)block, sizeof(block));
+            if (n == 0)
+            {
+                sched_yield();
+                continue;
+            }
+            for (k = 0; k < n; k++)
+            {
+                // 生产者按块写入，块内第j个字节为(块起点 + j) * 131
+                if (block[k] != (unsigned char)((expect_from + (received + k - done)) * 131))
+                {
+                    printf("5. failed! byte %lu.\n", received + k);
+                    exit(-1);
+                }
+                if (received + k + 1 - done == len)
+                {
+                    done += len;
+                    expect_from = done;
+                    len = 1 + done % 1499;
+                }
+            }
+            received += n;
+        }
+        pthread_join(tid, NULL);
+    }
+    ring_buffer_destroy(&rb);
+    printf("5. ...OK\n");
+
+    printf("6. attach and open arbitrary lengths:\n");
+    {
+        static _Alignas(64) char block[sizeof(ring_buffer_t) + 5003];
+        ring_buffer_t *opened;
+
+        rb = ring_buffer_attach(block, sizeof(block));
+        opened = ring_buffer_open(block, sizeof(block));
+        if (rb == NULL || rb->buffer_cap != 5000 || opened != rb)
+        {
+            printf("6. failed! attach/open.\n");
+            exit(-1);
+        }
+        run_model(rb, 20000, "6.");
+        rb->index_gap++;
+        if (ring_buffer_open(block, sizeof(block)) != NULL)
+        {
+            printf("6. failed! corrupted index_gap accepted.\n");
+            exit(-1);
+        }
+    }
+    printf("6. ...OK\n");
+
+    return 0;
+}
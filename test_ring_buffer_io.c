@@ -0,0 +1,176 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_io.c
+	> 文件描述符读写测试：跨越数组末尾的数据经管道写出和读入、部分写入、文件结束、队列满、
+	> 非阻塞fd，以及io_uring变体（内核不支持时跳过）。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_io test_ring_buffer_io.c ringbuffer.c ringbuffer_io.c
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ringbuffer_io.h"
+
+typedef ssize_t (*write_fn)(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max);
+typedef ssize_t (*read_fn)(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max);
+
+static ssize_t plain_write(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max)
+{
+    (void)ctx;
+    return ring_buffer_write_to_fd(rb, fd, max);
+}
+
+static ssize_t plain_read(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max)
+{
+    (void)ctx;
+    return ring_buffer_read_from_fd(rb, fd, max);
+}
+
+static ssize_t uring_write(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max)
+{
+    return ring_buffer_uring_write_to_fd(ctx, rb, fd, max);
+}
+
+static ssize_t uring_read(void *ctx, ring_buffer_t *rb, int fd, ring_buffer_size_t max)
+{
+    return ring_buffer_uring_read_from_fd(ctx, rb, fd, max);
+}
+
+static void check(const char *name, void *ctx, write_fn wr, read_fn rd)
+{
+    ring_buffer_t *rb = ring_buffer_new(64);
+    char a[64], b[64];
+    int p[2], i;
+    ssize_t n;
+
+    for (i = 0; i < 64; i++)
+    {
+        a[i] = (char)(i * 7 + 1);
+    }
+    if (pipe(p) != 0)
+    {
+        printf("   %s failed! pipe().\n", name);
+        exit(-1);
+    }
+
+    // 数据从下标40开始，跨越数组末尾
+    ring_buffer_queue_arr(rb, a, 40);
+    ring_buffer_dequeue_arr(rb, b, 40);
+    ring_buffer_queue_arr(rb, a, 50);
+    n = wr(ctx, rb, p[1], 30);
+    if (n != 30 || ring_buffer_num_items(rb) != 20)
+    {
+        printf("   %s failed! write_to_fd with max returned %d.\n", name, (int)n);
+        exit(-1);
+    }
+    n = wr(ctx, rb, p[1], 64);
+    if (n != 20 || !ring_buffer_is_empty(rb) || wr(ctx, rb, p[1], 64) != 0)
+    {
+        printf("   %s failed! write_to_fd of the rest.\n", name);
+        exit(-1);
+    }
+    if (read(p[0], b, 64) != 50 || memcmp(a, b, 50) != 0)
+    {
+        printf("   %s failed! data written to the pipe.\n", name);
+        exit(-1);
+    }
+
+    // 读入时空闲空间同样跨越数组末尾：head在下标26
+    ring_buffer_queue_arr(rb, a, 40);
+    ring_buffer_dequeue_arr(rb, b, 40);
+    if (write(p[1], a, 64) != 64)
+    {
+        printf("   %s failed! write().\n", name);
+        exit(-1);
+    }
+    n = rd(ctx, rb, p[0], 64);
+    if (n != 64 || !ring_buffer_is_full(rb))
+    {
+        printf("   %s failed! read_from_fd returned %d.\n", name, (int)n);
+        exit(-1);
+    }
+    errno = 0;
+    if (rd(ctx, rb, p[0], 64) != -1 || errno != ENOBUFS)
+    {
+        printf("   %s failed! read_from_fd into a full buffer.\n", name);
+        exit(-1);
+    }
+    if (ring_buffer_dequeue_arr(rb, b, 64) != 64 || memcmp(a, b, 64) != 0)
+    {
+        printf("   %s failed! data read from the pipe.\n", name);
+        exit(-1);
+    }
+
+    // 非阻塞fd上没有数据时返回EAGAIN（io_uring会等待fd就绪，不检查），写端关闭后返回0
+    fcntl(p[0], F_SETFL, O_NONBLOCK);
+    errno = 0;
+    if (ctx == NULL && (rd(ctx, rb, p[0], 64) != -1 || errno != EAGAIN))
+    {
+        printf("   %s failed! EAGAIN on an empty non-blocking pipe.\n", name);
+        exit(-1);
+    }
+    close(p[1]);
+    if (rd(ctx, rb, p[0], 64) != 0 || !ring_buffer_is_empty(rb))
+    {
+        printf("   %s failed! end of file.\n", name);
+        exit(-1);
+    }
+    close(p[0]);
+    ring_buffer_destroy(&rb);
+    printf("   %s\n", name);
+}
+
+int main(void)
+{
+    ring_buffer_uring_t *uring;
+
+    printf("1. readv/writev:\n");
+    check("readv/writev", NULL, plain_write, plain_read);
+    printf("1. ...OK\n");
+
+    printf("2. io_uring:\n");
+    uring = ring_buffer_uring_new(8);
+    if (uring != NULL)
+    {
+        check("io_uring", uring, uring_write, uring_read);
+        // 失败的请求不会留下完成事件或重复提交，下一次请求得到自己的结果
+        {
+            ring_buffer_t *rb = ring_buffer_new(64);
+            char out[8];
+            int p[2];
+
+            ring_buffer_queue_arr(rb, "abcdefgh", 8);
+            if (pipe(p) != 0 || ring_buffer_uring_write_to_fd(uring, rb, -1, 8) != -1 || errno != EBADF ||
+                ring_buffer_num_items(rb) != 8 || ring_buffer_uring_write_to_fd(uring, rb, p[1], 8) != 8 ||
+                read(p[0], out, sizeof(out)) != 8 || memcmp(out, "abcdefgh", 8) != 0 ||
+                ring_buffer_uring_write_to_fd(uring, rb, p[1], 8) != 0)
+            {
+                printf("2. failed! request after an error.\n");
+                exit(-1);
+            }
+            close(p[0]);
+            close(p[1]);
+            ring_buffer_destroy(&rb);
+        }
+        ring_buffer_uring_destroy(&uring);
+        if (uring != NULL)
+        {
+            printf("2. failed! ring_buffer_uring_destroy().\n");
+            exit(-1);
+        }
+    }
+    else
+    {
+        printf("   io_uring not available, skipped\n");
+    }
+    printf("2. ...OK\n");
+
+    return 0;
+}
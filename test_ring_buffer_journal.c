@@ -0,0 +1,201 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_journal.c
+	> 持久化日志队列测试：关闭后重新打开、进程崩溃后恢复、写了一半的记录和上一轮残留的旧记录被丢弃、
+	> 同步接口。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_journal test_ring_buffer_journal.c ringbuffer.c ringbuffer_journal.c
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_journal.h"
+
+/* 第i条记录的长度和内容 */
+static ring_buffer_size_t rec_len(int i)
+{
+    return (ring_buffer_size_t)((i * 37) % 100);
+}
+
+static void rec_fill(int i, char *out)
+{
+    ring_buffer_size_t k;
+
+    for (k = 0; k < rec_len(i); k++)
+    {
+        out[k] = (char)(i * 13 + k);
+    }
+}
+
+/* 读出记录first..last-1并逐条比较 */
+static void expect_records(ring_buffer_t *rb, int first, int last, const char *step)
+{
+    char want[128], got[128];
+    ring_buffer_size_t len;
+    int i;
+
+    for (i = first; i < last; i++)
+    {
+        len = sizeof(got);
+        rec_fill(i, want);
+        if (!ring_buffer_journal_read(rb, got, &len) || len != rec_len(i) || memcmp(want, got, len) != 0)
+        {
+            printf("%s failed! record %d.\n", step, i);
+            exit(-1);
+        }
+    }
+    len = sizeof(got);
+    if (ring_buffer_journal_read(rb, got, &len))
+    {
+        printf("%s failed! unexpected record after %d.\n", step, last - 1);
+        exit(-1);
+    }
+}
+
+int main(void)
+{
+    char path[64], data[128];
+    ring_buffer_t *rb;
+    ring_buffer_size_t discarded, len;
+    pid_t pid;
+    int i, status;
+
+    snprintf(path, sizeof(path), "/tmp/test_rb_journal_%d", (int)getpid());
+
+    printf("1. close and reopen:\n");
+    rb = ring_buffer_journal_create(path, 1024);
+    if (rb == NULL || ring_buffer_journal_create(path, 1024) != NULL)
+    {
+        printf("1. failed! ring_buffer_journal_create().\n");
+        exit(-1);
+    }
+    // 先写读一批，使后面的记录跨越数组末尾
+    for (i = 0; i < 15; i++)
+    {
+        rec_fill(i, data);
+        ring_buffer_journal_append(rb, data, rec_len(i));
+    }
+    expect_records(rb, 0, 15, "1.");
+    for (i = 15; i < 30; i++)
+    {
+        rec_fill(i, data);
+        if (!ring_buffer_journal_append(rb, data, rec_len(i)))
+        {
+            printf("1. failed! append record %d.\n", i);
+            exit(-1);
+        }
+    }
+    len = sizeof(data);
+    if (ring_buffer_journal_read(rb, data, &len) != 1 || !ring_buffer_sync(rb))
+    {
+        printf("1. failed! read or sync.\n");
+        exit(-1);
+    }
+    ring_buffer_journal_close(&rb);
+    rb = ring_buffer_journal_open(path, &discarded);
+    if (rb == NULL || discarded != 0)
+    {
+        printf("1. failed! ring_buffer_journal_open().\n");
+        exit(-1);
+    }
+    expect_records(rb, 16, 30, "1.");
+    printf("1. ...OK\n");
+
+    printf("2. recovery after a process crash:\n");
+    pid = fork();
+    if (pid == 0)
+    {
+        for (i = 100; i < 110; i++)
+        {
+            rec_fill(i, data);
+            ring_buffer_journal_append(rb, data, rec_len(i));
+        }
+        // 不同步也不关闭，直接退出
+        _exit(0);
+    }
+    waitpid(pid, &status, 0);
+    // 父进程的映射与子进程共享同一文件，直接解除映射（不同步），再像重启后一样重新打开
+    munmap(rb, rb->data_offset + rb->buffer_cap);
+    rb = ring_buffer_journal_open(path, &discarded);
+    if (rb == NULL || discarded != 0)
+    {
+        printf("2. failed! reopen after crash.\n");
+        exit(-1);
+    }
+    expect_records(rb, 100, 110, "2.");
+    printf("2. ...OK\n");
+
+    printf("3. torn record is discarded with everything after it:\n");
+    for (i = 200; i < 203; i++)
+    {
+        rec_fill(i, data);
+        ring_buffer_journal_append(rb, data, rec_len(i));
+    }
+    {
+        // 第二条记录的内容只写了一部分：改坏其中一个字节
+        ring_buffer_size_t pos = rb->tail_index + (RING_BUFFER_JOURNAL_HEADER + rec_len(200) + 7) / 8 * 8;
+        ring_buffer_data(rb)[(pos + RING_BUFFER_JOURNAL_HEADER + 3) & (rb->buffer_cap - 1)] ^= 0x5A;
+    }
+    ring_buffer_journal_close(&rb);
+    rb = ring_buffer_journal_open(path, &discarded);
+    if (rb == NULL || discarded != (RING_BUFFER_JOURNAL_HEADER + rec_len(201) + 7) / 8 * 8 +
+                                       (RING_BUFFER_JOURNAL_HEADER + rec_len(202) + 7) / 8 * 8)
+    {
+        printf("3. failed! discarded %u bytes.\n", rb == NULL ? 0 : (unsigned)discarded);
+        exit(-1);
+    }
+    expect_records(rb, 200, 201, "3.");
+    printf("3. ...OK\n");
+
+    printf("4. stale record from the previous lap is rejected:\n");
+    {
+        ring_buffer_size_t tail;
+
+        // 写满一整圈再读空，数组中留下的全是有效格式的旧记录
+        while (ring_buffer_num_items(rb) < rb->buffer_cap - 128)
+        {
+            rec_fill(7, data);
+            ring_buffer_journal_append(rb, data, rec_len(7));
+        }
+        len = sizeof(data);
+        while (ring_buffer_journal_read(rb, data, &len))
+        {
+            len = sizeof(data);
+        }
+        // 模拟头部已落盘而数据没有：head指向上一轮的旧数据
+        tail = rb->tail_index;
+        rb->head_index = tail + 128;
+        ring_buffer_journal_close(&rb);
+        rb = ring_buffer_journal_open(path, &discarded);
+        if (rb == NULL || discarded != 128 || !ring_buffer_is_empty(rb) || rb->head_index != tail)
+        {
+            printf("4. failed! stale data accepted.\n");
+            exit(-1);
+        }
+    }
+    printf("4. ...OK\n");
+
+    printf("5. sync on a ring that is not file backed:\n");
+    {
+        ring_buffer_t *mem = ring_buffer_new(64);
+
+        if (ring_buffer_sync(mem))
+        {
+            printf("5. failed! ring_buffer_sync() on malloc memory.\n");
+            exit(-1);
+        }
+        ring_buffer_destroy(&mem);
+    }
+    ring_buffer_journal_close(&rb);
+    unlink(path);
+    printf("5. ...OK\n");
+
+    return 0;
+}
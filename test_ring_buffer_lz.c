@@ -0,0 +1,332 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_lz.c
+	> 压缩记录测试：编解码器对文本、随机数据、重复字节和长记录的往返、损坏输入不越界、
+	> 队列中的压缩记录读写和统计、跨越数组末尾的记录、两个线程之间的记录流。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_lz test_ring_buffer_lz.c ringbuffer.c ringbuffer_msg.c ringbuffer_lz.c -pthread
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ringbuffer_lz.h"
+
+#define STREAM_RECORDS 20000
+
+static uint64_t xorshift(uint64_t *s)
+{
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* 生成第n条类似日志的文本记录，返回长度 */
+static int make_record(char *out, int n)
+{
+    return sprintf(out, "ts=%d level=info service=gateway path=/api/v1/items/%d status=200 latency_us=%d", 1700000000 + n,
+                   n % 97, (n * 37) % 1000);
+}
+
+/* 压缩后解压，检查内容一致，返回压缩后的长度 */
+static size_t roundtrip(ring_buffer_lz_t *lz, const char *src, size_t len)
+{
+    static char packed[RING_BUFFER_LZ_BOUND(RING_BUFFER_LZ_MAX_RECORD)];
+    static char out[RING_BUFFER_LZ_MAX_RECORD];
+    size_t size = ring_buffer_lz_compress(lz, src, len, packed, RING_BUFFER_LZ_BOUND(len));
+
+    if (size == 0 || ring_buffer_lz_decompress(packed, size, out, len) != len || memcmp(out, src, len) != 0)
+    {
+        return 0;
+    }
+    return size;
+}
+
+/* 第n批记录：连续8条文本记录拼在一起，返回长度 */
+static int make_batch(char *out, int n)
+{
+    int i, len = 0;
+
+    for (i = 0; i < 8; i++)
+    {
+        len += make_record(out + len, n * 8 + i);
+    }
+    return len;
+}
+
+typedef struct
+{
+    ring_buffer_t *rb;
+    int errors;
+} stream_arg_t;
+
+static void *consumer(void *arg)
+{
+    stream_arg_t *s = arg;
+    ring_buffer_lz_t *lz = ring_buffer_lz_new();
+    char expect[1024], out[1024];
+    ring_buffer_size_t len;
+    int n = 0, elen;
+
+    while (n < STREAM_RECORDS)
+    {
+        len = sizeof(out);
+        if (!ring_buffer_pop_lz(s->rb, lz, out, &len))
+        {
+            continue;
+        }
+        elen = make_batch(expect, n);
+        if ((int)len != elen || memcmp(out, expect, len) != 0)
+        {
+            s->errors++;
+        }
+        n++;
+    }
+    ring_buffer_lz_destroy(&lz);
+    return NULL;
+}
+
+int main(void)
+{
+    static char src[RING_BUFFER_LZ_MAX_RECORD], packed[RING_BUFFER_LZ_BOUND(RING_BUFFER_LZ_MAX_RECORD)];
+    static char out[RING_BUFFER_LZ_MAX_RECORD], noise[300];
+    ring_buffer_lz_t *lz = ring_buffer_lz_new(), *reader = ring_buffer_lz_new();
+    ring_buffer_lz_stats_t stats;
+    ring_buffer_t *rb;
+    ring_buffer_size_t len;
+    const char *view;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    size_t size, total, k;
+    int i, j, n;
+
+    printf("1. codec roundtrip:\n");
+    for (i = 0, total = 0; total + 128 < 8192; i++)
+    {
+        total += make_record(src + total, i);
+    }
+    size = roundtrip(lz, src, total);
+    if (size == 0 || size * 3 > total)
+    {
+        printf("1. failed! text, %zu -> %zu.\n", total, size);
+        exit(-1);
+    }
+    for (i = 0; i < 4096; i++)
+    {
+        src[i] = (char)xorshift(&seed);
+    }
+    if (roundtrip(lz, src, 4096) == 0 || ring_buffer_lz_compress(lz, src, 4096, packed, 4095) != 0)
+    {
+        printf("1. failed! random.\n");
+        exit(-1);
+    }
+    // 重复字节：匹配与输出重叠
+    memset(src, 'z', sizeof(src));
+    src[0] = 'a';
+    if (roundtrip(lz, src, RING_BUFFER_LZ_MAX_RECORD) == 0 || roundtrip(lz, src, 1000) > 20)
+    {
+        printf("1. failed! runs.\n");
+        exit(-1);
+    }
+    for (i = 0; i < 20; i++)
+    {
+        if (roundtrip(lz, "abcabcabcabcabcabcabc", i) == 0 && i != 0)
+        {
+            printf("1. failed! short input %d.\n", i);
+            exit(-1);
+        }
+    }
+    for (k = 0; k < RING_BUFFER_LZ_MAX_RECORD; k++)
+    {
+        src[k] = (char)(xorshift(&seed) % 4 == 0 ? xorshift(&seed) : k / 64);
+    }
+    if (roundtrip(lz, src, RING_BUFFER_LZ_MAX_RECORD) == 0)
+    {
+        printf("1. failed! mixed 64KB.\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n");
+
+    printf("2. corrupted input never overruns:\n");
+    for (i = 0, total = 0; total + 128 < 2048; i++)
+    {
+        total += make_record(src + total, i);
+    }
+    size = ring_buffer_lz_compress(lz, src, total, packed, sizeof(packed));
+    for (i = 0; i < 20000; i++)
+    {
+        char bad[4096];
+        size_t cut = xorshift(&seed) % (size + 1);
+
+        memcpy(bad, packed, size);
+        for (j = 0; j < 1 + i % 4; j++)
+        {
+            bad[xorshift(&seed) % size] = (char)xorshift(&seed);
+        }
+        // 输出缓冲区刚好够大，越界写会被-fsanitize或后面的检查发现
+        if (ring_buffer_lz_decompress(bad, cut, out, total) > total)
+        {
+            printf("2. failed! output overrun.\n");
+            exit(-1);
+        }
+    }
+    if (ring_buffer_lz_decompress(packed, size, out, total - 1) != 0 ||
+        ring_buffer_lz_decompress("\x00\x01\x00", 3, out, 16) != 0)
+    {
+        printf("2. failed! invalid input accepted.\n");
+        exit(-1);
+    }
+    printf("2. ...OK\n");
+
+    printf("3. compressed records in a ring:\n");
+    rb = ring_buffer_new(4096);
+    for (i = 0, total = 0; i < 12; i++)
+    {
+        n = make_batch(src, i);
+        total += n;
+        if (!ring_buffer_push_lz(rb, lz, src, n))
+        {
+            break;
+        }
+    }
+    // 4KB的队列放不下12批原始记录（约8KB），压缩后可以
+    if (i != 12 || ring_buffer_num_items(rb) * 2 >= total)
+    {
+        printf("3. failed! only %d records fit.\n", i);
+        exit(-1);
+    }
+    for (i = 0; i < 12; i++)
+    {
+        n = make_batch(src, i);
+        if (i % 2 == 0)
+        {
+            if (!ring_buffer_peek_lz(rb, reader, &view, &len) || len != (ring_buffer_size_t)n ||
+                memcmp(view, src, n) != 0 || !ring_buffer_release_msg(rb))
+            {
+                printf("3. failed! peek record %d.\n", i);
+                exit(-1);
+            }
+            continue;
+        }
+        len = 10;
+        if (ring_buffer_pop_lz(rb, reader, out, &len) || len != (ring_buffer_size_t)n)
+        {
+            printf("3. failed! small buffer.\n");
+            exit(-1);
+        }
+        len = sizeof(out);
+        if (!ring_buffer_pop_lz(rb, reader, out, &len) || len != (ring_buffer_size_t)n || memcmp(out, src, n) != 0)
+        {
+            printf("3. failed! pop record %d.\n", i);
+            exit(-1);
+        }
+    }
+    len = sizeof(out);
+    if (ring_buffer_pop_lz(rb, reader, out, &len) || len != 0 || !ring_buffer_is_empty(rb))
+    {
+        printf("3. failed! ring not empty.\n");
+        exit(-1);
+    }
+    // 不可压缩和空记录原样存放
+    for (i = 0; i < (int)sizeof(noise); i++)
+    {
+        noise[i] = (char)xorshift(&seed);
+    }
+    ring_buffer_push_lz(rb, lz, noise, 300);
+    ring_buffer_push_lz(rb, lz, "", 0);
+    ring_buffer_lz_get_stats(lz, &stats);
+    if (stats.records != 14 || stats.stored_records < 2 || stats.raw_bytes != total + 300 ||
+        stats.packed_bytes * 2 > stats.raw_bytes)
+    {
+        printf("3. failed! stats.\n");
+        exit(-1);
+    }
+    len = sizeof(out);
+    if (!ring_buffer_pop_lz(rb, reader, out, &len) || len != 300 || memcmp(out, noise, 300) != 0 ||
+        !ring_buffer_peek_lz(rb, reader, &view, &len) || len != 0)
+    {
+        printf("3. failed! stored records.\n");
+        exit(-1);
+    }
+    ring_buffer_release_msg(rb);
+    ring_buffer_lz_get_stats(reader, &stats);
+    if (stats.read_records != 14)
+    {
+        printf("3. failed! read stats.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n");
+
+    printf("4. records wrapping past the array end:\n");
+    rb = ring_buffer_new(512);
+    for (i = 0; i < 2000; i++)
+    {
+        n = make_batch(src, i);
+        // 每隔几条插入一条不可压缩的记录，让两种记录都跨越数组末尾
+        if (i % 3 == 0)
+        {
+            n = 40 + i % 50;
+            for (j = 0; j < n; j++)
+            {
+                src[j] = (char)(i * 31 + j * 7 + (j * j) % 13);
+            }
+        }
+        if (!ring_buffer_push_lz(rb, lz, src, n))
+        {
+            printf("4. failed! push %d.\n", i);
+            exit(-1);
+        }
+        if (i % 2 == 0)
+        {
+            if (!ring_buffer_peek_lz(rb, reader, &view, &len) || len != (ring_buffer_size_t)n ||
+                memcmp(view, src, n) != 0)
+            {
+                printf("4. failed! peek %d.\n", i);
+                exit(-1);
+            }
+            ring_buffer_release_msg(rb);
+            continue;
+        }
+        len = sizeof(out);
+        if (!ring_buffer_pop_lz(rb, reader, out, &len) || len != (ring_buffer_size_t)n || memcmp(out, src, n) != 0)
+        {
+            printf("4. failed! pop %d.\n", i);
+            exit(-1);
+        }
+    }
+    ring_buffer_destroy(&rb);
+    printf("4. ...OK\n");
+
+    printf("5. producer and consumer threads:\n");
+    {
+        stream_arg_t arg;
+        pthread_t tid;
+
+        rb = ring_buffer_new(2048);
+        arg.rb = rb;
+        arg.errors = 0;
+        pthread_create(&tid, NULL, consumer, &arg);
+        for (i = 0; i < STREAM_RECORDS; i++)
+        {
+            n = make_batch(src, i);
+            while (!ring_buffer_push_lz(rb, lz, src, n))
+            {
+            }
+        }
+        pthread_join(tid, NULL);
+        if (arg.errors != 0 || !ring_buffer_is_empty(rb))
+        {
+            printf("5. failed! %d bad records.\n", arg.errors);
+            exit(-1);
+        }
+        ring_buffer_destroy(&rb);
+    }
+    printf("5. ...OK\n");
+
+    ring_buffer_lz_destroy(&lz);
+    ring_buffer_lz_destroy(&reader);
+    return 0;
+}
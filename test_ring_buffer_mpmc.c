@@ -0,0 +1,196 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_mpmc.c
+	> MPMC队列压力测试：N个生产者 x M个消费者，校验没有丢失和重复。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_mpmc test_ring_buffer_mpmc.c ringbuffer_mpmc.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer_mpmc.h"
+
+#define PRODUCERS 4
+#define CONSUMERS 3
+#define PER_PRODUCER 200000UL
+
+/* 元素：生产者编号 + 该生产者内的序号 + 填充，共32字节 */
+typedef struct
+{
+    uint32_t producer;
+    uint32_t pad;
+    uint64_t seq;
+    uint64_t check;
+    uint64_t fill;
+} item_t;
+
+static ring_buffer_mpmc_t *queue;
+static _Atomic unsigned char seen[PRODUCERS][PER_PRODUCER];
+static _Atomic unsigned long consumed;
+static _Atomic int failed;
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    item_t batch[16];
+    uint64_t next = 0;
+
+    while (next < PER_PRODUCER)
+    {
+        /* 奇数编号的生产者使用批量接口 */
+        ring_buffer_size_t i, n = (id & 1) ? 16 : 1;
+        if (n > PER_PRODUCER - next)
+        {
+            n = PER_PRODUCER - next;
+        }
+        for (i = 0; i < n; i++)
+        {
+            batch[i].producer = id;
+            batch[i].seq = next + i;
+            batch[i].check = (next + i) * 2654435761UL ^ id;
+        }
+        if (n == 1)
+        {
+            n = ring_buffer_mpmc_try_enqueue(queue, batch);
+        }
+        else
+        {
+            n = ring_buffer_mpmc_enqueue_batch(queue, batch, n);
+        }
+        if (n == 0)
+        {
+            sched_yield();
+        }
+        next += n;
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    uintptr_t id = (uintptr_t)arg;
+    item_t batch[8];
+    uint64_t last[PRODUCERS];
+    int p;
+
+    for (p = 0; p < PRODUCERS; p++)
+    {
+        last[p] = (uint64_t)-1;
+    }
+
+    while (atomic_load(&consumed) < PRODUCERS * PER_PRODUCER && !atomic_load(&failed))
+    {
+        ring_buffer_size_t i, n = (id & 1) ? ring_buffer_mpmc_dequeue_batch(queue, batch, 8)
+                                           : ring_buffer_mpmc_try_dequeue(queue, batch);
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        for (i = 0; i < n; i++)
+        {
+            item_t *it = &batch[i];
+            if (it->producer >= PRODUCERS || it->seq >= PER_PRODUCER ||
+                it->check != (it->seq * 2654435761UL ^ it->producer) ||
+                atomic_exchange(&seen[it->producer][it->seq], 1) != 0 ||
+                (last[it->producer] != (uint64_t)-1 && it->seq <= last[it->producer]))
+            {
+                printf("1. failed! bad or duplicated item producer %u seq %lu.\n", it->producer, (unsigned long)it->seq);
+                atomic_store(&failed, 1);
+                return NULL;
+            }
+            /* 同一消费者看到的同一生产者的元素必须保持先后顺序 */
+            last[it->producer] = it->seq;
+        }
+        atomic_fetch_add(&consumed, n);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    pthread_t producers[PRODUCERS], consumers[CONSUMERS];
+    item_t it;
+    uintptr_t i, j;
+
+    queue = ring_buffer_mpmc_new(sizeof(item_t), 1000);
+    if (queue == NULL || queue->buffer_cap != 1024)
+    {
+        printf("1. ring_buffer_mpmc_new() failed!\n");
+        exit(-1);
+    }
+
+    printf("1. %d producers x %d consumers, %lu items:\n", PRODUCERS, CONSUMERS, PRODUCERS * PER_PRODUCER);
+    for (i = 0; i < CONSUMERS; i++)
+    {
+        pthread_create(&consumers[i], NULL, consumer, (void *)i);
+    }
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        pthread_create(&producers[i], NULL, producer, (void *)i);
+    }
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        pthread_join(producers[i], NULL);
+    }
+    for (i = 0; i < CONSUMERS; i++)
+    {
+        pthread_join(consumers[i], NULL);
+    }
+
+    if (atomic_load(&failed))
+    {
+        exit(-1);
+    }
+    for (i = 0; i < PRODUCERS; i++)
+    {
+        for (j = 0; j < PER_PRODUCER; j++)
+        {
+            if (!seen[i][j])
+            {
+                printf("1. failed! item producer %lu seq %lu lost.\n", (unsigned long)i, (unsigned long)j);
+                exit(-1);
+            }
+        }
+    }
+    if (ring_buffer_mpmc_try_dequeue(queue, &it))
+    {
+        printf("1. failed! queue not empty.\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n\n");
+
+    printf("2. full and empty:\n");
+    for (i = 0; i < queue->buffer_cap; i++)
+    {
+        it.seq = i;
+        if (!ring_buffer_mpmc_try_enqueue(queue, &it))
+        {
+            printf("2. failed! enqueue %lu into non-full queue.\n", (unsigned long)i);
+            exit(-1);
+        }
+    }
+    if (ring_buffer_mpmc_try_enqueue(queue, &it) || ring_buffer_mpmc_enqueue_batch(queue, &it, 1) != 0)
+    {
+        printf("2. failed! enqueue into full queue.\n");
+        exit(-1);
+    }
+    for (i = 0; i < queue->buffer_cap; i++)
+    {
+        if (!ring_buffer_mpmc_try_dequeue(queue, &it) || it.seq != i)
+        {
+            printf("2. failed! dequeue order at %lu.\n", (unsigned long)i);
+            exit(-1);
+        }
+    }
+    printf("2. ...OK\n");
+
+    ring_buffer_mpmc_destroy(&queue);
+    return 0;
+}
@@ -0,0 +1,350 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_msg.c
+	> 变长消息层测试：全有或全无写入、跳过填充、双线程并发收发、批量写入和批量读出。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_msg test_ring_buffer_msg.c ringbuffer.c ringbuffer_msg.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer_msg.h"
+
+#define MESSAGES 200000UL
+
+/* 第i条消息的长度和内容 */
+static ring_buffer_size_t msg_len(unsigned long i)
+{
+    return (i * 7919) % 700;
+}
+
+static char msg_byte(unsigned long i, ring_buffer_size_t k)
+{
+    return (char)(i + k * 31);
+}
+
+static void *producer(void *arg)
+{
+    ring_buffer_t *rb = arg;
+    char msg[1024];
+    unsigned long i;
+
+    for (i = 0; i < MESSAGES; i++)
+    {
+        ring_buffer_size_t k, len = msg_len(i);
+        for (k = 0; k < len; k++)
+        {
+            msg[k] = msg_byte(i, k);
+        }
+        while (!ring_buffer_push_msg(rb, msg, len))
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* 批量写入：每16条消息发布一次，空间不足时先发布已追加的消息 */
+static void *batch_producer(void *arg)
+{
+    ring_buffer_msg_batch_t batch;
+    char msg[1024];
+    unsigned long i;
+
+    ring_buffer_begin_batch(arg, &batch);
+    for (i = 0; i < MESSAGES; i++)
+    {
+        ring_buffer_size_t k, len = msg_len(i);
+        for (k = 0; k < len; k++)
+        {
+            msg[k] = msg_byte(i, k);
+        }
+        while (!ring_buffer_batch_append(&batch, msg, len))
+        {
+            ring_buffer_publish_batch(&batch);
+            sched_yield();
+        }
+        if (batch.records == 16)
+        {
+            ring_buffer_publish_batch(&batch);
+        }
+    }
+    ring_buffer_publish_batch(&batch);
+    return NULL;
+}
+
+/* 批量写入、批量读出的双线程收发 */
+static void run_batch_threads(ring_buffer_t *rb)
+{
+    static char out[4096];
+    ring_buffer_size_t lens[32], n, j, k, off;
+    pthread_t tid;
+    unsigned long i = 0;
+
+    pthread_create(&tid, NULL, batch_producer, rb);
+    while (i < MESSAGES)
+    {
+        n = ring_buffer_dequeue_batch(rb, out, sizeof(out), lens, 32);
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        for (j = 0, off = 0; j < n; j++, i++)
+        {
+            if (lens[j] != msg_len(i))
+            {
+                printf("failed! batch message %lu length %lu.\n", i, (unsigned long)lens[j]);
+                exit(-1);
+            }
+            for (k = 0; k < lens[j]; k++)
+            {
+                if (out[off + k] != msg_byte(i, k))
+                {
+                    printf("failed! batch message %lu byte %lu.\n", i, (unsigned long)k);
+                    exit(-1);
+                }
+            }
+            off += lens[j];
+        }
+    }
+    pthread_join(tid, NULL);
+}
+
+/* 双线程收发，pad为1时检查每条消息都是连续的 */
+static void run_threads(ring_buffer_t *rb, int pad)
+{
+    pthread_t tid;
+    unsigned long i;
+
+    pthread_create(&tid, NULL, producer, rb);
+    for (i = 0; i < MESSAGES; i++)
+    {
+        ring_buffer_span_t spans[2];
+        ring_buffer_size_t k;
+
+        while (!ring_buffer_peek_msg(rb, spans))
+        {
+            sched_yield();
+        }
+        if (spans[0].len + spans[1].len != msg_len(i) || (pad && spans[1].len != 0))
+        {
+            printf("failed! message %lu length %lu + %lu.\n", i, (unsigned long)spans[0].len, (unsigned long)spans[1].len);
+            exit(-1);
+        }
+        for (k = 0; k < msg_len(i); k++)
+        {
+            char c = k < spans[0].len ? spans[0].data[k] : spans[1].data[k - spans[0].len];
+            if (c != msg_byte(i, k))
+            {
+                printf("failed! message %lu byte %lu.\n", i, (unsigned long)k);
+                exit(-1);
+            }
+        }
+        ring_buffer_release_msg(rb);
+    }
+    pthread_join(tid, NULL);
+}
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(256);
+    ring_buffer_span_t spans[2];
+    char a[256], c[256];
+    ring_buffer_size_t len;
+    int i;
+
+    for (i = 0; i < 256; i++)
+    {
+        a[i] = i;
+    }
+
+    printf("1. all or nothing push:\n");
+    /* 每条记录4字节头 + 100字节，按4字节对齐后为104字节，256字节只能放两条 */
+    if (!ring_buffer_push_msg(rb, a, 100) || !ring_buffer_push_msg(rb, a + 1, 100) ||
+        ring_buffer_push_msg(rb, a, 100) || ring_buffer_num_items(rb) != 208 || ring_buffer_push_msg(rb, a, 300))
+    {
+        printf("1. failed! push beyond free space.\n");
+        exit(-1);
+    }
+    len = 50;
+    if (ring_buffer_pop_msg(rb, c, &len) || len != 100)
+    {
+        printf("1. failed! pop into small buffer.\n");
+        exit(-1);
+    }
+    len = sizeof(c);
+    if (!ring_buffer_pop_msg(rb, c, &len) || len != 100 || memcmp(a, c, 100) != 0)
+    {
+        printf("1. failed! pop message.\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n\n");
+
+    printf("2. wrapped message and padding:\n");
+    /* 第三条记录从偏移208开始，跨越数组末尾 */
+    if (!ring_buffer_push_msg(rb, a, 90) || !ring_buffer_release_msg(rb) || !ring_buffer_peek_msg(rb, spans) ||
+        spans[0].len != 44 || spans[1].len != 46 || memcmp(spans[0].data, a, 44) != 0)
+    {
+        printf("2. failed! wrapped message spans.\n");
+        exit(-1);
+    }
+    ring_buffer_release_msg(rb);
+    /* 设置填充后，同样的位置上消息被整体移到数组开头 */
+    ring_buffer_init(rb);
+    ring_buffer_set_msg_pad(rb, 1);
+    ring_buffer_push_msg(rb, a, 100);
+    ring_buffer_push_msg(rb, a, 100);
+    ring_buffer_release_msg(rb);
+    ring_buffer_release_msg(rb);
+    if (!ring_buffer_push_msg(rb, a, 90) || !ring_buffer_peek_msg(rb, spans) ||
+        spans[0].len != 90 || spans[1].len != 0 || spans[0].data != ring_buffer_data(rb) + RING_BUFFER_MSG_HEADER)
+    {
+        printf("2. failed! padded message is not contiguous.\n");
+        exit(-1);
+    }
+    ring_buffer_release_msg(rb);
+    if (!ring_buffer_is_empty(rb) || ring_buffer_peek_msg(rb, spans))
+    {
+        printf("2. failed! buffer not empty.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    /* 空队列中写位置到数组末尾只剩12字节，更长的记录填充后从数组开头开始 */
+    rb = ring_buffer_new_policy(64, RING_BUFFER_DROP_NEWEST);
+    ring_buffer_set_msg_pad(rb, 1);
+    ring_buffer_push_msg(rb, a, 4);
+    ring_buffer_release_msg(rb);
+    ring_buffer_push_msg(rb, a, 16);
+    ring_buffer_release_msg(rb);
+    ring_buffer_push_msg(rb, a, 20);
+    ring_buffer_release_msg(rb);
+    if (!ring_buffer_is_empty(rb) || !ring_buffer_push_msg(rb, a + 1, 24) || !ring_buffer_peek_msg(rb, spans) ||
+        spans[0].len != 24 || spans[0].data != ring_buffer_data(rb) + RING_BUFFER_MSG_HEADER ||
+        memcmp(spans[0].data, a + 1, 24) != 0)
+    {
+        printf("2. failed! padded record in empty ring.\n");
+        exit(-1);
+    }
+    ring_buffer_release_msg(rb);
+    ring_buffer_push_msg(rb, a, 4);
+    ring_buffer_release_msg(rb);
+    /* 写位置到数组末尾28字节：超过数组一半的记录按超长拒绝，不计入丢弃；一半大小的记录总能写入 */
+    if (ring_buffer_push_msg(rb, a, 56) || ring_buffer_dropped_msgs(rb) != 0 || !ring_buffer_push_msg(rb, a + 2, 28) ||
+        !ring_buffer_peek_msg(rb, spans) || spans[0].data != ring_buffer_data(rb) + RING_BUFFER_MSG_HEADER ||
+        memcmp(spans[0].data, a + 2, 28) != 0)
+    {
+        printf("2. failed! largest padded record.\n");
+        exit(-1);
+    }
+    /* 队列中有记录时不能切换填充 */
+    if (ring_buffer_set_msg_pad(rb, 0) || !(rb->flags & RING_BUFFER_FLAG_MSG_PAD))
+    {
+        printf("2. failed! padding switched on a non-empty ring.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("2. ...OK\n\n");
+
+    printf("3. two thread stream, %lu messages:\n", MESSAGES);
+    rb = ring_buffer_new(4096);
+    run_threads(rb, 0);
+    ring_buffer_set_msg_pad(rb, 1);
+    run_threads(rb, 1);
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n\n");
+
+    printf("4. batch append, publish and dequeue:\n");
+    {
+        ring_buffer_msg_batch_t batch;
+        ring_buffer_size_t lens[8];
+
+        rb = ring_buffer_new(256);
+        ring_buffer_begin_batch(rb, &batch);
+        for (i = 0; i < 3; i++)
+        {
+            ring_buffer_batch_append(&batch, a + i, 10);
+        }
+        /* 发布之前消费者看不到 */
+        if (ring_buffer_num_items(rb) != 0 || ring_buffer_peek_msg(rb, spans) || ring_buffer_publish_batch(&batch) != 3 ||
+            ring_buffer_num_items(rb) != 48)
+        {
+            printf("4. failed! publish.\n");
+            exit(-1);
+        }
+        if (!ring_buffer_batch_append(&batch, a, 100) || !ring_buffer_batch_append(&batch, a + 1, 100) ||
+            ring_buffer_batch_append(&batch, a + 2, 100) || ring_buffer_publish_batch(&batch) != 2 ||
+            ring_buffer_publish_batch(&batch) != 0 || !ring_buffer_is_full(rb))
+        {
+            printf("4. failed! append beyond free space.\n");
+            exit(-1);
+        }
+        if (ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 2) != 2 || lens[0] != 10 || lens[1] != 10 ||
+            memcmp(c, a, 10) != 0 || memcmp(c + 10, a + 1, 10) != 0)
+        {
+            printf("4. failed! dequeue up to max.\n");
+            exit(-1);
+        }
+        if (ring_buffer_dequeue_batch(rb, c, 50, lens, 8) != 1 || lens[0] != 10 || memcmp(c, a + 2, 10) != 0 ||
+            ring_buffer_dequeue_batch(rb, c, 50, lens, 8) != 0 || lens[0] != 100)
+        {
+            printf("4. failed! dequeue into small buffer.\n");
+            exit(-1);
+        }
+        if (ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 8) != 2 || lens[0] != 100 || lens[1] != 100 ||
+            memcmp(c, a, 100) != 0 || memcmp(c + 100, a + 1, 100) != 0 ||
+            ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 8) != 0 || lens[0] != 0)
+        {
+            printf("4. failed! dequeue all.\n");
+            exit(-1);
+        }
+
+        /* 写位置在192，第二条记录需要填充到数组末尾 */
+        ring_buffer_set_msg_pad(rb, 1);
+        for (i = 0; i < 3; i++)
+        {
+            ring_buffer_batch_append(&batch, a, 60);
+        }
+        ring_buffer_publish_batch(&batch);
+        ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 8);
+        ring_buffer_batch_append(&batch, a + 5, 80);
+        ring_buffer_batch_append(&batch, a + 6, 20);
+        if (ring_buffer_publish_batch(&batch) != 2 || !ring_buffer_peek_msg(rb, spans) ||
+            spans[0].data != ring_buffer_data(rb) + RING_BUFFER_MSG_HEADER ||
+            ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 8) != 2 || lens[0] != 80 || lens[1] != 20 ||
+            memcmp(c, a + 5, 80) != 0 || memcmp(c + 80, a + 6, 20) != 0)
+        {
+            printf("4. failed! padded batch.\n");
+            exit(-1);
+        }
+
+        /* 不填充时第二条记录跨越数组末尾 */
+        ring_buffer_set_msg_pad(rb, 0);
+        ring_buffer_batch_append(&batch, a + 7, 100);
+        ring_buffer_batch_append(&batch, a + 8, 100);
+        if (ring_buffer_publish_batch(&batch) != 2 || ring_buffer_dequeue_batch(rb, c, sizeof(c), lens, 8) != 2 ||
+            memcmp(c, a + 7, 100) != 0 || memcmp(c + 100, a + 8, 100) != 0 || !ring_buffer_is_empty(rb))
+        {
+            printf("4. failed! wrapped batch.\n");
+            exit(-1);
+        }
+        ring_buffer_destroy(&rb);
+    }
+    printf("4. ...OK\n\n");
+
+    printf("5. two thread batch stream, %lu messages:\n", MESSAGES);
+    rb = ring_buffer_new(4096);
+    run_batch_threads(rb);
+    ring_buffer_set_msg_pad(rb, 1);
+    run_batch_threads(rb);
+    ring_buffer_destroy(&rb);
+    printf("5. ...OK\n");
+
+    return 0;
+}
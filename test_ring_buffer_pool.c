@@ -0,0 +1,205 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_pool.c
+	> 队列池测试：按容量选择级、用完后退到更大的级、释放时清空并优先复用、
+	> 无效释放、多线程并发取出/释放、共享内存中跨进程释放。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_pool test_ring_buffer_pool.c ringbuffer.c ringbuffer_pool.c -pthread
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_pool.h"
+
+#define THREADS 4
+#define ROUNDS 200000
+
+static ring_buffer_pool_t *shared_pool;
+
+/* 每个线程反复取出队列、写入自己的编号再读回，两个线程拿到同一个队列时内容会不一致 */
+static void *churn(void *arg)
+{
+    char id = (char)(long)arg, out[8];
+    ring_buffer_t *rb[3];
+    int i, k;
+
+    for (i = 0; i < ROUNDS; i++)
+    {
+        for (k = 0; k < 3; k++)
+        {
+            rb[k] = ring_buffer_pool_acquire(shared_pool, 64);
+            if (rb[k] == NULL || !ring_buffer_is_empty(rb[k]))
+            {
+                printf("3. failed! acquire returned %s ring.\n", rb[k] == NULL ? "no" : "a non-empty");
+                exit(-1);
+            }
+            memset(out, id, sizeof(out));
+            ring_buffer_queue_arr(rb[k], out, sizeof(out));
+        }
+        for (k = 0; k < 3; k++)
+        {
+            if (ring_buffer_dequeue_arr(rb[k], out, sizeof(out)) != sizeof(out) || out[0] != id || out[7] != id ||
+                !ring_buffer_is_empty(rb[k]))
+            {
+                printf("3. failed! ring shared between threads.\n");
+                exit(-1);
+            }
+            ring_buffer_pool_release(shared_pool, rb[k]);
+        }
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    ring_buffer_pool_class_t classes[] = {{1000, 4}, {4096, 2}, {65536, 1}};
+    ring_buffer_pool_t *pool;
+    ring_buffer_t *rb[8], *other;
+    char data[16] = "connection data", out[16];
+    int i;
+
+    printf("1. size classes:\n");
+    pool = ring_buffer_pool_new(classes, 3, RING_BUFFER_REJECT);
+    if (pool == NULL || pool->slabs[0].capacity != 1024 || ring_buffer_pool_available(pool, 0) != 4 ||
+        ring_buffer_pool_available(pool, 3) != 0)
+    {
+        printf("1. failed! ring_buffer_pool_new().\n");
+        exit(-1);
+    }
+    for (i = 0; i < 4; i++)
+    {
+        rb[i] = ring_buffer_pool_acquire(pool, 100);
+        if (rb[i] == NULL || rb[i]->buffer_cap != 1024 || (rb[i]->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) !=
+                                                                 RING_BUFFER_REJECT)
+        {
+            printf("1. failed! acquire from class 0.\n");
+            exit(-1);
+        }
+    }
+    // 第0级用完，依次退到更大的级
+    rb[4] = ring_buffer_pool_acquire(pool, 100);
+    rb[5] = ring_buffer_pool_acquire(pool, 2000);
+    rb[6] = ring_buffer_pool_acquire(pool, 2000);
+    rb[7] = ring_buffer_pool_acquire(pool, 1);
+    if (rb[4] == NULL || rb[4]->buffer_cap != 4096 || rb[5] == NULL || rb[5]->buffer_cap != 4096 ||
+        rb[6] == NULL || rb[6]->buffer_cap != 65536 || rb[7] != NULL || ring_buffer_pool_acquire(pool, 65537) != NULL)
+    {
+        printf("1. failed! fall back to larger classes.\n");
+        exit(-1);
+    }
+    for (i = 0; i < 7; i++)
+    {
+        ring_buffer_queue_arr(rb[i], data, sizeof(data));
+    }
+    for (i = 0; i < 7; i++)
+    {
+        if (ring_buffer_dequeue_arr(rb[i], out, sizeof(out)) != sizeof(out) || memcmp(data, out, sizeof(out)) != 0)
+        {
+            printf("1. failed! ring %d data.\n", i);
+            exit(-1);
+        }
+    }
+    printf("1. ...OK\n");
+
+    printf("2. release resets the ring and is reused first:\n");
+    ring_buffer_queue_arr(rb[2], data, sizeof(data));
+    other = ring_buffer_new(1024);
+    ring_buffer_destroy(&rb[2]);
+    if (rb[2] == NULL || ring_buffer_pool_release(pool, other) || !ring_buffer_pool_release(pool, rb[2]) ||
+        ring_buffer_pool_available(pool, 0) != 1)
+    {
+        printf("2. failed! release.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&other);
+    if (ring_buffer_pool_acquire(pool, 10) != rb[2] || !ring_buffer_is_empty(rb[2]))
+    {
+        printf("2. failed! released ring is not reused empty.\n");
+        exit(-1);
+    }
+    for (i = 0; i < 7; i++)
+    {
+        ring_buffer_pool_release(pool, rb[i]);
+    }
+    if (ring_buffer_pool_available(pool, 0) != 4 || ring_buffer_pool_available(pool, 1) != 2 ||
+        ring_buffer_pool_available(pool, 2) != 1)
+    {
+        printf("2. failed! available after release.\n");
+        exit(-1);
+    }
+    ring_buffer_pool_destroy(&pool);
+    printf("2. ...OK\n");
+
+    printf("3. concurrent acquire and release:\n");
+    {
+        ring_buffer_pool_class_t small[] = {{64, THREADS * 3}};
+        pthread_t tid[THREADS];
+        long t;
+
+        shared_pool = ring_buffer_pool_new(small, 1, RING_BUFFER_OVERWRITE);
+        for (t = 0; t < THREADS; t++)
+        {
+            pthread_create(&tid[t], NULL, churn, (void *)(t + 1));
+        }
+        for (t = 0; t < THREADS; t++)
+        {
+            pthread_join(tid[t], NULL);
+        }
+        if (ring_buffer_pool_available(shared_pool, 0) != THREADS * 3)
+        {
+            printf("3. failed! rings lost.\n");
+            exit(-1);
+        }
+        ring_buffer_pool_destroy(&shared_pool);
+    }
+    printf("3. ...OK\n");
+
+    printf("4. pool in shared memory, released by another process:\n");
+    {
+        size_t length = ring_buffer_pool_calc_size(classes, 3);
+        void *addr = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        pid_t pid;
+        int status;
+
+        pool = ring_buffer_pool_attach(addr, length, classes, 3, RING_BUFFER_OVERWRITE);
+        rb[0] = ring_buffer_pool_acquire(pool, 4000);
+        ring_buffer_queue_arr(rb[0], data, sizeof(data));
+        pid = fork();
+        if (pid == 0)
+        {
+            // 子进程按其他进程的方式打开池，读出数据并释放队列
+            ring_buffer_pool_t *child = ring_buffer_pool_open(addr, length);
+            if (child == NULL || ring_buffer_dequeue_arr(rb[0], out, sizeof(out)) != sizeof(out) ||
+                memcmp(data, out, sizeof(out)) != 0 || !ring_buffer_pool_release(child, rb[0]))
+            {
+                _exit(1);
+            }
+            _exit(0);
+        }
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || ring_buffer_pool_available(pool, 1) != 2 ||
+            ring_buffer_pool_acquire(pool, 4000) != rb[0])
+        {
+            printf("4. failed! cross-process release.\n");
+            exit(-1);
+        }
+        ring_buffer_pool_destroy(&pool);
+        if (pool == NULL)
+        {
+            printf("4. failed! destroyed an attached pool.\n");
+            exit(-1);
+        }
+        munmap(addr, length);
+    }
+    printf("4. ...OK\n");
+
+    return 0;
+}
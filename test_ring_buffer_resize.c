@@ -0,0 +1,213 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_resize.c
+	> 在线调整容量测试：跨越数组末尾的数据在增长/缩小后保持不变、任意容量的队列、
+	> 带填充的消息队列、拒绝不支持的队列、自动增长和带滞后的缩小。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_resize test_ring_buffer_resize.c ringbuffer.c ringbuffer_resize.c ringbuffer_msg.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ringbuffer_resize.h"
+#include "ringbuffer_msg.h"
+
+/* 读出len个字节，检查是否为从seq开始的递增序列 */
+static int drain_check(ring_buffer_t *rb, ring_buffer_size_t len, unsigned char seq)
+{
+    char out[4096];
+    ring_buffer_size_t i;
+
+    if (ring_buffer_dequeue_arr(rb, out, len) != len)
+    {
+        return 0;
+    }
+    for (i = 0; i < len; i++)
+    {
+        if ((unsigned char)out[i] != (unsigned char)(seq + i))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void)
+{
+    ring_buffer_t *rb, *before;
+    ring_buffer_span_t spans[2];
+    char data[4096], block[512];
+    ring_buffer_size_t len;
+    int i;
+
+    for (i = 0; i < (int)sizeof(data); i++)
+    {
+        data[i] = (char)i;
+    }
+
+    printf("1. grow and shrink keep wrapped data:\n");
+    rb = ring_buffer_new_policy(16, RING_BUFFER_DROP_NEWEST);
+    ring_buffer_queue_arr(rb, data, 12);
+    drain_check(rb, 8, 0);
+    // 数据跨越数组末尾：[8, 16) + [0, 8)，最后2个字节被截断
+    ring_buffer_queue_arr(rb, data + 12, 14);
+    if (ring_buffer_num_items(rb) != 16 || ring_buffer_dropped_bytes(rb) != 2 || !ring_buffer_resize(&rb, 100) ||
+        rb->buffer_cap != 128 || ring_buffer_num_items(rb) != 16 || ring_buffer_dropped_bytes(rb) != 2 ||
+        (rb->flags & RING_BUFFER_FLAG_OVERFLOW_MASK) != RING_BUFFER_DROP_NEWEST)
+    {
+        printf("1. failed! grow.\n");
+        exit(-1);
+    }
+    ring_buffer_queue_arr(rb, data + 24, 40);
+    before = rb;
+    if (ring_buffer_resize(&rb, 32) || rb != before || !ring_buffer_resize(&rb, 56) || rb->buffer_cap != 64 ||
+        !drain_check(rb, 56, 8) || !ring_buffer_is_empty(rb))
+    {
+        printf("1. failed! shrink.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("1. ...OK\n");
+
+    printf("2. arbitrary capacity:\n");
+    rb = ring_buffer_new_exact(1000, RING_BUFFER_REJECT);
+    for (i = 0; i < 7; i++)
+    {
+        ring_buffer_queue_arr(rb, data + i * 130, 130);
+        drain_check(rb, 130, (unsigned char)(i * 130));
+    }
+    // tail = 910，数据跨越数组末尾
+    ring_buffer_queue_arr(rb, data + 910, 300);
+    if (!ring_buffer_resize(&rb, 3000) || rb->buffer_cap != 3000 || !(rb->flags & RING_BUFFER_FLAG_EXACT) ||
+        !ring_buffer_resize(&rb, 301) || rb->buffer_cap != 304 || !drain_check(rb, 300, (unsigned char)910))
+    {
+        printf("2. failed! exact resize.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    // 容量中途是2的整数次幂时仍按8字节取整
+    rb = ring_buffer_new_exact(4096, RING_BUFFER_REJECT);
+    if (!ring_buffer_resize(&rb, 5000) || rb->buffer_cap != 5000)
+    {
+        printf("2. failed! resize from exact 4096.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    rb = ring_buffer_new_exact(1000, RING_BUFFER_REJECT);
+    ring_buffer_queue_arr(rb, data, 700);
+    if (!ring_buffer_resize(&rb, 1024) || rb->buffer_cap != 1024 || !ring_buffer_resize(&rb, 1500) ||
+        rb->buffer_cap != 1504 || !drain_check(rb, 700, 0))
+    {
+        printf("2. failed! resize through a power of two.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("2. ...OK\n");
+
+    printf("3. padded messages stay valid:\n");
+    rb = ring_buffer_new(256);
+    ring_buffer_set_msg_pad(rb, 1);
+    ring_buffer_push_msg(rb, data, 100);
+    ring_buffer_push_msg(rb, data, 100);
+    ring_buffer_release_msg(rb);
+    ring_buffer_release_msg(rb);
+    // 第三条消息放不下，数组末尾的48字节是填充，消息从数组开头开始
+    ring_buffer_push_msg(rb, data + 1, 90);
+    if (!ring_buffer_resize(&rb, 1024) || !(rb->flags & RING_BUFFER_FLAG_MSG_PAD) ||
+        !ring_buffer_push_msg(rb, data + 2, 500) || !ring_buffer_peek_msg(rb, spans) || spans[0].len != 90 ||
+        spans[1].len != 0 || memcmp(spans[0].data, data + 1, 90) != 0)
+    {
+        printf("3. failed! padded message after resize.\n");
+        exit(-1);
+    }
+    ring_buffer_release_msg(rb);
+    len = sizeof(block);
+    if (!ring_buffer_pop_msg(rb, block, &len) || len != 500 || memcmp(block, data + 2, 500) != 0 ||
+        !ring_buffer_is_empty(rb))
+    {
+        printf("3. failed! message after padding.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n");
+
+    printf("4. rings not allocated by ring_buffer_new are rejected:\n");
+    {
+        static _Alignas(RING_BUFFER_CACHE_LINE) char mem[1024];
+        ring_buffer_t *attached = ring_buffer_attach_array(mem, mem + 512, 256, RING_BUFFER_OVERWRITE);
+        before = attached;
+        if (attached == NULL || ring_buffer_resize(&attached, 512) || attached != before)
+        {
+            printf("4. failed! resized an attached ring.\n");
+            exit(-1);
+        }
+    }
+    printf("4. ...OK\n");
+
+    printf("5. automatic growth with an upper bound and delayed shrink:\n");
+    {
+        ring_buffer_autosize_t autosize = {64, 4096, 3, 0};
+        ring_buffer_size_t total = 0;
+
+        rb = ring_buffer_new_policy(autosize.min_cap, RING_BUFFER_REJECT);
+        for (i = 0; i < 10; i++)
+        {
+            total += ring_buffer_queue_arr_auto(&rb, data + i * 100, 100, &autosize);
+        }
+        if (total != 1000 || rb->buffer_cap != 1024)
+        {
+            printf("5. failed! growth, capacity %llu.\n", (unsigned long long)rb->buffer_cap);
+            exit(-1);
+        }
+        // 达到上限之后由溢出策略处理
+        for (i = 10; i < 41; i++)
+        {
+            total += ring_buffer_queue_arr_auto(&rb, data + (i * 100) % 4000, 100, &autosize);
+        }
+        if (total != 4000 || rb->buffer_cap != 4096)
+        {
+            printf("5. failed! upper bound, capacity %llu.\n", (unsigned long long)rb->buffer_cap);
+            exit(-1);
+        }
+        if (!drain_check(rb, 3000, 0) || ring_buffer_autosize_check(&rb, &autosize) ||
+            ring_buffer_autosize_check(&rb, &autosize) || !ring_buffer_autosize_check(&rb, &autosize) ||
+            rb->buffer_cap != 2048)
+        {
+            printf("5. failed! delayed shrink.\n");
+            exit(-1);
+        }
+        // 使用量超过1/4时重新计数
+        ring_buffer_autosize_check(&rb, &autosize);
+        ring_buffer_autosize_check(&rb, &autosize);
+        ring_buffer_queue_arr(rb, data, 600);
+        if (ring_buffer_autosize_check(&rb, &autosize) || autosize.low_count != 0)
+        {
+            printf("5. failed! hysteresis.\n");
+            exit(-1);
+        }
+        for (i = 0; i < 100; i++)
+        {
+            ring_buffer_autosize_check(&rb, &autosize);
+        }
+        if (rb->buffer_cap != 2048 || !drain_check(rb, 1000, (unsigned char)3000) || !drain_check(rb, 600, 0))
+        {
+            printf("5. failed! shrink below used data.\n");
+            exit(-1);
+        }
+        for (i = 0; i < 100; i++)
+        {
+            ring_buffer_autosize_check(&rb, &autosize);
+        }
+        if (rb->buffer_cap != 64)
+        {
+            printf("5. failed! shrink to lower bound, capacity %llu.\n", (unsigned long long)rb->buffer_cap);
+            exit(-1);
+        }
+        ring_buffer_destroy(&rb);
+    }
+    printf("5. ...OK\n");
+
+    return 0;
+}
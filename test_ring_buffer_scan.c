@@ -0,0 +1,167 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_scan.c
+	> 分隔符查找测试：各扫描实现与逐字节peek的结果对比（包括跨越数组末尾的数据）、按行读出。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_scan test_ring_buffer_scan.c ringbuffer.c ringbuffer_scan.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ringbuffer_scan.h"
+
+/* 用ring_buffer_peek逐字节查找，作为参照结果 */
+static ring_buffer_diff_t naive_find_any(ring_buffer_t *rb, const char *set, ring_buffer_size_t start)
+{
+    ring_buffer_size_t i, n = ring_buffer_num_items(rb);
+    char c;
+
+    for (i = start; i < n; i++)
+    {
+        ring_buffer_peek(rb, &c, i);
+        if (c != '\0' && strchr(set, c) != NULL)
+        {
+            return (ring_buffer_diff_t)i;
+        }
+    }
+    return -1;
+}
+
+static ring_buffer_size_t naive_count(ring_buffer_t *rb, char byte)
+{
+    ring_buffer_size_t i, cnt = 0, n = ring_buffer_num_items(rb);
+    char c;
+
+    for (i = 0; i < n; i++)
+    {
+        ring_buffer_peek(rb, &c, i);
+        cnt += (c == byte);
+    }
+    return cnt;
+}
+
+static void check_impl(ring_buffer_scan_impl_t impl, const char *name)
+{
+    static const char *sets[] = {"\n", ";,", "\r\n\t ", "0123456789:;<=>?"};
+    ring_buffer_t *rb = ring_buffer_new(1024);
+    char data[1024], out[1024];
+    int round, s;
+
+    if (!ring_buffer_scan_select(impl))
+    {
+        printf("   %s not supported, skipped\n", name);
+        ring_buffer_destroy(&rb);
+        return;
+    }
+    printf("   %s\n", name);
+    srand(7);
+    for (round = 0; round < 300; round++)
+    {
+        ring_buffer_size_t n = (ring_buffer_size_t)(rand() % 1024), i, start;
+
+        // 读掉随机数量的字节，使数据从数组的不同位置开始并经常跨越末尾
+        ring_buffer_dequeue_arr(rb, out, (ring_buffer_size_t)(rand() % 1024));
+        for (i = 0; i < n; i++)
+        {
+            // 稀疏的匹配字节，使各实现的向量循环和尾部处理都被走到
+            data[i] = (rand() % 97 == 0) ? "\n;,\t0?"[rand() % 6] : (char)('a' + rand() % 26);
+        }
+        ring_buffer_queue_arr(rb, data, n);
+
+        for (s = 0; s < (int)(sizeof(sets) / sizeof(sets[0])); s++)
+        {
+            for (start = 0; start <= ring_buffer_num_items(rb); start += 1 + rand() % 97)
+            {
+                ring_buffer_diff_t want = naive_find_any(rb, sets[s], start);
+                ring_buffer_diff_t got = ring_buffer_find_any(rb, sets[s], start);
+
+                if (got != want)
+                {
+                    printf("1. failed! %s find_any(\"%s\", %u) = %d, expected %d.\n", name, sets[s],
+                           (unsigned)start, (int)got, (int)want);
+                    exit(-1);
+                }
+                if (s == 0 && ring_buffer_find(rb, '\n', start) != want)
+                {
+                    printf("1. failed! %s find('\\n', %u).\n", name, (unsigned)start);
+                    exit(-1);
+                }
+            }
+        }
+        if (ring_buffer_count(rb, '\n') != naive_count(rb, '\n') || ring_buffer_count(rb, 'q') != naive_count(rb, 'q'))
+        {
+            printf("1. failed! %s count().\n", name);
+            exit(-1);
+        }
+    }
+    ring_buffer_destroy(&rb);
+}
+
+int main(void)
+{
+    ring_buffer_t *rb;
+    char out[64];
+    ring_buffer_size_t n;
+
+    printf("1. find, find_any and count against peek:\n");
+    check_impl(RING_BUFFER_SCAN_SCALAR, "scalar");
+    check_impl(RING_BUFFER_SCAN_SSE2, "sse2");
+    check_impl(RING_BUFFER_SCAN_AVX2, "avx2");
+    ring_buffer_scan_select(RING_BUFFER_SCAN_AUTO);
+    printf("1. ...OK\n");
+
+    printf("2. dequeue_line:\n");
+    rb = ring_buffer_new(64);
+    ring_buffer_queue_arr(rb, "0123456789012345678901234567890123456789", 40);
+    ring_buffer_dequeue_arr(rb, out, 40);
+    // 第二行跨越数组末尾
+    ring_buffer_queue_arr(rb, "first line\nsecond line, longer\npartial", 38);
+    if (ring_buffer_count(rb, '\n') != 2 || ring_buffer_find(rb, '\n', 11) != 30)
+    {
+        printf("2. failed! find() across the end of the array.\n");
+        exit(-1);
+    }
+    n = ring_buffer_dequeue_line(rb, out, sizeof(out));
+    if (n != 11 || memcmp(out, "first line\n", 11) != 0)
+    {
+        printf("2. failed! first line.\n");
+        exit(-1);
+    }
+    n = ring_buffer_dequeue_line(rb, out, sizeof(out));
+    if (n != 20 || memcmp(out, "second line, longer\n", 20) != 0)
+    {
+        printf("2. failed! second line.\n");
+        exit(-1);
+    }
+    if (ring_buffer_dequeue_line(rb, out, sizeof(out)) != 0 || ring_buffer_num_items(rb) != 7)
+    {
+        printf("2. failed! incomplete line must stay in the buffer.\n");
+        exit(-1);
+    }
+    // 比len长的行分段读出
+    ring_buffer_queue_arr(rb, " and more\n", 10);
+    n = ring_buffer_dequeue_line(rb, out, 10);
+    if (n != 10 || memcmp(out, "partial an", 10) != 0)
+    {
+        printf("2. failed! long line truncated to len.\n");
+        exit(-1);
+    }
+    n = ring_buffer_dequeue_line(rb, out, 10);
+    if (n != 7 || memcmp(out, "d more\n", 7) != 0 || !ring_buffer_is_empty(rb))
+    {
+        printf("2. failed! rest of the long line.\n");
+        exit(-1);
+    }
+    if (ring_buffer_find(rb, '\n', 0) != -1 || ring_buffer_count(rb, '\n') != 0 ||
+        ring_buffer_dequeue_line(rb, out, sizeof(out)) != 0)
+    {
+        printf("2. failed! empty buffer.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("2. ...OK\n");
+
+    return 0;
+}
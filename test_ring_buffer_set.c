@@ -0,0 +1,295 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_set.c
+	> 队列集合测试：就绪标记和重新标记、同优先级轮流调度、按权重调度不饿死低优先级、
+	> 一万个队列的两级位图、多个生产者线程并发标记时不丢失就绪队列。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_set test_ring_buffer_set.c ringbuffer.c ringbuffer_set.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ringbuffer_set.h"
+
+#define BIG_SET 10000
+#define THREAD_RINGS 64
+#define PRODUCERS 2
+#define WRITES_PER_PRODUCER 200000
+
+static ring_buffer_set_t *shared_set;
+static ring_buffer_t *shared_rings[THREAD_RINGS];
+
+static void *producer(void *arg)
+{
+    uint64_t seed = 0x9E3779B97F4A7C15ULL * ((uintptr_t)arg + 1);
+    unsigned long i;
+    int id;
+    char c = 'p';
+
+    for (i = 0; i < WRITES_PER_PRODUCER; i++)
+    {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        //每个生产者只写自己的一半队列，每个队列只有一个生产者。
+        id = (int)(seed % (THREAD_RINGS / PRODUCERS)) * PRODUCERS + (int)(uintptr_t)arg;
+        while (ring_buffer_queue_arr(shared_rings[id], &c, 1) != 1)
+        {
+            sched_yield();
+        }
+        ring_buffer_set_notify(shared_set, id);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    ring_buffer_set_t *set;
+    ring_buffer_t *rings[8];
+    ring_buffer_size_t quantum;
+    char data[256];
+    int i, id, counts[RING_BUFFER_SET_LEVELS];
+
+    memset(data, 'd', sizeof(data));
+    for (i = 0; i < 8; i++)
+    {
+        rings[i] = ring_buffer_new_policy(1024, RING_BUFFER_REJECT);
+    }
+
+    printf("1. notify, next and done:\n");
+    set = ring_buffer_set_new(8, NULL);
+    for (i = 0; i < 8; i++)
+    {
+        ring_buffer_set_add(set, rings[i], 0, 16 * (i + 1));
+    }
+    if (ring_buffer_set_add(set, rings[0], 0, 16) != -1 || ring_buffer_set_next(set, &quantum) != -1)
+    {
+        printf("1. failed! empty set.\n");
+        exit(-1);
+    }
+    ring_buffer_queue_arr(rings[5], data, 10);
+    ring_buffer_set_notify(set, 5);
+    ring_buffer_set_notify(set, 5);
+    ring_buffer_queue_arr(rings[2], data, 100);
+    ring_buffer_set_notify(set, 2);
+    if (ring_buffer_set_next(set, &quantum) != 2 || quantum != 48)
+    {
+        printf("1. failed! first ready ring.\n");
+        exit(-1);
+    }
+    // 只处理quantum字节，还有数据时重新标记
+    ring_buffer_dequeue_arr(rings[2], data, quantum);
+    ring_buffer_set_done(set, 2);
+    if (ring_buffer_set_next(set, &quantum) != 5 || quantum != 96)
+    {
+        printf("1. failed! second ready ring.\n");
+        exit(-1);
+    }
+    ring_buffer_dequeue_arr(rings[5], data, quantum);
+    ring_buffer_set_done(set, 5);
+    if (ring_buffer_set_next(set, &quantum) != 2 || ring_buffer_dequeue_arr(rings[2], data, quantum) != 48)
+    {
+        printf("1. failed! ring flagged again.\n");
+        exit(-1);
+    }
+    ring_buffer_set_done(set, 2);
+    if (ring_buffer_set_next(set, &quantum) != 2 || ring_buffer_dequeue_arr(rings[2], data, quantum) != 4)
+    {
+        printf("1. failed! rest of the ring.\n");
+        exit(-1);
+    }
+    ring_buffer_set_done(set, 2);
+    if (ring_buffer_set_next(set, &quantum) != -1)
+    {
+        printf("1. failed! drained rings still ready.\n");
+        exit(-1);
+    }
+    ring_buffer_set_destroy(&set);
+    printf("1. ...OK\n");
+
+    printf("2. round robin within a level:\n");
+    set = ring_buffer_set_new(8, NULL);
+    for (i = 0; i < 3; i++)
+    {
+        ring_buffer_set_add(set, rings[i], 1, 10);
+        ring_buffer_queue_arr(rings[i], data, 30);
+        ring_buffer_set_notify(set, i);
+    }
+    // 每个队列处理3次才能读完，调度顺序为0 1 2 0 1 2 0 1 2
+    for (i = 0; i < 9; i++)
+    {
+        id = ring_buffer_set_next(set, &quantum);
+        if (id != i % 3)
+        {
+            printf("2. failed! step %d got ring %d.\n", i, id);
+            exit(-1);
+        }
+        ring_buffer_dequeue_arr(rings[id], data, quantum);
+        ring_buffer_set_done(set, id);
+    }
+    if (ring_buffer_set_next(set, &quantum) != -1)
+    {
+        printf("2. failed! rings still ready.\n");
+        exit(-1);
+    }
+    ring_buffer_set_destroy(&set);
+    printf("2. ...OK\n");
+
+    printf("3. weighted levels without starvation:\n");
+    {
+        static const uint32_t weights[RING_BUFFER_SET_LEVELS] = {8, 4, 2, 1};
+
+        set = ring_buffer_set_new(8, weights);
+        for (i = 0; i < 4; i++)
+        {
+            ring_buffer_set_add(set, rings[i], (uint32_t)i, 1);
+            ring_buffer_queue_arr(rings[i], data, 200);
+            ring_buffer_set_notify(set, i);
+        }
+        memset(counts, 0, sizeof(counts));
+        // 每轮15次调度：8 + 4 + 2 + 1
+        for (i = 0; i < 150; i++)
+        {
+            id = ring_buffer_set_next(set, &quantum);
+            if (id < 0)
+            {
+                printf("3. failed! no ready ring.\n");
+                exit(-1);
+            }
+            counts[id]++;
+            ring_buffer_dequeue_arr(rings[id], data, quantum);
+            ring_buffer_set_done(set, id);
+        }
+        if (counts[0] != 80 || counts[1] != 40 || counts[2] != 20 || counts[3] != 10)
+        {
+            printf("3. failed! dispatch counts %d %d %d %d.\n", counts[0], counts[1], counts[2], counts[3]);
+            exit(-1);
+        }
+        ring_buffer_set_destroy(&set);
+
+        // 高优先级空闲时低优先级不受权重限制
+        set = ring_buffer_set_new(8, weights);
+        for (i = 0; i < 4; i++)
+        {
+            ring_buffer_set_add(set, rings[i], (uint32_t)i, 1);
+        }
+        ring_buffer_set_notify(set, 3);
+        for (i = 0; i < 100; i++)
+        {
+            if (ring_buffer_set_next(set, &quantum) != 3 || ring_buffer_dequeue_arr(rings[3], data, 1) != 1)
+            {
+                printf("3. failed! lower level alone.\n");
+                exit(-1);
+            }
+            ring_buffer_set_done(set, 3);
+        }
+        ring_buffer_set_destroy(&set);
+    }
+    printf("3. ...OK\n");
+
+    printf("4. two level bitmap with %d rings:\n", BIG_SET);
+    {
+        static unsigned char seen[BIG_SET];
+        ring_buffer_t *ring = ring_buffer_new(64);
+        int expect = 0;
+
+        set = ring_buffer_set_new(BIG_SET, NULL);
+        for (i = 0; i < BIG_SET; i++)
+        {
+            // 测试只检查位图，所有编号共用一个队列
+            ring_buffer_set_add(set, ring, (uint32_t)(i % 2), 1);
+        }
+        for (i = 0; i < BIG_SET; i += 1 + i % 97)
+        {
+            ring_buffer_set_notify(set, i);
+            seen[i] = 1;
+            expect++;
+        }
+        ring_buffer_set_notify(set, BIG_SET - 1);
+        expect += !seen[BIG_SET - 1];
+        seen[BIG_SET - 1] = 1;
+        while ((id = ring_buffer_set_next(set, &quantum)) >= 0)
+        {
+            if (seen[id] != 1)
+            {
+                printf("4. failed! ring %d dispatched without notify or twice.\n", id);
+                exit(-1);
+            }
+            seen[id] = 2;
+            expect--;
+        }
+        if (expect != 0)
+        {
+            printf("4. failed! %d ready rings missed.\n", expect);
+            exit(-1);
+        }
+        // 摘要位已清除，再次标记仍能找到
+        ring_buffer_set_notify(set, 4097);
+        if (ring_buffer_set_next(set, &quantum) != 4097 || ring_buffer_set_next(set, &quantum) != -1)
+        {
+            printf("4. failed! notify after summary cleared.\n");
+            exit(-1);
+        }
+        ring_buffer_set_destroy(&set);
+        ring_buffer_destroy(&ring);
+    }
+    printf("4. ...OK\n");
+
+    printf("5. concurrent producers:\n");
+    {
+        pthread_t tids[PRODUCERS];
+        unsigned long received = 0;
+        ring_buffer_size_t n;
+
+        shared_set = ring_buffer_set_new(THREAD_RINGS, NULL);
+        for (i = 0; i < THREAD_RINGS; i++)
+        {
+            shared_rings[i] = ring_buffer_new_policy(64, RING_BUFFER_REJECT);
+            ring_buffer_set_add(shared_set, shared_rings[i], (uint32_t)(i % RING_BUFFER_SET_LEVELS), 8);
+        }
+        for (i = 0; i < PRODUCERS; i++)
+        {
+            pthread_create(&tids[i], NULL, producer, (void *)(uintptr_t)i);
+        }
+        // 只通过就绪标记找队列，丢失一次标记就会永远读不完
+        while (received < (unsigned long)PRODUCERS * WRITES_PER_PRODUCER)
+        {
+            id = ring_buffer_set_next(shared_set, &quantum);
+            if (id < 0)
+            {
+                sched_yield();
+                continue;
+            }
+            n = ring_buffer_dequeue_arr(shared_rings[id], data, quantum);
+            received += n;
+            ring_buffer_set_done(shared_set, id);
+        }
+        for (i = 0; i < PRODUCERS; i++)
+        {
+            pthread_join(tids[i], NULL);
+        }
+        for (i = 0; i < THREAD_RINGS; i++)
+        {
+            if (!ring_buffer_is_empty(shared_rings[i]))
+            {
+                printf("5. failed! ring %d not drained.\n", i);
+                exit(-1);
+            }
+            ring_buffer_destroy(&shared_rings[i]);
+        }
+        ring_buffer_set_destroy(&shared_set);
+    }
+    printf("5. ...OK\n");
+
+    for (i = 0; i < 8; i++)
+    {
+        ring_buffer_destroy(&rings[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_shm.c
+	> 共享内存队列测试：重新打开不清空、不同映射地址、fork后双进程并发读写、镜像映射。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -o test_rb_shm test_ring_buffer_shm.c ringbuffer.c ringbuffer_shm.c
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "ringbuffer_shm.h"
+
+#define TOTAL_BYTES (16UL * 1024 * 1024)
+
+static char pattern(unsigned long i)
+{
+    return (char)(i % 251);
+}
+
+/* 子进程：重新映射同一个fd作为消费者，校验收到的每个字节。 */
+static int consumer(int fd)
+{
+    ring_buffer_t *rb = ring_buffer_fd_open(fd);
+    char chunk[512];
+    unsigned long received = 0;
+
+    if (rb == NULL)
+    {
+        return 1;
+    }
+
+    while (received < TOTAL_BYTES)
+    {
+        ring_buffer_size_t i, n = ring_buffer_spsc_dequeue_arr(rb, chunk, sizeof(chunk));
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        for (i = 0; i < n; i++)
+        {
+            if (chunk[i] != pattern(received + i))
+            {
+                printf("3. failed! byte %lu is %d, expect %d\n", received + i, chunk[i], pattern(received + i));
+                return 1;
+            }
+        }
+        received += n;
+    }
+
+    ring_buffer_shm_close(&rb);
+    return 0;
+}
+
+int main(void)
+{
+    ring_buffer_t *rb1, *rb2;
+    char a[100], c[100];
+    char name[64];
+    int i, fd, status;
+    unsigned long sent;
+    pid_t pid;
+
+    for (i = 0; i < 100; i++)
+    {
+        a[i] = i;
+    }
+
+    printf("1. reopen memfd ring at another address:\n");
+    rb1 = ring_buffer_memfd_create("test_ring", 4096, &fd);
+    if (rb1 == NULL)
+    {
+        printf("1. ring_buffer_memfd_create() failed!\n");
+        exit(-1);
+    }
+    ring_buffer_queue_arr(rb1, a, 100);
+
+    rb2 = ring_buffer_fd_open(fd);
+    if (rb2 == NULL || rb2 == rb1)
+    {
+        printf("1. failed! ring_buffer_fd_open() returned %p.\n", (void *)rb2);
+        exit(-1);
+    }
+    if (ring_buffer_num_items(rb2) != 100 || ring_buffer_dequeue_arr(rb2, c, 100) != 100 || memcmp(a, c, 100) != 0)
+    {
+        printf("1. failed! data lost after reopen.\n");
+        exit(-1);
+    }
+    if (!ring_buffer_is_empty(rb1))
+    {
+        printf("1. failed! dequeue through second mapping not visible.\n");
+        exit(-1);
+    }
+    ring_buffer_shm_close(&rb2);
+    printf("1. ...OK\n\n");
+
+    printf("2. open rejects memory without ring header:\n");
+    memset(c, 0x5a, sizeof(c));
+    if (ring_buffer_open(c, sizeof(c)) != NULL)
+    {
+        printf("2. failed! garbage accepted.\n");
+        exit(-1);
+    }
+    if (ring_buffer_open(rb1, 1024) != NULL)
+    {
+        printf("2. failed! truncated mapping accepted.\n");
+        exit(-1);
+    }
+    printf("2. ...OK\n\n");
+
+    printf("3. fork producer/consumer, %lu bytes:\n", TOTAL_BYTES);
+    pid = fork();
+    if (pid == 0)
+    {
+        ring_buffer_shm_close(&rb1);
+        _exit(consumer(fd));
+    }
+    for (sent = 0; sent < TOTAL_BYTES;)
+    {
+        char chunk[300];
+        ring_buffer_size_t n = sizeof(chunk), w, k;
+        if (n > TOTAL_BYTES - sent)
+        {
+            n = TOTAL_BYTES - sent;
+        }
+        for (k = 0; k < n; k++)
+        {
+            chunk[k] = pattern(sent + k);
+        }
+        for (w = 0; w < n;)
+        {
+            ring_buffer_size_t k = ring_buffer_spsc_queue_arr(rb1, chunk + w, n - w);
+            if (k == 0)
+            {
+                sched_yield();
+            }
+            w += k;
+        }
+        sent += n;
+    }
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        printf("3. failed! consumer exit status %d.\n", status);
+        exit(-1);
+    }
+    ring_buffer_shm_close(&rb1);
+    close(fd);
+    printf("3. ...OK\n\n");
+
+    printf("4. named POSIX shm:\n");
+    snprintf(name, sizeof(name), "/test_ring_%d", (int)getpid());
+    rb1 = ring_buffer_shm_create(name, 1000);
+    if (rb1 == NULL)
+    {
+        printf("4. ring_buffer_shm_create() failed!\n");
+        exit(-1);
+    }
+    ring_buffer_queue_arr(rb1, a, 50);
+    rb2 = ring_buffer_shm_open(name);
+    shm_unlink(name);
+    if (rb2 == NULL || rb2->buffer_cap != 1024 || ring_buffer_num_items(rb2) != 50)
+    {
+        printf("4. failed! reopened ring does not match.\n");
+        exit(-1);
+    }
+    ring_buffer_shm_close(&rb1);
+    ring_buffer_shm_close(&rb2);
+    printf("4. ...OK\n\n");
+
+    printf("5. mirrored mapping:\n");
+    {
+        ring_buffer_span_t spans[2];
+        rb1 = ring_buffer_new_mirrored(100);
+        if (rb1 == NULL || !(rb1->flags & RING_BUFFER_FLAG_MIRRORED) || rb1->buffer_cap < 4096)
+        {
+            printf("5. ring_buffer_new_mirrored() failed!\n");
+            exit(-1);
+        }
+        /* 移动到数组末尾前50字节处，再写入100字节使数据跨越数组末尾 */
+        rb1->head_index = rb1->tail_index = rb1->cached_head = rb1->cached_tail = rb1->buffer_cap - 50;
+        ring_buffer_queue_arr(rb1, a, 100);
+        if (ring_buffer_peek_spans(rb1, spans) != 100 || spans[0].len != 100 || spans[1].len != 0 ||
+            memcmp(spans[0].data, a, 100) != 0)
+        {
+            printf("5. failed! wrapped data is not contiguous.\n");
+            exit(-1);
+        }
+        if (ring_buffer_data(rb1) + rb1->buffer_cap != spans[0].data + 50)
+        {
+            printf("5. failed! data does not cross the end of array.\n");
+            exit(-1);
+        }
+        ring_buffer_destroy(&rb1);
+    }
+    printf("5. ...OK\n");
+
+    return 0;
+}
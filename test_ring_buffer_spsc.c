@@ -0,0 +1,231 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_spsc.c
+	> 单生产者/单消费者无锁接口的双线程压力测试。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_spsc test_ring_buffer_spsc.c ringbuffer.c ringbuffer_wait.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+#include "ringbuffer_wait.h"
+
+#define TOTAL_BYTES (64UL * 1024 * 1024)
+
+/* 生产者写入的第i个字节的值，取质数模长使其与队列容量不同步。 */
+static char pattern(unsigned long i)
+{
+    return (char)(i % 251);
+}
+
+static void *producer(void *arg)
+{
+    ring_buffer_t *rb = arg;
+    char chunk[1024];
+    unsigned long sent = 0;
+    unsigned int seed = 1;
+
+    while (sent < TOTAL_BYTES)
+    {
+        ring_buffer_size_t n = (ring_buffer_size_t)(rand_r(&seed) % sizeof(chunk)) + 1;
+        ring_buffer_size_t i, done;
+
+        if (n > TOTAL_BYTES - sent)
+        {
+            n = TOTAL_BYTES - sent;
+        }
+        for (i = 0; i < n; i++)
+        {
+            chunk[i] = pattern(sent + i);
+        }
+        /* 单字节和数组接口交替使用 */
+        if (n == 1)
+        {
+            while (!ring_buffer_spsc_queue(rb, chunk[0]))
+            {
+                sched_yield();
+            }
+            sent++;
+            continue;
+        }
+        for (done = 0; done < n;)
+        {
+            ring_buffer_size_t w = ring_buffer_spsc_queue_arr(rb, chunk + done, n - done);
+            if (w == 0)
+            {
+                sched_yield();
+            }
+            done += w;
+        }
+        sent += n;
+    }
+    return NULL;
+}
+
+/* 阻塞接口的生产者，写入TOTAL_BYTES / 4个字节，偶尔停顿让消费者进入睡眠。 */
+static void *blocking_producer(void *arg)
+{
+    ring_buffer_t *rb = arg;
+    char chunk[3000];
+    unsigned long sent = 0;
+    unsigned int seed = 3;
+
+    while (sent < TOTAL_BYTES / 4)
+    {
+        ring_buffer_size_t i, n = (ring_buffer_size_t)(rand_r(&seed) % sizeof(chunk)) + 1;
+
+        if (n > TOTAL_BYTES / 4 - sent)
+        {
+            n = TOTAL_BYTES / 4 - sent;
+        }
+        for (i = 0; i < n; i++)
+        {
+            chunk[i] = pattern(sent + i);
+        }
+        if (ring_buffer_queue_wait(rb, chunk, n, -1) != n)
+        {
+            printf("3. failed! ring_buffer_queue_wait() returned early.\n");
+            exit(-1);
+        }
+        sent += n;
+        if (rand_r(&seed) % 512 == 0)
+        {
+            struct timespec ts = {0, 200000};
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(4096);
+    pthread_t tid;
+    char chunk[700];
+    unsigned long received = 0;
+    unsigned int seed = 2;
+
+    if (rb == NULL)
+    {
+        printf("1. ring_buffer_new() failed!\n");
+        exit(-1);
+    }
+
+    printf("1. sizeof ring_buffer_t is %lu, head at offset %lu, tail at offset %lu.\n",
+           sizeof(ring_buffer_t), offsetof(ring_buffer_t, head_index), offsetof(ring_buffer_t, tail_index));
+    if (offsetof(ring_buffer_t, tail_index) - offsetof(ring_buffer_t, head_index) < RING_BUFFER_CACHE_LINE)
+    {
+        printf("1. failed! head and tail share a cache line.\n");
+        exit(-1);
+    }
+
+    printf("2. two thread stress test, %lu bytes:\n", TOTAL_BYTES);
+    pthread_create(&tid, NULL, producer, rb);
+    while (received < TOTAL_BYTES)
+    {
+        ring_buffer_size_t i, n;
+        if (rand_r(&seed) % 8 == 0)
+        {
+            n = ring_buffer_spsc_dequeue(rb, chunk);
+        }
+        else
+        {
+            n = ring_buffer_spsc_dequeue_arr(rb, chunk, (rand_r(&seed) % sizeof(chunk)) + 1);
+        }
+        if (n == 0)
+        {
+            sched_yield();
+            continue;
+        }
+        for (i = 0; i < n; i++)
+        {
+            if (chunk[i] != pattern(received + i))
+            {
+                printf("2. failed! byte %lu is %d, expect %d\n", received + i, chunk[i], pattern(received + i));
+                exit(-1);
+            }
+        }
+        received += n;
+    }
+    pthread_join(tid, NULL);
+
+    if (!ring_buffer_is_empty(rb))
+    {
+        printf("2. failed! buffer not empty after all bytes received.\n");
+        exit(-1);
+    }
+    printf("2. ...OK\n");
+
+    printf("3. blocking queue_wait/dequeue_wait, %lu bytes:\n", TOTAL_BYTES / 4);
+    received = 0;
+    pthread_create(&tid, NULL, blocking_producer, rb);
+    while (received < TOTAL_BYTES / 4)
+    {
+        ring_buffer_size_t i, n = ring_buffer_dequeue_wait(rb, chunk, (rand_r(&seed) % sizeof(chunk)) + 1, -1);
+
+        if (n == 0)
+        {
+            printf("3. failed! ring_buffer_dequeue_wait() returned 0 without timeout.\n");
+            exit(-1);
+        }
+        for (i = 0; i < n; i++)
+        {
+            if (chunk[i] != pattern(received + i))
+            {
+                printf("3. failed! byte %lu is %d, expect %d\n", received + i, chunk[i], pattern(received + i));
+                exit(-1);
+            }
+        }
+        received += n;
+    }
+    pthread_join(tid, NULL);
+    if (!ring_buffer_is_empty(rb) || atomic_load(&rb->data_waiters) != 0 || atomic_load(&rb->space_waiters) != 0)
+    {
+        printf("3. failed! buffer not empty or waiters left registered.\n");
+        exit(-1);
+    }
+    printf("3. ...OK\n");
+
+    printf("4. timeouts:\n");
+    {
+        double start = now_ms();
+        if (ring_buffer_dequeue_wait(rb, chunk, sizeof(chunk), 0) != 0 ||
+            ring_buffer_dequeue_wait(rb, chunk, sizeof(chunk), 20) != 0 ||
+            now_ms() - start < 19)
+        {
+            printf("4. failed! dequeue_wait on empty buffer.\n");
+            exit(-1);
+        }
+        memset(chunk, 0, sizeof(chunk));
+        while (ring_buffer_spsc_queue_arr(rb, chunk, sizeof(chunk)) > 0)
+        {
+        }
+        start = now_ms();
+        if (ring_buffer_queue_wait(rb, chunk, 1, 20) != 0 || now_ms() - start < 19 ||
+            ring_buffer_wait_space(rb, 1, 0) || !ring_buffer_wait_data(rb, 4096, 0) ||
+            ring_buffer_wait_data(rb, 4097, -1))
+        {
+            printf("4. failed! queue_wait/wait_space on full buffer.\n");
+            exit(-1);
+        }
+    }
+    printf("4. ...OK\n");
+
+    ring_buffer_destroy(&rb);
+    return 0;
+}
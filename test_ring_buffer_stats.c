@@ -0,0 +1,128 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_stats.c
+	> 统计计数测试：读写计数、满/空次数、覆盖、高水位、批大小直方图，以及跨映射读取快照。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -DRING_BUFFER_STATS=1 -o test_rb_stats test_ring_buffer_stats.c ringbuffer.c ringbuffer_shm.c
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ringbuffer.h"
+#include "ringbuffer_shm.h"
+
+#if !RING_BUFFER_STATS
+#error "compile with -DRING_BUFFER_STATS=1"
+#endif
+
+int main(void)
+{
+    ring_buffer_t *rb = ring_buffer_new(128);
+    ring_buffer_stats_t st;
+    ring_buffer_span_t spans[2];
+    char a[200], c[200], b;
+    int i;
+
+    for (i = 0; i < 200; i++)
+    {
+        a[i] = (char)i;
+    }
+
+    printf("1. byte and array counters:\n");
+    ring_buffer_queue(rb, 'x');
+    ring_buffer_queue_arr(rb, a, 100);
+    ring_buffer_dequeue(rb, &b);
+    ring_buffer_dequeue_arr(rb, c, 60);
+    ring_buffer_get_stats(rb, &st);
+    if (st.capacity != 128 || st.num_items != 40 || st.enqueued_bytes != 101 || st.enqueued_records != 2 ||
+        st.dequeued_bytes != 61 || st.dequeued_records != 2 || st.high_water != 101 ||
+        st.full_hits != 0 || st.empty_hits != 0 || st.overwrites != 0)
+    {
+        printf("1. failed! counters after simple queue/dequeue.\n");
+        exit(-1);
+    }
+    printf("1. ...OK\n");
+
+    printf("2. full, empty and overwrite:\n");
+    ring_buffer_queue_arr(rb, a, 100);
+    ring_buffer_dequeue_arr(rb, c, 200);
+    if (ring_buffer_dequeue(rb, &b) || ring_buffer_spsc_dequeue(rb, &b) || ring_buffer_spsc_dequeue_arr(rb, c, 10) ||
+        ring_buffer_peek_spans(rb, spans) != 0)
+    {
+        printf("2. failed! dequeue from empty buffer.\n");
+        exit(-1);
+    }
+    ring_buffer_spsc_queue_arr(rb, a, 200);
+    ring_buffer_spsc_queue(rb, 'y');
+    ring_buffer_get_stats(rb, &st);
+    if (st.overwrites != 1 || st.dropped_bytes != 12 || st.empty_hits != 4 || st.full_hits != 3 ||
+        st.high_water != 128 || st.num_items != 128)
+    {
+        printf("2. failed! full %llu, empty %llu, overwrites %llu, high water %llu.\n",
+               (unsigned long long)st.full_hits, (unsigned long long)st.empty_hits,
+               (unsigned long long)st.overwrites, (unsigned long long)st.high_water);
+        exit(-1);
+    }
+    printf("2. ...OK\n");
+
+    printf("3. batch size histogram:\n");
+    ring_buffer_init(rb);
+    ring_buffer_spsc_queue_arr(rb, a, 1);
+    ring_buffer_spsc_queue_arr(rb, a, 3);
+    ring_buffer_spsc_queue_arr(rb, a, 64);
+    ring_buffer_reserve(rb, 60, spans);
+    ring_buffer_commit(rb, 60);
+    ring_buffer_peek_spans(rb, spans);
+    ring_buffer_consume(rb, 128);
+    ring_buffer_get_stats(rb, &st);
+    if (st.enqueued_records != 4 || st.enqueue_hist[0] != 1 || st.enqueue_hist[1] != 1 ||
+        st.enqueue_hist[5] != 1 || st.enqueue_hist[6] != 1 || st.dequeue_hist[7] != 1 ||
+        st.dequeued_bytes != 128 || st.empty_hits != 0)
+    {
+        printf("3. failed! histogram buckets.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&rb);
+    printf("3. ...OK\n");
+
+    printf("4. snapshot through a second mapping:\n");
+    {
+        int fd;
+        ring_buffer_t *writer = ring_buffer_memfd_create("rb_stats", 4096, &fd);
+        ring_buffer_t *reader;
+
+        if (writer == NULL)
+        {
+            printf("4. failed! ring_buffer_memfd_create().\n");
+            exit(-1);
+        }
+        reader = ring_buffer_fd_open(fd);
+        if (reader == NULL || !(reader->flags & RING_BUFFER_FLAG_STATS))
+        {
+            printf("4. failed! ring_buffer_fd_open().\n");
+            exit(-1);
+        }
+        for (i = 0; i < 1000; i++)
+        {
+            ring_buffer_spsc_queue_arr(writer, a, 3);
+            ring_buffer_spsc_dequeue_arr(writer, c, 3);
+        }
+        ring_buffer_get_stats(reader, &st);
+        if (st.enqueued_bytes != 3000 || st.dequeued_records != 1000 || st.enqueue_hist[1] != 1000)
+        {
+            printf("4. failed! counters not visible through the second mapping.\n");
+            exit(-1);
+        }
+        ring_buffer_shm_close(&reader);
+        ring_buffer_shm_close(&writer);
+        close(fd);
+    }
+    printf("4. ...OK\n");
+
+    return 0;
+}
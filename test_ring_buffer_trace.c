@@ -0,0 +1,250 @@
+/*************************************************************************
+	> File Name: test_ring_buffer_trace.c
+	> 事件记录器测试：参数校验、时间窗口查询、写满后覆盖、快照、共享内存中打开、
+	> 生产者持续写入时并发查询和快照只返回完整的记录、生产者转圈时查询的记录数不超过槽位数。
+ ************************************************************************/
+
+// compile command:
+//  gcc -std=c11 -O2 -pthread -o test_rb_trace test_ring_buffer_trace.c ringbuffer.c ringbuffer_trace.c
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "ringbuffer_trace.h"
+
+#define SLOT 64
+#define STREAM_RECORDS 2000000ULL
+#define LAP_SEEKS 2000000
+
+static _Atomic int producer_done;
+static _Atomic int lap_stop;
+
+/* 第seq条记录的内容，长度随序号变化 */
+static uint32_t fill_record(char *out, uint64_t seq)
+{
+    uint32_t i, len = (uint32_t)(seq % (SLOT - sizeof(ring_buffer_trace_record_t) + 1));
+
+    for (i = 0; i < len; i++)
+    {
+        out[i] = (char)(seq * 13 + i);
+    }
+    return len;
+}
+
+/* 检查一条记录的时间戳、长度和内容都与序号一致 */
+static int check_record(const ring_buffer_trace_record_t *rec)
+{
+    char expect[SLOT];
+    uint32_t len = fill_record(expect, rec->seq);
+
+    return rec->ts == rec->seq * 10 && rec->len == len && memcmp(rec->data, expect, len) == 0;
+}
+
+static void write_range(ring_buffer_trace_t *trace, uint64_t from, uint64_t to)
+{
+    char data[SLOT];
+    uint64_t seq;
+
+    for (seq = from; seq < to; seq++)
+    {
+        ring_buffer_trace_write_ts(trace, seq * 10, data, fill_record(data, seq));
+    }
+}
+
+/* 查询[from, to]，返回记录数，检查每条记录 */
+static uint64_t query(ring_buffer_trace_t *trace, uint64_t from, uint64_t to, uint64_t *first)
+{
+    _Alignas(8) char buf[SLOT];
+    ring_buffer_trace_record_t *rec = (ring_buffer_trace_record_t *)buf;
+    ring_buffer_trace_iter_t it;
+    uint64_t n = 0, prev = 0;
+
+    ring_buffer_trace_seek(trace, &it, from, to);
+    while (ring_buffer_trace_next(trace, &it, rec))
+    {
+        if (!check_record(rec) || rec->ts < from || rec->ts > to || (n != 0 && rec->seq != prev + 1))
+        {
+            printf("failed! bad record %llu in query.\n", (unsigned long long)rec->seq);
+            exit(-1);
+        }
+        if (n++ == 0 && first != NULL)
+        {
+            *first = rec->seq;
+        }
+        prev = rec->seq;
+    }
+    return n;
+}
+
+static void *producer(void *arg)
+{
+    write_range(arg, 0, STREAM_RECORDS);
+    atomic_store(&producer_done, 1);
+    return NULL;
+}
+
+/* 不停地写入，很小的记录器在两次读取之间就会被转过一圈 */
+static void *lap_producer(void *arg)
+{
+    char data[8] = {0};
+    uint64_t seq = 0;
+
+    while (!atomic_load_explicit(&lap_stop, memory_order_relaxed))
+    {
+        ring_buffer_trace_write_ts(arg, seq++, data, sizeof(data));
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    static _Alignas(RING_BUFFER_CACHE_LINE) char mem[sizeof(ring_buffer_trace_t) + 8192];
+    static _Alignas(8) char snap[SLOT * 64];
+    ring_buffer_trace_t *trace, *other;
+    ring_buffer_t *plain;
+    ring_buffer_trace_record_t *rec = (ring_buffer_trace_record_t *)snap;
+    uint64_t n, first, i;
+    char data[SLOT];
+
+    printf("1. parameters:\n");
+    trace = ring_buffer_trace_new(4096, SLOT);
+    plain = ring_buffer_new(4096);
+    if (trace == NULL || trace->slots != 64 || ring_buffer_trace_new(4096, 48) != NULL ||
+        ring_buffer_trace_new(4096, 16) != NULL || ring_buffer_trace_new(32, SLOT) != NULL ||
+        ring_buffer_trace_open(plain, ring_buffer_calc_size(4096)) != NULL ||
+        ring_buffer_trace_write(trace, data, SLOT - sizeof(ring_buffer_trace_record_t) + 1) ||
+        !ring_buffer_trace_write(trace, data, SLOT - sizeof(ring_buffer_trace_record_t)))
+    {
+        printf("1. failed! parameter checks.\n");
+        exit(-1);
+    }
+    ring_buffer_destroy(&plain);
+    ring_buffer_trace_destroy(&trace);
+    printf("1. ...OK\n");
+
+    printf("2. time window query:\n");
+    trace = ring_buffer_trace_new(4096, SLOT);
+    write_range(trace, 0, 40);
+    if (query(trace, 100, 200, &first) != 11 || first != 10 || query(trace, 95, 105, &first) != 1 || first != 10 ||
+        query(trace, 0, 0, &first) != 1 || first != 0 || query(trace, 391, 1000, NULL) != 0 ||
+        query(trace, 0, UINT64_MAX, NULL) != 40)
+    {
+        printf("2. failed! query.\n");
+        exit(-1);
+    }
+    // 时间戳减小时按上一条记录保存
+    ring_buffer_trace_write_ts(trace, 5, data, 0);
+    ring_buffer_trace_snapshot(trace, snap, 1);
+    if (rec->ts != 390 || rec->seq != 40)
+    {
+        printf("2. failed! timestamp went backwards.\n");
+        exit(-1);
+    }
+    ring_buffer_trace_destroy(&trace);
+    printf("2. ...OK\n");
+
+    printf("3. overwrite and snapshot:\n");
+    trace = ring_buffer_trace_new(4096, SLOT);
+    write_range(trace, 0, 1000);
+    if (query(trace, 0, UINT64_MAX, &first) != 64 || first != 936 || query(trace, 9500, 9600, &first) != 11 ||
+        first != 950 || query(trace, 0, 9000, NULL) != 0)
+    {
+        printf("3. failed! query after overwrite.\n");
+        exit(-1);
+    }
+    n = ring_buffer_trace_snapshot(trace, snap, 10);
+    for (i = 0; i < n; i++)
+    {
+        rec = (ring_buffer_trace_record_t *)(snap + i * SLOT);
+        if (rec->seq != 990 + i || !check_record(rec))
+        {
+            break;
+        }
+    }
+    if (n != 10 || i != n || ring_buffer_trace_snapshot(trace, snap, 1000) != 64 ||
+        ((ring_buffer_trace_record_t *)snap)->seq != 936 || ((ring_buffer_trace_record_t *)(snap + 63 * SLOT))->seq != 999)
+    {
+        printf("3. failed! snapshot.\n");
+        exit(-1);
+    }
+    ring_buffer_trace_destroy(&trace);
+    printf("3. ...OK\n");
+
+    printf("4. attach and open in another mapping:\n");
+    trace = ring_buffer_trace_attach(mem, sizeof(mem), SLOT);
+    write_range(trace, 0, 100);
+    other = ring_buffer_trace_open(mem, sizeof(mem));
+    if (trace == NULL || trace->ring.buffer_cap != 8192 || other == NULL || query(other, 0, UINT64_MAX, &first) != 100 ||
+        first != 0)
+    {
+        printf("4. failed! shared trace.\n");
+        exit(-1);
+    }
+    printf("4. ...OK\n");
+
+    printf("5. queries and snapshots while the producer writes:\n");
+    {
+        pthread_t tid;
+        uint64_t queries = 0, records = 0, head;
+
+        trace = ring_buffer_trace_new(4096, SLOT);
+        pthread_create(&tid, NULL, producer, trace);
+        while (!atomic_load(&producer_done))
+        {
+            head = atomic_load(&trace->head);
+            records += query(trace, head > 32 ? (head - 32) * 10 : 0, UINT64_MAX, NULL);
+            n = ring_buffer_trace_snapshot(trace, snap, 64);
+            for (i = 0; i < n; i++)
+            {
+                rec = (ring_buffer_trace_record_t *)(snap + i * SLOT);
+                if (!check_record(rec) || (i != 0 && rec->seq != ((ring_buffer_trace_record_t *)snap)->seq + i))
+                {
+                    printf("5. failed! torn record %llu in snapshot.\n", (unsigned long long)rec->seq);
+                    exit(-1);
+                }
+            }
+            queries++;
+        }
+        pthread_join(tid, NULL);
+        if (queries == 0 || atomic_load(&trace->head) != STREAM_RECORDS)
+        {
+            printf("5. failed! stream.\n");
+            exit(-1);
+        }
+        printf("%llu queries, %llu records checked\n", (unsigned long long)queries, (unsigned long long)records);
+        ring_buffer_trace_destroy(&trace);
+    }
+    printf("5. ...OK\n");
+
+    printf("6. seek while the producer laps a 2-slot trace:\n");
+    {
+        pthread_t tid;
+        ring_buffer_trace_iter_t it;
+        int q;
+
+        trace = ring_buffer_trace_new(64, 32);
+        if (trace == NULL || trace->slots != 2)
+        {
+            printf("6. failed! ring_buffer_trace_new().\n");
+            exit(-1);
+        }
+        pthread_create(&tid, NULL, lap_producer, trace);
+        for (q = 0; q < LAP_SEEKS; q++)
+        {
+            n = ring_buffer_trace_seek(trace, &it, 0, UINT64_MAX);
+            if (n > trace->slots || it.next > it.end)
+            {
+                printf("6. failed! seek returned %llu records.\n", (unsigned long long)n);
+                exit(-1);
+            }
+        }
+        atomic_store(&lap_stop, 1);
+        pthread_join(tid, NULL);
+        ring_buffer_trace_destroy(&trace);
+    }
+    printf("6. ...OK\n");
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/*************************************************************************
+	> File Name: ringstat.c
+	> 打开一个命名共享内存队列，定时打印读写速率、满/空次数、丢弃计数和高水位，
+	> 退出时打印读写批大小的log2直方图。队列需由以RING_BUFFER_STATS=1编译的程序创建。
+	> 用法：ringstat /name [interval_ms] [count]
+ ************************************************************************/
+
+// compile command:
+//  make -C tools ringstat
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+
+#include "ringbuffer.h"
+#include "ringbuffer_shm.h"
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void print_hist(const char *name, const uint64_t *hist)
+{
+    int i;
+
+    printf("%s batch sizes:\n", name);
+    for (i = 0; i < RING_BUFFER_STATS_BUCKETS; i++)
+    {
+        if (hist[i] != 0)
+        {
+            printf("  [%llu, %llu) %llu\n", 1ULL << i, 1ULL << (i + 1), (unsigned long long)hist[i]);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ring_buffer_t *rb;
+    ring_buffer_stats_t prev, cur;
+    struct timespec interval;
+    int interval_ms = 1000, count = -1;
+    double t_prev, t_cur;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s /name [interval_ms] [count]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+    {
+        interval_ms = atoi(argv[2]);
+    }
+    if (argc > 3)
+    {
+        count = atoi(argv[3]);
+    }
+    if (interval_ms <= 0)
+    {
+        interval_ms = 1000;
+    }
+
+    rb = ring_buffer_shm_open(argv[1]);
+    if (rb == NULL)
+    {
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    interval.tv_sec = interval_ms / 1000;
+    interval.tv_nsec = (long)(interval_ms % 1000) * 1000000;
+
+    printf("%12s %12s %12s %12s %12s %10s %10s %12s %12s\n", "items", "high water", "in MB/s", "out MB/s",
+           "in rec/s", "full/s", "empty/s", "overwrites", "dropped B");
+    ring_buffer_get_stats(rb, &prev);
+    t_prev = now_sec();
+    while (!stop && count != 0)
+    {
+        double dt;
+
+        nanosleep(&interval, NULL);
+        ring_buffer_get_stats(rb, &cur);
+        t_cur = now_sec();
+        dt = t_cur - t_prev;
+        printf("%12llu %12llu %12.2f %12.2f %12.0f %10.0f %10.0f %12llu %12llu\n",
+               (unsigned long long)cur.num_items, (unsigned long long)cur.high_water,
+               (cur.enqueued_bytes - prev.enqueued_bytes) / dt / 1e6,
+               (cur.dequeued_bytes - prev.dequeued_bytes) / dt / 1e6,
+               (cur.enqueued_records - prev.enqueued_records) / dt,
+               (cur.full_hits - prev.full_hits) / dt, (cur.empty_hits - prev.empty_hits) / dt,
+               (unsigned long long)cur.overwrites, (unsigned long long)cur.dropped_bytes);
+        fflush(stdout);
+        prev = cur;
+        t_prev = t_cur;
+        if (count > 0)
+        {
+            count--;
+        }
+    }
+
+    ring_buffer_get_stats(rb, &cur);
+    print_hist("enqueue", cur.enqueue_hist);
+    print_hist("dequeue", cur.dequeue_hist);
+    ring_buffer_shm_close(&rb);
+    return 0;
+}